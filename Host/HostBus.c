@@ -0,0 +1,623 @@
+/*
+ * HostBus.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * One wire, event by event: the nodes that are due run, the frame on the
+ * wire finishes, and an idle bus goes to arbitration.  Then time jumps to
+ * whichever comes first of the end of that frame, a node's next wake-up or
+ * the next background frame.
+ *
+ * Every node is asked about every frame, so the asking is done through
+ * HN_CANState() and HN_CANAccepts(), which read its registers where they
+ * lie; only the nodes a frame is actually for are loaded and run.  What a
+ * node would send is asked once and kept until its controller says the
+ * answer may have changed -- the canTxRequest callback.
+ */
+
+#include "HostBus.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define HB_CRC15_POLY			0x4599
+#define HB_FRAME_MAX_BITS		128			// SOF to CRC, unstuffed: 118 at most
+#define HB_FRAME_TAIL_BITS		13			// CRC delimiter, ACK slot and delimiter, EOF, intermission
+#define HB_STUFF_RUN			5
+#define HB_LOAD_DATA_BYTES		8
+#define HB_NS_PER_US			1000ULL
+#define HB_NS_PER_S				1000000000ULL
+#define HB_PPM					1000000
+
+typedef struct _HB_PORT
+{
+	HB_BUS			*busPtr;
+	HN_NODE			*nodePtr;
+	HN_CALLBACKS	callbacks;				// the caller's
+	bool			stale;					// what it would send may have changed: ask again
+	bool			ready;					// frame/mailbox are what it would send
+	bool			sending;
+	HS_CAN_FRAME	frame;
+	int				mailbox;
+	uint64_t		queuedUs;
+	uint64_t		holdNs;					// taking a frame: not run again before this
+} HB_PORT;
+
+struct _HB_BUS
+{
+	HB_CONFIG		config;
+	HB_PORT			**portPtrs;
+	int				count;
+	int				capacity;
+	uint64_t		nowNs;
+	uint64_t		random;
+
+	// The frame on the wire
+	bool			busy;
+	bool			corrupt;
+	bool			acked;
+	HS_CAN_FRAME	frame;
+	int				sender;					// the first of them; -1 for the background
+	uint32_t		bits;
+	uint64_t		endNs;
+
+	// Background load
+	uint32_t		loadPending;			// arrived and not yet sent
+	bool			loadSending;
+	uint64_t		loadDueNs;				// the next arrival
+	uint64_t		loadMeanNs;
+	uint32_t		loadSequence;
+	HS_CAN_FRAME	loadFrame;
+
+	HB_STATS		stats;
+	uint64_t		statsStartNs;
+	uint32_t		*latencyPtr;
+	uint64_t		latencyCapacity;
+};
+
+static uint64_t hbRandom(HB_BUS *busPtr)
+{
+	uint64_t x = busPtr->random;
+
+	// xorshift64*: repeatable from the seed, which is all this needs
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	busPtr->random = x;
+	return(x * 0x2545F4914F6CDD1DULL);
+}
+
+static uint64_t hbBitsNs(const HB_BUS *busPtr, uint32_t bits)
+{
+	return(((uint64_t)bits * HB_NS_PER_S) / busPtr->config.bitrate);
+}
+
+static int hbPut(uint8_t *bitsPtr, int count, uint32_t value, int width)
+{
+	for (int bit = width - 1; bit >= 0; bit--)
+	{
+		bitsPtr[count++] = (uint8_t)((value >> bit) & 1);
+	}
+	return(count);
+}
+
+// On the wire, from SOF to the end of the intermission
+static uint32_t hbFrameBits(const HS_CAN_FRAME *framePtr)
+{
+	uint8_t bits[HB_FRAME_MAX_BITS];
+	uint32_t bytes = ((true == framePtr->remote) || (8 < framePtr->dlc)) ? ((true == framePtr->remote) ? 0 : 8) : framePtr->dlc;
+	uint32_t crc = 0;
+	uint32_t stuffed = 0;
+	uint32_t run = 0;
+	uint8_t last = 2;
+	int count = 0;
+
+	count = hbPut(bits, count, 0, 1);									// SOF
+	if (true == framePtr->extended)
+	{
+		count = hbPut(bits, count, framePtr->id >> 18, 11);
+		count = hbPut(bits, count, 3, 2);								// SRR, IDE
+		count = hbPut(bits, count, framePtr->id & 0x3FFFF, 18);
+		count = hbPut(bits, count, (true == framePtr->remote) ? 1 : 0, 1);
+		count = hbPut(bits, count, 0, 2);								// r1, r0
+	}
+	else
+	{
+		count = hbPut(bits, count, framePtr->id & 0x7FF, 11);
+		count = hbPut(bits, count, (true == framePtr->remote) ? 1 : 0, 1);
+		count = hbPut(bits, count, 0, 2);								// IDE, r0
+	}
+	count = hbPut(bits, count, framePtr->dlc & 0x0F, 4);
+	for (uint32_t i = 0; i < bytes; i++)
+	{
+		count = hbPut(bits, count, framePtr->data[i], 8);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		uint32_t next = bits[i] ^ ((crc >> 14) & 1);
+
+		crc = (crc << 1) & 0x7FFF;
+		crc ^= (0 != next) ? HB_CRC15_POLY : 0;
+	}
+	count = hbPut(bits, count, crc, 15);
+
+	// Five alike and the sender puts in one the other way, which counts toward the next five
+	for (int i = 0; i < count; i++)
+	{
+		run = (bits[i] == last) ? (run + 1) : 1;
+		last = bits[i];
+		if (HB_STUFF_RUN == run)
+		{
+			stuffed++;
+			last ^= 1;
+			run = 1;
+		}
+	}
+	return((uint32_t)count + stuffed + HB_FRAME_TAIL_BITS);
+}
+
+// Lower wins: the arbitration field as it goes out, dominant 0
+static uint32_t hbArbitrationKey(const HS_CAN_FRAME *framePtr)
+{
+	uint32_t rtr = (true == framePtr->remote) ? 1 : 0;
+
+	if (true == framePtr->extended)
+	{
+		return(((framePtr->id >> 18) << 21) | (1UL << 20) | (1UL << 19) | ((framePtr->id & 0x3FFFF) << 1) | rtr);
+	}
+	return(((framePtr->id & 0x7FF) << 21) | (rtr << 20));		// IDE dominant
+}
+
+static bool hbSameFrame(const HS_CAN_FRAME *aPtr, const HS_CAN_FRAME *bPtr)
+{
+	return((aPtr->id == bPtr->id) && (aPtr->extended == bPtr->extended) && (aPtr->remote == bPtr->remote) &&
+			(aPtr->dlc == bPtr->dlc) && ((true == aPtr->remote) || (0 == memcmp(aPtr->data, bPtr->data, (8 < aPtr->dlc) ? 8 : aPtr->dlc))));
+}
+
+static void hbOutput(void *contextPtr, HN_NODE *nodePtr, const uint8_t *dataPtr, uint32_t length)
+{
+	HB_PORT *portPtr = (HB_PORT *)contextPtr;
+
+	if (NULL != portPtr->callbacks.uartOutputPtr)
+	{
+		portPtr->callbacks.uartOutputPtr(portPtr->callbacks.contextPtr, nodePtr, dataPtr, length);
+	}
+}
+
+static void hbTxRequest(void *contextPtr, HN_NODE *nodePtr)
+{
+	(void)nodePtr;
+	((HB_PORT *)contextPtr)->stale = true;
+}
+
+static void hbLatency(HB_BUS *busPtr, uint64_t queuedUs)
+{
+	uint64_t doneUs = busPtr->nowNs / HB_NS_PER_US;
+
+	if (busPtr->stats.latencyCount == busPtr->latencyCapacity)
+	{
+		busPtr->latencyCapacity = (0 == busPtr->latencyCapacity) ? 4096 : (busPtr->latencyCapacity * 2);
+		busPtr->latencyPtr = realloc(busPtr->latencyPtr, busPtr->latencyCapacity * sizeof(uint32_t));
+	}
+	busPtr->latencyPtr[busPtr->stats.latencyCount++] = (uint32_t)((doneUs > queuedUs) ? (doneUs - queuedUs) : 0);
+}
+
+// What the background sends next
+static void hbLoadFrame(HB_BUS *busPtr)
+{
+	busPtr->loadFrame.id = (HB_LOAD_SOURCE << 20) | (HB_LOAD_SOURCE << 11) | (busPtr->loadSequence++ & 0x3FF);
+	busPtr->loadFrame.extended = true;
+	busPtr->loadFrame.remote = false;
+	busPtr->loadFrame.dlc = HB_LOAD_DATA_BYTES;
+	for (int i = 0; i < HB_LOAD_DATA_BYTES; i++)
+	{
+		busPtr->loadFrame.data[i] = (uint8_t)hbRandom(busPtr);
+	}
+}
+
+// Evenly spread around the mean: no bursts beyond what arbitration makes
+static void hbLoadSchedule(HB_BUS *busPtr)
+{
+	busPtr->loadDueNs += hbRandom(busPtr) % ((2 * busPtr->loadMeanNs) + 1);
+}
+
+static void hbLoadArrivals(HB_BUS *busPtr)
+{
+	while ((0 != busPtr->config.loadPercent) && (busPtr->loadDueNs <= busPtr->nowNs))
+	{
+		if (0 == busPtr->loadPending++)
+		{
+			hbLoadFrame(busPtr);
+		}
+		hbLoadSchedule(busPtr);
+	}
+}
+
+// Bring a node up to the bus's time, running it if anything fell due
+static void hbCatchUp(HB_BUS *busPtr, HB_PORT *portPtr)
+{
+	if (portPtr->holdNs <= busPtr->nowNs)
+	{
+		HN_RunUntil(portPtr->nodePtr, busPtr->nowNs / HB_NS_PER_US);
+	}
+}
+
+// Every controller with something to send, at once
+static void hbArbitrate(HB_BUS *busPtr)
+{
+	uint32_t bestKey = 0;
+	bool any = false;
+	bool collision = false;
+	HS_CAN_STATE state;
+
+	for (int node = 0; node < busPtr->count; node++)
+	{
+		HB_PORT *portPtr = busPtr->portPtrs[node];
+
+		if (true == portPtr->stale)
+		{
+			portPtr->stale = false;
+			portPtr->ready = HN_CANTxNext(portPtr->nodePtr, &portPtr->frame, &portPtr->mailbox);
+			if (true == portPtr->ready)
+			{
+				portPtr->queuedUs = HN_CANTxQueuedUs(portPtr->nodePtr, portPtr->mailbox);
+			}
+		}
+		if ((true == portPtr->ready) && ((false == any) || (hbArbitrationKey(&portPtr->frame) < bestKey)))
+		{
+			bestKey = hbArbitrationKey(&portPtr->frame);
+			any = true;
+		}
+	}
+	if ((0 != busPtr->loadPending) && ((false == any) || (hbArbitrationKey(&busPtr->loadFrame) < bestKey)))
+	{
+		bestKey = hbArbitrationKey(&busPtr->loadFrame);
+		any = true;
+	}
+	if (false == any)
+	{
+		return;
+	}
+
+	busPtr->sender = -2;
+	for (int node = 0; node < busPtr->count; node++)
+	{
+		HB_PORT *portPtr = busPtr->portPtrs[node];
+
+		if (false == portPtr->ready)
+		{
+			continue;
+		}
+		if (bestKey != hbArbitrationKey(&portPtr->frame))
+		{
+			HN_CANTxResult(portPtr->nodePtr, portPtr->mailbox, HS_CAN_TX_ARBITRATION_LOST);
+			busPtr->stats.arbitrationLosses++;
+			continue;
+		}
+		if (-2 == busPtr->sender)
+		{
+			busPtr->sender = node;
+			busPtr->frame = portPtr->frame;
+		}
+		collision = collision || (false == hbSameFrame(&busPtr->frame, &portPtr->frame));
+		portPtr->sending = true;
+	}
+	busPtr->loadSending = ((0 != busPtr->loadPending) && (bestKey == hbArbitrationKey(&busPtr->loadFrame)));
+	if (true == busPtr->loadSending)
+	{
+		if (-2 == busPtr->sender)
+		{
+			busPtr->sender = -1;
+			busPtr->frame = busPtr->loadFrame;
+		}
+		collision = collision || (false == hbSameFrame(&busPtr->frame, &busPtr->loadFrame));
+	}
+	else if (0 != busPtr->loadPending)
+	{
+		busPtr->stats.arbitrationLosses++;
+	}
+
+	// Who will garble it and who will ACK it, as things stand at the SOF
+	busPtr->corrupt = collision || ((hbRandom(busPtr) % HB_PPM) < busPtr->config.lossPpm);
+	busPtr->acked = false;
+	for (int node = 0; node < busPtr->count; node++)
+	{
+		HB_PORT *portPtr = busPtr->portPtrs[node];
+
+		HN_CANState(portPtr->nodePtr, &state);
+		if ((false == state.onBus) || ((true == state.listenOnly) && (false == portPtr->sending)))
+		{
+			continue;
+		}
+		if (state.bitrate != busPtr->config.bitrate)
+		{
+			busPtr->corrupt = true;
+		}
+		else if (false == portPtr->sending)
+		{
+			busPtr->acked = true;
+		}
+	}
+
+	busPtr->bits = hbFrameBits(&busPtr->frame);
+	if ((true == busPtr->corrupt) || (false == busPtr->acked))
+	{
+		busPtr->bits += HB_ERROR_FRAME_BITS;
+	}
+	busPtr->endNs = busPtr->nowNs + hbBitsNs(busPtr, busPtr->bits);
+	busPtr->busy = true;
+}
+
+// The end of the frame on the wire
+static void hbFinish(HB_BUS *busPtr)
+{
+	bool good = (false == busPtr->corrupt) && (true == busPtr->acked);
+	HS_CAN_STATE state;
+
+	busPtr->busy = false;
+	busPtr->stats.bits += busPtr->bits;
+	busPtr->stats.busyUs += hbBitsNs(busPtr, busPtr->bits) / HB_NS_PER_US;
+	busPtr->stats.errorFrames += (true == busPtr->corrupt) ? 1 : 0;
+	busPtr->stats.noAcks += ((false == busPtr->corrupt) && (false == busPtr->acked)) ? 1 : 0;
+
+	for (int node = 0; node < busPtr->count; node++)
+	{
+		HB_PORT *portPtr = busPtr->portPtrs[node];
+		HS_CAN_RX rx;
+
+		if (true == portPtr->sending)
+		{
+			continue;
+		}
+		HN_CANState(portPtr->nodePtr, &state);
+		if (false == state.onBus)
+		{
+			continue;
+		}
+		// An error frame -- or, at another bitrate, nothing but errors
+		if ((false == good) || (state.bitrate != busPtr->config.bitrate))
+		{
+			hbCatchUp(busPtr, portPtr);
+			HN_CANBusError(portPtr->nodePtr);
+			continue;
+		}
+
+		rx = HN_CANAccepts(portPtr->nodePtr, &busPtr->frame);
+		if (HS_CAN_RX_NONE == rx)
+		{
+			continue;
+		}
+		hbCatchUp(busPtr, portPtr);
+		if (HS_CAN_RX_OVERRUN == rx)
+		{
+			busPtr->stats.overruns++;
+		}
+		if ((HS_CAN_RX_COUNT != rx) && (portPtr->holdNs <= busPtr->nowNs))
+		{
+			portPtr->holdNs = busPtr->nowNs + ((uint64_t)busPtr->config.serviceUs * HB_NS_PER_US);
+		}
+		HN_CANReceive(portPtr->nodePtr, &busPtr->frame);
+	}
+
+	for (int node = 0; node < busPtr->count; node++)
+	{
+		HB_PORT *portPtr = busPtr->portPtrs[node];
+
+		if (false == portPtr->sending)
+		{
+			continue;
+		}
+		if (true == good)
+		{
+			hbLatency(busPtr, portPtr->queuedUs);
+		}
+		portPtr->sending = false;
+		portPtr->stale = true;
+		HN_CANTxResult(portPtr->nodePtr, portPtr->mailbox, (true == good) ? HS_CAN_TX_OK : HS_CAN_TX_ERROR);
+	}
+	if ((true == busPtr->loadSending) && (true == good))
+	{
+		busPtr->stats.loadFrames++;
+		if (0 != --busPtr->loadPending)
+		{
+			hbLoadFrame(busPtr);
+		}
+	}
+	busPtr->loadSending = false;
+
+	if (true == good)
+	{
+		busPtr->stats.frames++;
+		busPtr->stats.payloadBytes += (true == busPtr->frame.remote) ? 0 : busPtr->frame.dlc;
+		if (NULL != busPtr->config.framePtr)
+		{
+			busPtr->config.framePtr(busPtr->config.contextPtr, busPtr->sender, &busPtr->frame);
+		}
+	}
+}
+
+static uint64_t hbNextNs(HB_BUS *busPtr)
+{
+	uint64_t nextNs = (true == busPtr->busy) ? busPtr->endNs : UINT64_MAX;
+
+	if ((0 != busPtr->config.loadPercent) && (busPtr->loadDueNs < nextNs))
+	{
+		nextNs = busPtr->loadDueNs;
+	}
+	for (int node = 0; node < busPtr->count; node++)
+	{
+		HB_PORT *portPtr = busPtr->portPtrs[node];
+		uint64_t wakeUs = HN_NextEventUs(portPtr->nodePtr);
+		uint64_t wakeNs;
+
+		if (UINT64_MAX == wakeUs)
+		{
+			continue;
+		}
+		wakeNs = wakeUs * HB_NS_PER_US;
+		if (wakeNs < portPtr->holdNs)
+		{
+			wakeNs = portPtr->holdNs;
+		}
+		if (wakeNs < nextNs)
+		{
+			nextNs = wakeNs;
+		}
+	}
+	return(nextNs);
+}
+
+HB_BUS *HB_Create(const HB_CONFIG *configPtr)
+{
+	HB_BUS *busPtr = calloc(1, sizeof(HB_BUS));
+
+	busPtr->config = *configPtr;
+	busPtr->random = ((uint64_t)configPtr->seed << 32) ^ 0x9E3779B97F4A7C15ULL;
+	HB_SetLoad(busPtr, configPtr->loadPercent);
+	return(busPtr);
+}
+
+// From now on; what has already arrived still goes out
+void HB_SetLoad(HB_BUS *busPtr, uint32_t loadPercent)
+{
+	HS_CAN_FRAME frame = busPtr->loadFrame;
+
+	busPtr->config.loadPercent = loadPercent;
+	if (0 != loadPercent)
+	{
+		hbLoadFrame(busPtr);
+		busPtr->loadMeanNs = (hbBitsNs(busPtr, hbFrameBits(&busPtr->loadFrame)) * 100) / loadPercent;
+		busPtr->loadDueNs = busPtr->nowNs;
+		hbLoadSchedule(busPtr);
+		busPtr->loadFrame = (0 != busPtr->loadPending) ? frame : busPtr->loadFrame;
+	}
+}
+
+void HB_Destroy(HB_BUS *busPtr)
+{
+	for (int node = 0; node < busPtr->count; node++)
+	{
+		HN_Destroy(busPtr->portPtrs[node]->nodePtr);
+		free(busPtr->portPtrs[node]);
+	}
+	free(busPtr->portPtrs);
+	free(busPtr->latencyPtr);
+	free(busPtr);
+}
+
+HN_NODE *HB_AddNode(HB_BUS *busPtr, const HN_CALLBACKS *callbacksPtr)
+{
+	HB_PORT *portPtr = calloc(1, sizeof(HB_PORT));
+	HN_CALLBACKS callbacks = {portPtr, hbOutput, hbTxRequest};
+
+	if (busPtr->count == busPtr->capacity)
+	{
+		busPtr->capacity = (0 == busPtr->capacity) ? 16 : (busPtr->capacity * 2);
+		busPtr->portPtrs = realloc(busPtr->portPtrs, (size_t)busPtr->capacity * sizeof(HB_PORT *));
+	}
+	portPtr->busPtr = busPtr;
+	portPtr->callbacks = *callbacksPtr;
+	portPtr->stale = true;
+	portPtr->nodePtr = HN_Create(&callbacks);
+	busPtr->portPtrs[busPtr->count++] = portPtr;
+	return(portPtr->nodePtr);
+}
+
+int HB_NodeCount(const HB_BUS *busPtr)
+{
+	return(busPtr->count);
+}
+
+HN_NODE *HB_Node(const HB_BUS *busPtr, int node)
+{
+	return(((0 <= node) && (node < busPtr->count)) ? busPtr->portPtrs[node]->nodePtr : NULL);
+}
+
+// Every node, from its reset vector, at the bus's time zero
+void HB_PowerOn(HB_BUS *busPtr)
+{
+	for (int node = 0; node < busPtr->count; node++)
+	{
+		HN_PowerOn(busPtr->portPtrs[node]->nodePtr);
+	}
+}
+
+void HB_RunUntil(HB_BUS *busPtr, uint64_t untilUs)
+{
+	uint64_t untilNs = untilUs * HB_NS_PER_US;
+	uint64_t nextNs;
+
+	for (;;)
+	{
+		hbLoadArrivals(busPtr);
+		for (int node = 0; node < busPtr->count; node++)
+		{
+			hbCatchUp(busPtr, busPtr->portPtrs[node]);
+		}
+		if ((true == busPtr->busy) && (busPtr->endNs <= busPtr->nowNs))
+		{
+			hbFinish(busPtr);
+			continue;						// the nodes it woke may answer in this very idle
+		}
+		if (false == busPtr->busy)
+		{
+			hbArbitrate(busPtr);
+		}
+
+		nextNs = hbNextNs(busPtr);
+		if (nextNs > untilNs)
+		{
+			break;
+		}
+		busPtr->nowNs = nextNs;
+	}
+
+	if (busPtr->nowNs < untilNs)
+	{
+		busPtr->nowNs = untilNs;
+	}
+	for (int node = 0; node < busPtr->count; node++)
+	{
+		hbCatchUp(busPtr, busPtr->portPtrs[node]);
+	}
+}
+
+uint64_t HB_Now(const HB_BUS *busPtr)
+{
+	return(busPtr->nowNs / HB_NS_PER_US);
+}
+
+static int hbCompare(const void *aPtr, const void *bPtr)
+{
+	uint32_t a = *(const uint32_t *)aPtr;
+	uint32_t b = *(const uint32_t *)bPtr;
+
+	return((a < b) ? -1 : ((a > b) ? 1 : 0));
+}
+
+void HB_Stats(const HB_BUS *busPtr, HB_STATS *statsPtr)
+{
+	uint64_t count = busPtr->stats.latencyCount;
+
+	*statsPtr = busPtr->stats;
+	statsPtr->elapsedUs = (busPtr->nowNs - busPtr->statsStartNs) / HB_NS_PER_US;
+	if (0 != count)
+	{
+		uint32_t *sortedPtr = malloc(count * sizeof(uint32_t));
+
+		memcpy(sortedPtr, busPtr->latencyPtr, count * sizeof(uint32_t));
+		qsort(sortedPtr, count, sizeof(uint32_t), hbCompare);
+		statsPtr->latencyP50Us = sortedPtr[((count - 1) * 50) / 100];
+		statsPtr->latencyP99Us = sortedPtr[((count - 1) * 99) / 100];
+		statsPtr->latencyMaxUs = sortedPtr[count - 1];
+		free(sortedPtr);
+	}
+}
+
+void HB_ClearStats(HB_BUS *busPtr)
+{
+	memset(&busPtr->stats, 0, sizeof(busPtr->stats));
+	busPtr->statsStartNs = busPtr->nowNs;
+}
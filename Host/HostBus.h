@@ -0,0 +1,92 @@
+/*
+ * HostBus.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef HOSTBUS_H_
+#define HOSTBUS_H_
+
+#include "HostNode.h"
+
+// A CAN bus of host nodes
+// =======================
+//
+// Any number of HN_NODEs on one wire, bit-timed in nanoseconds.  A frame takes
+// the bits ISO 11898 says it does -- stuffing and CRC-15 worked out from its
+// contents -- and who gets the bus is settled the way the wire settles it:
+// every controller with something to send starts together when the bus goes
+// idle, and the lowest identifier (dominant bits, so a data frame beats a
+// remote one, base beats extended) wins.  Losers try again at the next idle.
+// Two controllers sending the very same frame both succeed; the same
+// identifier with different contents is a bit error.
+//
+// Each node's own controller model (Shim/HostCAN.c) does the rest: its three
+// mailboxes and their priority, its 14 filter banks, its two 3-deep FIFOs and
+// what happens when one is full.  A node at another bitrate sees only errors,
+// and one that is not silent destroys every frame it hears.  A frame is
+// acknowledged if any other node on the bus at its bitrate and not silent
+// hears it; otherwise the sender sees an ACK error and tries again.
+//
+// The nodes run in no time at all (see HostNode.h), so without help a FIFO
+// would never fill.  serviceUs stands in for the receive interrupt's latency:
+// a node that has taken a frame is not run again until that long after, and
+// whatever else comes by meanwhile piles up in its FIFOs as it would.
+//
+// lossPpm corrupts that many frames in a million at random: an error frame
+// after it, an error to everyone, and the sender tries again.  loadPercent
+// adds background traffic from outside the fleet -- eight-byte frames that no
+// node's filters take, at random intervals averaging that share of the bus.
+
+#define HB_ERROR_FRAME_BITS		17			// 6 flag + 8 delimiter + 3 intermission
+#define HB_LOAD_SOURCE			0x1F0		// background: a source address no node answers to
+
+typedef struct _HB_BUS HB_BUS;
+
+typedef struct _HB_CONFIG
+{
+	uint32_t	bitrate;
+	uint32_t	lossPpm;
+	uint32_t	serviceUs;
+	uint32_t	loadPercent;
+	uint32_t	seed;
+	void		*contextPtr;
+	void		(*framePtr)(void *contextPtr, int node, const HS_CAN_FRAME *framePtr);	// every good frame; node -1 is the background
+} HB_CONFIG;
+
+typedef struct _HB_STATS
+{
+	uint64_t	elapsedUs;					// since the stats were last cleared
+	uint64_t	frames;						// good frames, background included
+	uint64_t	loadFrames;
+	uint64_t	payloadBytes;
+	uint64_t	bits;
+	uint64_t	busyUs;
+	uint64_t	arbitrationLosses;
+	uint64_t	errorFrames;
+	uint64_t	noAcks;
+	uint64_t	overruns;					// frames a full FIFO had no room for
+	uint64_t	latencyCount;				// nodes' frames: handed to the controller until the end of the frame
+	uint32_t	latencyP50Us;
+	uint32_t	latencyP99Us;
+	uint32_t	latencyMaxUs;
+} HB_STATS;
+
+HB_BUS *HB_Create(const HB_CONFIG *configPtr);
+void HB_Destroy(HB_BUS *busPtr);						// and its nodes
+
+// CALLBACKS' canTxRequestPtr is the bus's own and is ignored
+HN_NODE *HB_AddNode(HB_BUS *busPtr, const HN_CALLBACKS *callbacksPtr);
+int HB_NodeCount(const HB_BUS *busPtr);
+HN_NODE *HB_Node(const HB_BUS *busPtr, int node);
+
+void HB_PowerOn(HB_BUS *busPtr);
+void HB_RunUntil(HB_BUS *busPtr, uint64_t untilUs);
+uint64_t HB_Now(const HB_BUS *busPtr);
+void HB_SetLoad(HB_BUS *busPtr, uint32_t loadPercent);
+
+void HB_Stats(const HB_BUS *busPtr, HB_STATS *statsPtr);
+void HB_ClearStats(HB_BUS *busPtr);
+
+#endif /* HOSTBUS_H_ */
@@ -0,0 +1,747 @@
+/*
+ * HostNode.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * The host's side of a node: its memory, its time and its wires.
+ *
+ * The firmware reads flash, the system memory block and the peripherals at
+ * the part's own addresses, so those are mapped there -- one memfd per region
+ * per node, mapped in when the node is.  Its variables are the linker's:
+ * Host/fw_sections.ld gathers every firmware object's .data (with .ccmbss),
+ * .bss and .ccmnoinit into fw_data, fw_bss and fw_noinit, and switching nodes
+ * swaps those sections' contents.  A reset puts fw_data back as the program
+ * image had it, zeroes fw_bss and leaves fw_noinit alone, like the part.
+ *
+ * Switching is the expensive part, so what a bus asks of a node that is not
+ * running -- its CAN state, whether its filters take a frame, when it next
+ * wants the processor -- is answered without one: from a second, private
+ * mapping of its peripherals, and from the wake-up time its last run left.
+ */
+
+#define _GNU_SOURCE
+
+#include "HostNode.h"
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/personality.h>
+#include <unistd.h>
+
+#define HN_STACK_BYTES			(128 * 1024)		// host code (vsprintf) is hungrier than the part
+#define HN_STACKS				(HP_MAX_TASKS + 1)	// the last one is main()'s
+#define HN_INTERRUPT_LIMIT		256					// per wake-up: a storm, not a hang
+#define HN_FLASH_BASE			0x08000000UL
+#define HN_FLASH_BYTES			(512 * 1024)
+#define HN_FLASHSIZE_ADDRESS	0x1FFFF7CCUL		// FLASHSIZE_BASE: the size in K
+
+typedef enum _HN_REGION_ID
+{
+	HN_REGION_FLASH,
+	HN_REGION_SYSTEM,
+	HN_REGION_PERIPHERALS,
+	HN_REGION_GPIO,
+	HN_REGION_CORE,
+	HN_REGION_RCC_BITBAND,
+	HN_REGIONS
+} HN_REGION_ID;
+
+typedef struct _HN_REGION
+{
+	uintptr_t	base;
+	size_t		bytes;
+	bool		survivesReset;
+} HN_REGION;
+
+typedef enum _HN_STATE
+{
+	HN_STATE_OFF,
+	HN_STATE_IDLE,							// wakes at the next tick
+	HN_STATE_SLEEP							// wakes when the tickless sleep ends
+} HN_STATE;
+
+struct _HN_NODE
+{
+	HN_CALLBACKS	callbacks;
+	int				regionFd[HN_REGIONS];
+	uint8_t			*peripheralsPtr;		// the host's own view of the peripherals, loaded or not
+	uint8_t			*dataPtr;				// this node's fw_data/fw_bss/fw_noinit while it is not loaded
+	uint8_t			*bssPtr;
+	uint8_t			*noinitPtr;
+	uint8_t			*stacksPtr;
+	ucontext_t		hostContext;
+	ucontext_t		bootContext;
+	jmp_buf			resetJump;
+
+	HN_STATE		state;
+	bool			kick;					// an input is waiting for the interrupts to run
+	uint64_t		nowUs;
+	uint64_t		wakeUs;					// hnWakeUs() as the last run left it
+	bool			wakeKnown;
+	uint64_t		nextTickUs;
+	uint64_t		sleepTickUs;			// the first tick of the sleep
+	uint32_t		sleepTicks;
+	uint32_t		resets;
+	uint32_t		flashErases;			// pages, since it was created
+	HS_RESET		lastReset;
+
+	uint8_t			*uartInPtr;
+	uint32_t		uartInSize;
+	uint32_t		uartInHead;
+	uint32_t		uartInTail;
+	uint64_t		uartStartUs;			// first byte of the current burst went at
+	uint32_t		uartSent;				// bytes of it so far
+	bool			uartIdlePending;
+	uint32_t		uartDropped;
+};
+
+// fw_sections.ld
+extern uint8_t __start_fw_data[] __attribute__((weak));
+extern uint8_t __stop_fw_data[] __attribute__((weak));
+extern uint8_t __start_fw_bss[] __attribute__((weak));
+extern uint8_t __stop_fw_bss[] __attribute__((weak));
+extern uint8_t __start_fw_noinit[] __attribute__((weak));
+extern uint8_t __stop_fw_noinit[] __attribute__((weak));
+
+static const HN_REGION hnRegions[HN_REGIONS] =
+{
+	{HN_FLASH_BASE,	HN_FLASH_BYTES,	true},		// FLASH_BASE
+	{0x1FFFF000UL,	0x1000,			true},		// system memory: UID, FLASHSIZE
+	{0x40000000UL,	0x25000,		false},		// APB1, APB2, AHB1 (DMA1, RCC, FLASH)
+	{0x48000000UL,	0x2000,			false},		// AHB2: GPIOA..F
+	{0xE0000000UL,	0x43000,		false},		// PPB: DWT, SysTick, NVIC, SCB, DBGMCU
+	{0x42420000UL,	0x8000,			false},		// RCC's bit-band alias: __HAL_RCC_CLEAR_RESET_FLAGS()
+};
+
+static HN_NODE	*hnLoadedPtr = NULL;
+static uint8_t	*hnPristinePtr = NULL;			// fw_data as the program image has it
+
+static size_t hnDataBytes(void)
+{
+	return((size_t)(__stop_fw_data - __start_fw_data));
+}
+
+static size_t hnBssBytes(void)
+{
+	return((size_t)(__stop_fw_bss - __start_fw_bss));
+}
+
+static size_t hnNoinitBytes(void)
+{
+	return((size_t)(__stop_fw_noinit - __start_fw_noinit));
+}
+
+static void hnFail(const char *whatPtr)
+{
+	perror(whatPtr);
+	abort();
+}
+
+// The part's addresses, claimed before main() -- and so before malloc(), the
+// task stacks (below 2G too) and the bus have taken any of the low 4G.  What
+// can still be there is what the loader put at a random address: if that hit
+// one of them, run the program again with the layout fixed, so a clash is
+// either never or every time, not one run in a hundred
+__attribute__((constructor))
+static void hnReserve(int argc, char **argv)
+{
+	int persona = personality(0xFFFFFFFF);
+
+	(void)argc;
+	for (int region = 0; region < HN_REGIONS; region++)
+	{
+		void *addressPtr = (void *)hnRegions[region].base;
+
+		if (addressPtr != mmap(addressPtr, hnRegions[region].bytes, PROT_NONE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0))
+		{
+			if ((0 <= persona) && (0 == (persona & ADDR_NO_RANDOMIZE)) && (NULL != argv)
+					&& (0 <= personality((unsigned long)persona | ADDR_NO_RANDOMIZE)))
+			{
+				execv("/proc/self/exe", argv);
+			}
+			hnFail("HostNode: reserving the part's address space");
+		}
+	}
+}
+
+static void hnMap(HN_NODE *nodePtr)
+{
+	for (int region = 0; region < HN_REGIONS; region++)
+	{
+		void *addressPtr = (void *)hnRegions[region].base;
+
+		if (addressPtr != mmap(addressPtr, hnRegions[region].bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+				nodePtr->regionFd[region], 0))
+		{
+			hnFail("HostNode: mapping the part's address space");
+		}
+	}
+}
+
+// Make NODE the one whose memory the firmware sees
+static void hnSelect(HN_NODE *nodePtr)
+{
+	HN_NODE *loadedPtr = hnLoadedPtr;
+
+	if (loadedPtr == nodePtr)
+	{
+		return;
+	}
+	if (NULL != loadedPtr)
+	{
+		memcpy(loadedPtr->dataPtr, __start_fw_data, hnDataBytes());
+		memcpy(loadedPtr->bssPtr, __start_fw_bss, hnBssBytes());
+		memcpy(loadedPtr->noinitPtr, __start_fw_noinit, hnNoinitBytes());
+	}
+	hnMap(nodePtr);
+	memcpy(__start_fw_data, nodePtr->dataPtr, hnDataBytes());
+	memcpy(__start_fw_bss, nodePtr->bssPtr, hnBssBytes());
+	memcpy(__start_fw_noinit, nodePtr->noinitPtr, hnNoinitBytes());
+	hnLoadedPtr = nodePtr;
+}
+
+HN_NODE *HN_Create(const HN_CALLBACKS *callbacksPtr)
+{
+	HN_NODE *nodePtr = calloc(1, sizeof(HN_NODE));
+	uint8_t *flashPtr;
+
+	if (NULL == hnPristinePtr)
+	{
+		hnPristinePtr = malloc(hnDataBytes() + 1);
+		memcpy(hnPristinePtr, __start_fw_data, hnDataBytes());
+	}
+
+	nodePtr->callbacks = *callbacksPtr;
+	nodePtr->dataPtr = malloc(hnDataBytes() + 1);
+	nodePtr->bssPtr = calloc(1, hnBssBytes() + 1);
+	nodePtr->noinitPtr = calloc(1, hnNoinitBytes() + 1);
+	memcpy(nodePtr->dataPtr, hnPristinePtr, hnDataBytes());
+
+	// Below 2G: the firmware keeps addresses in uint32_t now and then
+	nodePtr->stacksPtr = mmap(NULL, (size_t)HN_STACKS * HN_STACK_BYTES, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT | MAP_NORESERVE, -1, 0);
+	if (MAP_FAILED == nodePtr->stacksPtr)
+	{
+		hnFail("HostNode: task stacks");
+	}
+
+	for (int region = 0; region < HN_REGIONS; region++)
+	{
+		nodePtr->regionFd[region] = memfd_create("HostNode", 0);
+		if ((0 > nodePtr->regionFd[region]) || (0 != ftruncate(nodePtr->regionFd[region], (off_t)hnRegions[region].bytes)))
+		{
+			hnFail("HostNode: memfd");
+		}
+	}
+
+	nodePtr->peripheralsPtr = mmap(NULL, hnRegions[HN_REGION_PERIPHERALS].bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+			nodePtr->regionFd[HN_REGION_PERIPHERALS], 0);
+	if (MAP_FAILED == nodePtr->peripheralsPtr)
+	{
+		hnFail("HostNode: peripheral view");
+	}
+
+	// An erased part
+	flashPtr = mmap(NULL, HN_FLASH_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, nodePtr->regionFd[HN_REGION_FLASH], 0);
+	memset(flashPtr, 0xFF, HN_FLASH_BYTES);
+	munmap(flashPtr, HN_FLASH_BYTES);
+	if ((sizeof(uint16_t) != pwrite(nodePtr->regionFd[HN_REGION_SYSTEM], &(uint16_t){HN_FLASH_BYTES / 1024},
+			sizeof(uint16_t), (off_t)(HN_FLASHSIZE_ADDRESS - hnRegions[HN_REGION_SYSTEM].base))))
+	{
+		hnFail("HostNode: FLASHSIZE");
+	}
+
+	nodePtr->state = HN_STATE_OFF;
+	return(nodePtr);
+}
+
+void HN_Destroy(HN_NODE *nodePtr)
+{
+	if (hnLoadedPtr == nodePtr)
+	{
+		hnLoadedPtr = NULL;
+	}
+	for (int region = 0; region < HN_REGIONS; region++)
+	{
+		close(nodePtr->regionFd[region]);
+	}
+	munmap(nodePtr->stacksPtr, (size_t)HN_STACKS * HN_STACK_BYTES);
+	munmap(nodePtr->peripheralsPtr, hnRegions[HN_REGION_PERIPHERALS].bytes);
+	free(nodePtr->dataPtr);
+	free(nodePtr->bssPtr);
+	free(nodePtr->noinitPtr);
+	free(nodePtr->uartInPtr);
+	free(nodePtr);
+}
+
+// Start the node from its reset vector and run it until it first goes idle
+static void hnReset(HN_NODE *nodePtr, HS_RESET reason)
+{
+	memcpy(__start_fw_data, hnPristinePtr, hnDataBytes());
+	memset(__start_fw_bss, 0, hnBssBytes());
+	for (int region = 0; region < HN_REGIONS; region++)
+	{
+		if (false == hnRegions[region].survivesReset)
+		{
+			memset((void *)hnRegions[region].base, 0, hnRegions[region].bytes);
+		}
+	}
+
+	nodePtr->resets++;
+	nodePtr->lastReset = reason;
+	nodePtr->kick = false;
+	nodePtr->nextTickUs = nodePtr->nowUs + HN_TICK_US;
+	nodePtr->uartInHead = nodePtr->uartInTail;		// nobody is listening for the rest
+	nodePtr->uartSent = 0;
+	nodePtr->uartIdlePending = false;
+
+	HS_PowerOn(reason);
+	HS_Sync(nodePtr->nowUs);
+	getcontext(&nodePtr->bootContext);
+	nodePtr->bootContext.uc_stack.ss_sp = nodePtr->stacksPtr + ((size_t)HP_MAX_TASKS * HN_STACK_BYTES);
+	nodePtr->bootContext.uc_stack.ss_size = HN_STACK_BYTES;
+	nodePtr->bootContext.uc_link = NULL;
+	makecontext(&nodePtr->bootContext, HS_Main, 0);
+	HP_Boot(&nodePtr->bootContext);
+}
+
+// What the node did when it last gave the processor back
+static void hnYielded(HN_NODE *nodePtr)
+{
+	switch (HP_Reason())
+	{
+	case HP_YIELD_SLEEP:
+		nodePtr->state = HN_STATE_SLEEP;
+		nodePtr->sleepTicks = HP_SleepTicks();
+		nodePtr->sleepTickUs = nodePtr->nextTickUs;
+		break;
+
+	case HP_YIELD_RESET:
+		hnReset(nodePtr, HS_RESET_SOFTWARE);
+		hnYielded(nodePtr);
+		break;
+
+	default:
+		nodePtr->state = HN_STATE_IDLE;
+		break;
+	}
+}
+
+static uint64_t hnUartCharUs(uint32_t count)
+{
+	uint32_t baud = HS_UARTBaud();
+
+	return((0 == baud) ? UINT64_MAX : (((uint64_t)count * 10 * 1000000) / baud));
+}
+
+// RTS holds the host off until it drops, and the line goes idle meanwhile
+static uint64_t hnUartNextUs(HN_NODE *nodePtr)
+{
+	if ((nodePtr->uartInHead != nodePtr->uartInTail) && (false == HS_UARTHeldOff()))
+	{
+		return((0 == nodePtr->uartSent) ? nodePtr->nowUs : (nodePtr->uartStartUs + hnUartCharUs(nodePtr->uartSent)));
+	}
+	if (true == nodePtr->uartIdlePending)
+	{
+		return(nodePtr->uartStartUs + hnUartCharUs(nodePtr->uartSent + 1));
+	}
+	return(UINT64_MAX);
+}
+
+static uint64_t hnWakeUs(HN_NODE *nodePtr)
+{
+	uint64_t wakeUs;
+	uint64_t eventUs;
+
+	if (HN_STATE_OFF == nodePtr->state)
+	{
+		return(UINT64_MAX);
+	}
+	if (true == nodePtr->kick)
+	{
+		return(nodePtr->nowUs);
+	}
+
+	if (HN_STATE_SLEEP == nodePtr->state)
+	{
+		wakeUs = nodePtr->sleepTickUs + ((uint64_t)(nodePtr->sleepTicks - 1) * HN_TICK_US);
+	}
+	else
+	{
+		wakeUs = nodePtr->nextTickUs;
+	}
+	eventUs = HS_NextEventUs();
+	if (eventUs < wakeUs)
+	{
+		wakeUs = eventUs;
+	}
+	eventUs = hnUartNextUs(nodePtr);
+	if (eventUs < wakeUs)
+	{
+		wakeUs = eventUs;
+	}
+	return((wakeUs < nodePtr->nowUs) ? nodePtr->nowUs : wakeUs);
+}
+
+// Bytes whose time has come, one character time apart, then the idle line
+static void hnUartDeliver(HN_NODE *nodePtr)
+{
+	while ((nodePtr->uartInHead != nodePtr->uartInTail) && (false == HS_UARTHeldOff()))
+	{
+		if (0 == nodePtr->uartSent)
+		{
+			nodePtr->uartStartUs = nodePtr->nowUs;
+		}
+		else if ((nodePtr->uartStartUs + hnUartCharUs(nodePtr->uartSent)) > nodePtr->nowUs)
+		{
+			return;
+		}
+
+		if (0 == HS_UARTReceive(&nodePtr->uartInPtr[nodePtr->uartInTail], 1))
+		{
+			nodePtr->uartDropped++;		// nobody listening: an overrun on the part
+		}
+		nodePtr->uartInTail = (nodePtr->uartInTail + 1) % nodePtr->uartInSize;
+		nodePtr->uartSent++;
+		nodePtr->uartIdlePending = true;
+	}
+
+	// Out of bytes or held off: a new burst starts from the next one
+	if (((nodePtr->uartInHead == nodePtr->uartInTail) || (true == HS_UARTHeldOff())) && (true == nodePtr->uartIdlePending) &&
+		((nodePtr->uartStartUs + hnUartCharUs(nodePtr->uartSent + 1)) <= nodePtr->nowUs))
+	{
+		HS_UARTLineIdle();
+		nodePtr->uartIdlePending = false;
+		nodePtr->uartSent = 0;
+	}
+}
+
+// The ticks due by now: one at a time while idle, in one step out of a sleep
+static void hnTicks(HN_NODE *nodePtr)
+{
+	uint32_t passed;
+
+	if (HN_STATE_SLEEP == nodePtr->state)
+	{
+		passed = (nodePtr->nowUs < nodePtr->sleepTickUs) ? 0 : (uint32_t)(((nodePtr->nowUs - nodePtr->sleepTickUs) / HN_TICK_US) + 1);
+		if (passed >= nodePtr->sleepTicks)
+		{
+			// The last one is a real tick, so it is the kernel's tick that unblocks
+			passed = nodePtr->sleepTicks;
+			HP_StepTicks(passed - 1);
+			HS_Tick();
+		}
+		else if (0 != passed)
+		{
+			HP_StepTicks(passed);
+		}
+		nodePtr->nextTickUs = nodePtr->sleepTickUs + ((uint64_t)passed * HN_TICK_US);
+		nodePtr->state = HN_STATE_IDLE;
+		return;
+	}
+
+	while (nodePtr->nextTickUs <= nodePtr->nowUs)
+	{
+		HS_Tick();
+		nodePtr->nextTickUs += HN_TICK_US;
+	}
+}
+
+static void hnRun(HN_NODE *nodePtr, uint64_t untilUs)
+{
+	uint64_t wakeUs;
+
+	if (0 != setjmp(nodePtr->resetJump))
+	{
+		hnReset(nodePtr, HS_RESET_SOFTWARE);	// from an interrupt handler
+		hnYielded(nodePtr);
+	}
+
+	while ((wakeUs = hnWakeUs(nodePtr)) <= untilUs)
+	{
+		nodePtr->nowUs = wakeUs;
+		nodePtr->kick = false;
+		if (true == HS_Sync(wakeUs))
+		{
+			hnReset(nodePtr, HS_RESET_WATCHDOG);
+			hnYielded(nodePtr);
+			continue;
+		}
+		hnUartDeliver(nodePtr);
+		hnTicks(nodePtr);
+
+		for (int count = 0; (count < HN_INTERRUPT_LIMIT) && (true == HS_Interrupts()); count++)
+		{
+		}
+		HP_Resume();
+		hnYielded(nodePtr);
+	}
+	if ((HN_STATE_OFF != nodePtr->state) && (nodePtr->nowUs < untilUs))
+	{
+		nodePtr->nowUs = untilUs;
+	}
+	nodePtr->wakeUs = wakeUs;
+	nodePtr->wakeKnown = true;
+}
+
+// An input: the node wants the processor now
+static void hnKick(HN_NODE *nodePtr)
+{
+	nodePtr->kick = true;
+	nodePtr->wakeUs = nodePtr->nowUs;
+	nodePtr->wakeKnown = true;
+}
+
+void HN_PowerOn(HN_NODE *nodePtr)
+{
+	hnSelect(nodePtr);
+	nodePtr->resets = 0;
+	hnReset(nodePtr, HS_RESET_POWER);
+	nodePtr->resets = 0;
+	hnYielded(nodePtr);
+	nodePtr->wakeUs = hnWakeUs(nodePtr);
+	nodePtr->wakeKnown = true;
+}
+
+void HN_RunUntil(HN_NODE *nodePtr, uint64_t untilUs)
+{
+	// Nothing due: time passes without the node
+	if ((true == nodePtr->wakeKnown) && (nodePtr->wakeUs > untilUs))
+	{
+		if ((HN_STATE_OFF != nodePtr->state) && (nodePtr->nowUs < untilUs))
+		{
+			nodePtr->nowUs = untilUs;
+		}
+		return;
+	}
+	hnSelect(nodePtr);
+	hnRun(nodePtr, untilUs);
+}
+
+uint64_t HN_Now(const HN_NODE *nodePtr)
+{
+	return(nodePtr->nowUs);
+}
+
+uint64_t HN_NextEventUs(HN_NODE *nodePtr)
+{
+	if (false == nodePtr->wakeKnown)
+	{
+		hnSelect(nodePtr);
+		nodePtr->wakeUs = hnWakeUs(nodePtr);
+		nodePtr->wakeKnown = true;
+	}
+	return(nodePtr->wakeUs);
+}
+
+uint32_t HN_ResetCount(const HN_NODE *nodePtr)
+{
+	return(nodePtr->resets);
+}
+
+HS_RESET HN_LastReset(const HN_NODE *nodePtr)
+{
+	return(nodePtr->lastReset);
+}
+
+void HN_UARTSend(HN_NODE *nodePtr, const void *dataPtr, uint32_t length)
+{
+	const uint8_t *bytePtr = dataPtr;
+	uint32_t used = (nodePtr->uartInHead + nodePtr->uartInSize - nodePtr->uartInTail) % ((0 == nodePtr->uartInSize) ? 1 : nodePtr->uartInSize);
+
+	if ((used + length + 1) > nodePtr->uartInSize)
+	{
+		uint32_t size = (used + length + 1) * 2;
+		uint8_t *bufferPtr = malloc(size);
+
+		for (uint32_t i = 0; i < used; i++)
+		{
+			bufferPtr[i] = nodePtr->uartInPtr[(nodePtr->uartInTail + i) % nodePtr->uartInSize];
+		}
+		free(nodePtr->uartInPtr);
+		nodePtr->uartInPtr = bufferPtr;
+		nodePtr->uartInSize = size;
+		nodePtr->uartInTail = 0;
+		nodePtr->uartInHead = used;
+	}
+
+	for (uint32_t i = 0; i < length; i++)
+	{
+		nodePtr->uartInPtr[nodePtr->uartInHead] = bytePtr[i];
+		nodePtr->uartInHead = (nodePtr->uartInHead + 1) % nodePtr->uartInSize;
+	}
+	nodePtr->wakeKnown = false;
+}
+
+uint32_t HN_UARTDropped(const HN_NODE *nodePtr)
+{
+	return(nodePtr->uartDropped);
+}
+
+bool HN_CANTxNext(HN_NODE *nodePtr, HS_CAN_FRAME *framePtr, int *mailboxPtr)
+{
+	hnSelect(nodePtr);
+	HS_Sync(nodePtr->nowUs);
+	nodePtr->wakeKnown = false;
+	return(HS_CANTxNext(framePtr, mailboxPtr));
+}
+
+uint64_t HN_CANTxQueuedUs(HN_NODE *nodePtr, int mailbox)
+{
+	hnSelect(nodePtr);
+	return(HS_CANTxQueuedUs(mailbox));
+}
+
+void HN_CANTxResult(HN_NODE *nodePtr, int mailbox, HS_CAN_RESULT result)
+{
+	// Losing arbitration is a status bit and no interrupt: no need to load it
+	if ((HS_CAN_TX_ARBITRATION_LOST == result) && (true == HS_CANArbitrationLost(nodePtr->peripheralsPtr, mailbox)))
+	{
+		return;
+	}
+	hnSelect(nodePtr);
+	HS_CANTxResult(mailbox, result);
+	hnKick(nodePtr);
+}
+
+bool HN_CANReceive(HN_NODE *nodePtr, const HS_CAN_FRAME *framePtr)
+{
+	hnSelect(nodePtr);
+	hnKick(nodePtr);
+	return(HS_CANReceive(framePtr));
+}
+
+void HN_CANBusError(HN_NODE *nodePtr)
+{
+	hnSelect(nodePtr);
+	HS_CANBusError();
+	hnKick(nodePtr);
+}
+
+HS_CAN_RX HN_CANAccepts(const HN_NODE *nodePtr, const HS_CAN_FRAME *framePtr)
+{
+	return(HS_CANAccepts(nodePtr->peripheralsPtr, framePtr));
+}
+
+void HN_CANState(const HN_NODE *nodePtr, HS_CAN_STATE *statePtr)
+{
+	HS_CANState(nodePtr->peripheralsPtr, statePtr);
+}
+
+uint32_t HN_CANBitrate(const HN_NODE *nodePtr)
+{
+	HS_CAN_STATE state;
+
+	HS_CANState(nodePtr->peripheralsPtr, &state);
+	return(state.bitrate);
+}
+
+bool HN_CANOnBus(HN_NODE *nodePtr)
+{
+	HS_CAN_STATE state;
+
+	hnSelect(nodePtr);
+	HS_Sync(nodePtr->nowUs);				// a bus-off recovery may have run out
+	HS_CANState(nodePtr->peripheralsPtr, &state);
+	return(state.onBus);
+}
+
+void HN_Button(HN_NODE *nodePtr, bool pressed)
+{
+	hnSelect(nodePtr);
+	HS_Button(pressed);
+	hnKick(nodePtr);
+}
+
+bool HN_LED(HN_NODE *nodePtr)
+{
+	hnSelect(nodePtr);
+	return(HS_LED());
+}
+
+// What the node has programmed at ADDRESS, without running it
+bool HN_ReadFlash(const HN_NODE *nodePtr, uint32_t address, void *dataPtr, uint32_t length)
+{
+	if ((address < HN_FLASH_BASE) || ((address - HN_FLASH_BASE) + (uint64_t)length > HN_FLASH_BYTES))
+	{
+		return(false);
+	}
+	return((ssize_t)length == pread(nodePtr->regionFd[HN_REGION_FLASH], dataPtr, length, (off_t)(address - HN_FLASH_BASE)));
+}
+
+// Programmed the way the part programs it: bits only go from 1 to 0
+bool HN_WriteFlash(HN_NODE *nodePtr, uint32_t address, const void *dataPtr, uint32_t length)
+{
+	uint8_t *flashPtr;
+	const uint8_t *bytePtr = (const uint8_t *)dataPtr;
+
+	if ((address < HN_FLASH_BASE) || ((address - HN_FLASH_BASE) + (uint64_t)length > HN_FLASH_BYTES))
+	{
+		return(false);
+	}
+	flashPtr = mmap(NULL, HN_FLASH_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, nodePtr->regionFd[HN_REGION_FLASH], 0);
+	if (MAP_FAILED == flashPtr)
+	{
+		return(false);
+	}
+	for (uint32_t i = 0; i < length; i++)
+	{
+		flashPtr[(address - HN_FLASH_BASE) + i] &= bytePtr[i];
+	}
+	munmap(flashPtr, HN_FLASH_BYTES);
+	return(true);
+}
+
+uint32_t HN_FlashErases(const HN_NODE *nodePtr)
+{
+	return(nodePtr->flashErases);
+}
+
+// Called from inside the node
+
+ucontext_t *HN_HostContext(void)
+{
+	return(&hnLoadedPtr->hostContext);
+}
+
+void *HN_TaskStack(uint32_t slot, size_t *sizePtr)
+{
+	*sizePtr = HN_STACK_BYTES;
+	return(hnLoadedPtr->stacksPtr + ((size_t)slot * HN_STACK_BYTES));
+}
+
+uint64_t HN_NowUs(void)
+{
+	return(hnLoadedPtr->nowUs);
+}
+
+void HN_UARTOutput(const uint8_t *dataPtr, uint32_t length)
+{
+	if (NULL != hnLoadedPtr->callbacks.uartOutputPtr)
+	{
+		hnLoadedPtr->callbacks.uartOutputPtr(hnLoadedPtr->callbacks.contextPtr, hnLoadedPtr, dataPtr, length);
+	}
+}
+
+void HN_FlashErased(void)
+{
+	hnLoadedPtr->flashErases++;
+}
+
+void HN_CANTxRequest(void)
+{
+	if (NULL != hnLoadedPtr->callbacks.canTxRequestPtr)
+	{
+		hnLoadedPtr->callbacks.canTxRequestPtr(hnLoadedPtr->callbacks.contextPtr, hnLoadedPtr);
+	}
+}
+
+void HN_ResetFromInterrupt(void)
+{
+	longjmp(hnLoadedPtr->resetJump, 1);
+}
@@ -0,0 +1,75 @@
+/*
+ * HostNode.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef HOSTNODE_H_
+#define HOSTNODE_H_
+
+#include "HostShim.h"
+
+// A node on the host
+// ==================
+//
+// The whole firmware -- main(), the FreeRTOS kernel, every task and module --
+// built for the host against Shim/ and run on virtual time.  Each HN_NODE has
+// its own flash, peripherals and copy of the firmware's .data/.bss, so any
+// number of them can share one process; only one runs at a time.
+//
+// A node runs until it has nothing left to do (all tasks blocked), in no
+// virtual time at all: the figures out of the host build are about what the
+// code does and how long the host takes to do it, not about the part's clock.
+// HN_RunUntil() moves its time forward tick by tick -- or straight to the end
+// of a tickless sleep -- taking whatever interrupts fall due on the way.
+//
+// Inputs (UART bytes, CAN frames, the button) take effect at the node's
+// current time: run it up to the moment first.  The callbacks are made from
+// inside the node and must not call back into any node.
+//
+// Taking turns costs a swap of the firmware's variables and mappings, so the
+// calls a bus makes of every node for every frame -- HN_CANState(),
+// HN_CANAccepts(), HN_NextEventUs(), losing arbitration, HN_RunUntil() with
+// nothing due -- do without one.  Host/HostBus.h is such a bus.
+
+#define HN_TICK_US				1000		// configTICK_RATE_HZ
+
+typedef struct _HN_NODE HN_NODE;
+
+typedef struct _HN_CALLBACKS
+{
+	void	*contextPtr;
+	void	(*uartOutputPtr)(void *contextPtr, HN_NODE *nodePtr, const uint8_t *dataPtr, uint32_t length);
+	void	(*canTxRequestPtr)(void *contextPtr, HN_NODE *nodePtr);		// what it would send may have changed
+} HN_CALLBACKS;
+
+HN_NODE *HN_Create(const HN_CALLBACKS *callbacksPtr);
+void HN_Destroy(HN_NODE *nodePtr);
+void HN_PowerOn(HN_NODE *nodePtr);
+void HN_RunUntil(HN_NODE *nodePtr, uint64_t untilUs);
+uint64_t HN_Now(const HN_NODE *nodePtr);
+uint64_t HN_NextEventUs(HN_NODE *nodePtr);
+uint32_t HN_ResetCount(const HN_NODE *nodePtr);
+HS_RESET HN_LastReset(const HN_NODE *nodePtr);
+
+void HN_UARTSend(HN_NODE *nodePtr, const void *dataPtr, uint32_t length);
+uint32_t HN_UARTDropped(const HN_NODE *nodePtr);
+
+bool HN_CANTxNext(HN_NODE *nodePtr, HS_CAN_FRAME *framePtr, int *mailboxPtr);
+uint64_t HN_CANTxQueuedUs(HN_NODE *nodePtr, int mailbox);		// when the firmware handed it over
+void HN_CANTxResult(HN_NODE *nodePtr, int mailbox, HS_CAN_RESULT result);
+bool HN_CANReceive(HN_NODE *nodePtr, const HS_CAN_FRAME *framePtr);
+void HN_CANBusError(HN_NODE *nodePtr);
+HS_CAN_RX HN_CANAccepts(const HN_NODE *nodePtr, const HS_CAN_FRAME *framePtr);
+void HN_CANState(const HN_NODE *nodePtr, HS_CAN_STATE *statePtr);
+uint32_t HN_CANBitrate(const HN_NODE *nodePtr);
+bool HN_CANOnBus(HN_NODE *nodePtr);
+
+void HN_Button(HN_NODE *nodePtr, bool pressed);
+bool HN_LED(HN_NODE *nodePtr);
+bool HN_ReadFlash(const HN_NODE *nodePtr, uint32_t address, void *dataPtr, uint32_t length);
+bool HN_WriteFlash(HN_NODE *nodePtr, uint32_t address, const void *dataPtr, uint32_t length);
+uint32_t HN_FlashErases(const HN_NODE *nodePtr);			// pages the node has erased
+
+#endif /* HOSTNODE_H_ */
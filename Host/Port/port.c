@@ -0,0 +1,269 @@
+/*
+ * port.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * FreeRTOS port for the host build.
+ *
+ * Every task runs on a ucontext of its own with a host sized stack from
+ * HN_TaskStack() -- the stack freertos.c hands the kernel is only used to
+ * hold the slot number, in its top word, where the TCB's pxTopOfStack points.
+ * One task runs at a time and a switch is a swapcontext() done by the task
+ * giving up the processor, so the kernel's view (pxCurrentTCB, the ready
+ * lists, the critical nesting) is exactly what it is on the part.
+ *
+ * Nothing interrupts a running task.  The host gets control back when the
+ * idle task would sleep (portSUPPRESS_TICKS_AND_SLEEP) or has looped once
+ * with nothing to do, and only then runs ticks and interrupts -- on its own
+ * context, with HP_Ipsr() saying which, so the FromISR paths are the ones
+ * taken.  A switch those ask for happens when the host resumes the node.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "HostShim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct _HP_TASK
+{
+	ucontext_t		context;
+	TaskFunction_t	code;
+	void			*paramsPtr;
+} HP_TASK;
+
+extern void * volatile pxCurrentTCB;
+
+static HP_TASK				hpTasks[HP_MAX_TASKS];
+static uint32_t				hpTaskCount = 0;
+static ucontext_t			*hpRunningPtr = NULL;		// NULL: the host has the processor
+static volatile UBaseType_t	uxCriticalNesting = 0;
+static volatile bool		hpYieldPending = false;
+static volatile uint32_t	hpIpsr = 0;
+static HP_YIELD				hpReason = HP_YIELD_IDLE;
+static TickType_t			hpSleepTicks = 0;
+static bool					hpIdlePassed = false;
+static bool					hpStarted = false;
+
+static HP_TASK *hpCurrent(void)
+{
+	StackType_t *slotPtr = *(StackType_t **)pxCurrentTCB;
+
+	return(&hpTasks[*slotPtr]);
+}
+
+static void hpTaskEntry(void)
+{
+	HP_TASK *taskPtr = hpCurrent();
+
+	taskPtr->code(taskPtr->paramsPtr);
+	vPortAssertFailed(__FILE__, __LINE__);		// tasks never return
+}
+
+// Give the processor back to the host from whatever the node is running
+static void hpToHost(HP_YIELD reason)
+{
+	ucontext_t *fromPtr = hpRunningPtr;
+
+	hpReason = reason;
+	hpRunningPtr = NULL;
+	swapcontext(fromPtr, HN_HostContext());
+	hpRunningPtr = fromPtr;
+}
+
+static void hpSwitch(void)
+{
+	HP_TASK *fromPtr = hpCurrent();
+	HP_TASK *toPtr;
+
+	hpYieldPending = false;
+	vTaskSwitchContext();
+	toPtr = hpCurrent();
+	if (fromPtr != toPtr)
+	{
+		hpRunningPtr = &toPtr->context;
+		swapcontext(&fromPtr->context, &toPtr->context);
+		hpRunningPtr = &fromPtr->context;
+	}
+}
+
+StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters)
+{
+	HP_TASK *taskPtr;
+	size_t stackSize;
+
+	configASSERT(HP_MAX_TASKS > hpTaskCount);
+	taskPtr = &hpTasks[hpTaskCount];
+	taskPtr->code = pxCode;
+	taskPtr->paramsPtr = pvParameters;
+	getcontext(&taskPtr->context);
+	taskPtr->context.uc_stack.ss_sp = HN_TaskStack(hpTaskCount, &stackSize);
+	taskPtr->context.uc_stack.ss_size = stackSize;
+	taskPtr->context.uc_link = NULL;
+	makecontext(&taskPtr->context, hpTaskEntry, 0);
+
+	*pxTopOfStack = (StackType_t)hpTaskCount;
+	hpTaskCount++;
+	return(pxTopOfStack);
+}
+
+BaseType_t xPortStartScheduler(void)
+{
+	HP_TASK *firstPtr = hpCurrent();
+
+	hpStarted = true;
+	uxCriticalNesting = 0;
+	hpYieldPending = false;
+	hpRunningPtr = &firstPtr->context;
+	setcontext(&firstPtr->context);		// main()'s context is never used again
+	return(pdFALSE);
+}
+
+void vPortEndScheduler(void)
+{
+	vPortAssertFailed(__FILE__, __LINE__);
+}
+
+void vPortEnterCritical(void)
+{
+	uxCriticalNesting++;
+}
+
+void vPortExitCritical(void)
+{
+	configASSERT(0 != uxCriticalNesting);
+	uxCriticalNesting--;
+	if ((0 == uxCriticalNesting) && (true == hpYieldPending) && (0 == hpIpsr))
+	{
+		hpSwitch();
+	}
+}
+
+void vPortYield(void)
+{
+	if ((0 != hpIpsr) || (0 != uxCriticalNesting))
+	{
+		hpYieldPending = true;
+		return;
+	}
+	hpSwitch();
+}
+
+void vPortYieldFromISR(void)
+{
+	hpYieldPending = true;
+}
+
+void vApplicationIdleHook(void)
+{
+	// Once round the idle loop to let the tickless check run, then back to
+	// the host to move time along by a tick.
+	if (true == hpIdlePassed)
+	{
+		hpIdlePassed = false;
+		hpToHost(HP_YIELD_IDLE);
+	}
+	else
+	{
+		hpIdlePassed = true;
+	}
+}
+
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
+{
+	// The scheduler is suspended: the host steps the ticks with
+	// HP_StepTicks() and interrupts only pend their tasks, as in a real sleep.
+	hpIdlePassed = false;
+	hpSleepTicks = xExpectedIdleTime;
+	hpToHost(HP_YIELD_SLEEP);
+	hpSleepTicks = 0;
+}
+
+void xPortSysTickHandler(void)
+{
+	if (pdFALSE != xTaskIncrementTick())
+	{
+		hpYieldPending = true;
+	}
+}
+
+void vPortAssertFailed(const char *pcFile, int iLine)
+{
+	fprintf(stderr, "FreeRTOS assert failed: %s:%d\n", pcFile, iLine);
+	abort();
+}
+
+uint32_t HP_Ipsr(void)
+{
+	return(hpIpsr);
+}
+
+void HP_EnterInterrupt(int irq)
+{
+	hpIpsr = (uint32_t)(irq + 16);
+}
+
+void HP_ExitInterrupt(void)
+{
+	hpIpsr = 0;
+}
+
+bool HP_Started(void)
+{
+	return(hpStarted);
+}
+
+HP_YIELD HP_Reason(void)
+{
+	return(hpReason);
+}
+
+uint32_t HP_SleepTicks(void)
+{
+	return(hpSleepTicks);
+}
+
+// Host: a tick inside a sleep the idle task asked for, ticks short of its
+// end.  The last tick of it goes through HS_Tick() so its unblocking is done
+// by the kernel's own tick, as the part's wake-up SysTick does.
+void HP_StepTicks(uint32_t ticks)
+{
+	vTaskStepTick(ticks);
+}
+
+// Host: run the node from main() until it first goes idle.
+void HP_Boot(ucontext_t *bootContextPtr)
+{
+	hpRunningPtr = bootContextPtr;
+	swapcontext(HN_HostContext(), bootContextPtr);
+}
+
+// Host: let the node run until it hands the processor back.
+void HP_Resume(void)
+{
+	HP_TASK *taskPtr;
+
+	if ((true == hpYieldPending) && (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()))
+	{
+		hpYieldPending = false;
+		vTaskSwitchContext();
+	}
+	taskPtr = hpCurrent();
+	hpRunningPtr = &taskPtr->context;
+	swapcontext(HN_HostContext(), &taskPtr->context);
+}
+
+// The node asked for a reset.  From a task (or main()) the host takes over
+// for good; from an interrupt the host is already running and unwinds itself.
+void HP_Reset(void)
+{
+	if (NULL != hpRunningPtr)
+	{
+		hpToHost(HP_YIELD_RESET);
+		vPortAssertFailed(__FILE__, __LINE__);		// never resumed
+	}
+	HN_ResetFromInterrupt();
+}
@@ -0,0 +1,112 @@
+/*
+ * portmacro.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * FreeRTOS port for the host build: the kernel sources and Inc/FreeRTOSConfig.h
+ * as they are, with every task on its own ucontext and one task running at a
+ * time.  The host (Host/HostNode.c) gets control back whenever the node goes
+ * idle, and delivers ticks and interrupts in between -- see Port/port.c.
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Type definitions -- StackType_t stays 32 bits: freertos.c hands out
+uint32_t buffers sized in words. */
+#define portCHAR		char
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		long
+#define portSHORT		short
+#define portSTACK_TYPE	uint32_t
+#define portBASE_TYPE	long
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#if( configUSE_16_BIT_TICKS == 1 )
+	#error The host port keeps the 32-bit tick of the part
+#endif
+typedef uint32_t TickType_t;
+#define portMAX_DELAY ( TickType_t ) 0xffffffffUL
+#define portTICK_TYPE_IS_ATOMIC 1
+
+#define portPOINTER_SIZE_TYPE	uintptr_t
+
+/* Architecture specifics. */
+#define portSTACK_GROWTH			( -1 )
+#define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT			8
+
+/* Scheduler utilities.  A yield asked for in a critical section or an
+interrupt happens when it ends, as PendSV would. */
+extern void vPortYield( void );
+extern void vPortYieldFromISR( void );
+#define portYIELD()									vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired )	if( xSwitchRequired != pdFALSE ) vPortYieldFromISR()
+#define portYIELD_FROM_ISR( x )						portEND_SWITCHING_ISR( x )
+
+/* Critical section management.  Interrupts are only delivered while no task
+is running, so there is nothing to mask -- only the nesting to count. */
+extern void vPortEnterCritical( void );
+extern void vPortExitCritical( void );
+#define portSET_INTERRUPT_MASK_FROM_ISR()		0
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)	( void ) ( x )
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+#define portENTER_CRITICAL()					vPortEnterCritical()
+#define portEXIT_CRITICAL()						vPortExitCritical()
+
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+/* Tickless idle hands the expected idle time to the host, which skips over
+it.  The idle hook hands back control when the next tick is too close to
+bother -- the host steps a single tick instead. */
+extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
+#undef configUSE_IDLE_HOOK
+#define configUSE_IDLE_HOOK		1
+
+#if configUSE_PORT_OPTIMISED_TASK_SELECTION == 1
+	#if( configMAX_PRIORITIES > 32 )
+		#error configUSE_PORT_OPTIMISED_TASK_SELECTION can only be set to 1 when configMAX_PRIORITIES is less than or equal to 32.
+	#endif
+	#define portRECORD_READY_PRIORITY( uxPriority, uxReadyPriorities ) ( uxReadyPriorities ) |= ( 1UL << ( uxPriority ) )
+	#define portRESET_READY_PRIORITY( uxPriority, uxReadyPriorities ) ( uxReadyPriorities ) &= ~( 1UL << ( uxPriority ) )
+	#define portGET_HIGHEST_PRIORITY( uxTopPriority, uxReadyPriorities ) uxTopPriority = ( 31UL - ( uint32_t ) __builtin_clz( ( uint32_t ) ( uxReadyPriorities ) ) )
+#endif
+
+/* A failed assert stops the run with the place it failed, rather than
+spinning with interrupts off where nothing can see it. */
+extern void vPortAssertFailed( const char *pcFile, int iLine ) __attribute__(( noreturn ));
+#undef configASSERT
+#define configASSERT( x ) if( ( x ) == 0 ) vPortAssertFailed( __FILE__, __LINE__ )
+#define portASSERT_IF_INTERRUPT_PRIORITY_INVALID()
+
+#define portNOP()
+#define portINLINE	__inline
+#ifndef portFORCE_INLINE
+	#define portFORCE_INLINE inline __attribute__(( always_inline))
+#endif
+
+extern uint32_t HP_Ipsr( void );
+portFORCE_INLINE static BaseType_t xPortIsInsideInterrupt( void )
+{
+	return ( 0 != HP_Ipsr() ) ? pdTRUE : pdFALSE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
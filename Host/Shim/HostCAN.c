@@ -0,0 +1,909 @@
+/*
+ * HostCAN.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * bxCAN for the host build, at the HAL_CAN_* level.
+ *
+ * What the firmware reads for itself is real register state: ESR (TEC, REC,
+ * LEC, EWGF/EPVF/BOFF), MSR INAK, MCR INRQ, the RFxR fill levels, TSR and
+ * IER.  The filter banks are read back out of FMR/FM1R/FS1R/FFA1R/FA1R and
+ * sFilterRegister[] exactly as HAL_CAN_ConfigFilter() leaves them, and
+ * acceptance follows RM0316: the filter number a frame matched is counted
+ * through every bank assigned to its FIFO, active or not.
+ *
+ * The receive FIFOs are three deep and overrun the way RFLM says.  The
+ * transmit mailboxes go out by TXFP -- request order -- or by identifier.
+ * The bus itself is the host's: HS_CANTxNext() hands it the frame this
+ * controller would put into arbitration, HS_CANTxResult() says how that
+ * went, HS_CANReceive() delivers what others sent.  HS_CANState() and
+ * HS_CANAccepts() answer from the registers alone, so a bus of many nodes
+ * can ask them of a node that is not the one loaded.
+ */
+
+#include "HostHAL.h"
+
+#include <string.h>
+
+#define HS_CAN_MAILBOXES		3
+#define HS_CAN_FIFO_DEPTH		3
+#define HS_CAN_FILTER_BANKS		14
+
+#define HS_CAN_LEC_STUFF		1
+#define HS_CAN_LEC_FORM			2
+#define HS_CAN_LEC_ACK			3
+
+#define HS_CAN_RECOVERY_BITS	(128 * 11)	// bus-off ends after 128 x 11 recessive bits
+
+typedef struct _HS_CAN_MAILBOX
+{
+	HS_CAN_FRAME	frame;
+	bool			pending;
+	uint32_t		order;					// request order, for TXFP
+	uint64_t		queuedUs;
+} HS_CAN_MAILBOX;
+
+typedef struct _HS_CAN_ENTRY
+{
+	HS_CAN_FRAME	frame;
+	uint32_t		filterMatch;
+} HS_CAN_ENTRY;
+
+typedef struct _HS_CAN_FIFO
+{
+	HS_CAN_ENTRY	entry[HS_CAN_FIFO_DEPTH];
+	uint32_t		head;
+	uint32_t		count;
+} HS_CAN_FIFO;
+
+static HS_CAN_MAILBOX	hsMailbox[HS_CAN_MAILBOXES];
+static uint32_t			hsTxOrder = 0;
+static HS_CAN_FIFO		hsFifo[2];
+static bool				hsRecovering = false;	// bus-off, and INRQ has been cycled
+static uint64_t			hsRecoveredUs = 0;
+
+static const uint32_t	hsTme[HS_CAN_MAILBOXES] = {CAN_TSR_TME0, CAN_TSR_TME1, CAN_TSR_TME2};
+static const uint32_t	hsRqcp[HS_CAN_MAILBOXES] = {CAN_TSR_RQCP0, CAN_TSR_RQCP1, CAN_TSR_RQCP2};
+static const uint32_t	hsTxok[HS_CAN_MAILBOXES] = {CAN_TSR_TXOK0, CAN_TSR_TXOK1, CAN_TSR_TXOK2};
+static const uint32_t	hsAlst[HS_CAN_MAILBOXES] = {CAN_TSR_ALST0, CAN_TSR_ALST1, CAN_TSR_ALST2};
+static const uint32_t	hsTerr[HS_CAN_MAILBOXES] = {CAN_TSR_TERR0, CAN_TSR_TERR1, CAN_TSR_TERR2};
+
+static volatile uint32_t *hsRfr(uint32_t fifo)
+{
+	return((CAN_RX_FIFO0 == fifo) ? &CAN->RF0R : &CAN->RF1R);
+}
+
+// This node's registers, or another's through the host's view of its window
+static CAN_TypeDef *hsCan(const void *peripheralsPtr)
+{
+	return((CAN_TypeDef *)((uintptr_t)peripheralsPtr + (CAN_BASE - PERIPH_BASE)));
+}
+
+// The identifier as the filters (and TIR) lay it out
+static uint32_t hsFilterWord(const HS_CAN_FRAME *framePtr)
+{
+	uint32_t word = (true == framePtr->extended) ? ((framePtr->id << 3) | CAN_TI0R_IDE) : (framePtr->id << 21);
+
+	return(word | ((true == framePtr->remote) ? CAN_TI0R_RTR : 0));
+}
+
+static uint16_t hsFilterHalf(const HS_CAN_FRAME *framePtr)
+{
+	uint32_t word = hsFilterWord(framePtr);
+
+	// STID[10:0] RTR IDE EXID[17:15]
+	return((uint16_t)(((word >> 16) & 0xFFE0) | ((word & CAN_TI0R_RTR) << 3) | ((word & CAN_TI0R_IDE) << 1) | ((word >> 15) & 0x7)));
+}
+
+// Neither initializing nor asleep, as it comes out of reset
+static bool hsStarted(const CAN_TypeDef *canPtr)
+{
+	return(0 == (canPtr->MSR & (CAN_MSR_INAK | CAN_MSR_SLAK)));
+}
+
+static uint32_t hsBitrate(const CAN_TypeDef *canPtr)
+{
+	uint32_t btr = canPtr->BTR;
+	uint32_t quanta = 3 + ((btr & CAN_BTR_TS1) >> CAN_BTR_TS1_Pos) + ((btr & CAN_BTR_TS2) >> CAN_BTR_TS2_Pos);
+
+	return(HS_APB1_CLOCK_HZ / (((btr & CAN_BTR_BRP) + 1) * quanta));
+}
+
+static bool hsOnBus(const CAN_TypeDef *canPtr)
+{
+	return(hsStarted(canPtr) && (0 == (canPtr->ESR & CAN_ESR_BOFF)));
+}
+
+static bool hsListenOnly(const CAN_TypeDef *canPtr)
+{
+	return(0 != (canPtr->BTR & CAN_BTR_SILM));
+}
+
+// ESR flags and the error interrupt that follow TEC/REC
+static void hsErrorState(uint32_t lec)
+{
+	uint32_t esr = CAN->ESR;
+	uint32_t tec = (esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos;
+	uint32_t rec = (esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos;
+	uint32_t flags = 0;
+	uint32_t raised;
+
+	if ((96 <= tec) || (96 <= rec))
+	{
+		flags |= CAN_ESR_EWGF;
+	}
+	if ((128 <= tec) || (128 <= rec))
+	{
+		flags |= CAN_ESR_EPVF;
+	}
+	if ((0 != (esr & CAN_ESR_BOFF)) || (255 < tec))
+	{
+		flags |= CAN_ESR_BOFF;
+		tec = 255;
+	}
+
+	raised = flags & ~esr;
+	esr = (esr & ~(CAN_ESR_EWGF | CAN_ESR_EPVF | CAN_ESR_BOFF | CAN_ESR_TEC)) | flags | (tec << CAN_ESR_TEC_Pos);
+	if (0 != lec)
+	{
+		esr = (esr & ~CAN_ESR_LEC) | (lec << CAN_ESR_LEC_Pos);
+	}
+	CAN->ESR = esr;
+
+	if (((0 != (raised & CAN_ESR_EWGF)) && (0 != (CAN->IER & CAN_IER_EWGIE))) ||
+		((0 != (raised & CAN_ESR_EPVF)) && (0 != (CAN->IER & CAN_IER_EPVIE))) ||
+		((0 != (raised & CAN_ESR_BOFF)) && (0 != (CAN->IER & CAN_IER_BOFIE))) ||
+		((0 != lec) && (0 != (CAN->IER & CAN_IER_LECIE))))
+	{
+		CAN->MSR |= CAN_MSR_ERRI;
+	}
+}
+
+static void hsCounter(uint32_t mask, uint32_t pos, int32_t delta)
+{
+	int32_t value = (int32_t)((CAN->ESR & mask) >> pos) + delta;
+
+	if (0 > value)
+	{
+		value = 0;
+	}
+	if ((CAN_ESR_REC == mask) && (255 < value))
+	{
+		value = 255;
+	}
+	if (256 < value)
+	{
+		value = 256;		// hsErrorState() turns anything past 255 into bus-off
+	}
+	CAN->ESR = (CAN->ESR & ~mask) | ((uint32_t)(value & 0xFF) << pos);
+	if ((CAN_ESR_TEC == mask) && (255 < value))
+	{
+		CAN->ESR |= CAN_ESR_BOFF;
+	}
+}
+
+static void hsSetCode(void)
+{
+	uint32_t tsr = CAN->TSR & ~CAN_TSR_CODE;
+
+	for (uint32_t mailbox = 0; mailbox < HS_CAN_MAILBOXES; mailbox++)
+	{
+		if (0 != (tsr & hsTme[mailbox]))
+		{
+			CAN->TSR = tsr | (mailbox << CAN_TSR_CODE_Pos);
+			return;
+		}
+	}
+	CAN->TSR = tsr;
+}
+
+static void hsFifoLevel(uint32_t fifo)
+{
+	volatile uint32_t *rfrPtr = hsRfr(fifo);
+	uint32_t count = hsFifo[fifo].count;
+
+	*rfrPtr = (*rfrPtr & ~(CAN_RF0R_FMP0 | CAN_RF0R_FULL0)) | count | ((HS_CAN_FIFO_DEPTH == count) ? CAN_RF0R_FULL0 : 0);
+}
+
+void HS_CANPowerOn(void)
+{
+	CAN->MCR = 0x00010002;					// reset values: SLEEP, DBF
+	CAN->MSR = 0x00000C02;					// SLAK, SAMP, RX
+	CAN->TSR = CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2;
+	CAN->BTR = 0x01230000;
+	CAN->FMR = 0x2A1C0E01;
+	HN_CANTxRequest();						// whatever was in the mailboxes is gone
+}
+
+// Host: the register writes the firmware does without the HAL take effect
+void HS_CANSync(uint64_t nowUs)
+{
+	if ((0 != (CAN->MCR & CAN_MCR_INRQ)) && (0 == (CAN->MSR & CAN_MSR_INAK)))
+	{
+		CAN->MSR |= CAN_MSR_INAK;
+		hsRecovering = (0 != (CAN->ESR & CAN_ESR_BOFF));
+	}
+	else if ((0 == (CAN->MCR & CAN_MCR_INRQ)) && (0 != (CAN->MSR & CAN_MSR_INAK)))
+	{
+		CAN->MSR &= ~CAN_MSR_INAK;
+		if (true == hsRecovering)
+		{
+			hsRecoveredUs = nowUs + ((HS_CAN_RECOVERY_BITS * 1000000ULL) / hsBitrate(CAN));
+		}
+	}
+
+	if ((true == hsRecovering) && hsStarted(CAN) && (nowUs >= hsRecoveredUs))
+	{
+		hsRecovering = false;
+		CAN->ESR &= ~(CAN_ESR_BOFF | CAN_ESR_EPVF | CAN_ESR_EWGF | CAN_ESR_TEC | CAN_ESR_REC);
+		HN_CANTxRequest();
+	}
+}
+
+uint64_t HS_CANNextEventUs(void)
+{
+	return(((true == hsRecovering) && hsStarted(CAN)) ? hsRecoveredUs : UINT64_MAX);
+}
+
+bool HS_CANPending(IRQn_Type irq)
+{
+	uint32_t ier = CAN->IER;
+
+	switch (irq)
+	{
+	case USB_HP_CAN_TX_IRQn:
+		return((0 != (ier & CAN_IER_TMEIE)) && (0 != (CAN->TSR & (CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2))));
+
+	case USB_LP_CAN_RX0_IRQn:
+		return(((0 != (ier & CAN_IER_FMPIE0)) && (0 != (CAN->RF0R & CAN_RF0R_FMP0))) ||
+				((0 != (ier & CAN_IER_FFIE0)) && (0 != (CAN->RF0R & CAN_RF0R_FULL0))) ||
+				((0 != (ier & CAN_IER_FOVIE0)) && (0 != (CAN->RF0R & CAN_RF0R_FOVR0))));
+
+	case CAN_RX1_IRQn:
+		return(((0 != (ier & CAN_IER_FMPIE1)) && (0 != (CAN->RF1R & CAN_RF1R_FMP1))) ||
+				((0 != (ier & CAN_IER_FFIE1)) && (0 != (CAN->RF1R & CAN_RF1R_FULL1))) ||
+				((0 != (ier & CAN_IER_FOVIE1)) && (0 != (CAN->RF1R & CAN_RF1R_FOVR1))));
+
+	case CAN_SCE_IRQn:
+		return((0 != (ier & CAN_IER_ERRIE)) && (0 != (CAN->MSR & CAN_MSR_ERRI)));
+
+	default:
+		return(false);
+	}
+}
+
+// Host: the bus-facing state, from any node's registers
+void HS_CANState(const void *peripheralsPtr, HS_CAN_STATE *statePtr)
+{
+	const CAN_TypeDef *canPtr = hsCan(peripheralsPtr);
+
+	statePtr->bitrate = hsBitrate(canPtr);
+	statePtr->onBus = hsOnBus(canPtr);
+	statePtr->listenOnly = hsListenOnly(canPtr);
+}
+
+// Host: the mailbox this controller puts into the next arbitration
+bool HS_CANTxNext(HS_CAN_FRAME *framePtr, int *mailboxPtr)
+{
+	int best = -1;
+
+	if ((false == hsOnBus(CAN)) || (true == hsListenOnly(CAN)))
+	{
+		return(false);
+	}
+
+	for (int mailbox = 0; mailbox < HS_CAN_MAILBOXES; mailbox++)
+	{
+		if (false == hsMailbox[mailbox].pending)
+		{
+			continue;
+		}
+		if (-1 == best)
+		{
+			best = mailbox;
+		}
+		else if (0 != (CAN->MCR & CAN_MCR_TXFP))
+		{
+			if ((int32_t)(hsMailbox[mailbox].order - hsMailbox[best].order) < 0)
+			{
+				best = mailbox;
+			}
+		}
+		else if (hsFilterWord(&hsMailbox[mailbox].frame) < hsFilterWord(&hsMailbox[best].frame))
+		{
+			best = mailbox;
+		}
+	}
+
+	if (-1 == best)
+	{
+		return(false);
+	}
+	*framePtr = hsMailbox[best].frame;
+	*mailboxPtr = best;
+	return(true);
+}
+
+uint64_t HS_CANTxQueuedUs(int mailbox)
+{
+	return(hsMailbox[mailbox].queuedUs);
+}
+
+// Host: lost arbitration, from any node's registers.  False if it is one-shot
+// (NART) and so done with the mailbox -- that takes HS_CANTxResult().
+bool HS_CANArbitrationLost(void *peripheralsPtr, int mailbox)
+{
+	CAN_TypeDef *canPtr = hsCan(peripheralsPtr);
+
+	if (0 != (canPtr->MCR & CAN_MCR_NART))
+	{
+		return(false);
+	}
+	canPtr->TSR |= hsAlst[mailbox];			// and tries again at the next bus idle
+	return(true);
+}
+
+void HS_CANTxResult(int mailbox, HS_CAN_RESULT result)
+{
+	bool oneShot = (0 != (CAN->MCR & CAN_MCR_NART));
+
+	switch (result)
+	{
+	case HS_CAN_TX_OK:
+		hsMailbox[mailbox].pending = false;
+		CAN->TSR = (CAN->TSR & ~(hsAlst[mailbox] | hsTerr[mailbox])) | hsRqcp[mailbox] | hsTxok[mailbox] | hsTme[mailbox];
+		hsCounter(CAN_ESR_TEC, CAN_ESR_TEC_Pos, -1);
+		hsErrorState(0);
+		break;
+
+	case HS_CAN_TX_ARBITRATION_LOST:
+		if (false == HS_CANArbitrationLost((void *)PERIPH_BASE, mailbox))
+		{
+			hsMailbox[mailbox].pending = false;
+			CAN->TSR = (CAN->TSR & ~hsTxok[mailbox]) | hsAlst[mailbox] | hsRqcp[mailbox] | hsTme[mailbox];
+			HN_CANTxRequest();				// one-shot: given up
+		}
+		break;
+
+	case HS_CAN_TX_ERROR:
+		hsCounter(CAN_ESR_TEC, CAN_ESR_TEC_Pos, 8);
+		if (true == oneShot)
+		{
+			hsMailbox[mailbox].pending = false;
+			CAN->TSR = (CAN->TSR & ~hsTxok[mailbox]) | hsTerr[mailbox] | hsRqcp[mailbox] | hsTme[mailbox];
+			HN_CANTxRequest();
+		}
+		hsErrorState(HS_CAN_LEC_ACK);
+		break;
+	}
+	hsSetCode();
+}
+
+// The FIFO and filter number a frame goes to; false if no filter takes it.
+// 32-bit beats 16-bit, list beats mask, then the lower filter number.
+static bool hsFilter(const CAN_TypeDef *canPtr, const HS_CAN_FRAME *framePtr, uint32_t *fifoPtr, uint32_t *matchPtr)
+{
+	uint32_t word = hsFilterWord(framePtr);
+	uint16_t half = hsFilterHalf(framePtr);
+	uint32_t number[2] = {0, 0};
+	int bestRank = -1;
+
+	for (uint32_t bank = 0; bank < HS_CAN_FILTER_BANKS; bank++)
+	{
+		uint32_t bit = 1UL << bank;
+		uint32_t fifo = (0 != (canPtr->FFA1R & bit)) ? CAN_RX_FIFO1 : CAN_RX_FIFO0;
+		bool wide = (0 != (canPtr->FS1R & bit));
+		bool list = (0 != (canPtr->FM1R & bit));
+		uint32_t fr1 = canPtr->sFilterRegister[bank].FR1;
+		uint32_t fr2 = canPtr->sFilterRegister[bank].FR2;
+		uint32_t first = number[fifo];
+		int rank = (wide ? 2 : 0) + (list ? 1 : 0);
+		int hit = -1;
+
+		number[fifo] += (wide ? 1 : 2) * (list ? 2 : 1);
+		if ((0 == (canPtr->FA1R & bit)) || (rank <= bestRank))
+		{
+			continue;
+		}
+
+		if (wide && !list)
+		{
+			hit = (0 == ((word ^ fr1) & fr2)) ? 0 : -1;
+		}
+		else if (wide)
+		{
+			hit = (word == fr1) ? 0 : ((word == fr2) ? 1 : -1);
+		}
+		else if (!list)
+		{
+			if (0 == ((half ^ fr1) & (fr1 >> 16) & 0xFFFF))
+			{
+				hit = 0;
+			}
+			else if (0 == ((half ^ fr2) & (fr2 >> 16) & 0xFFFF))
+			{
+				hit = 1;
+			}
+		}
+		else
+		{
+			const uint16_t ids[4] = {(uint16_t)fr1, (uint16_t)(fr1 >> 16), (uint16_t)fr2, (uint16_t)(fr2 >> 16)};
+
+			for (int i = 0; (i < 4) && (-1 == hit); i++)
+			{
+				hit = (half == ids[i]) ? i : -1;
+			}
+		}
+
+		if (-1 != hit)
+		{
+			bestRank = rank;
+			*fifoPtr = fifo;
+			*matchPtr = first + (uint32_t)hit;
+		}
+	}
+	return(-1 != bestRank);
+}
+
+// Host: what HS_CANReceive() would do with a frame, from any node's registers
+HS_CAN_RX HS_CANAccepts(const void *peripheralsPtr, const HS_CAN_FRAME *framePtr)
+{
+	const CAN_TypeDef *canPtr = hsCan(peripheralsPtr);
+	uint32_t fifo;
+	uint32_t match;
+
+	if (false == hsStarted(canPtr))
+	{
+		return(HS_CAN_RX_NONE);
+	}
+	if (true == hsFilter(canPtr, framePtr, &fifo, &match))
+	{
+		const volatile uint32_t *rfrPtr = (CAN_RX_FIFO0 == fifo) ? &canPtr->RF0R : &canPtr->RF1R;
+
+		return((0 != (*rfrPtr & CAN_RF0R_FULL0)) ? HS_CAN_RX_OVERRUN : HS_CAN_RX_FIFO);
+	}
+	return((0 != (canPtr->ESR & CAN_ESR_REC)) ? HS_CAN_RX_COUNT : HS_CAN_RX_NONE);
+}
+
+// Host: one frame went by on the bus.  True if this node ACKs it.
+bool HS_CANReceive(const HS_CAN_FRAME *framePtr)
+{
+	uint32_t fifo;
+	uint32_t match;
+	HS_CAN_FIFO *fifoPtr;
+	HS_CAN_ENTRY *entryPtr;
+
+	if (false == hsStarted(CAN))
+	{
+		return(false);
+	}
+	hsCounter(CAN_ESR_REC, CAN_ESR_REC_Pos, -1);
+	hsErrorState(0);
+
+	if (true == hsFilter(CAN, framePtr, &fifo, &match))
+	{
+		fifoPtr = &hsFifo[fifo];
+		if (HS_CAN_FIFO_DEPTH == fifoPtr->count)
+		{
+			*hsRfr(fifo) |= CAN_RF0R_FOVR0;
+			if (0 == (CAN->MCR & CAN_MCR_RFLM))
+			{
+				// Not locked: the newest overwrites the last one in
+				entryPtr = &fifoPtr->entry[(fifoPtr->head + HS_CAN_FIFO_DEPTH - 1) % HS_CAN_FIFO_DEPTH];
+				entryPtr->frame = *framePtr;
+				entryPtr->filterMatch = match;
+			}
+		}
+		else
+		{
+			entryPtr = &fifoPtr->entry[(fifoPtr->head + fifoPtr->count) % HS_CAN_FIFO_DEPTH];
+			entryPtr->frame = *framePtr;
+			entryPtr->filterMatch = match;
+			fifoPtr->count++;
+		}
+		hsFifoLevel(fifo);
+	}
+	return(false == hsListenOnly(CAN));
+}
+
+// Host: a frame this node could not make sense of -- a bitrate mismatch
+void HS_CANBusError(void)
+{
+	if (false == hsStarted(CAN))
+	{
+		return;
+	}
+	hsCounter(CAN_ESR_REC, CAN_ESR_REC_Pos, 1);
+	hsErrorState(HS_CAN_LEC_STUFF);
+}
+
+// HAL_CAN_* -- the parts of stm32f3xx_hal_can.c the firmware uses, same
+// states, same error codes.
+
+HAL_StatusTypeDef HAL_CAN_Init(CAN_HandleTypeDef *hcan)
+{
+	if (NULL == hcan)
+	{
+		return(HAL_ERROR);
+	}
+	if (HAL_CAN_STATE_RESET == hcan->State)
+	{
+		HAL_CAN_MspInit(hcan);
+	}
+
+	CLEAR_BIT(hcan->Instance->MCR, CAN_MCR_SLEEP);
+	CLEAR_BIT(hcan->Instance->MSR, CAN_MSR_SLAK);
+	SET_BIT(hcan->Instance->MCR, CAN_MCR_INRQ);
+	SET_BIT(hcan->Instance->MSR, CAN_MSR_INAK);
+
+	MODIFY_REG(hcan->Instance->MCR, CAN_MCR_TTCM | CAN_MCR_ABOM | CAN_MCR_AWUM | CAN_MCR_NART | CAN_MCR_RFLM | CAN_MCR_TXFP,
+			((ENABLE == hcan->Init.TimeTriggeredMode) ? CAN_MCR_TTCM : 0) |
+			((ENABLE == hcan->Init.AutoBusOff) ? CAN_MCR_ABOM : 0) |
+			((ENABLE == hcan->Init.AutoWakeUp) ? CAN_MCR_AWUM : 0) |
+			((ENABLE == hcan->Init.AutoRetransmission) ? 0 : CAN_MCR_NART) |
+			((ENABLE == hcan->Init.ReceiveFifoLocked) ? CAN_MCR_RFLM : 0) |
+			((ENABLE == hcan->Init.TransmitFifoPriority) ? CAN_MCR_TXFP : 0));
+	WRITE_REG(hcan->Instance->BTR, hcan->Init.Mode | hcan->Init.SyncJumpWidth | hcan->Init.TimeSeg1 |
+			hcan->Init.TimeSeg2 | (hcan->Init.Prescaler - 1U));
+
+	hcan->ErrorCode = HAL_CAN_ERROR_NONE;
+	hcan->State = HAL_CAN_STATE_READY;
+	return(HAL_OK);
+}
+
+HAL_StatusTypeDef HAL_CAN_ConfigFilter(CAN_HandleTypeDef *hcan, CAN_FilterTypeDef *sFilterConfig)
+{
+	CAN_TypeDef *canPtr = hcan->Instance;
+	uint32_t bit;
+
+	if ((HAL_CAN_STATE_READY != hcan->State) && (HAL_CAN_STATE_LISTENING != hcan->State))
+	{
+		hcan->ErrorCode |= HAL_CAN_ERROR_NOT_INITIALIZED;
+		return(HAL_ERROR);
+	}
+
+	SET_BIT(canPtr->FMR, CAN_FMR_FINIT);
+	bit = 1UL << (sFilterConfig->FilterBank & 0x1FU);
+	CLEAR_BIT(canPtr->FA1R, bit);
+
+	if (CAN_FILTERSCALE_16BIT == sFilterConfig->FilterScale)
+	{
+		CLEAR_BIT(canPtr->FS1R, bit);
+		canPtr->sFilterRegister[sFilterConfig->FilterBank].FR1 =
+				((0x0000FFFFU & sFilterConfig->FilterMaskIdLow) << 16U) | (0x0000FFFFU & sFilterConfig->FilterIdLow);
+		canPtr->sFilterRegister[sFilterConfig->FilterBank].FR2 =
+				((0x0000FFFFU & sFilterConfig->FilterMaskIdHigh) << 16U) | (0x0000FFFFU & sFilterConfig->FilterIdHigh);
+	}
+	else
+	{
+		SET_BIT(canPtr->FS1R, bit);
+		canPtr->sFilterRegister[sFilterConfig->FilterBank].FR1 =
+				((0x0000FFFFU & sFilterConfig->FilterIdHigh) << 16U) | (0x0000FFFFU & sFilterConfig->FilterIdLow);
+		canPtr->sFilterRegister[sFilterConfig->FilterBank].FR2 =
+				((0x0000FFFFU & sFilterConfig->FilterMaskIdHigh) << 16U) | (0x0000FFFFU & sFilterConfig->FilterMaskIdLow);
+	}
+
+	if (CAN_FILTERMODE_IDMASK == sFilterConfig->FilterMode)
+	{
+		CLEAR_BIT(canPtr->FM1R, bit);
+	}
+	else
+	{
+		SET_BIT(canPtr->FM1R, bit);
+	}
+
+	if (CAN_FILTER_FIFO0 == sFilterConfig->FilterFIFOAssignment)
+	{
+		CLEAR_BIT(canPtr->FFA1R, bit);
+	}
+	else
+	{
+		SET_BIT(canPtr->FFA1R, bit);
+	}
+
+	if (ENABLE == sFilterConfig->FilterActivation)
+	{
+		SET_BIT(canPtr->FA1R, bit);
+	}
+	CLEAR_BIT(canPtr->FMR, CAN_FMR_FINIT);
+	return(HAL_OK);
+}
+
+HAL_StatusTypeDef HAL_CAN_Start(CAN_HandleTypeDef *hcan)
+{
+	if (HAL_CAN_STATE_READY != hcan->State)
+	{
+		hcan->ErrorCode |= HAL_CAN_ERROR_NOT_READY;
+		return(HAL_ERROR);
+	}
+
+	hcan->State = HAL_CAN_STATE_LISTENING;
+	CLEAR_BIT(hcan->Instance->MCR, CAN_MCR_INRQ);
+	CLEAR_BIT(hcan->Instance->MSR, CAN_MSR_INAK);
+	hcan->ErrorCode = HAL_CAN_ERROR_NONE;
+	HN_CANTxRequest();
+	return(HAL_OK);
+}
+
+HAL_StatusTypeDef HAL_CAN_Stop(CAN_HandleTypeDef *hcan)
+{
+	if (HAL_CAN_STATE_LISTENING != hcan->State)
+	{
+		hcan->ErrorCode |= HAL_CAN_ERROR_NOT_STARTED;
+		return(HAL_ERROR);
+	}
+
+	SET_BIT(hcan->Instance->MCR, CAN_MCR_INRQ);
+	SET_BIT(hcan->Instance->MSR, CAN_MSR_INAK);
+	CLEAR_BIT(hcan->Instance->MCR, CAN_MCR_SLEEP);
+	hcan->State = HAL_CAN_STATE_READY;
+	HN_CANTxRequest();						// off the bus: nothing to send now
+	return(HAL_OK);
+}
+
+HAL_StatusTypeDef HAL_CAN_AddTxMessage(CAN_HandleTypeDef *hcan, CAN_TxHeaderTypeDef *pHeader, uint8_t aData[], uint32_t *pTxMailbox)
+{
+	uint32_t mailbox;
+	HS_CAN_MAILBOX *mailboxPtr;
+
+	if ((HAL_CAN_STATE_READY != hcan->State) && (HAL_CAN_STATE_LISTENING != hcan->State))
+	{
+		hcan->ErrorCode |= HAL_CAN_ERROR_NOT_INITIALIZED;
+		return(HAL_ERROR);
+	}
+	if (0 == (hcan->Instance->TSR & (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)))
+	{
+		hcan->ErrorCode |= HAL_CAN_ERROR_PARAM;
+		return(HAL_ERROR);
+	}
+
+	mailbox = (hcan->Instance->TSR & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+	if (HS_CAN_MAILBOXES <= mailbox)
+	{
+		hcan->ErrorCode |= HAL_CAN_ERROR_INTERNAL;
+		return(HAL_ERROR);
+	}
+	*pTxMailbox = 1UL << mailbox;
+
+	mailboxPtr = &hsMailbox[mailbox];
+	mailboxPtr->frame.extended = (CAN_ID_EXT == pHeader->IDE);
+	mailboxPtr->frame.id = (true == mailboxPtr->frame.extended) ? (pHeader->ExtId & 0x1FFFFFFF) : (pHeader->StdId & 0x7FF);
+	mailboxPtr->frame.remote = (CAN_RTR_REMOTE == pHeader->RTR);
+	mailboxPtr->frame.dlc = (uint8_t)(pHeader->DLC & 0xF);
+	memcpy(mailboxPtr->frame.data, aData, sizeof(mailboxPtr->frame.data));
+	mailboxPtr->order = hsTxOrder++;
+	mailboxPtr->queuedUs = HN_NowUs();
+	mailboxPtr->pending = true;
+
+	hcan->Instance->TSR &= ~(hsTme[mailbox] | hsRqcp[mailbox] | hsTxok[mailbox] | hsAlst[mailbox] | hsTerr[mailbox]);
+	hsSetCode();
+	HN_CANTxRequest();
+	return(HAL_OK);
+}
+
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(CAN_HandleTypeDef *hcan)
+{
+	uint32_t freeLevel = 0;
+
+	if ((HAL_CAN_STATE_READY == hcan->State) || (HAL_CAN_STATE_LISTENING == hcan->State))
+	{
+		for (uint32_t mailbox = 0; mailbox < HS_CAN_MAILBOXES; mailbox++)
+		{
+			freeLevel += (0 != (hcan->Instance->TSR & hsTme[mailbox])) ? 1 : 0;
+		}
+	}
+	return(freeLevel);
+}
+
+HAL_StatusTypeDef HAL_CAN_GetRxMessage(CAN_HandleTypeDef *hcan, uint32_t RxFifo, CAN_RxHeaderTypeDef *pHeader, uint8_t aData[])
+{
+	HS_CAN_FIFO *fifoPtr = &hsFifo[(CAN_RX_FIFO0 == RxFifo) ? 0 : 1];
+	HS_CAN_ENTRY *entryPtr;
+
+	if ((HAL_CAN_STATE_READY != hcan->State) && (HAL_CAN_STATE_LISTENING != hcan->State))
+	{
+		hcan->ErrorCode |= HAL_CAN_ERROR_NOT_INITIALIZED;
+		return(HAL_ERROR);
+	}
+	if (0 == fifoPtr->count)
+	{
+		hcan->ErrorCode |= HAL_CAN_ERROR_PARAM;
+		return(HAL_ERROR);
+	}
+
+	entryPtr = &fifoPtr->entry[fifoPtr->head];
+	pHeader->IDE = (true == entryPtr->frame.extended) ? CAN_ID_EXT : CAN_ID_STD;
+	pHeader->StdId = (true == entryPtr->frame.extended) ? 0 : entryPtr->frame.id;
+	pHeader->ExtId = (true == entryPtr->frame.extended) ? entryPtr->frame.id : 0;
+	pHeader->RTR = (true == entryPtr->frame.remote) ? CAN_RTR_REMOTE : CAN_RTR_DATA;
+	pHeader->DLC = entryPtr->frame.dlc;
+	pHeader->FilterMatchIndex = entryPtr->filterMatch;
+	pHeader->Timestamp = 0;
+	memcpy(aData, entryPtr->frame.data, sizeof(entryPtr->frame.data));
+
+	// RFOM: release the output mailbox
+	fifoPtr->head = (fifoPtr->head + 1) % HS_CAN_FIFO_DEPTH;
+	fifoPtr->count--;
+	hsFifoLevel((CAN_RX_FIFO0 == RxFifo) ? 0 : 1);
+	return(HAL_OK);
+}
+
+uint32_t HAL_CAN_GetRxFifoFillLevel(CAN_HandleTypeDef *hcan, uint32_t RxFifo)
+{
+	if ((HAL_CAN_STATE_READY != hcan->State) && (HAL_CAN_STATE_LISTENING != hcan->State))
+	{
+		return(0);
+	}
+	return(*hsRfr(RxFifo) & CAN_RF0R_FMP0);
+}
+
+HAL_StatusTypeDef HAL_CAN_ActivateNotification(CAN_HandleTypeDef *hcan, uint32_t ActiveITs)
+{
+	if ((HAL_CAN_STATE_READY != hcan->State) && (HAL_CAN_STATE_LISTENING != hcan->State))
+	{
+		hcan->ErrorCode |= HAL_CAN_ERROR_NOT_INITIALIZED;
+		return(HAL_ERROR);
+	}
+	hcan->Instance->IER |= ActiveITs;
+	return(HAL_OK);
+}
+
+static void hsTxComplete(CAN_HandleTypeDef *hcan, uint32_t mailbox, uint32_t *errorCodePtr)
+{
+	static const uint32_t alstCode[HS_CAN_MAILBOXES] = {HAL_CAN_ERROR_TX_ALST0, HAL_CAN_ERROR_TX_ALST1, HAL_CAN_ERROR_TX_ALST2};
+	static const uint32_t terrCode[HS_CAN_MAILBOXES] = {HAL_CAN_ERROR_TX_TERR0, HAL_CAN_ERROR_TX_TERR1, HAL_CAN_ERROR_TX_TERR2};
+	uint32_t tsr = hcan->Instance->TSR;
+
+	if (0 == (tsr & hsRqcp[mailbox]))
+	{
+		return;
+	}
+	hcan->Instance->TSR &= ~(hsRqcp[mailbox] | hsTxok[mailbox] | hsAlst[mailbox] | hsTerr[mailbox]);
+
+	if (0 != (tsr & hsTxok[mailbox]))
+	{
+		if (0 == mailbox)
+		{
+			HAL_CAN_TxMailbox0CompleteCallback(hcan);
+		}
+		else if (1 == mailbox)
+		{
+			HAL_CAN_TxMailbox1CompleteCallback(hcan);
+		}
+		else
+		{
+			HAL_CAN_TxMailbox2CompleteCallback(hcan);
+		}
+	}
+	else if (0 != (tsr & hsAlst[mailbox]))
+	{
+		*errorCodePtr |= alstCode[mailbox];
+	}
+	else if (0 != (tsr & hsTerr[mailbox]))
+	{
+		*errorCodePtr |= terrCode[mailbox];
+	}
+}
+
+static void hsRxService(CAN_HandleTypeDef *hcan, uint32_t fifo, uint32_t *errorCodePtr)
+{
+	volatile uint32_t *rfrPtr = hsRfr(fifo);
+	uint32_t ier = hcan->Instance->IER;
+	uint32_t fov = (CAN_RX_FIFO0 == fifo) ? CAN_IER_FOVIE0 : CAN_IER_FOVIE1;
+	uint32_t ff = (CAN_RX_FIFO0 == fifo) ? CAN_IER_FFIE0 : CAN_IER_FFIE1;
+	uint32_t fmp = (CAN_RX_FIFO0 == fifo) ? CAN_IER_FMPIE0 : CAN_IER_FMPIE1;
+
+	if ((0 != (ier & fov)) && (0 != (*rfrPtr & CAN_RF0R_FOVR0)))
+	{
+		*errorCodePtr |= (CAN_RX_FIFO0 == fifo) ? HAL_CAN_ERROR_RX_FOV0 : HAL_CAN_ERROR_RX_FOV1;
+		*rfrPtr &= ~CAN_RF0R_FOVR0;
+	}
+	if ((0 != (ier & ff)) && (0 != (*rfrPtr & CAN_RF0R_FULL0)))
+	{
+		*rfrPtr &= ~CAN_RF0R_FULL0;
+		if (CAN_RX_FIFO0 == fifo)
+		{
+			HAL_CAN_RxFifo0FullCallback(hcan);
+		}
+		else
+		{
+			HAL_CAN_RxFifo1FullCallback(hcan);
+		}
+	}
+	if ((0 != (ier & fmp)) && (0 != (*rfrPtr & CAN_RF0R_FMP0)))
+	{
+		if (CAN_RX_FIFO0 == fifo)
+		{
+			HAL_CAN_RxFifo0MsgPendingCallback(hcan);
+		}
+		else
+		{
+			HAL_CAN_RxFifo1MsgPendingCallback(hcan);
+		}
+	}
+}
+
+void HAL_CAN_IRQHandler(CAN_HandleTypeDef *hcan)
+{
+	static const uint32_t lecCode[8] = {0, HAL_CAN_ERROR_STF, HAL_CAN_ERROR_FOR, HAL_CAN_ERROR_ACK,
+										HAL_CAN_ERROR_BR, HAL_CAN_ERROR_BD, HAL_CAN_ERROR_CRC, 0};
+	uint32_t errorCode = HAL_CAN_ERROR_NONE;
+	uint32_t ier = hcan->Instance->IER;
+	uint32_t esr = hcan->Instance->ESR;
+
+	if (0 != (ier & CAN_IER_TMEIE))
+	{
+		for (uint32_t mailbox = 0; mailbox < HS_CAN_MAILBOXES; mailbox++)
+		{
+			hsTxComplete(hcan, mailbox, &errorCode);
+		}
+	}
+
+	hsRxService(hcan, CAN_RX_FIFO0, &errorCode);
+	hsRxService(hcan, CAN_RX_FIFO1, &errorCode);
+
+	if ((0 != (ier & CAN_IER_ERRIE)) && (0 != (hcan->Instance->MSR & CAN_MSR_ERRI)))
+	{
+		if ((0 != (ier & CAN_IER_EWGIE)) && (0 != (esr & CAN_ESR_EWGF)))
+		{
+			errorCode |= HAL_CAN_ERROR_EWG;
+		}
+		if ((0 != (ier & CAN_IER_EPVIE)) && (0 != (esr & CAN_ESR_EPVF)))
+		{
+			errorCode |= HAL_CAN_ERROR_EPV;
+		}
+		if ((0 != (ier & CAN_IER_BOFIE)) && (0 != (esr & CAN_ESR_BOFF)))
+		{
+			errorCode |= HAL_CAN_ERROR_BOF;
+		}
+		if ((0 != (ier & CAN_IER_LECIE)) && (0 != (esr & CAN_ESR_LEC)))
+		{
+			errorCode |= lecCode[(esr & CAN_ESR_LEC) >> CAN_ESR_LEC_Pos];
+			CLEAR_BIT(hcan->Instance->ESR, CAN_ESR_LEC);
+		}
+		CLEAR_BIT(hcan->Instance->MSR, CAN_MSR_ERRI);
+	}
+
+	if (HAL_CAN_ERROR_NONE != errorCode)
+	{
+		hcan->ErrorCode |= errorCode;
+		HAL_CAN_ErrorCallback(hcan);
+	}
+}
+
+__weak void HAL_CAN_MspInit(CAN_HandleTypeDef *hcan)
+{
+}
+
+__weak void HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef *hcan)
+{
+}
+
+__weak void HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef *hcan)
+{
+}
+
+__weak void HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef *hcan)
+{
+}
+
+__weak void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
+{
+}
+
+__weak void HAL_CAN_RxFifo0FullCallback(CAN_HandleTypeDef *hcan)
+{
+}
+
+__weak void HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef *hcan)
+{
+}
+
+__weak void HAL_CAN_RxFifo1FullCallback(CAN_HandleTypeDef *hcan)
+{
+}
+
+__weak void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
+{
+}
@@ -0,0 +1,723 @@
+/*
+ * HostHAL.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * The rest of the HAL for the host build: RCC, NVIC, SysTick, GPIO/EXTI,
+ * DMA, the USART and the flash controller, at the level the firmware calls
+ * them, plus the node's end of the interrupt dispatch and the clocks it reads
+ * straight out of registers (DWT->CYCCNT, TIM2->CNT, the IWDG).
+ *
+ * The USART sends a DMA buffer to the host at once and finishes the transfer
+ * (DMA TC, then USART TC) one character time per byte later.  Reception is
+ * the circular DMA into the firmware's buffer, CNDTR and all, with the half
+ * and full transfer interrupts; the host marks an idle line.
+ */
+
+#include "HostHAL.h"
+
+#include "FreeRTOS.h"
+
+#include "stm32f3xx_it.h"
+#include "main.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define HS_GPIO_MODE_IT			0x00010000U		// stm32f3xx_hal_gpio.c
+#define HS_GPIO_RISING_EDGE		0x00100000U
+#define HS_GPIO_FALLING_EDGE	0x00200000U
+
+#define HS_IWDG_LSI_HZ			40000ULL
+#define HS_IWDG_KEY_RELOAD		0xAAAA
+
+#define HS_FLASH_SIZE			(512 * 1024)
+#define HS_FORMAT_LENGTH		256
+
+typedef struct _HS_IRQ
+{
+	IRQn_Type	irq;
+	void		(*handlerPtr)(void);
+} HS_IRQ;
+
+extern int FW_Main(void);
+
+__IO uint32_t			uwTick;
+uint32_t				uwTickPrio = (1UL << __NVIC_PRIO_BITS);
+HAL_TickFreqTypeDef		uwTickFreq = HAL_TICK_FREQ_DEFAULT;
+uint32_t				SystemCoreClock = HS_CORE_CLOCK_HZ;
+
+static uint64_t			hsNvicEnabled = 0;
+static uint64_t			hsNowUs = 0;
+
+static UART_HandleTypeDef	*hsUartPtr = NULL;
+static uint32_t			hsUartBaud = 0;
+static uint32_t			hsUartRxPos = 0;
+static bool				hsUartTxBusy = false;
+static uint64_t			hsUartTxDoneUs = 0;
+
+static bool				hsIwdgRunning = false;
+static uint64_t			hsIwdgFedUs = 0;
+
+// In IRQn order: same priority everywhere, so that is the order they are taken
+static const HS_IRQ hsIrqs[] =
+{
+	{DMA1_Channel6_IRQn,	DMA1_Channel6_IRQHandler},
+	{DMA1_Channel7_IRQn,	DMA1_Channel7_IRQHandler},
+	{USB_HP_CAN_TX_IRQn,	USB_HP_CAN_TX_IRQHandler},
+	{USB_LP_CAN_RX0_IRQn,	USB_LP_CAN_RX0_IRQHandler},
+	{CAN_RX1_IRQn,			CAN_RX1_IRQHandler},
+	{CAN_SCE_IRQn,			CAN_SCE_IRQHandler},
+	{USART2_IRQn,			USART2_IRQHandler},
+	{EXTI15_10_IRQn,		EXTI15_10_IRQHandler},
+};
+
+static uint32_t hsDmaShift(DMA_Channel_TypeDef *channelPtr)
+{
+	return(((uint32_t)((uintptr_t)channelPtr - (uintptr_t)DMA1_Channel1) / 0x14) * 4);
+}
+
+// ICR is write-one-to-clear; the firmware writes it with the HAL macros
+static void hsUartClear(void)
+{
+	USART2->ISR &= ~USART2->ICR;
+	USART2->ICR = 0;
+}
+
+static bool hsPending(IRQn_Type irq)
+{
+	switch (irq)
+	{
+	case DMA1_Channel6_IRQn:
+		return(0 != (DMA1->ISR & ((DMA_ISR_TCIF1 | DMA_ISR_HTIF1) << hsDmaShift(DMA1_Channel6))));
+
+	case DMA1_Channel7_IRQn:
+		return(0 != (DMA1->ISR & ((DMA_ISR_TCIF1 | DMA_ISR_HTIF1) << hsDmaShift(DMA1_Channel7))));
+
+	case USART2_IRQn:
+		hsUartClear();
+		return(((0 != (USART2->ISR & USART_ISR_IDLE)) && (0 != (USART2->CR1 & USART_CR1_IDLEIE))) ||
+				((0 != (USART2->ISR & USART_ISR_TC)) && (0 != (USART2->CR1 & USART_CR1_TCIE))));
+
+	case EXTI15_10_IRQn:
+		return(0 != (EXTI->PR & EXTI->IMR & 0xFC00));
+
+	default:
+		return(HS_CANPending(irq));
+	}
+}
+
+// The node's power-on (or reset) state.  The host has zeroed the peripherals.
+void HS_PowerOn(HS_RESET reason)
+{
+	static const uint32_t resetFlags[] = {RCC_CSR_PORRSTF, RCC_CSR_SFTRSTF, RCC_CSR_IWDGRSTF};
+
+	RCC->CSR = RCC_CSR_PINRSTF | resetFlags[reason];
+	FLASH->CR = FLASH_CR_LOCK;
+	IWDG->RLR = 0xFFF;
+	USART2->ISR = USART_ISR_TC | USART_ISR_TXE;
+	GPIOC->IDR = B1_Pin;					// B1 is active low
+	HS_CANPowerOn();
+}
+
+// The node's reset vector, on the boot context HP_Boot() was given
+void HS_Main(void)
+{
+	FW_Main();
+	vPortAssertFailed(__FILE__, __LINE__);		// main() never returns
+}
+
+void HS_Tick(void)
+{
+	HP_EnterInterrupt(SysTick_IRQn);
+	SysTick_Handler();
+	HP_ExitInterrupt();
+}
+
+bool HS_Sync(uint64_t nowUs)
+{
+	uint64_t timeoutUs;
+
+	hsNowUs = nowUs;
+	DWT->CYCCNT = (uint32_t)(nowUs * (HS_CORE_CLOCK_HZ / 1000000));
+	if (0 != (TIM2->CR1 & TIM_CR1_CEN))
+	{
+		TIM2->CNT = (uint32_t)((nowUs * (HS_APB1_TIMER_CLOCK_HZ / (TIM2->PSC + 1))) / 1000000);
+	}
+
+	if ((true == hsUartTxBusy) && (nowUs >= hsUartTxDoneUs))
+	{
+		hsUartTxBusy = false;
+		DMA1->ISR |= (DMA_ISR_GIF1 | DMA_ISR_TCIF1) << hsDmaShift(DMA1_Channel7);
+	}
+	hsUartClear();
+	HS_CANSync(nowUs);
+
+	// The bit-band alias is plain memory here: do what the write would have
+	if (0 != *(__IO uint32_t *)RCC_CSR_RMVF_BB)
+	{
+		*(__IO uint32_t *)RCC_CSR_RMVF_BB = 0;
+		RCC->CSR &= ~(RCC_CSR_RMVF | RCC_CSR_OBLRSTF | RCC_CSR_PINRSTF | RCC_CSR_PORRSTF |
+				RCC_CSR_SFTRSTF | RCC_CSR_IWDGRSTF | RCC_CSR_WWDGRSTF | RCC_CSR_LPWRRSTF);
+	}
+
+	// Any key at all means it was started, and once started it runs until reset
+	if (0 != IWDG->KR)
+	{
+		if ((false == hsIwdgRunning) || (HS_IWDG_KEY_RELOAD == IWDG->KR))
+		{
+			hsIwdgFedUs = nowUs;
+		}
+		hsIwdgRunning = true;
+		IWDG->KR = 0;
+	}
+	if (true == hsIwdgRunning)
+	{
+		timeoutUs = ((IWDG->RLR + 1ULL) * (4ULL << (IWDG->PR & 0x7)) * 1000000ULL) / HS_IWDG_LSI_HZ;
+		if ((nowUs - hsIwdgFedUs) > timeoutUs)
+		{
+			return(true);
+		}
+	}
+	return(false);
+}
+
+uint64_t HS_NextEventUs(void)
+{
+	uint64_t nextUs = HS_CANNextEventUs();
+
+	if ((true == hsUartTxBusy) && (hsUartTxDoneUs < nextUs))
+	{
+		nextUs = hsUartTxDoneUs;
+	}
+	return(nextUs);
+}
+
+// Take the highest priority interrupt that is pending and enabled
+bool HS_Interrupts(void)
+{
+	for (size_t i = 0; i < (sizeof(hsIrqs) / sizeof(hsIrqs[0])); i++)
+	{
+		if ((0 != (hsNvicEnabled & (1ULL << hsIrqs[i].irq))) && (true == hsPending(hsIrqs[i].irq)))
+		{
+			HP_EnterInterrupt(hsIrqs[i].irq);
+			hsIrqs[i].handlerPtr();
+			HP_ExitInterrupt();
+			return(true);
+		}
+	}
+	return(false);
+}
+
+void HS_Barrier(void)
+{
+	if (0 != (SCB->AIRCR & SCB_AIRCR_SYSRESETREQ_Msk))
+	{
+		HP_Reset();
+	}
+}
+
+// uint32_t is unsigned long on the part and unsigned int here -- drop the
+// single l (and newlib's L, which is no wider) length modifiers so the
+// firmware's formats read what it passed.
+int HS_sprintf(char *strPtr, const char *formatPtr, ...)
+{
+	char format[HS_FORMAT_LENGTH];
+	size_t length = 0;
+	va_list args;
+	int result;
+
+	for (const char *charPtr = formatPtr; ('\0' != *charPtr) && (length < (sizeof(format) - 1)); charPtr++)
+	{
+		if ((charPtr > formatPtr) &&
+			(('L' == charPtr[0]) || (('l' == charPtr[0]) && ('l' != charPtr[1]) && ('l' != charPtr[-1]))))
+		{
+			const char *specPtr = charPtr;
+
+			while ((specPtr > formatPtr) && (NULL != strchr("0123456789.-+ #*", specPtr[-1])))
+			{
+				specPtr--;
+			}
+			if ((specPtr > formatPtr) && ('%' == specPtr[-1]))
+			{
+				continue;
+			}
+		}
+		format[length++] = *charPtr;
+	}
+	format[length] = '\0';
+
+	va_start(args, formatPtr);
+	result = vsprintf(strPtr, format, args);
+	va_end(args);
+	return(result);
+}
+
+// Host: the UART line
+
+uint32_t HS_UARTBaud(void)
+{
+	return(hsUartBaud);
+}
+
+bool HS_UARTHeldOff(void)
+{
+	return(0 != (USART_RTS_GPIO_Port->ODR & USART_RTS_Pin));
+}
+
+// Bytes off the wire into the receive DMA.  Returns how many it took -- none
+// while reception is not armed (they would be overruns).
+uint32_t HS_UARTReceive(const uint8_t *dataPtr, uint32_t length)
+{
+	DMA_HandleTypeDef *dmaPtr;
+	uint32_t shift;
+	uint32_t taken;
+
+	if ((NULL == hsUartPtr) || (HAL_UART_STATE_BUSY_RX != hsUartPtr->RxState))
+	{
+		return(0);
+	}
+	dmaPtr = hsUartPtr->hdmarx;
+	shift = hsDmaShift(dmaPtr->Instance);
+
+	for (taken = 0; (taken < length) && (hsUartRxPos < hsUartPtr->RxXferSize); taken++)
+	{
+		hsUartPtr->pRxBuffPtr[hsUartRxPos++] = dataPtr[taken];
+		dmaPtr->Instance->CNDTR = hsUartPtr->RxXferSize - hsUartRxPos;
+		if ((hsUartPtr->RxXferSize / 2) == hsUartRxPos)
+		{
+			DMA1->ISR |= (DMA_ISR_GIF1 | DMA_ISR_HTIF1) << shift;
+		}
+		if (hsUartPtr->RxXferSize == hsUartRxPos)
+		{
+			DMA1->ISR |= (DMA_ISR_GIF1 | DMA_ISR_TCIF1) << shift;
+			if (DMA_CIRCULAR == dmaPtr->Init.Mode)
+			{
+				hsUartRxPos = 0;
+				dmaPtr->Instance->CNDTR = hsUartPtr->RxXferSize;
+			}
+		}
+	}
+	return(taken);
+}
+
+void HS_UARTLineIdle(void)
+{
+	USART2->ISR |= USART_ISR_IDLE;
+}
+
+// Host: the blue button (B1, PC13), through EXTI line 13
+void HS_Button(bool pressed)
+{
+	uint32_t level = (true == pressed) ? 0 : B1_Pin;
+	uint32_t was = GPIOC->IDR & B1_Pin;
+
+	GPIOC->IDR = (GPIOC->IDR & ~B1_Pin) | level;
+	if ((0 != was) && (0 == level) && (0 != (EXTI->FTSR & B1_Pin)))
+	{
+		EXTI->PR |= EXTI->IMR & B1_Pin;
+	}
+	if ((0 == was) && (0 != level) && (0 != (EXTI->RTSR & B1_Pin)))
+	{
+		EXTI->PR |= EXTI->IMR & B1_Pin;
+	}
+}
+
+bool HS_LED(void)
+{
+	return(0 != (LD2_GPIO_Port->ODR & LD2_Pin));
+}
+
+// HAL: core, RCC, NVIC, SysTick
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+	HAL_MspInit();
+	return(HAL_OK);
+}
+
+void HAL_IncTick(void)
+{
+	uwTick += uwTickFreq;
+}
+
+uint32_t HAL_GetTick(void)
+{
+	return(uwTick);
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+	return(HAL_OK);
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency)
+{
+	return(HAL_OK);
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit)
+{
+	return(HAL_OK);
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+	return(SystemCoreClock);
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+	return(HS_APB1_CLOCK_HZ);
+}
+
+void HAL_NVIC_SetPriorityGrouping(uint32_t PriorityGroup)
+{
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+	hsNvicEnabled |= 1ULL << IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+	hsNvicEnabled &= ~(1ULL << IRQn);
+}
+
+uint32_t HAL_SYSTICK_Config(uint32_t TicksNumb)
+{
+	return(0);
+}
+
+void HAL_SYSTICK_CLKSourceConfig(uint32_t CLKSource)
+{
+}
+
+// HAL: GPIO and EXTI
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+	for (uint32_t position = 0; position < 16; position++)
+	{
+		uint32_t pin = 1UL << position;
+
+		if (0 == (GPIO_Init->Pin & pin))
+		{
+			continue;
+		}
+		MODIFY_REG(GPIOx->MODER, GPIO_MODER_MODER0 << (position * 2), (GPIO_Init->Mode & GPIO_MODER_MODER0) << (position * 2));
+		if (0 != (GPIO_Init->Mode & HS_GPIO_MODE_IT))
+		{
+			EXTI->IMR |= pin;
+			EXTI->RTSR = (EXTI->RTSR & ~pin) | ((0 != (GPIO_Init->Mode & HS_GPIO_RISING_EDGE)) ? pin : 0);
+			EXTI->FTSR = (EXTI->FTSR & ~pin) | ((0 != (GPIO_Init->Mode & HS_GPIO_FALLING_EDGE)) ? pin : 0);
+		}
+	}
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin)
+{
+	for (uint32_t position = 0; position < 16; position++)
+	{
+		if (0 != (GPIO_Pin & (1UL << position)))
+		{
+			GPIOx->MODER &= ~(GPIO_MODER_MODER0 << (position * 2));
+		}
+	}
+	EXTI->IMR &= ~GPIO_Pin;
+}
+
+static void hsGpioOutput(GPIO_TypeDef *GPIOx, uint32_t odr)
+{
+	uint32_t outputs = 0;
+
+	GPIOx->ODR = odr;
+	for (uint32_t position = 0; position < 16; position++)
+	{
+		if (GPIO_MODE_OUTPUT_PP == ((GPIOx->MODER >> (position * 2)) & GPIO_MODER_MODER0))
+		{
+			outputs |= 1UL << position;
+		}
+	}
+	GPIOx->IDR = (GPIOx->IDR & ~outputs) | (odr & outputs);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+	return((0 != (GPIOx->IDR & GPIO_Pin)) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	hsGpioOutput(GPIOx, (GPIO_PIN_RESET != PinState) ? (GPIOx->ODR | GPIO_Pin) : (GPIOx->ODR & ~GPIO_Pin));
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+	hsGpioOutput(GPIOx, GPIOx->ODR ^ GPIO_Pin);
+}
+
+void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin)
+{
+	if (0 != (EXTI->PR & GPIO_Pin))
+	{
+		EXTI->PR &= ~GPIO_Pin;
+		HAL_GPIO_EXTI_Callback(GPIO_Pin);
+	}
+}
+
+__weak void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+}
+
+// HAL: DMA -- only what the USART's transfers need
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+	hdma->Instance->CCR = hdma->Init.Direction | hdma->Init.PeriphInc | hdma->Init.MemInc |
+			hdma->Init.PeriphDataAlignment | hdma->Init.MemDataAlignment | hdma->Init.Mode | hdma->Init.Priority;
+	hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+	hdma->State = HAL_DMA_STATE_READY;
+	return(HAL_OK);
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma)
+{
+	hdma->Instance->CCR = 0;
+	hdma->Instance->CNDTR = 0;
+	DMA1->ISR &= ~((DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1) << hsDmaShift(hdma->Instance));
+	hdma->State = HAL_DMA_STATE_RESET;
+	return(HAL_OK);
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+	uint32_t shift = hsDmaShift(hdma->Instance);
+	uint32_t isr = DMA1->ISR;
+
+	if (0 != (isr & (DMA_ISR_HTIF1 << shift)))
+	{
+		DMA1->ISR &= ~((DMA_ISR_GIF1 | DMA_ISR_HTIF1) << shift);
+		if (NULL != hdma->XferHalfCpltCallback)
+		{
+			hdma->XferHalfCpltCallback(hdma);
+		}
+	}
+	if (0 != (isr & (DMA_ISR_TCIF1 << shift)))
+	{
+		DMA1->ISR &= ~((DMA_ISR_GIF1 | DMA_ISR_TCIF1) << shift);
+		if (DMA_CIRCULAR != hdma->Init.Mode)
+		{
+			hdma->Instance->CCR &= ~DMA_CCR_EN;
+			hdma->State = HAL_DMA_STATE_READY;
+		}
+		if (NULL != hdma->XferCpltCallback)
+		{
+			hdma->XferCpltCallback(hdma);
+		}
+	}
+}
+
+// HAL: USART2
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+	if (NULL == huart)
+	{
+		return(HAL_ERROR);
+	}
+	if (HAL_UART_STATE_RESET == huart->gState)
+	{
+		huart->Lock = HAL_UNLOCKED;
+		HAL_UART_MspInit(huart);
+	}
+
+	hsUartPtr = huart;
+	hsUartBaud = huart->Init.BaudRate;
+	huart->Instance->BRR = HS_APB1_CLOCK_HZ / huart->Init.BaudRate;
+	MODIFY_REG(huart->Instance->CR3, USART_CR3_CTSE | USART_CR3_RTSE, huart->Init.HwFlowCtl);
+	huart->Instance->CR1 |= USART_CR1_UE | USART_CR1_TE | USART_CR1_RE;
+
+	huart->ErrorCode = HAL_UART_ERROR_NONE;
+	huart->gState = HAL_UART_STATE_READY;
+	huart->RxState = HAL_UART_STATE_READY;
+	return(HAL_OK);
+}
+
+static void hsUartDmaTxCplt(DMA_HandleTypeDef *hdma)
+{
+	UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+	// Last byte is in the shift register: finish on the USART's TC
+	huart->TxXferCount = 0;
+	huart->Instance->CR3 &= ~USART_CR3_DMAT;
+	huart->Instance->ISR |= USART_ISR_TC;
+	huart->Instance->CR1 |= USART_CR1_TCIE;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+	uint32_t baud = (0 != hsUartBaud) ? hsUartBaud : 115200;
+
+	if (HAL_UART_STATE_READY != huart->gState)
+	{
+		return(HAL_BUSY);
+	}
+	if ((NULL == pData) || (0 == Size))
+	{
+		return(HAL_ERROR);
+	}
+
+	huart->pTxBuffPtr = pData;
+	huart->TxXferSize = Size;
+	huart->TxXferCount = Size;
+	huart->ErrorCode = HAL_UART_ERROR_NONE;
+	huart->gState = HAL_UART_STATE_BUSY_TX;
+	huart->hdmatx->XferCpltCallback = hsUartDmaTxCplt;
+	huart->hdmatx->XferHalfCpltCallback = NULL;
+	huart->Instance->ISR &= ~USART_ISR_TC;
+	huart->Instance->CR3 |= USART_CR3_DMAT;
+
+	HN_UARTOutput(pData, Size);
+	hsUartTxBusy = true;
+	hsUartTxDoneUs = hsNowUs + (((uint64_t)Size * 10 * 1000000) / baud);
+	return(HAL_OK);
+}
+
+static void hsUartDmaRxHalfCplt(DMA_HandleTypeDef *hdma)
+{
+	HAL_UART_RxHalfCpltCallback((UART_HandleTypeDef *)hdma->Parent);
+}
+
+static void hsUartDmaRxCplt(DMA_HandleTypeDef *hdma)
+{
+	UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+	if (DMA_CIRCULAR != hdma->Init.Mode)
+	{
+		huart->RxXferCount = 0;
+		huart->Instance->CR3 &= ~USART_CR3_DMAR;
+		huart->RxState = HAL_UART_STATE_READY;
+	}
+	HAL_UART_RxCpltCallback(huart);
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+	if (HAL_UART_STATE_READY != huart->RxState)
+	{
+		return(HAL_BUSY);
+	}
+	if ((NULL == pData) || (0 == Size))
+	{
+		return(HAL_ERROR);
+	}
+
+	hsUartPtr = huart;
+	huart->pRxBuffPtr = pData;
+	huart->RxXferSize = Size;
+	huart->ErrorCode = HAL_UART_ERROR_NONE;
+	huart->RxState = HAL_UART_STATE_BUSY_RX;
+	huart->hdmarx->XferCpltCallback = hsUartDmaRxCplt;
+	huart->hdmarx->XferHalfCpltCallback = hsUartDmaRxHalfCplt;
+	huart->hdmarx->Instance->CNDTR = Size;
+	huart->hdmarx->Instance->CCR |= DMA_CCR_EN;
+	huart->Instance->CR3 |= USART_CR3_DMAR;
+	hsUartRxPos = 0;
+	return(HAL_OK);
+}
+
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart)
+{
+	huart->Instance->CR1 &= ~(USART_CR1_RXNEIE | USART_CR1_PEIE | USART_CR1_TXEIE | USART_CR1_TCIE);
+	huart->Instance->CR3 &= ~(USART_CR3_EIE | USART_CR3_DMAT | USART_CR3_DMAR);
+	huart->hdmatx->Instance->CCR &= ~DMA_CCR_EN;
+	huart->hdmarx->Instance->CCR &= ~DMA_CCR_EN;
+	DMA1->ISR &= ~((DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1) << hsDmaShift(huart->hdmatx->Instance));
+	DMA1->ISR &= ~((DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1) << hsDmaShift(huart->hdmarx->Instance));
+	hsUartTxBusy = false;
+	huart->Instance->ISR |= USART_ISR_TC;
+
+	huart->TxXferCount = 0;
+	huart->RxXferCount = 0;
+	huart->ErrorCode = HAL_UART_ERROR_NONE;
+	huart->gState = HAL_UART_STATE_READY;
+	huart->RxState = HAL_UART_STATE_READY;
+	return(HAL_OK);
+}
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart)
+{
+	hsUartClear();
+	if ((0 != (huart->Instance->ISR & USART_ISR_TC)) && (0 != (huart->Instance->CR1 & USART_CR1_TCIE)))
+	{
+		huart->Instance->CR1 &= ~USART_CR1_TCIE;
+		huart->gState = HAL_UART_STATE_READY;
+		HAL_UART_TxCpltCallback(huart);
+	}
+}
+
+// HAL: flash.  NOR rules -- a halfword programs only over 0xFFFF, or to 0.
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+	FLASH->CR &= ~FLASH_CR_LOCK;
+	return(HAL_OK);
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+	FLASH->CR |= FLASH_CR_LOCK;
+	return(HAL_OK);
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+	uint32_t halfwords = (FLASH_TYPEPROGRAM_HALFWORD == TypeProgram) ? 1 : ((FLASH_TYPEPROGRAM_WORD == TypeProgram) ? 2 : 4);
+
+	if ((0 != (FLASH->CR & FLASH_CR_LOCK)) || (0 != (Address & 1)) ||
+		(FLASH_BASE > Address) || ((FLASH_BASE + HS_FLASH_SIZE) < (Address + (halfwords * 2))))
+	{
+		return(HAL_ERROR);
+	}
+
+	for (uint32_t i = 0; i < halfwords; i++)
+	{
+		volatile uint16_t *cellPtr = (volatile uint16_t *)(uintptr_t)(Address + (i * 2));
+		uint16_t value = (uint16_t)(Data >> (16 * i));
+
+		if ((0xFFFF != *cellPtr) && (0 != value))
+		{
+			FLASH->SR |= FLASH_SR_PGERR;
+			return(HAL_ERROR);
+		}
+		*cellPtr = value;
+	}
+	return(HAL_OK);
+}
+
+void FLASH_PageErase(uint32_t PageAddress)
+{
+	uint32_t base = PageAddress & ~(FLASH_PAGE_SIZE - 1);
+
+	if ((0 != (FLASH->CR & FLASH_CR_LOCK)) || (FLASH_BASE > base) || ((FLASH_BASE + HS_FLASH_SIZE) <= base))
+	{
+		return;
+	}
+	FLASH->CR |= FLASH_CR_PER;
+	FLASH->AR = PageAddress;
+	memset((void *)(uintptr_t)base, 0xFF, FLASH_PAGE_SIZE);
+	HN_FlashErased();
+}
+
+HAL_StatusTypeDef FLASH_WaitForLastOperation(uint32_t Timeout)
+{
+	return(HAL_OK);
+}
@@ -0,0 +1,29 @@
+/*
+ * HostHAL.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef HOSTHAL_H_
+#define HOSTHAL_H_
+
+#include "stm32f3xx_hal.h"
+
+#include "HostShim.h"
+
+// Between the shim's own files.  Each peripheral model keeps its state in its
+// registers where the firmware reads them itself, and in statics (reset with
+// the rest of the node's .data/.bss) where it only goes through the HAL.
+
+#define HS_APB1_CLOCK_HZ		36000000UL
+#define HS_APB1_TIMER_CLOCK_HZ	72000000UL	// x2: APB1 is divided
+#define HS_CORE_CLOCK_HZ		72000000UL
+
+// HostCAN.c
+void HS_CANPowerOn(void);
+void HS_CANSync(uint64_t nowUs);
+uint64_t HS_CANNextEventUs(void);
+bool HS_CANPending(IRQn_Type irq);
+
+#endif /* HOSTHAL_H_ */
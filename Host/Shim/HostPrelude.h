@@ -0,0 +1,98 @@
+/*
+ * HostPrelude.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * Forced into every firmware source of the host build (-include), ahead of
+ * the CMSIS headers.  It stands in for cmsis_gcc.h, whose intrinsics are
+ * Cortex-M instructions, and reroutes the few library calls whose arguments
+ * change size on a 64-bit host.
+ */
+
+#ifndef HOSTPRELUDE_H_
+#define HOSTPRELUDE_H_
+
+#include <stdint.h>
+
+#define __CMSIS_GCC_H				// core_cm4.h pulls it in -- these replace it
+
+#ifndef __ASM
+#define __ASM						__asm
+#endif
+#ifndef __INLINE
+#define __INLINE					inline
+#endif
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE				static inline
+#endif
+
+uint32_t HP_Ipsr(void);
+void HS_Barrier(void);
+int HS_sprintf(char *bufferPtr, const char *formatPtr, ...);
+
+// Interrupts only ever arrive between task runs on the host (Port/port.c), so
+// masking them has nothing to do.
+static inline void __enable_irq(void) {}
+static inline void __disable_irq(void) {}
+static inline void __enable_fault_irq(void) {}
+static inline void __disable_fault_irq(void) {}
+static inline uint32_t __get_PRIMASK(void) { return(0); }
+static inline void __set_PRIMASK(uint32_t priMask) { (void)priMask; }
+static inline uint32_t __get_BASEPRI(void) { return(0); }
+static inline void __set_BASEPRI(uint32_t value) { (void)value; }
+static inline void __set_BASEPRI_MAX(uint32_t value) { (void)value; }
+static inline uint32_t __get_FAULTMASK(void) { return(0); }
+static inline void __set_FAULTMASK(uint32_t faultMask) { (void)faultMask; }
+
+// The exception number of the interrupt being run, so cmsis_os.c picks the
+// FromISR calls exactly as it does on the part
+static inline uint32_t __get_IPSR(void) { return(HP_Ipsr()); }
+static inline uint32_t __get_xPSR(void) { return(HP_Ipsr()); }
+static inline uint32_t __get_APSR(void) { return(0); }
+
+// There is no second stack to report; Crash.c only records these
+static inline uint32_t __get_CONTROL(void) { return(0); }
+static inline void __set_CONTROL(uint32_t control) { (void)control; }
+static inline uint32_t __get_PSP(void) { return(0); }
+static inline void __set_PSP(uint32_t topOfProcStack) { (void)topOfProcStack; }
+static inline uint32_t __get_MSP(void) { return(0); }
+static inline void __set_MSP(uint32_t topOfMainStack) { (void)topOfMainStack; }
+static inline uint32_t __get_FPSCR(void) { return(0); }
+static inline void __set_FPSCR(uint32_t fpscr) { (void)fpscr; }
+
+static inline void __NOP(void) {}
+static inline void __WFI(void) {}
+static inline void __WFE(void) {}
+static inline void __SEV(void) {}
+static inline void __ISB(void) {}
+static inline void __DMB(void) {}
+// NVIC_SystemReset() passes through here right after requesting the reset
+static inline void __DSB(void) { HS_Barrier(); }
+#define __BKPT(value)				__builtin_trap()
+
+static inline uint32_t __REV(uint32_t value) { return(__builtin_bswap32(value)); }
+static inline uint32_t __REV16(uint32_t value) { return(((value & 0xFF00FF00UL) >> 8) | ((value & 0x00FF00FFUL) << 8)); }
+static inline int32_t __REVSH(int32_t value) { return((int16_t)__builtin_bswap16((uint16_t)value)); }
+static inline uint32_t __ROR(uint32_t op1, uint32_t op2) { op2 &= 31; return((0 == op2) ? op1 : ((op1 >> op2) | (op1 << (32 - op2)))); }
+static inline uint32_t __CLZ(uint32_t value) { return((0 == value) ? 32 : (uint32_t)__builtin_clz(value)); }
+static inline uint32_t __RBIT(uint32_t value)
+{
+	uint32_t result = 0;
+
+	for (int i = 0; i < 32; i++, value >>= 1)
+	{
+		result = (result << 1) | (value & 1);
+	}
+	return(result);
+}
+
+// %lu and %LX mean 32 bits to newlib on the part; HS_sprintf() reads them
+// that way on the host too.
+#define sprintf						HS_sprintf
+
+// Crash.h: there is no exception frame to hand over, and no fault to take
+#define CR_FAULT_ENTRY(reason)		__builtin_trap()
+#define naked						noinline
+
+#endif /* HOSTPRELUDE_H_ */
@@ -0,0 +1,123 @@
+/*
+ * HostShim.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef HOSTSHIM_H_
+#define HOSTSHIM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <ucontext.h>
+
+// Between the node and the host
+// =============================
+//
+// HP_ (Port/port.c) and HS_ (Shim/) are built with the firmware and are the
+// node's side: the FreeRTOS port and the peripherals the HAL calls land on.
+// HN_ (HostNode.c) is the host's side: it owns time, the memory the node
+// sees at the part's addresses and everything the node is wired to.
+//
+// This header is shared by both, so it stays clear of the device headers --
+// the host side is built without them.
+
+#define HP_MAX_TASKS			8			// freertos.c's five, idle, timers, one spare
+
+typedef enum _HP_YIELD
+{
+	HP_YIELD_IDLE,							// nothing to do until the next tick
+	HP_YIELD_SLEEP,							// nothing to do for HP_SleepTicks()
+	HP_YIELD_RESET							// the node asked for a reset
+} HP_YIELD;
+
+typedef enum _HS_RESET
+{
+	HS_RESET_POWER,
+	HS_RESET_SOFTWARE,
+	HS_RESET_WATCHDOG
+} HS_RESET;
+
+typedef struct _HS_CAN_FRAME
+{
+	uint32_t	id;							// 11 or 29 bits
+	bool		extended;
+	bool		remote;
+	uint8_t		dlc;
+	uint8_t		data[8];
+} HS_CAN_FRAME;
+
+typedef enum _HS_CAN_RESULT
+{
+	HS_CAN_TX_OK,
+	HS_CAN_TX_ARBITRATION_LOST,
+	HS_CAN_TX_ERROR							// no ACK or a bit error: TEC +8
+} HS_CAN_RESULT;
+
+typedef enum _HS_CAN_RX
+{
+	HS_CAN_RX_NONE,							// the node would not notice it
+	HS_CAN_RX_COUNT,						// no filter takes it, but REC comes down
+	HS_CAN_RX_FIFO,
+	HS_CAN_RX_OVERRUN						// a filter takes it, for a full FIFO
+} HS_CAN_RX;
+
+typedef struct _HS_CAN_STATE
+{
+	uint32_t	bitrate;
+	bool		onBus;						// started and not bus-off
+	bool		listenOnly;					// SILM: hears the bus, never drives it or ACKs
+} HS_CAN_STATE;
+
+// Port -- Port/port.c
+uint32_t HP_Ipsr(void);
+void HP_EnterInterrupt(int irq);
+void HP_ExitInterrupt(void);
+bool HP_Started(void);
+HP_YIELD HP_Reason(void);
+uint32_t HP_SleepTicks(void);
+void HP_StepTicks(uint32_t ticks);
+void HP_Boot(ucontext_t *bootContextPtr);
+void HP_Resume(void);
+void HP_Reset(void) __attribute__((noreturn));
+
+// Node side peripherals -- Shim/
+void HS_PowerOn(HS_RESET reason);
+void HS_Main(void);
+void HS_Tick(void);
+bool HS_Sync(uint64_t nowUs);			// true: the IWDG ran out
+uint64_t HS_NextEventUs(void);
+bool HS_Interrupts(void);
+
+bool HS_CANTxNext(HS_CAN_FRAME *framePtr, int *mailboxPtr);
+uint64_t HS_CANTxQueuedUs(int mailbox);
+void HS_CANTxResult(int mailbox, HS_CAN_RESULT result);
+bool HS_CANReceive(const HS_CAN_FRAME *framePtr);
+void HS_CANBusError(void);
+
+// These take the node's APB/AHB1 window: PERIPH_BASE for the node that is
+// loaded, the host's own view of it for any other
+void HS_CANState(const void *peripheralsPtr, HS_CAN_STATE *statePtr);
+HS_CAN_RX HS_CANAccepts(const void *peripheralsPtr, const HS_CAN_FRAME *framePtr);
+bool HS_CANArbitrationLost(void *peripheralsPtr, int mailbox);
+
+uint32_t HS_UARTBaud(void);
+uint32_t HS_UARTReceive(const uint8_t *dataPtr, uint32_t length);
+void HS_UARTLineIdle(void);
+bool HS_UARTHeldOff(void);
+
+void HS_Button(bool pressed);
+bool HS_LED(void);
+
+// Host side -- HostNode.c
+ucontext_t *HN_HostContext(void);
+void *HN_TaskStack(uint32_t slot, size_t *sizePtr);
+uint64_t HN_NowUs(void);
+void HN_UARTOutput(const uint8_t *dataPtr, uint32_t length);
+void HN_FlashErased(void);
+void HN_CANTxRequest(void);
+void HN_ResetFromInterrupt(void) __attribute__((noreturn));
+
+#endif /* HOSTSHIM_H_ */
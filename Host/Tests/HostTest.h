@@ -0,0 +1,74 @@
+/*
+ * HostTest.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef HOSTTEST_H_
+#define HOSTTEST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "HostNode.h"
+
+// What the host tests share
+// =========================
+//
+// CHECK() prints a condition that did not hold, with where it is, and counts
+// it in htFailures for main() to exit on.  HT_Output() is a node's
+// uartOutputPtr: give it an HT_OUTPUT as the context and it keeps what the
+// node wrote as one string, cut short when the buffer is full.
+//
+// HT_APP_BASE is where LOAD puts an image.  The tests stay clear of the
+// CMSIS headers, so this is a copy.
+//
+// Every test is a single translation unit, so all of it lives here.
+
+#define HT_APP_BASE		0x08010000UL		// RELO_APP_BASE (stm32f303xe.h)
+
+typedef struct _HT_OUTPUT
+{
+	char		*textPtr;
+	uint32_t	size;					// of textPtr, the '\0' included
+	uint32_t	length;
+} HT_OUTPUT;
+
+static int htFailures = 0;
+
+#define CHECK(condition, ...) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+			htFailures++; \
+		} \
+	} while (0)
+
+static inline void HT_Output(void *contextPtr, HN_NODE *nodePtr, const uint8_t *dataPtr, uint32_t length)
+{
+	HT_OUTPUT *outputPtr = (HT_OUTPUT *)contextPtr;
+	uint32_t room = (outputPtr->size - 1) - outputPtr->length;
+
+	(void)nodePtr;
+	if (length > room)
+	{
+		length = room;
+	}
+	memcpy(&outputPtr->textPtr[outputPtr->length], dataPtr, length);
+	outputPtr->length += length;
+	outputPtr->textPtr[outputPtr->length] = '\0';
+}
+
+static inline void HT_Clear(HT_OUTPUT *outputPtr)
+{
+	outputPtr->length = 0;
+	outputPtr->textPtr[0] = '\0';
+}
+
+#endif /* HOSTTEST_H_ */
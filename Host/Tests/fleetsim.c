@@ -0,0 +1,518 @@
+/*
+ * fleetsim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * A whole fleet on one simulated bus (Host/HostBus.h): a master and up to 254
+ * children, every one of them the real firmware, driven the way a bench is --
+ * through the master's UART and each child's button.
+ *
+ *		commission	the master claims, then every child in turn asks for an
+ *					address and is given one; a global VER must come back
+ *					from each of them
+ *		load		FLOW RTS, LOAD 0 08010000 and an image down the master's
+ *					UART as ':' lines, a JOBS in the middle of them; the
+ *					console must answer it and every child's flash must
+ *					have the image after
+ *		storm		background traffic, TOP 0 and every child's button at
+ *					once: every child's answers must reach the wire
+ *
+ * Each reports what it took, in virtual and in host time, and what the bus
+ * saw: frames, load, arbitration losses, errors, overruns and the latency
+ * from a frame being handed to a controller to its last bit.  Exits non-zero
+ * if any scenario fails.
+ *
+ *		fleetsim [--nodes N] [--bitrate bit/s] [--loss ppm] [--service us]
+ *				 [--load percent] [--image bytes] [--seed n]
+ *				 [--scenario commission|load|storm|all]
+ *
+ * The master can only ASSIGN addresses 2..99 (CAN_AssignAddress()), so past
+ * 98 children the rest stay unassigned: on the bus and ACKing, but not part
+ * of any scenario.  Unassigned they still take every frame (CAN_FILTER_GLOBAL)
+ * and so run for each one: host time grows with them, virtual time does not.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "HostBus.h"
+#include "HostTest.h"
+
+#define FLEET_MAX_NODES			255
+#define FLEET_MAX_CHILDREN		98			// addresses 2..99
+#define FLEET_FIRST_CHILD_ID	2
+#define FLEET_OUTPUT_BYTES		(256 * 1024)
+#define FLEET_STEP_US			10000
+#define FLEET_LOAD_LINE_BYTES	32			// image bytes per ':' data line
+#define FLEET_TASKS_MIN			4			// REPORT_STATS answers per child, at least
+
+#define FLEET_MASTER_ID			0x001		// CAN_MASTER_ID
+#define FLEET_ACK_BIT			0x400		// CAN_ACK_RESPONSE_BIT
+#define FLEET_SWITCH_STATE		0x06		// CAN_SWITCH_STATE
+#define FLEET_REPORT_STATS		0xE6		// CAN_REPORT_STATS
+#define FLEET_REPORT_VERSION	0xE5		// CAN_REPORT_VERSION
+#define FLEET_PROGRAM_BLOCK		0xF0		// CAN_PROGRAM_BLOCK
+#define FLEET_PROGRAM_CLOSE		0xE4		// CAN_PROGRAM_CLOSE
+
+typedef struct _FLEET_OPTIONS
+{
+	int			nodes;
+	uint32_t	bitrate;
+	uint32_t	lossPpm;
+	uint32_t	serviceUs;
+	uint32_t	loadPercent;
+	uint32_t	imageBytes;
+	uint32_t	seed;
+	const char	*scenarioPtr;
+} FLEET_OPTIONS;
+
+typedef struct _FLEET
+{
+	FLEET_OPTIONS	options;
+	HB_BUS			*busPtr;
+	int				children;				// assigned ones: nodes 1..children
+	HT_OUTPUT		output;					// the master's console
+	uint32_t		stats[FLEET_MAX_NODES];		// REPORT_STATS answers on the wire, by node
+	uint32_t		switches[FLEET_MAX_NODES];	// SWITCH_STATE
+	uint32_t		versions[FLEET_MAX_NODES];	// REPORT_VERSION
+	uint32_t		closes[FLEET_MAX_NODES];	// PROGRAM_CLOSE
+	uint32_t		blocks;
+} FLEET;
+
+static FLEET fleet;
+
+static uint64_t fleetHostNs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return(((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec);
+}
+
+// Every frame that made it: who answered what
+static void fleetFrame(void *contextPtr, int node, const HS_CAN_FRAME *framePtr)
+{
+	FLEET *fleetPtr = (FLEET *)contextPtr;
+	uint32_t command = framePtr->id & 0x7FF;
+
+	if ((0 > node) || (false == framePtr->extended))
+	{
+		return;
+	}
+	if ((FLEET_PROGRAM_BLOCK & ~0x07) == (command & ~0x07))
+	{
+		fleetPtr->blocks++;
+	}
+	if (FLEET_MASTER_ID != ((framePtr->id >> 11) & 0x1FF))
+	{
+		return;
+	}
+	switch (command)
+	{
+	case (FLEET_REPORT_STATS | FLEET_ACK_BIT):
+		fleetPtr->stats[node]++;
+		break;
+
+	case (FLEET_SWITCH_STATE | FLEET_ACK_BIT):
+		fleetPtr->switches[node]++;
+		break;
+
+	case (FLEET_REPORT_VERSION | FLEET_ACK_BIT):
+		fleetPtr->versions[node]++;
+		break;
+
+	case (FLEET_PROGRAM_CLOSE | FLEET_ACK_BIT):
+		fleetPtr->closes[node]++;
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void fleetRun(uint32_t ms)
+{
+	HB_RunUntil(fleet.busPtr, HB_Now(fleet.busPtr) + (ms * 1000ULL));
+}
+
+// Until the master's console has TEXT, or LIMIT ms go by
+static bool fleetAwait(const char *textPtr, uint32_t limitMs)
+{
+	for (uint32_t ms = 0; ms <= limitMs; ms += FLEET_STEP_US / 1000)
+	{
+		if (NULL != strstr(fleet.output.textPtr, textPtr))
+		{
+			return(true);
+		}
+		fleetRun(FLEET_STEP_US / 1000);
+	}
+	return(NULL != strstr(fleet.output.textPtr, textPtr));
+}
+
+static void fleetClear(void)
+{
+	HT_Clear(&fleet.output);
+}
+
+static void fleetCommand(const char *linePtr)
+{
+	HN_UARTSend(HB_Node(fleet.busPtr, 0), linePtr, (uint32_t)strlen(linePtr));
+	HN_UARTSend(HB_Node(fleet.busPtr, 0), "\r", 1);
+}
+
+static void fleetButton(int node, bool pressed)
+{
+	HN_Button(HB_Node(fleet.busPtr, node), pressed);
+}
+
+static void fleetReport(const char *namePtr, uint64_t virtualUs, uint64_t hostNs)
+{
+	HB_STATS stats;
+	double seconds;
+
+	HB_Stats(fleet.busPtr, &stats);
+	seconds = (0 == stats.elapsedUs) ? 1.0 : ((double)stats.elapsedUs / 1e6);
+	printf("%-10s %8.3f s virtual %8.3f s host  %7.0f frames/s %8.0f B/s  load %5.1f%%\n",
+			namePtr, (double)virtualUs / 1e6, (double)hostNs / 1e9,
+			(double)stats.frames / seconds, (double)stats.payloadBytes / seconds,
+			(100.0 * (double)stats.busyUs) / (double)((0 == stats.elapsedUs) ? 1 : stats.elapsedUs));
+	printf("%-10s %8lu frames (%lu background) %lu lost arbitration %lu error frames %lu no ACK %lu overruns\n", "",
+			(unsigned long)stats.frames, (unsigned long)stats.loadFrames, (unsigned long)stats.arbitrationLosses,
+			(unsigned long)stats.errorFrames, (unsigned long)stats.noAcks, (unsigned long)stats.overruns);
+	printf("%-10s latency p50 %u us p99 %u us max %u us over %lu frames\n", "",
+			stats.latencyP50Us, stats.latencyP99Us, stats.latencyMaxUs, (unsigned long)stats.latencyCount);
+}
+
+static void fleetCommission(void)
+{
+	uint64_t startUs = HB_Now(fleet.busPtr);
+	uint64_t startNs = fleetHostNs();
+	char line[32];
+	const char *droppedPtr;
+	int answered = 0;
+	int logged = 0;
+	int dropped;
+
+	HB_ClearStats(fleet.busPtr);
+	fleetClear();
+	fleetCommand("MYADR");
+	CHECK(true == fleetAwait("My ID is: 00000001", 1000), "no master claim: \"%s\"", fleet.output.textPtr);
+
+	for (int node = 1; node <= fleet.children; node++)
+	{
+		fleetClear();
+		fleetButton(node, true);
+		fleetRun(50);
+		fleetButton(node, false);
+		if (false == fleetAwait("Need Node address", 1000))
+		{
+			CHECK(false, "node %d never asked for an address: \"%s\"", node, fleet.output.textPtr);
+			continue;
+		}
+		sprintf(line, "ASSIGN %X", FLEET_FIRST_CHILD_ID + node - 1);
+		fleetCommand(line);
+		fleetRun(100);
+
+		// It takes up its new filters as it handles the ASSIGN: no waiting
+		fleetClear();
+		sprintf(line, "VER %d", FLEET_FIRST_CHILD_ID + node - 1);
+		fleetCommand(line);
+		sprintf(line, "0x%04X 0x0001 0x04E5", FLEET_FIRST_CHILD_ID + node - 1);
+		CHECK(true == fleetAwait(line, 100), "node %d deaf after ASSIGN: \"%s\"", node, fleet.output.textPtr);
+	}
+
+	memset(fleet.versions, 0, sizeof(fleet.versions));
+	fleetClear();
+	fleetCommand("VER 0");
+	fleetRun(2000);
+	// Past FL_RING_RECORDS answers at once the master's log drops the rest,
+	// and says how many
+	for (int node = 1; node <= fleet.children; node++)
+	{
+		sprintf(line, "0x%04X 0x0001 0x04E5", FLEET_FIRST_CHILD_ID + node - 1);
+		answered += (0 != fleet.versions[node]) ? 1 : 0;
+		logged += (NULL != strstr(fleet.output.textPtr, line)) ? 1 : 0;
+	}
+	droppedPtr = strstr(fleet.output.textPtr, "LOG DROPPED ");
+	dropped = (NULL == droppedPtr) ? 0 : (int)strtoul(droppedPtr + strlen("LOG DROPPED "), NULL, 16);
+	CHECK(fleet.children == answered, "%d of %d children answered VER", answered, fleet.children);
+	CHECK(fleet.children == (logged + dropped), "master logged %d answers and dropped %d of %d", logged, dropped, fleet.children);
+
+	fleetReport("commission", HB_Now(fleet.busPtr) - startUs, fleetHostNs() - startNs);
+}
+
+// The image as LOAD's ':' data lines, with a JOBS query halfway through it
+static char *fleetLoadText(const uint8_t *imagePtr, uint32_t bytes, uint32_t *lengthPtr)
+{
+	char *textPtr = malloc(((bytes / FLEET_LOAD_LINE_BYTES) + 3) * ((2 * FLEET_LOAD_LINE_BYTES) + 8));
+	uint32_t length = 0;
+	bool asked = false;
+
+	for (uint32_t offset = 0; offset < bytes; offset += FLEET_LOAD_LINE_BYTES)
+	{
+		uint32_t count = ((bytes - offset) < FLEET_LOAD_LINE_BYTES) ? (bytes - offset) : FLEET_LOAD_LINE_BYTES;
+
+		if ((false == asked) && ((bytes / 2) <= offset))
+		{
+			length += sprintf(&textPtr[length], "JOBS\r");
+			asked = true;
+		}
+		textPtr[length++] = ':';
+		for (uint32_t i = 0; i < count; i++)
+		{
+			length += sprintf(&textPtr[length], "%02X", imagePtr[offset + i]);
+		}
+		textPtr[length++] = '\r';
+	}
+	length += sprintf(&textPtr[length], ":\r");
+	*lengthPtr = length;
+	return(textPtr);
+}
+
+static void fleetLoad(void)
+{
+	uint8_t *imagePtr = malloc(fleet.options.imageBytes);
+	uint8_t *readPtr = malloc(fleet.options.imageBytes);
+	char line[32];
+	char *textPtr;
+	const char *runningPtr;
+	const char *donePtr;
+	uint32_t textLength;
+	uint64_t startUs;
+	uint64_t startNs = fleetHostNs();
+	uint32_t seed = fleet.options.seed;
+	int loaded = 0;
+	int closed = 0;
+
+	for (uint32_t i = 0; i < fleet.options.imageBytes; i++)
+	{
+		seed = (seed * 1103515245) + 12345;
+		imagePtr[i] = (uint8_t)(seed >> 16);
+	}
+	textPtr = fleetLoadText(imagePtr, fleet.options.imageBytes, &textLength);
+
+	// The host here honours RTS, not XON/XOFF
+	fleetClear();
+	fleetCommand("FLOW RTS");
+	fleetRun(200);
+	sprintf(line, "LOAD 0 %08lX", HT_APP_BASE);
+	fleetCommand(line);
+	if (false == fleetAwait("JOB ", 1000))
+	{
+		CHECK(false, "LOAD did not start: \"%s\"", fleet.output.textPtr);
+		free(textPtr);
+		free(imagePtr);
+		free(readPtr);
+		return;
+	}
+
+	HB_ClearStats(fleet.busPtr);
+	fleet.blocks = 0;
+	memset(fleet.closes, 0, sizeof(fleet.closes));
+	startUs = HB_Now(fleet.busPtr);
+	HN_UARTSend(HB_Node(fleet.busPtr, 0), textPtr, textLength);
+	CHECK(true == fleetAwait("LOAD DONE", 60000), "LOAD did not finish: \"%s\"", fleet.output.textPtr);
+
+	// DONE is the master's -- the tail of the image may still be on its way
+	for (uint32_t ms = 0; (ms < 2000) && (fleet.children > closed); ms += FLEET_STEP_US / 1000)
+	{
+		fleetRun(FLEET_STEP_US / 1000);
+		closed = 0;
+		for (int node = 1; node <= fleet.children; node++)
+		{
+			closed += (0 != fleet.closes[node]) ? 1 : 0;
+		}
+	}
+	CHECK(fleet.children == closed, "%d of %d children acknowledged CLOSE", closed, fleet.children);
+	CHECK((fleet.options.imageBytes / 8) <= fleet.blocks, "%u program blocks for %u bytes", fleet.blocks, fleet.options.imageBytes);
+
+	// The console answered in the middle of it
+	runningPtr = strstr(fleet.output.textPtr, "LOAD RUNNING");
+	donePtr = strstr(fleet.output.textPtr, "LOAD DONE");
+	CHECK((NULL != runningPtr) && (runningPtr < donePtr), "no JOBS answer during the load: \"%s\"", fleet.output.textPtr);
+
+	for (int node = 0; node <= fleet.children; node++)
+	{
+		bool same = (true == HN_ReadFlash(HB_Node(fleet.busPtr, node), HT_APP_BASE, readPtr, fleet.options.imageBytes)) &&
+				(0 == memcmp(imagePtr, readPtr, fleet.options.imageBytes));
+
+		loaded += (true == same) ? 1 : 0;
+	}
+	CHECK((fleet.children + 1) == loaded, "%d of %d nodes have the image", loaded, fleet.children + 1);
+
+	fleetReport("load", HB_Now(fleet.busPtr) - startUs, fleetHostNs() - startNs);
+	free(textPtr);
+	free(imagePtr);
+	free(readPtr);
+}
+
+static void fleetStorm(void)
+{
+	uint64_t startUs = HB_Now(fleet.busPtr);
+	uint64_t startNs = fleetHostNs();
+	int quiet = 0;
+	int unswitched = 0;
+
+	memset(fleet.stats, 0, sizeof(fleet.stats));
+	memset(fleet.switches, 0, sizeof(fleet.switches));
+	HB_ClearStats(fleet.busPtr);
+	HB_SetLoad(fleet.busPtr, fleet.options.loadPercent);
+	fleetRun(100);
+
+	// Every child at once, twice over: the master asks and the buttons go
+	fleetCommand("TOP 0");
+	for (int node = 1; node <= fleet.children; node++)
+	{
+		fleetButton(node, true);
+	}
+	fleetRun(50);
+	for (int node = 1; node <= fleet.children; node++)
+	{
+		fleetButton(node, false);
+	}
+	fleetRun(2000);
+	HB_SetLoad(fleet.busPtr, 0);
+
+	for (int node = 1; node <= fleet.children; node++)
+	{
+		quiet += (FLEET_TASKS_MIN > fleet.stats[node]) ? 1 : 0;
+		unswitched += (2 != fleet.switches[node]) ? 1 : 0;
+	}
+	CHECK(0 == quiet, "%d of %d children sent under %d REPORT_STATS frames", quiet, fleet.children, FLEET_TASKS_MIN);
+	CHECK(0 == unswitched, "%d of %d children did not report both switch edges", unswitched, fleet.children);
+
+	fleetReport("storm", HB_Now(fleet.busPtr) - startUs, fleetHostNs() - startNs);
+}
+
+static bool fleetOptions(int argc, char *argv[], FLEET_OPTIONS *optionsPtr)
+{
+	optionsPtr->nodes = 8;
+	optionsPtr->bitrate = 500000;
+	optionsPtr->lossPpm = 0;
+	optionsPtr->serviceUs = 20;
+	optionsPtr->loadPercent = 30;
+	optionsPtr->imageBytes = 4096;
+	optionsPtr->seed = 1;
+	optionsPtr->scenarioPtr = "all";
+
+	for (int i = 1; i < argc; i += 2)
+	{
+		if (i + 1 >= argc)
+		{
+			return(false);
+		}
+		if (0 == strcmp(argv[i], "--nodes"))
+		{
+			optionsPtr->nodes = atoi(argv[i + 1]);
+		}
+		else if (0 == strcmp(argv[i], "--bitrate"))
+		{
+			optionsPtr->bitrate = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[i], "--loss"))
+		{
+			optionsPtr->lossPpm = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[i], "--service"))
+		{
+			optionsPtr->serviceUs = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[i], "--load"))
+		{
+			optionsPtr->loadPercent = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[i], "--image"))
+		{
+			optionsPtr->imageBytes = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[i], "--seed"))
+		{
+			optionsPtr->seed = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+		}
+		else if (0 == strcmp(argv[i], "--scenario"))
+		{
+			optionsPtr->scenarioPtr = argv[i + 1];
+		}
+		else
+		{
+			return(false);
+		}
+	}
+	return((2 <= optionsPtr->nodes) && (FLEET_MAX_NODES >= optionsPtr->nodes) && (0 != optionsPtr->bitrate) &&
+			(0 != optionsPtr->imageBytes) && (100 >= optionsPtr->loadPercent));
+}
+
+int main(int argc, char *argv[])
+{
+	HB_CONFIG config;
+	HN_CALLBACKS master = {&fleet.output, HT_Output, NULL};
+	HN_CALLBACKS child = {NULL, NULL, NULL};		// no console
+	bool all;
+
+	if (false == fleetOptions(argc, argv, &fleet.options))
+	{
+		printf("usage: %s [--nodes 2..%d] [--bitrate bit/s] [--loss ppm] [--service us] [--load percent]\n"
+				"       [--image bytes] [--seed n] [--scenario commission|load|storm|all]\n", argv[0], FLEET_MAX_NODES);
+		return(2);
+	}
+	all = (0 == strcmp(fleet.options.scenarioPtr, "all"));
+
+	memset(&config, 0, sizeof(config));
+	config.bitrate = fleet.options.bitrate;
+	config.lossPpm = fleet.options.lossPpm;
+	config.serviceUs = fleet.options.serviceUs;
+	config.seed = fleet.options.seed;
+	config.contextPtr = &fleet;
+	config.framePtr = fleetFrame;
+
+	fleet.output.textPtr = calloc(1, FLEET_OUTPUT_BYTES);
+	fleet.output.size = FLEET_OUTPUT_BYTES;
+	fleet.busPtr = HB_Create(&config);
+	fleet.children = fleet.options.nodes - 1;
+	if (FLEET_MAX_CHILDREN < fleet.children)
+	{
+		fleet.children = FLEET_MAX_CHILDREN;
+	}
+	for (int node = 0; node < fleet.options.nodes; node++)
+	{
+		HB_AddNode(fleet.busPtr, (0 == node) ? &master : &child);
+	}
+
+	printf("fleetsim: %d nodes (%d children to commission) at %u bit/s, loss %u ppm, service %u us\n",
+			fleet.options.nodes, fleet.children, fleet.options.bitrate, fleet.options.lossPpm, fleet.options.serviceUs);
+	HB_PowerOn(fleet.busPtr);
+	fleetRun(1000);
+	for (int node = 0; node < fleet.options.nodes; node++)
+	{
+		HN_NODE *nodePtr = HB_Node(fleet.busPtr, node);
+
+		CHECK((true == HN_CANOnBus(nodePtr)) && (fleet.options.bitrate == HN_CANBitrate(nodePtr)),
+				"node %d at %u bit/s, %s the bus", node, HN_CANBitrate(nodePtr), HN_CANOnBus(nodePtr) ? "on" : "off");
+	}
+
+	// Load and storm need addressed children, so they commission first
+	fleetCommission();
+	if ((true == all) || (0 == strcmp(fleet.options.scenarioPtr, "load")))
+	{
+		fleetLoad();
+	}
+	if ((true == all) || (0 == strcmp(fleet.options.scenarioPtr, "storm")))
+	{
+		fleetStorm();
+	}
+
+	for (int node = 0; node < fleet.options.nodes; node++)
+	{
+		CHECK(0 == HN_ResetCount(HB_Node(fleet.busPtr, node)), "node %d reset %u times", node, HN_ResetCount(HB_Node(fleet.busPtr, node)));
+	}
+	HB_Destroy(fleet.busPtr);
+	free(fleet.output.textPtr);
+
+	printf("fleetsim: %d failures\n", htFailures);
+	return((0 == htFailures) ? 0 : 1);
+}
@@ -0,0 +1,329 @@
+/*
+ * hostbench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * Host benchmark of the firmware's hot paths: the character queue on its
+ * own, then whole nodes -- a boot, a CLI line in and its answer out, a CAN
+ * command to a child and its ACK back.  Each is the best of a few runs, in
+ * host nanoseconds per operation: a regression gate, not a prediction of the
+ * part (see Host/HostNode.h).
+ *
+ *		hostbench							print the figures
+ *		hostbench --check <baseline>		and fail if any is BENCH_SLACK times its baseline
+ *		hostbench --update <baseline>		write them as the new baseline
+ *
+ * The slack is wide on purpose: CI machines differ and share their cores.
+ * It catches a hot path going quadratic or a new copy per frame, not 10%.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "HostNode.h"
+#include "CharQueue.h"
+
+#define BENCH_SLACK				5.0
+#define BENCH_RUNS				3
+#define BENCH_NAME_LENGTH		32
+
+#define BENCH_CHILD_ID			5
+#define BENCH_MASTER_ID			0x001		// CAN_MASTER_ID
+#define BENCH_TEMPORARY_ID		0x1FE		// CAN_TEMPORARY_ID
+#define BENCH_ASSIGN_ADDRESS	0x02		// CAN_ASSIGN_ADDRESS
+#define BENCH_LED_STATE			0x05		// CAN_LED_STATE_CONTROL
+
+typedef struct _BENCH_RESULT
+{
+	const char	*namePtr;
+	double		nsPerOp;
+} BENCH_RESULT;
+
+typedef struct _BENCH_PORT
+{
+	uint32_t	newlines;
+} BENCH_PORT;
+
+static BENCH_PORT	benchPort;
+
+static uint64_t benchNowNs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return(((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec);
+}
+
+static void benchOutput(void *contextPtr, HN_NODE *nodePtr, const uint8_t *dataPtr, uint32_t length)
+{
+	BENCH_PORT *portPtr = (BENCH_PORT *)contextPtr;
+
+	(void)nodePtr;
+	for (uint32_t i = 0; i < length; i++)
+	{
+		if ('\n' == dataPtr[i])
+		{
+			portPtr->newlines++;
+		}
+	}
+}
+
+static HN_NODE *benchNode(void)
+{
+	HN_CALLBACKS callbacks = {&benchPort, benchOutput, NULL};
+	HN_NODE *nodePtr = HN_Create(&callbacks);
+
+	HN_PowerOn(nodePtr);
+	HN_RunUntil(nodePtr, HN_Now(nodePtr) + 100000);
+	return(nodePtr);
+}
+
+static uint32_t benchExtendedId(uint32_t source, uint32_t destination, uint32_t command)
+{
+	return((source << 20) | (destination << 11) | (command & 0x7FF));	// formExtendedIdentifier()
+}
+
+// Everything the node wants to send, acknowledged and dropped
+static uint32_t benchDrain(HN_NODE *nodePtr)
+{
+	HS_CAN_FRAME frame;
+	int mailbox;
+	uint32_t frames = 0;
+
+	while (true == HN_CANTxNext(nodePtr, &frame, &mailbox))
+	{
+		HN_CANTxResult(nodePtr, mailbox, HS_CAN_TX_OK);
+		frames++;
+	}
+	return(frames);
+}
+
+static double benchCharQueue(void)
+{
+	static const uint8_t line[] = "LOAD 5 08040000\r";
+	QUEUE_MGT_STRUCT queue;
+	uint8_t buffer[256];
+	uint8_t ch;
+	const uint32_t rounds = 200000;
+	uint64_t startNs;
+	volatile uint32_t sink = 0;
+
+	CQ_Init(&queue, buffer, sizeof(buffer));
+	startNs = benchNowNs();
+	for (uint32_t round = 0; round < rounds; round++)
+	{
+		CQ_EnqueueBlock(&queue, line, sizeof(line) - 1);
+		while (true == CQ_DequeueChar(&queue, &ch))
+		{
+			sink += ch;
+		}
+	}
+	(void)sink;
+	return((double)(benchNowNs() - startNs) / ((double)rounds * (sizeof(line) - 1)));
+}
+
+static double benchBoot(void)
+{
+	const uint32_t boots = 50;
+	uint64_t startNs = benchNowNs();
+
+	for (uint32_t boot = 0; boot < boots; boot++)
+	{
+		HN_Destroy(benchNode());
+	}
+	return((double)(benchNowNs() - startNs) / boots);
+}
+
+static double benchCommandLine(void)
+{
+	const uint32_t lines = 1000;
+	HN_NODE *nodePtr = benchNode();
+	uint64_t startNs;
+	uint32_t lost = 0;
+
+	// The first line claims master; the rest are the steady state
+	HN_UARTSend(nodePtr, "MYADR\r", 6);
+	HN_RunUntil(nodePtr, HN_Now(nodePtr) + 100000);
+
+	startNs = benchNowNs();
+	for (uint32_t line = 0; line < lines; line++)
+	{
+		uint32_t newlines = benchPort.newlines;
+
+		HN_UARTSend(nodePtr, "MYADR\r", 6);
+		HN_RunUntil(nodePtr, HN_Now(nodePtr) + 10000);
+		lost += (newlines == benchPort.newlines) ? 1 : 0;
+	}
+	startNs = benchNowNs() - startNs;
+	HN_Destroy(nodePtr);
+	if (0 != lost)
+	{
+		printf("hostbench: %u of %u lines went unanswered\n", lost, lines);
+		return(-1.0);
+	}
+	return((double)startNs / lines);
+}
+
+static double benchCANCommand(void)
+{
+	const uint32_t commands = 2000;
+	HN_NODE *nodePtr = benchNode();
+	HS_CAN_FRAME frame;
+	uint64_t startNs;
+	uint32_t acks = 0;
+
+	// Commission it by hand: the button, then the master's assignment
+	HN_Button(nodePtr, true);
+	HN_RunUntil(nodePtr, HN_Now(nodePtr) + 50000);
+	HN_Button(nodePtr, false);
+	HN_RunUntil(nodePtr, HN_Now(nodePtr) + 50000);
+	benchDrain(nodePtr);
+
+	memset(&frame, 0, sizeof(frame));
+	frame.extended = true;
+	frame.id = benchExtendedId(BENCH_MASTER_ID, BENCH_TEMPORARY_ID, BENCH_ASSIGN_ADDRESS);
+	frame.dlc = 2;
+	frame.data[1] = BENCH_CHILD_ID;
+	HN_CANReceive(nodePtr, &frame);
+	HN_RunUntil(nodePtr, HN_Now(nodePtr) + 2000000);	// until it takes up its filters
+	benchDrain(nodePtr);
+
+	frame.id = benchExtendedId(BENCH_MASTER_ID, BENCH_CHILD_ID, BENCH_LED_STATE);
+	frame.dlc = 1;
+	startNs = benchNowNs();
+	for (uint32_t command = 0; command < commands; command++)
+	{
+		frame.data[0] = (uint8_t)(command & 1);
+		HN_CANReceive(nodePtr, &frame);
+		HN_RunUntil(nodePtr, HN_Now(nodePtr) + HN_TICK_US);
+		acks += benchDrain(nodePtr);
+	}
+	startNs = benchNowNs() - startNs;
+	HN_Destroy(nodePtr);
+	if (commands != acks)
+	{
+		printf("hostbench: %u ACKs for %u commands\n", acks, commands);
+		return(-1.0);
+	}
+	return((double)startNs / commands);
+}
+
+static double benchBest(double (*benchPtr)(void))
+{
+	double best = 0.0;
+
+	for (int run = 0; run < BENCH_RUNS; run++)
+	{
+		double nsPerOp = benchPtr();
+
+		if (0.0 > nsPerOp)
+		{
+			return(nsPerOp);
+		}
+		if ((0 == run) || (nsPerOp < best))
+		{
+			best = nsPerOp;
+		}
+	}
+	return(best);
+}
+
+static bool benchBaseline(const char *pathPtr, const char *namePtr, double *nsPtr)
+{
+	FILE *filePtr = fopen(pathPtr, "r");
+	char name[BENCH_NAME_LENGTH];
+	double ns;
+	bool found = false;
+
+	if (NULL == filePtr)
+	{
+		return(false);
+	}
+	while ((false == found) && (2 == fscanf(filePtr, "%31s %lf", name, &ns)))
+	{
+		if (0 == strcmp(name, namePtr))
+		{
+			*nsPtr = ns;
+			found = true;
+		}
+	}
+	fclose(filePtr);
+	return(found);
+}
+
+int main(int argc, char *argv[])
+{
+	BENCH_RESULT results[] =
+	{
+		{"charqueue_char",	0.0},
+		{"boot",			0.0},
+		{"cli_line",		0.0},
+		{"can_command",		0.0},
+	};
+	double (*benches[])(void) = {benchCharQueue, benchBoot, benchCommandLine, benchCANCommand};
+	const int count = (int)(sizeof(results) / sizeof(results[0]));
+	const char *checkPtr = NULL;
+	const char *updatePtr = NULL;
+	int failures = 0;
+
+	if ((3 == argc) && (0 == strcmp(argv[1], "--check")))
+	{
+		checkPtr = argv[2];
+	}
+	else if ((3 == argc) && (0 == strcmp(argv[1], "--update")))
+	{
+		updatePtr = argv[2];
+	}
+	else if (1 != argc)
+	{
+		printf("usage: %s [--check|--update <baseline>]\n", argv[0]);
+		return(2);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		double baselineNs;
+
+		results[i].nsPerOp = benchBest(benches[i]);
+		if (0.0 > results[i].nsPerOp)
+		{
+			printf("%-16s FAILED\n", results[i].namePtr);
+			failures++;
+			continue;
+		}
+		printf("%-16s %12.1f ns/op", results[i].namePtr, results[i].nsPerOp);
+		if ((NULL != checkPtr) && (true == benchBaseline(checkPtr, results[i].namePtr, &baselineNs)))
+		{
+			bool slow = (results[i].nsPerOp > (baselineNs * BENCH_SLACK));
+
+			printf("  %5.2fx baseline%s", results[i].nsPerOp / baselineNs, (true == slow) ? "  TOO SLOW" : "");
+			failures += (true == slow) ? 1 : 0;
+		}
+		else if (NULL != checkPtr)
+		{
+			printf("  (no baseline)");
+		}
+		printf("\n");
+	}
+
+	if (NULL != updatePtr)
+	{
+		FILE *filePtr = fopen(updatePtr, "w");
+
+		if (NULL == filePtr)
+		{
+			perror(updatePtr);
+			return(1);
+		}
+		for (int i = 0; i < count; i++)
+		{
+			fprintf(filePtr, "%s %.1f\n", results[i].namePtr, results[i].nsPerOp);
+		}
+		fclose(filePtr);
+	}
+	return((0 == failures) ? 0 : 1);
+}
@@ -0,0 +1,295 @@
+/*
+ * hostregress.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * Regression run of the whole firmware on the host: two nodes on a wire,
+ * driven through their UARTs and the button the way a bench is.  The master
+ * claims, a child asks for an address and gets one, the address survives the
+ * child being restarted, a VER round trip comes back from it, a cancelled
+ * LOAD lets go of it, a BAUD switch nobody acknowledges falls back in its
+ * own time, and a global RESET restarts both.  Then the character queue
+ * and the block pools on their own, and a node booting with a crash record
+ * but no program.  Exits non-zero if anything disagrees.
+ *
+ *		ctest --test-dir build -R hostregress
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "HostNode.h"
+#include "HostTest.h"
+#include "CharQueue.h"
+#include "MemPool.h"
+
+#define REGRESS_OUTPUT_BYTES	16384
+#define REGRESS_STEP_US			HN_TICK_US
+#define REGRESS_CRASH_MAGIC		0x43524153UL		// CR_MAGIC
+#define REGRESS_CRASH_BYTES		128					// sizeof(CR_RECORD)
+
+uint32_t CR_StoreBase(void);						// Crash.h needs the HAL's headers
+
+static HN_NODE		*regressNode[2];
+static char			regressText[2][REGRESS_OUTPUT_BYTES];
+static HT_OUTPUT	regressPort[2] =
+{
+	{regressText[0], REGRESS_OUTPUT_BYTES, 0},
+	{regressText[1], REGRESS_OUTPUT_BYTES, 0},
+};
+static uint64_t		regressNowUs = 0;
+static uint32_t		regressFrames = 0;
+
+// A plain wire: whatever one node sends the other hears, and is acknowledged
+static void regressWire(void)
+{
+	HS_CAN_FRAME frame;
+	int mailbox;
+
+	for (int from = 0; from < 2; from++)
+	{
+		while (true == HN_CANTxNext(regressNode[from], &frame, &mailbox))
+		{
+			bool acked = HN_CANReceive(regressNode[1 - from], &frame);
+
+			HN_CANTxResult(regressNode[from], mailbox, (true == acked) ? HS_CAN_TX_OK : HS_CAN_TX_ERROR);
+			regressFrames++;
+		}
+	}
+}
+
+static void regressRun(uint32_t ms)
+{
+	uint64_t untilUs = regressNowUs + (ms * 1000ULL);
+
+	while (regressNowUs < untilUs)
+	{
+		regressNowUs += REGRESS_STEP_US;
+		HN_RunUntil(regressNode[0], regressNowUs);
+		HN_RunUntil(regressNode[1], regressNowUs);
+		regressWire();
+	}
+}
+
+static void regressCommand(int node, const char *linePtr)
+{
+	HN_UARTSend(regressNode[node], linePtr, (uint32_t)strlen(linePtr));
+	HN_UARTSend(regressNode[node], "\r", 1);
+	regressRun(200);
+}
+
+static void regressClear(void)
+{
+	HT_Clear(&regressPort[0]);
+	HT_Clear(&regressPort[1]);
+}
+
+static void regressNodes(void)
+{
+	const char *jobPtr;
+	unsigned job = 0;
+	char line[32];
+
+	for (int node = 0; node < 2; node++)
+	{
+		HN_CALLBACKS callbacks = {&regressPort[node], HT_Output, NULL};
+
+		regressNode[node] = HN_Create(&callbacks);
+		HN_PowerOn(regressNode[node]);
+	}
+
+	regressRun(1000);
+	CHECK(0 == HN_ResetCount(regressNode[0]), "master reset %u times booting", HN_ResetCount(regressNode[0]));
+	CHECK(0 == HN_ResetCount(regressNode[1]), "child reset %u times booting", HN_ResetCount(regressNode[1]));
+	CHECK(500000 == HN_CANBitrate(regressNode[0]), "master at %u bit/s", HN_CANBitrate(regressNode[0]));
+	CHECK(true == HN_CANOnBus(regressNode[1]), "child not on the bus");
+
+	regressClear();
+	regressCommand(0, "MYADR");
+	CHECK(NULL != strstr(regressPort[0].textPtr, "My ID is: 00000001"), "no master claim: \"%s\"", regressPort[0].textPtr);
+
+	// Commissioning: the button asks, the operator assigns
+	regressClear();
+	HN_Button(regressNode[1], true);
+	regressRun(50);
+	HN_Button(regressNode[1], false);
+	regressRun(200);
+	CHECK(NULL != strstr(regressPort[0].textPtr, "Need Node address"), "no address request: \"%s\"", regressPort[0].textPtr);
+
+	// The child takes up its new filters as it handles the ASSIGN, so it
+	// answers at the new address straight away
+	regressCommand(0, "ASSIGN 5");
+	regressClear();
+	regressCommand(0, "VER 5");
+	CHECK(NULL != strstr(regressPort[0].textPtr, "0x0005 0x0001 0x04E5"), "node 5 deaf after ASSIGN: \"%s\"", regressPort[0].textPtr);
+	regressClear();
+	regressCommand(0, "RESET 5");
+	regressRun(1000);
+	CHECK(1 == HN_ResetCount(regressNode[1]), "child reset %u times, wanted once", HN_ResetCount(regressNode[1]));
+	CHECK(HS_RESET_SOFTWARE == HN_LastReset(regressNode[1]), "child reset by %d", (int)HN_LastReset(regressNode[1]));
+
+	// Only the address from flash can answer this
+	regressClear();
+	regressCommand(0, "VER 5");
+	CHECK(NULL != strstr(regressPort[0].textPtr, "0x0005 0x0001 0x04E5"), "no version from node 5: \"%s\"", regressPort[0].textPtr);
+
+	// The child has no console: the master turns its auto-bitrate on
+	regressClear();
+	regressCommand(0, "BITRATE AUTO ON 5");
+	CHECK(NULL != strstr(regressPort[0].textPtr, "BITRATE 5: AUTO ON"), "auto-bitrate not set on node 5: \"%s\"", regressPort[0].textPtr);
+
+	// ... and its bus-off recovery wait
+	regressClear();
+	regressCommand(0, "CANERR BACKOFF 200 8000 5");
+	CHECK(NULL != strstr(regressPort[0].textPtr, "CANERR 5: BACKOFF SET"), "backoff not set on node 5: \"%s\"", regressPort[0].textPtr);
+
+	// A cancelled load lets go of the child: it answers VER, not "command
+	// during load"
+	regressClear();
+	sprintf(line, "LOAD 5 %08lX", HT_APP_BASE);
+	regressCommand(0, line);
+	jobPtr = strstr(regressPort[0].textPtr, "JOB ");
+	CHECK((NULL != jobPtr) && (1 == sscanf(jobPtr, "JOB %u", &job)), "LOAD did not start: \"%s\"", regressPort[0].textPtr);
+	regressCommand(0, ":0001020304050607");
+	sprintf(line, "CANCEL %u", job);
+	regressCommand(0, line);
+	regressRun(6000);		// SET_BASE waits 5 s for refusals
+	CHECK(NULL != strstr(regressPort[0].textPtr, "LOAD CANCELLED"), "load not cancelled: \"%s\"", regressPort[0].textPtr);
+	regressClear();
+	regressCommand(0, "VER 5");
+	CHECK(NULL != strstr(regressPort[0].textPtr, "0x0005 0x0001 0x04E5"), "child still loading: \"%s\"", regressPort[0].textPtr);
+
+	// A switch the host never acknowledges falls back -- after the full wait,
+	// however many other lines wake it meanwhile
+	regressClear();
+	regressCommand(0, "BAUD 230400");
+	CHECK(NULL != strstr(regressPort[0].textPtr, "BAUD OK 230400"), "no BAUD OK: \"%s\"", regressPort[0].textPtr);
+	for (int line = 0; line < 50; line++)
+	{
+		HN_UARTSend(regressNode[0], "X\r", 2);
+	}
+	regressRun(1600);
+	CHECK(NULL == strstr(regressPort[0].textPtr, "BAUD FALLBACK"), "fell back early: \"%s\"", regressPort[0].textPtr);
+	regressRun(400);
+	CHECK(NULL != strstr(regressPort[0].textPtr, "BAUD FALLBACK"), "never fell back: \"%s\"", regressPort[0].textPtr);
+
+	regressRun(5000);
+	CHECK(0 == HN_ResetCount(regressNode[0]), "master reset %u times idling", HN_ResetCount(regressNode[0]));
+	CHECK(1 == HN_ResetCount(regressNode[1]), "child reset %u times idling", HN_ResetCount(regressNode[1]));
+	CHECK(0 == HN_UARTDropped(regressNode[0]), "master dropped %u UART bytes", HN_UARTDropped(regressNode[0]));
+	CHECK(0 != regressFrames, "nothing crossed the wire");
+
+	// A global RESET has to leave the master before the master resets
+	regressCommand(0, "RESET 0");
+	regressRun(1000);
+	CHECK(1 == HN_ResetCount(regressNode[0]), "master reset %u times on RESET 0", HN_ResetCount(regressNode[0]));
+	CHECK(2 == HN_ResetCount(regressNode[1]), "child reset %u times on RESET 0", HN_ResetCount(regressNode[1]));
+}
+
+static void regressCharQueue(void)
+{
+	QUEUE_MGT_STRUCT queue;
+	uint8_t buffer[8];
+	uint8_t ch = 0;
+
+	CQ_Init(&queue, buffer, sizeof(buffer));
+	CHECK(false == CQ_DequeueChar(&queue, &ch), "dequeued from an empty queue");
+
+	// Full with a line in it: refused, and kept
+	CHECK(true == CQ_EnqueueBlock(&queue, (const uint8_t *)"abcdefg\r", 8), "a full line did not fit");
+	CHECK(false == CQ_EnqueueChar(&queue, 'h'), "took a ninth character");
+	CHECK(8 == queue.char_count, "%d left after overfilling", (int)queue.char_count);
+
+	// Around the end of the buffer and back
+	for (int i = 0; i < 3; i++)
+	{
+		CHECK((true == CQ_DequeueChar(&queue, &ch)) && (('a' + i) == ch), "out of order at %d", i);
+	}
+	CHECK(true == CQ_EnqueueBlock(&queue, (const uint8_t *)"xy\r", 3), "no room after dequeueing");
+	CHECK(2 == queue.term_count, "%d terminators counted", queue.term_count);
+	CHECK((true == CQ_Peek(&queue, &ch)) && ('d' == ch), "peeked '%c'", ch);
+
+	// Full with no line in it: garbage, flushed
+	CQ_Flush(&queue);
+	CHECK(0 == queue.char_count, "%d left after a flush", (int)queue.char_count);
+	CHECK(true == CQ_EnqueueBlock(&queue, (const uint8_t *)"abcdefgh", 8), "eight did not fit");
+	CHECK(false == CQ_EnqueueChar(&queue, 'i'), "took a ninth character");
+	CHECK(false == CQ_DequeueChar(&queue, &ch), "garbage with no terminator kept");
+}
+
+// The pools are firmware variables: this works on the copy the last node to
+// run left loaded, so it comes after the nodes are done with
+static void regressMemPool(void)
+{
+	void *blocks[MP_SMALL_BLOCKS + MP_MEDIUM_BLOCKS + MP_LARGE_BLOCKS];
+	void *blockPtr;
+	MP_STATS stats;
+	int count = 0;
+
+	CHECK(NULL == MP_Alloc(MP_LARGE_SIZE + 1), "got a block bigger than the biggest class");
+
+	// Small requests spill into the bigger classes until every block is out
+	while ((count < (int)(sizeof(blocks) / sizeof(blocks[0]))) &&
+			(NULL != (blocks[count] = MP_Alloc(MP_SMALL_SIZE))))
+	{
+		count++;
+	}
+	CHECK(NULL == MP_Alloc(1), "a block left over after %d", count);
+	CHECK((true == MP_Stats(0, &stats)) && (stats.blockCount == stats.inUse) && (0 < stats.failures),
+			"small class %u/%u in use, %lu failures", stats.inUse, stats.blockCount, (unsigned long)stats.failures);
+	CHECK((true == MP_Stats(MP_CLASSES - 1, &stats)) && (stats.blockCount == stats.inUse),
+			"large class %u/%u in use", stats.inUse, stats.blockCount);
+
+	// A block given back is the next one handed out, and still spills
+	blockPtr = blocks[count - 1];
+	MP_Free(blockPtr);
+	CHECK(NULL == MP_Alloc(MP_LARGE_SIZE + 1), "took an oversized request");
+	CHECK(blockPtr == MP_Alloc(1), "the free block was not reused");
+
+	while (0 < count)
+	{
+		MP_Free(blocks[--count]);
+	}
+	for (int sizeClass = 0; true == MP_Stats(sizeClass, &stats); sizeClass++)
+	{
+		CHECK(0 == stats.inUse, "class %d holds %u blocks after freeing them all", sizeClass, stats.inUse);
+		CHECK(stats.blockCount == stats.highWater, "class %d high water %u", sizeClass, stats.highWater);
+	}
+}
+
+// A node with a crash record and no program must boot without erasing: the
+// program block erase stops short of the crash page, so if a written crash
+// page made the block look used, every boot would erase it again
+static void regressCrashPage(void)
+{
+	HN_CALLBACKS callbacks = {NULL, NULL, NULL};
+	HN_NODE *nodePtr = HN_Create(&callbacks);
+	uint32_t record[REGRESS_CRASH_BYTES / sizeof(uint32_t)];
+	uint32_t erases;
+
+	HN_PowerOn(nodePtr);
+	memset(record, 0, sizeof(record));
+	record[0] = REGRESS_CRASH_MAGIC;
+	CHECK(true == HN_WriteFlash(nodePtr, CR_StoreBase(), record, sizeof(record)), "crash page not written");
+
+	erases = HN_FlashErases(nodePtr);
+	HN_PowerOn(nodePtr);
+	HN_RunUntil(nodePtr, HN_Now(nodePtr) + 1000000);
+	CHECK(erases == HN_FlashErases(nodePtr), "%u pages erased booting with a crash record",
+			HN_FlashErases(nodePtr) - erases);
+	HN_Destroy(nodePtr);
+}
+
+int main(void)
+{
+	regressNodes();
+	regressCharQueue();
+	regressMemPool();
+	regressCrashPage();
+
+	printf("hostregress: %u frames, %d failures\n", regressFrames, htFailures);
+	return((0 == htFailures) ? 0 : 1);
+}
@@ -0,0 +1,51 @@
+/*
+ * BootHandoff.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef BOOTHANDOFF_H_
+#define BOOTHANDOFF_H_
+
+#include "stm32f3xx.h"
+
+// Loader -> application hand-off contract
+// ========================================
+//
+// The low flash image decides from Reset_Handler (LoaderEarlyEntry), before
+// .data/.bss init, SystemInit() or HAL_Init() have run.  When it hands off to
+// the image at RELO_APP_BASE the following state carries over:
+//
+//		SYSCLK		72 MHz from PLL (HSI / PREDIV 1 * 9)
+//		HCLK		SYSCLK / 1
+//		PCLK1		HCLK / 2  (36 MHz -- CAN and USART2 timing assume this)
+//		PCLK2		HCLK / 1
+//		FLASH		2 wait states, prefetch enabled
+//		VTOR		RELO_APP_BASE
+//		MSP			initial stack pointer from the application vector table
+//		PRIMASK		cleared (nothing can fire -- see below)
+//
+// EVERYTHING else is in reset state: no peripheral clocks, no NVIC lines
+// enabled, SysTick stopped.  Every entry into the loader is a hardware reset
+// (RestartNode() resets, it does not jump), so the loader never has to undo
+// an application's configuration.
+//
+// The application must not trust a flag for this -- it checks the clock tree
+// itself with BOOT_HANDOFF_CLOCK_READY().  If the PLL failed to lock the
+// loader leaves the clock at reset state and the application falls back to
+// its full SystemInit()/SystemClock_Config() bring-up.
+
+#define BOOT_HANDOFF_SYSCLK_HZ		((uint32_t)72000000)
+
+#define BOOT_HANDOFF_CFGR_MASK		(RCC_CFGR_SWS | RCC_CFGR_PLLSRC | RCC_CFGR_PLLMUL | \
+									 RCC_CFGR_HPRE | RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2)
+
+#define BOOT_HANDOFF_CFGR_VALUE		(RCC_CFGR_SWS_PLL | RCC_CFGR_PLLSRC_HSI_PREDIV | RCC_CFGR_PLLMUL9 | \
+									 RCC_CFGR_HPRE_DIV1 | RCC_CFGR_PPRE1_DIV2 | RCC_CFGR_PPRE2_DIV1)
+
+#define BOOT_HANDOFF_CLOCK_READY()	((BOOT_HANDOFF_CFGR_VALUE == (RCC->CFGR & BOOT_HANDOFF_CFGR_MASK)) && \
+									 (0 == (RCC->CFGR2 & RCC_CFGR2_PREDIV)) && \
+									 (FLASH_ACR_LATENCY_1 == (FLASH->ACR & FLASH_ACR_LATENCY)))
+
+#endif /* BOOTHANDOFF_H_ */
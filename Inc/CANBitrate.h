@@ -0,0 +1,92 @@
+/*
+ * CANBitrate.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef CANBITRATE_H_
+#define CANBITRATE_H_
+
+#include "main.h"
+#include "stm32f3xx_hal.h"
+#include "cmsis_os.h"
+
+#include <stdbool.h>
+
+#include "CANTiming.h"
+
+// Runtime CAN bitrate
+// ===================
+//
+// The bit timing comes from CT_Solve() against the real PCLK1, and the last
+// confirmed rate is kept in the system block -- without one the node runs
+// MX_CAN_Init()'s 500 kbit/s.
+//
+// A bus-wide change is driven by the master in three steps:
+//
+//	1. CAN_BITRATE_PREPARE (global)	every node solves the new timing and ACKs,
+//									or answers BITRATE_ERR_NO_TIMING
+//	2. CAN_BITRATE_COMMIT (global)	every node switches DELAY ms later and goes
+//									on trial
+//	3. CAN_BITRATE_CONFIRM (global)	sent by the master BR_CONFIRM_DELAY_MS into
+//									the new rate; a child that hears it keeps the
+//									rate and ACKs, and the first ACK makes the
+//									master keep it too
+//
+// The operator sends COMMIT (BITRATE COMMIT) after reading the READY lines.
+// The master keeps no roster of its children, so it cannot wait for "all of
+// them" itself; what it does know is a refusal, and one NO TIMING drops the
+// prepared rate (BR_Refused()) so COMMIT has nothing to send until a rate
+// every node can run is prepared.  A child that missed PREPARE altogether
+// ignores COMMIT, stays behind, and finds the bus again with auto-bitrate.
+//
+// A node still on trial BR_TRIAL_MS after switching has not heard anyone at
+// the new rate: it goes back to the old one.  Nothing is written to flash
+// until the rate is kept, so a reset also lands on the last good rate.
+//
+// Payloads are MSB first: PREPARE is RATE kbit/s(2) SAMPLE permille(2),
+// COMMIT is DELAY ms(2), AUTO is ON(1).
+//
+// Auto-bitrate (BITRATE AUTO ON [ID], kept in the system block)
+// -------------
+//
+// Children have no console, so the master sets it for them with
+// CAN_BITRATE_AUTO; the ACK carries the setting back.
+//
+// A node that was off during a bus-wide change powers up at a rate nobody
+// uses any more.  With auto-bitrate on, BR_AutoDetect() listens in silent
+// mode -- no ACKs, no error frames, so the bus never notices -- at the stored
+// rate first and then each of brCandidates[].  A clean frame picks the rate;
+// a bit, stuff, form or CRC error moves straight on to the next candidate.
+// A bus quiet for BR_AUTO_ROUNDS full rounds leaves the stored rate in place.
+// The master never auto-detects: its rate is the bus rate.
+
+#define BR_DEFAULT_SAMPLE		875			// permille -- CiA recommendation
+#define BR_SWITCH_DELAY_MS		100			// COMMIT to switch: room for the TX ring to drain
+#define BR_CONFIRM_DELAY_MS		50			// lets every node finish switching first
+#define BR_TRIAL_MS				1000
+#define BR_AUTO_LISTEN_MS		50			// per candidate -- a few frames at 10 kbit/s
+#define BR_AUTO_ROUNDS			3
+
+typedef enum _BR_EVENT
+{
+	BR_EVENT_NONE,
+	BR_EVENT_SWITCHED,		// running at the new rate, on trial
+	BR_EVENT_CONFIRM_DUE,	// master: send CAN_BITRATE_CONFIRM now
+	BR_EVENT_FALLBACK		// trial expired -- back at the old rate
+} BR_EVENT;
+
+void BR_Init(void);
+bool BR_AutoDetect(void);
+bool BR_AutoEnabled(void);
+void BR_SetAuto(bool enabled);
+bool BR_Prepare(uint32_t kbitPerSec, uint16_t samplePermille);
+bool BR_Commit(uint16_t delayMs);
+void BR_Refused(void);
+bool BR_Confirm(void);
+BR_EVENT BR_Poll(uint32_t *waitMsPtr);
+uint32_t BR_Bitrate(void);
+void BR_Report(void);
+
+#endif /* CANBITRATE_H_ */
@@ -0,0 +1,73 @@
+/*
+ * CANBusState.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef CANBUSSTATE_H_
+#define CANBUSSTATE_H_
+
+#include "main.h"
+#include "stm32f3xx_hal.h"
+#include "cmsis_os.h"
+
+#include <stdbool.h>
+
+// CAN error state
+// ===============
+//
+// The controller's own fault confinement, read from CAN->ESR:
+//
+//		ERROR_ACTIVE	TEC and REC below 96
+//		WARNING			either counter at 96 or more (EWGF)
+//		PASSIVE			either counter above 127 (EPVF) -- passive error flags only
+//		BUS_OFF			TEC above 255 (BOFF) -- off the bus until recovered
+//
+// Automatic bus-off management is off in MX_CAN_Init(), so recovery is ours:
+// BS_BACKOFF_MIN ms after going bus-off the controller is cycled through
+// initialization mode, after which it rejoins once it has seen 128 x 11
+// recessive bits.  Going bus-off again before BS_STABLE_MS at error-active
+// doubles the wait, up to the maximum.  CANERR BACKOFF <min> <max> changes
+// both (system block); with an ID after them the master sends a child
+// CAN_BUS_BACKOFF, MIN ms(2) MAX ms(2) MSB first.
+//
+// Every state change is logged with the counters and the time.  A child back
+// at error-active sends the unreported ones to the master as
+// CAN_BUS_STATE | ACK, one frame each:
+//
+//		STATE(1) TEC(1) REC(1) SEQ(1) AGE ms(4, MSB first)
+
+#define BS_BACKOFF_MIN_MS		100
+#define BS_BACKOFF_MAX_MS		5000
+#define BS_STABLE_MS			10000
+#define BS_POLL_MS				100			// counters fall silently -- no interrupt back to active
+#define BS_LOG_ENTRIES			8
+
+typedef enum _BS_STATE
+{
+	BS_ERROR_ACTIVE,
+	BS_WARNING,
+	BS_PASSIVE,
+	BS_BUS_OFF
+} BS_STATE;
+
+typedef struct _BS_TRANSITION
+{
+	uint8_t		state;			// BS_STATE entered
+	uint8_t		tec;
+	uint8_t		rec;
+	uint8_t		seq;			// wraps; a gap at the master means lost entries
+	uint32_t	tick;
+} BS_TRANSITION;
+
+void BS_Init(void);
+void BS_Poll(uint32_t *waitMsPtr);
+BS_STATE BS_State(void);
+bool BS_NextReport(BS_TRANSITION *transitionPtr);
+const char *BS_StateName(uint8_t state);
+bool BS_BackoffValid(uint32_t minMs, uint32_t maxMs);
+bool BS_SetBackoff(uint32_t minMs, uint32_t maxMs);
+void BS_Report(void);
+
+#endif /* CANBUSSTATE_H_ */
@@ -19,6 +19,8 @@ uint32_t CAN_MyID(void);
 bool CAN_IAmMaster(void);
 bool CAN_IAmAssignedChild(void);
 void CAN_ClaimMaster(void);
+void CAN_Wake(void);
+void CAN_Restart(void);
 
 bool CAN_GetAddresses(void);
 bool CAN_AssignAddress(uint32_t addr);
@@ -30,8 +32,19 @@ bool CAN_EraseProgramBlock(uint32_t addr);
 bool CAN_ProgramStart(int id, uint32_t baseAddr);
 bool CAN_ProgramChar(uint8_t ch);
 bool CAN_ProgramClose(void);
+bool CAN_ProgramAbort(void);
 bool CAN_RestartNode(int id);
 bool CAN_GetReportVersion(int id);
+bool CAN_GetReportStats(int id);
+bool CAN_GetCrashRecord(int id, uint8_t index);
+bool CAN_BitratePrepare(uint32_t kbitPerSec, uint16_t samplePermille);
+bool CAN_BitrateCommit(void);
+bool CAN_BitrateAuto(int id, bool enabled);
+bool CAN_GetBusState(int id);
+bool CAN_SetBusBackoff(int id, uint16_t minMs, uint16_t maxMs);
+bool CAN_InjectFrame(uint32_t extId, uint8_t dlc, const uint8_t *dataPtr);
+uint32_t CAN_ErrorCount(void);
+uint32_t CAN_TxDropped(void);
 
 
 void cbCANLoadError(void const * argument);
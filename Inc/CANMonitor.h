@@ -0,0 +1,62 @@
+/*
+ * CANMonitor.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef CANMONITOR_H_
+#define CANMONITOR_H_
+
+#include "main.h"
+#include "stm32f3xx_hal.h"
+#include "cmsis_os.h"
+
+#include <stdbool.h>
+
+// Bus monitor (sniffer) for the master.
+//
+// MONITOR ON opens the acceptance filters and timestamps every received frame
+// (microseconds, from the DWT cycle counter) into a RAM ring straight from the
+// RX interrupt.  Frames addressed to this node still go on to the CAN task;
+// everything else is only recorded.  The FrameLog task packs the ring into
+// HL_MSG_CAN_MONITOR frames on the host link.
+//
+// Each HL_MSG_CAN_MONITOR payload is self contained:
+//
+//		| FORMAT(1) | DROPPED(4) | BASE TIME us(4) | BASE ID(4) | records ... |
+//
+// DROPPED is the running total of frames lost to a full ring or a hardware
+// FIFO overrun.  Every record starts with a flags byte (MON_FLAG_xxx, low
+// nibble = DLC), then:
+//
+//		MON_FORMAT_PLAIN	TIME us(4) ID(4) DATA(DLC)
+//		MON_FORMAT_DELTA	varint(TIME - previous TIME)
+//							varint(zigzag(ID - previous ID)), absent with MON_FLAG_SAME_ID
+//							DATA(DLC)
+//
+// "previous" starts at the BASE values of the payload.  Varints are LEB128.
+// Tools/CanMonitor/canmon.c turns the stream into a candump log.
+
+#define MON_RING_RECORDS		128
+
+#define MON_FORMAT_PLAIN		0x00
+#define MON_FORMAT_DELTA		0x01
+
+#define MON_FLAG_DLC_MASK		0x0F
+#define MON_FLAG_EXT			0x10
+#define MON_FLAG_RTR			0x20
+#define MON_FLAG_SAME_ID		0x40
+
+#define MON_HEADER_LENGTH		13
+
+void MON_Start(bool delta);
+void MON_Stop(void);
+bool MON_Active(void);
+uint32_t MON_Dropped(void);
+
+void MON_Capture(const CAN_RxHeaderTypeDef *headerPtr, const uint8_t *dataPtr);
+void MON_CountOverrun(void);
+bool MON_Pump(void);
+
+#endif /* CANMONITOR_H_ */
@@ -0,0 +1,49 @@
+/*
+ * CANTiming.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef CANTIMING_H_
+#define CANTIMING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// bxCAN bit-timing solver
+//
+// One bit is 1 + BS1 + BS2 time quanta of PRESCALER / clockHz each, sampled
+// at the end of BS1.  CT_Solve() searches every legal split for the requested
+// bitrate and sample point:
+//
+//		1. bitrate error, which must be within CT_RATE_TOLERANCE_PPM
+//		2. sample point error
+//		3. more quanta per bit -- finer resynchronization
+//
+// in that order.  SJW is as wide as BS2 allows, up to 4.  No HAL in here, so
+// Tools/CanTiming/cantiming_test.c checks it on the host.
+
+#define CT_BITRATE_MAX			1000000		// ISO 11898 classic CAN
+#define CT_PRESCALER_MAX		1024
+#define CT_BS1_MAX				16
+#define CT_BS2_MIN				2			// ISO 11898-1: phase segment 2 covers the 2 tq processing time
+#define CT_BS2_MAX				8
+#define CT_SJW_MAX				4
+#define CT_QUANTA_MIN			8
+#define CT_QUANTA_MAX			25
+#define CT_RATE_TOLERANCE_PPM	1000		// 0.1% -- well inside the CAN oscillator budget
+
+typedef struct _CT_TIMING
+{
+	uint16_t	prescaler;		// 1 .. CT_PRESCALER_MAX
+	uint8_t		bs1;			// quanta, 1 .. CT_BS1_MAX
+	uint8_t		bs2;			// quanta, CT_BS2_MIN .. CT_BS2_MAX
+	uint8_t		sjw;			// quanta, 1 .. CT_SJW_MAX
+} CT_TIMING;
+
+bool CT_Solve(uint32_t clockHz, uint32_t bitrate, uint16_t samplePermille, CT_TIMING *timingPtr);
+uint32_t CT_Bitrate(uint32_t clockHz, const CT_TIMING *timingPtr);
+uint16_t CT_SamplePermille(const CT_TIMING *timingPtr);
+
+#endif /* CANTIMING_H_ */
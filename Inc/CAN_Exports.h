@@ -19,6 +19,9 @@
 #define PROG_ERR_FAIL_FLASH_WRITE	14
 #define PROG_ERR_NO_LOAD				15
 #define PROG_ERR_CMD_DURING_LOAD		16
+#define BITRATE_ERR_NO_TIMING		20
+#define CRASH_ERR_NO_RECORD			30
+#define BUS_ERR_BAD_BACKOFF			40
 
 
 #define CAN_ACK_RESPONSE_BIT			0x400
@@ -33,12 +36,23 @@
 #define CAN_LED_STATE_CONTROL		0x05
 #define CAN_SWITCH_STATE				0x06
 
+// Bus-wide bitrate change -- see CANBitrate.h
+#define CAN_BITRATE_PREPARE			0x07
+#define CAN_BITRATE_COMMIT			0x08
+#define CAN_BITRATE_CONFIRM			0x09
+#define CAN_BUS_STATE				0x0A		// error state and counters -- see CANBusState.h
+#define CAN_BITRATE_AUTO				0x0B		// ON(1) -- auto-bitrate from the next power-up
+#define CAN_BUS_BACKOFF				0x0C		// MIN ms(2) MAX ms(2) -- bus-off recovery wait
+
 // Paving the way for a boot loader
 #define CAN_ERASE_SYS_BLOCK			0xE0
 #define CAN_ERASE_PROGRAM_BLOCK		0xE1
 #define	CAN_PROGRAM_SET_BASE			0xE2
+#define CAN_PROGRAM_ABORT			0xE3		// the master gave up -- no reply
 #define CAN_PROGRAM_CLOSE			0xE4
 #define CAN_REPORT_VERSION			0xE5
+#define CAN_REPORT_STATS			0xE6		// one ACK per task: index, CPU%, stack free, name
+#define CAN_REPORT_CRASH			0xE7		// INDEX(1) -- CR_CHUNKS ACKs, see Crash.h
 #define CAN_PROGRAM_BLOCK			0xF0		// LS 3 bits are sequence number 0 - 7
 #define CAN_PROGRAM_BLOCK_0			(CAN_PROGRAM_BLOCK + 0)
 #define CAN_PROGRAM_BLOCK_1			(CAN_PROGRAM_BLOCK + 1)
@@ -0,0 +1,44 @@
+/*
+ * CLIParse.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef CLIPARSE_H_
+#define CLIPARSE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Allocation free pieces of the text CLI.
+//
+// CLI_Tokenize() splits a line in place -- separators are overwritten with
+// '\0' and argv[] points into the line itself.
+//
+// CLI_Hash() is FNV-1a from CLI_HASH_SEED, top CLI_HASH_BITS bits.  The seed
+// is chosen offline so every command in UARTHandler.c lands in its own slot
+// (Tools/CliHash/clihash.c prints the seed and the index initializer); the
+// table is checked once at start-up.
+//
+// One line may carry several commands separated by CLI_COMMAND_SEPARATOR;
+// CLI_NextCommand() peels them off in place.  CLI_TokenizeHead() splits only
+// the first headArgs words and hands back the untouched rest of the line as
+// one more argument (DEF uses it for the macro body).  CLI_ParseRange()
+// reads "first..last".
+
+#define CLI_MAX_ARGS		8
+#define CLI_HASH_BITS		6
+#define CLI_HASH_SLOTS		(1 << CLI_HASH_BITS)
+#define CLI_HASH_SEED		0x00000C70UL
+#define CLI_COMMAND_SEPARATOR	';'
+#define CLI_RANGE_SEPARATOR		".."
+
+int CLI_Tokenize(char *linePtr, char *argv[], int maxArgs);
+int CLI_TokenizeHead(char *linePtr, char *argv[], int headArgs);
+char *CLI_NextCommand(char **linePtrPtr);
+uint32_t CLI_Hash(const char *strPtr);
+bool CLI_ParseUnsigned(const char *strPtr, uint8_t radix, uint32_t *valuePtr);
+bool CLI_ParseRange(const char *strPtr, uint8_t radix, uint32_t *firstPtr, uint32_t *lastPtr);
+
+#endif /* CLIPARSE_H_ */
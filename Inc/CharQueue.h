@@ -86,6 +86,9 @@ typedef struct _QUEUE_MGT_STRUCT
 ******************************************************************************/
 bool CQ_AboveWaterMark(QUEUE_MGT_STRUCT *inst_ptr);
 extern bool CQ_EnqueueChar(QUEUE_MGT_STRUCT *inst_ptr, uint8_t ch);
+extern bool CQ_EnqueueBlock(QUEUE_MGT_STRUCT *inst_ptr,
+                            const uint8_t *block_ptr,
+                            int16_t length);
 extern bool CQ_DequeueChar(QUEUE_MGT_STRUCT *inst_ptr, uint8_t *ch_ptr);
 extern bool CQ_Peek(QUEUE_MGT_STRUCT *inst_ptr, uint8_t *ch_ptr);
 extern void CQ_Flush(QUEUE_MGT_STRUCT *inst_ptr);
@@ -0,0 +1,98 @@
+/*
+ * Crash.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef CRASH_H_
+#define CRASH_H_
+
+#include "main.h"
+#include "stm32f3xx_hal.h"
+#include "cmsis_os.h"
+
+#include <stdbool.h>
+
+// Post-mortem crash records
+// =========================
+//
+// The fault handlers, _Error_Handler() and the task supervisor fill in a
+// CR_RECORD -- stacked registers, fault status/address registers, the task
+// that was running and the top of its stack -- in CCM-RAM that the reset
+// leaves alone, and reset the node.  CR_Init() (main(), ahead of the other
+// init) moves a record found there into the crash page, the flash page
+// just below the system block, which keeps the last CR_SLOTS crashes across
+// power cycles and program loads.
+//
+// CRASH lists this node's records; CRASH <ID> [n] shows record n (0 is the
+// newest), pulled from a child with CAN_REPORT_CRASH.  The child answers with
+// CR_CHUNKS ACK frames of INDEX(1) CHUNK(1) BYTES(6), or CRASH_ERR_NO_RECORD.
+
+#define CR_STACK_WORDS			8
+#define CR_CHUNK_BYTES			6
+#define CR_CHUNKS				((sizeof(CR_RECORD) + CR_CHUNK_BYTES - 1) / CR_CHUNK_BYTES)
+#define CR_SLOTS				(FLASH_PAGE_SIZE / sizeof(CR_RECORD))
+
+// Plain numbers -- CR_FAULT_ENTRY() pastes them into assembler
+#define CR_REASON_HARDFAULT		1
+#define CR_REASON_MEMMANAGE		2
+#define CR_REASON_BUSFAULT		3
+#define CR_REASON_USAGEFAULT	4
+#define CR_REASON_ERROR			5		// _Error_Handler(): FILE and LINE say where
+#define CR_REASON_WATCHDOG		6		// TASK missed its check-in by LINE ms (Watchdog.h)
+
+#define CR_FLAG_FRAME			0x01	// FRAME holds the stacked registers
+#define CR_FLAG_PSP				0x02	// a task was running (process stack)
+#define CR_FLAG_HANDLER			0x04	// the fault hit an interrupt handler
+#define CR_FLAG_FPU_FRAME		0x08	// extended frame: FPU state follows FRAME
+
+typedef struct _CR_RECORD
+{
+	uint32_t	magic;
+	uint8_t		reason;
+	uint8_t		flags;
+	uint16_t	line;
+	uint32_t	uptimeMs;
+	uint32_t	frame[8];				// R0 R1 R2 R3 R12 LR PC xPSR
+	uint32_t	cfsr;
+	uint32_t	hfsr;
+	uint32_t	mmfar;
+	uint32_t	bfar;
+	uint32_t	excReturn;
+	uint32_t	sp;						// before the exception
+	char		task[8];
+	char		file[16];
+	uint32_t	stack[CR_STACK_WORDS];	// from SP up
+	uint32_t	check;
+} CR_RECORD;							// 128 bytes, 16 to a page
+
+// The body of a fault handler (which must be naked, so nothing has moved
+// the stack yet): hand the exception frame to CR_Fault().  The host build
+// (Host/) has no exception frame and brings its own.
+#define CR_STRINGIFY(x)			#x
+#ifndef CR_FAULT_ENTRY
+#define CR_FAULT_ENTRY(reason)	__asm volatile(	\
+		"tst lr, #4\n\t"						\
+		"ite eq\n\t"							\
+		"mrseq r0, msp\n\t"						\
+		"mrsne r0, psp\n\t"						\
+		"mov r1, lr\n\t"						\
+		"movs r2, #" CR_STRINGIFY(reason) "\n\t"	\
+		"b CR_Fault\n\t")
+#endif
+
+void CR_Fault(uint32_t *framePtr, uint32_t excReturn, uint32_t reason) __attribute__((noreturn));
+void CR_Error(const char *filePtr, int line) __attribute__((noreturn));
+void CR_Watchdog(const char *taskNamePtr, uint32_t lateMs) __attribute__((noreturn));
+void CR_Init(void);
+uint32_t CR_StoreBase(void);
+int CR_Count(void);
+bool CR_Get(int index, CR_RECORD *recordPtr);
+void CR_Clear(void);
+bool CR_Assemble(const uint8_t *dataPtr, CR_RECORD *recordPtr);
+void CR_Print(uint16_t source, uint8_t index, const CR_RECORD *recordPtr);
+void CR_ReportRecord(uint8_t index);
+void CR_Report(void);
+
+#endif /* CRASH_H_ */
@@ -39,6 +39,7 @@ bool IAmInLowFlash(void);
 bool ValidProgramInHighFlash(void);
 bool UpperBlockIsEmpty(void);
 void JumpToHighFlash(void);
+void LoaderEarlyEntry(void);
 
 bool DidLoadOccur(void);
 void LoadSetup(int id, uint32_t baseAddr);
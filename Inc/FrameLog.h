@@ -0,0 +1,50 @@
+/*
+ * FrameLog.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef FRAMELOG_H_
+#define FRAMELOG_H_
+
+#include "main.h"
+#include "stm32f3xx_hal.h"
+#include "cmsis_os.h"
+
+#include <stdbool.h>
+
+// Deferred report of received CAN frames.
+//
+// FL_Record() only copies a fixed size record into a RAM ring -- no malloc, no
+// formatting, no waiting on the UART -- and is safe from tasks and ISRs.  The
+// low priority FrameLog task turns the records into the familiar text lines,
+// or in binary mode (and whenever the host link is framed) sends each packed
+// FL_RECORD as an HL_MSG_CAN_CAPTURE frame.
+//
+// When the ring is full new records are dropped and counted; text mode
+// reports the count once there is room again, the host link via HL_MSG_STATS.
+//
+// The task sleeps until FL_Record() (or MON_Start()) wakes it; only while the
+// monitor runs does it look in every millisecond, so captures go out batched.
+
+#define FL_RING_RECORDS		64
+
+typedef struct __attribute__((packed)) _FL_RECORD
+{
+	uint32_t	timestamp;		// RTOS ticks (ms)
+	uint16_t	source;
+	uint16_t	destination;
+	uint16_t	command;
+	uint8_t		data[8];
+} FL_RECORD;
+
+void FL_Record(uint16_t source, uint16_t destination, uint16_t command, const uint8_t *dataPtr);
+void FL_SetBinary(bool binary);
+bool FL_IsBinary(void);
+uint32_t FL_Dropped(void);
+void FL_Wake(void);
+
+extern void taskFrameLog(void const * argument);
+
+#endif /* FRAMELOG_H_ */
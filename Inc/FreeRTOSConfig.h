@@ -90,24 +90,32 @@
 #if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
     #include <stdint.h>
     extern uint32_t SystemCoreClock;
+    void configureTimerForRunTimeStats(void);
+    unsigned long getRunTimeCounterValue(void);
+    void TR_Event(uint8_t type, uint8_t arg, uint16_t extra);
 #endif
 
 #define configUSE_PREEMPTION                     1
-#define configSUPPORT_STATIC_ALLOCATION          0
-#define configSUPPORT_DYNAMIC_ALLOCATION         1
+#define configSUPPORT_STATIC_ALLOCATION          1
+#define configSUPPORT_DYNAMIC_ALLOCATION         0
 #define configUSE_IDLE_HOOK                      0
 #define configUSE_TICK_HOOK                      0
 #define configCPU_CLOCK_HZ                       ( SystemCoreClock )
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 7 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)48000)
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
 #define configQUEUE_REGISTRY_SIZE                8
 #define configUSE_COUNTING_SEMAPHORES            1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION  1
+/* Idle with nothing due: stop the tick and WFI until the next timeout or
+interrupt.  The HAL tick shares SysTick and stands still meanwhile -- HAL
+timeouts only ever run while the core is awake, so nothing waits on it. */
+#define configUSE_TICKLESS_IDLE                  1
+#define configUSE_TRACE_FACILITY                 1
+#define configGENERATE_RUN_TIME_STATS            1
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES                    0
@@ -161,6 +169,12 @@ header file. */
 #define configASSERT( x ) if ((x) == 0) {taskDISABLE_INTERRUPTS(); for( ;; );} 
 /* USER CODE END 1 */
 
+/* USER CODE BEGIN 2 */
+/* Definitions needed when configGENERATE_RUN_TIME_STATS is on */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS configureTimerForRunTimeStats
+#define portGET_RUN_TIME_COUNTER_VALUE getRunTimeCounterValue
+/* USER CODE END 2 */
+
 /* Definitions that map the FreeRTOS port interrupt handlers to their CMSIS
 standard names. */
 #define vPortSVCHandler    SVC_Handler
@@ -172,6 +186,15 @@ standard names. */
 
 /* USER CODE BEGIN Defines */   	      
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* Trace recorder hooks (Trace.h).  The event codes are TR_EV_xxx; they are
+spelled out here because the kernel sources only see this file. */
+#define traceTASK_SWITCHED_IN()					TR_Event(0x01, (uint8_t)pxCurrentTCB->uxTCBNumber, 0)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)		TR_Event(0x04, (uint8_t)(pxQueue)->uxMessagesWaiting, (uint16_t)(uint32_t)(pxQueue))
+#define traceQUEUE_SEND_FROM_ISR_FAILED(pxQueue)	TR_Event(0x05, 0, (uint16_t)(uint32_t)(pxQueue))
+#define traceTASK_NOTIFY()						TR_Event(0x06, (uint8_t)pxTCB->uxTCBNumber, 0)
+#define traceTASK_NOTIFY_FROM_ISR()				TR_Event(0x07, (uint8_t)pxTCB->uxTCBNumber, 0)
+#define traceLOW_POWER_IDLE_BEGIN()				TR_Event(0x08, 0, (uint16_t)xExpectedIdleTime)
+#define traceLOW_POWER_IDLE_END()				TR_Event(0x09, 0, 0)
 /* USER CODE END Defines */ 
 
 #endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,77 @@
+/*
+ * HostLink.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef HOSTLINK_H_
+#define HOSTLINK_H_
+
+#include "main.h"
+#include "stm32f3xx_hal.h"
+#include "cmsis_os.h"
+
+#include <stdbool.h>
+
+// Framed binary host link on USART2
+// =================================
+//
+// The text CLI command HOSTLINK switches the port into framed mode; a
+// HL_MSG_MODE frame with payload byte 0 switches it back.
+//
+// Every frame, before encoding:
+//
+//		| TYPE | SEQ | PAYLOAD (0 .. HL_MAX_PAYLOAD) | CRC16 lo | CRC16 hi |
+//
+// CRC16 is CCITT (poly 0x1021, init 0xFFFF) over TYPE through PAYLOAD.  The
+// frame is then COBS encoded and terminated with a single 0x00, so a 0x00 on
+// the wire always ends a frame and a receiver resynchronizes on the next one.
+// Multi-byte fields are little endian.
+//
+// Host requests are answered with TYPE | HL_REPLY_BIT and the same SEQ; the
+// first payload byte is an HL_STATUS_xxx code.  Frames with a bad CRC or bad
+// COBS are dropped and counted -- the host retries on timeout.
+
+#define HL_MAX_PAYLOAD			128
+
+#define HL_MSG_CAN_INJECT		0x01	// host -> node: EXTID(4) DLC(1) DATA(DLC)
+#define HL_MSG_CAN_CAPTURE		0x02	// node -> host: FL_RECORD
+#define HL_MSG_COMMAND			0x03	// host -> node: CLI line, no terminator
+#define HL_MSG_FW_CHUNK			0x04	// host -> node: HL_FW_xxx(1) ...
+#define HL_MSG_STATS			0x05	// host -> node: empty, reply carries HL_STATS
+#define HL_MSG_MODE				0x06	// host -> node: 0 = back to text CLI
+#define HL_MSG_TEXT				0x07	// node -> host: CLI output while framed
+#define HL_MSG_CAN_MONITOR		0x08	// node -> host: packed bus monitor records (CANMonitor.h)
+#define HL_MSG_TRACE			0x09	// node -> host: TRACE DUMP records (Trace.h)
+#define HL_REPLY_BIT			0x80
+
+#define HL_FW_START				0x00	// ID(2) BASE(4); reply STATUS JOBID(2)
+#define HL_FW_DATA				0x01	// image bytes
+#define HL_FW_CLOSE				0x02	// end of image; the job reports DONE/FAILED as TEXT
+
+#define HL_STATUS_OK			0x00
+#define HL_STATUS_BAD_LENGTH	0x01
+#define HL_STATUS_FAILED		0x02
+#define HL_STATUS_UNKNOWN		0x03
+#define HL_STATUS_BUSY			0x04	// not taken -- send the same frame again
+
+typedef struct __attribute__((packed)) _HL_STATS
+{
+	uint32_t	rxFrames;
+	uint32_t	rxErrors;		// CRC, COBS or overlong frames
+	uint32_t	txFrames;
+	uint32_t	logDropped;		// FL_Dropped()
+	uint32_t	uartTxDropped;	// UART_TxDropped()
+	uint32_t	canErrors;		// CAN_ErrorCount()
+	uint32_t	monitorDropped;	// MON_Dropped()
+	uint32_t	canTxDropped;	// CAN_TxDropped()
+} HL_STATS;
+
+void HL_Enter(void);
+bool HL_Active(void);
+void HL_RxByte(uint8_t ch);
+bool HL_Send(uint8_t type, uint8_t seq, const uint8_t *payloadPtr, uint16_t length, bool wait);
+bool HL_SendText(const char *strPtr, bool wait);
+
+#endif /* HOSTLINK_H_ */
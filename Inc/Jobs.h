@@ -0,0 +1,71 @@
+/*
+ * Jobs.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef JOBS_H_
+#define JOBS_H_
+
+#include "main.h"
+#include "stm32f3xx_hal.h"
+#include "cmsis_os.h"
+
+#include <stdbool.h>
+
+// Long running console work
+// =========================
+//
+// Commands that take seconds (LOAD) run on the Job task instead of the task
+// that parsed them, so the console keeps answering and received frames keep
+// being reported meanwhile.  JOB_Submit() queues the work and hands back a job
+// ID (never 0); JOBS lists the table, CANCEL <id> asks a job to stop.
+// Cancelling is cooperative -- a job polls JOB_Cancelled() between steps, a
+// job still waiting in the queue never starts.
+//
+// The table remembers the last JOB_SLOTS jobs; the oldest finished one makes
+// room for a new submit.
+//
+// Firmware load
+// -------------
+// The load job takes the image from a pipe fed by whoever owns the port: the
+// UART task with the text console's ':' data lines, HL_FW_DATA frames on the
+// host link.  Either way the console stays in command mode and the load ends
+// at JOB_LoadClose().  A cancelled or stalled (JOB_LOAD_STALL_MS) load never
+// sends CLOSE, so no node validates a partial image, and it sends ABORT so
+// the children stop expecting one.
+
+#define JOB_SLOTS				4
+#define JOB_LOAD_PIPE_LENGTH	1024
+#define JOB_LOAD_STALL_MS		60000		// no image for this long and the load fails
+
+typedef enum _JOB_STATE
+{
+	JOB_FREE = 0,
+	JOB_QUEUED,
+	JOB_RUNNING,
+	JOB_DONE,
+	JOB_FAILED,
+	JOB_CANCELLED
+} JOB_STATE;
+
+typedef bool (*JOB_FUNCTION)(uint32_t arg0, uint32_t arg1);
+
+uint16_t JOB_Submit(const char *namePtr, JOB_FUNCTION function, uint32_t arg0, uint32_t arg1);
+bool JOB_Cancel(uint16_t id);
+JOB_STATE JOB_State(uint16_t id);
+bool JOB_Cancelled(void);
+void JOB_Progress(uint32_t count);
+void JOB_Report(uint16_t id);
+
+uint16_t JOB_LoadStart(uint32_t id, uint32_t baseAddress);
+bool JOB_LoadActive(void);
+uint16_t JOB_LoadSpace(void);
+bool JOB_LoadFeed(const uint8_t *dataPtr, uint16_t length);
+bool JOB_LoadClose(void);
+bool JOB_LoadCancel(void);
+
+extern void taskJob(void const * argument);
+
+#endif /* JOBS_H_ */
@@ -0,0 +1,49 @@
+/*
+ * MemPool.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef MEMPOOL_H_
+#define MEMPOOL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Fixed size block pools for short lived buffers
+//
+// Each size class is a static array of equal blocks with its own free list,
+// so MP_Alloc() and MP_Free() are a couple of pointer moves with interrupts
+// masked -- no list walk, no scheduler suspension -- and both are safe from
+// tasks and ISRs.  A request takes the smallest class it fits; when that class
+// is empty it spills into the next bigger one.  NULL means every class that
+// would fit is in use, and is counted.
+//
+// Blocks that were never handed out are not on the free list; they are taken
+// off the end of the array first, so the pools need no init call.
+
+#define MP_SMALL_SIZE		32
+#define MP_SMALL_BLOCKS		8
+#define MP_MEDIUM_SIZE		64
+#define MP_MEDIUM_BLOCKS	8
+#define MP_LARGE_SIZE		128
+#define MP_LARGE_BLOCKS		4
+
+#define MP_CLASSES			3
+
+typedef struct _MP_STATS
+{
+	uint16_t	blockSize;
+	uint16_t	blockCount;
+	uint16_t	inUse;
+	uint16_t	highWater;		// most blocks ever in use at once
+	uint32_t	failures;		// requests this class could not serve
+} MP_STATS;
+
+void *MP_Alloc(uint16_t size);
+void MP_Free(void *blockPtr);
+bool MP_Stats(int sizeClass, MP_STATS *statsPtr);
+void MP_Report(void);
+
+#endif /* MEMPOOL_H_ */
@@ -0,0 +1,53 @@
+/*
+ * SysBlock.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef SYSBLOCK_H_
+#define SYSBLOCK_H_
+
+#include "main.h"
+#include "stm32f3xx_hal.h"
+
+#include <stdbool.h>
+
+// Append-only record store for the node's persistent settings.
+//
+// The store lives in the last SB_PAGE_COUNT pages of flash.  Every record is
+// one 32-bit word:
+//
+//		| 31 .. 24 | 23 ..  8 | 7 .. 0 |
+//		|   KEY    |  VALUE   | CHECK  |
+//
+// Updates are appended to the active page; the last record for a key wins.
+// A page is only erased when the active page is full -- the latest value of
+// every key is then copied to the next page, and that page's header (key
+// SB_KEY_PAGE_HEADER, value = sequence number) is written LAST so a power
+// loss during the copy leaves the old page in charge.
+//
+// Reads keep no RAM state so they are safe before .data/.bss are set up
+// (LoaderEarlyEntry).
+
+#define SB_PAGE_COUNT			2
+#define SB_PAGE_WORDS			(FLASH_PAGE_SIZE / sizeof(uint32_t))
+#define SB_KEY_LIMIT			16			// keys 1 .. SB_KEY_LIMIT-1 survive a page rotation
+
+#define SB_KEY_PAGE_HEADER		0x00
+#define SB_KEY_NODE_ID			0x01
+#define SB_KEY_PROGRAM_VALID	0x02
+#define SB_KEY_CAN_BITRATE		0x03		// kbit/s (CANBitrate.h)
+#define SB_KEY_CAN_SAMPLE		0x04		// sample point, permille
+#define SB_KEY_CAN_AUTO			0x05		// non-zero: BR_AutoDetect() at power-up
+#define SB_KEY_CAN_BACKOFF_MIN	0x06		// bus-off recovery, ms (CANBusState.h)
+#define SB_KEY_CAN_BACKOFF_MAX	0x07
+
+#define SB_PROGRAM_VALID_MARK	((uint16_t)0xA55A)
+#define SB_PROGRAM_INVALID_MARK	((uint16_t)0x0000)
+
+uint32_t SB_StoreBase(void);
+bool SB_Read(uint8_t key, uint16_t *valuePtr);
+bool SB_Write(uint8_t key, uint16_t value);
+
+#endif /* SYSBLOCK_H_ */
@@ -0,0 +1,46 @@
+/*
+ * TaskStats.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef TASKSTATS_H_
+#define TASKSTATS_H_
+
+#include "main.h"
+#include "stm32f3xx_hal.h"
+#include "cmsis_os.h"
+
+#include <stdbool.h>
+
+// Per task CPU accounting
+//
+// The kernel's run-time stats count TIM2 ticks (TS_CLOCK_HZ, free running,
+// 32 bits) against whichever task is switched in.  TS_Sample() turns that into
+// the share of each task since the previous sample -- TOP, or a CAN stats
+// query on a child -- so the figures show what is busy now, not since boot.
+// Two samples more than 2^32 ticks apart (~12 hours) give garbage.
+//
+// Stack figures are the kernel's high-water marks: the fewest words ever left
+// free on that task's stack.
+
+#define TS_CLOCK_HZ		100000		// 10us resolution, 10x finer than the tick
+#define TS_MAX_TASKS	12
+
+typedef struct _TS_TASK
+{
+	const char	*namePtr;
+	uint8_t		number;			// the kernel's task number, as in trace events
+	uint8_t		priority;
+	uint16_t	cpuTenths;		// 0..1000, per mille of the sample interval
+	uint16_t	stackFree;		// words
+} TS_TASK;
+
+void TS_ClockStart(void);
+uint32_t TS_Clock(void);
+int TS_Sample(TS_TASK *tasksPtr, int maxTasks);
+int TS_List(TS_TASK *tasksPtr, int maxTasks);
+void TS_Report(void);
+
+#endif /* TASKSTATS_H_ */
@@ -0,0 +1,79 @@
+/*
+ * Trace.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "main.h"
+#include "stm32f3xx_hal.h"
+#include "cmsis_os.h"
+
+#include <stdbool.h>
+
+// Scheduler and ISR trace recorder
+// ================================
+//
+// The kernel trace hooks (FreeRTOSConfig.h) and the CAN/UART interrupt
+// handlers drop 8 byte events into a ring in CCMRAM.  Recording is a handful
+// of stores with interrupts masked, on all the time from boot; once the ring
+// is full the oldest events are overwritten, so it always holds the lead-up
+// to whatever just went wrong.
+//
+// TRACE DUMP sends the ring over the host link as HL_MSG_TRACE frames, oldest
+// event first, and starts a fresh ring.  Tools/TraceDump/tracedump.c turns
+// the dump into a Chrome trace / Perfetto JSON timeline.  Recording pauses
+// while the dump runs; events missed meanwhile are counted as lost.
+//
+// HL_MSG_TRACE payload, byte 0 is the record kind:
+//
+//		TR_DUMP_BEGIN	CLOCK_HZ(4) EVENTS(4) LOST(4)
+//		TR_DUMP_TASK	NUMBER(1) NAME(..)			-- one per task
+//		TR_DUMP_EVENTS	TR_EVENT * n
+//		TR_DUMP_END
+//
+// Timestamps are TS_Clock() (TaskStats.h) at CLOCK_HZ, 10us apiece.  Unlike
+// DWT->CYCCNT, TIM2 keeps counting while the core sleeps in tickless idle, so
+// a sleep takes the time it took.  They wrap every ~12 hours and the
+// converter unwraps them, which works as long as something happens at least
+// that often (the LED timer alone sees to it).
+
+#define TR_EVENTS				512			// 4K of the 16K CCMRAM
+
+#define TR_EV_TASK_IN			0x01	// ARG task number
+#define TR_EV_ISR_ENTER			0x02	// ARG IRQn
+#define TR_EV_ISR_EXIT			0x03	// ARG IRQn
+#define TR_EV_QUEUE_SEND_ISR	0x04	// ARG items now waiting, EXTRA queue address (low 16 bits)
+#define TR_EV_QUEUE_FULL_ISR	0x05	// EXTRA queue address (low 16 bits)
+#define TR_EV_NOTIFY			0x06	// ARG task number notified
+#define TR_EV_NOTIFY_ISR		0x07	// ARG task number notified
+#define TR_EV_SLEEP				0x08	// tickless idle: EXTRA ticks expected
+#define TR_EV_WAKE				0x09
+#define TR_EV_CAN_RX			0x0A	// ARG FIFO, EXTRA 11 bit command
+#define TR_EV_UART_RX			0x0B	// EXTRA bytes delivered
+
+#define TR_DUMP_BEGIN			0x00
+#define TR_DUMP_TASK			0x01
+#define TR_DUMP_EVENTS			0x02
+#define TR_DUMP_END				0x03
+
+typedef struct __attribute__((packed)) _TR_EVENT
+{
+	uint32_t	stamp;
+	uint8_t		type;
+	uint8_t		arg;
+	uint16_t	extra;
+} TR_EVENT;
+
+void TR_Init(void);
+void TR_Event(uint8_t type, uint8_t arg, uint16_t extra);
+void TR_SetRecording(bool on);
+bool TR_Recording(void);
+void TR_Clear(void);
+void TR_Report(void);
+bool TR_Dump(void);
+
+#endif /* TRACE_H_ */
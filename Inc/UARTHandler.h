@@ -14,11 +14,25 @@
 
 #include <stdbool.h>
 
+typedef enum _UART_FLOW_MODE
+{
+	UART_FLOW_NONE,
+	UART_FLOW_XONXOFF,		// in band, through the TX ring
+	UART_FLOW_RTSCTS		// CTS in hardware, RTS from the queue watermarks
+} UART_FLOW_MODE;
+
 bool StartSync(void);
 void WriteUARTString(char *strPtr);
+void UART_Write(const uint8_t *dataPtr, uint16_t length);
+bool UART_TryWrite(const uint8_t *dataPtr, uint16_t length);
+bool UART_TryWriteString(const char *strPtr);
+void DoUARTCommand(char *strPtr);
+uint32_t UART_TxDropped(void);
 void UART_ReportReceivedMessage(uint16_t source, uint16_t destination, uint16_t command, uint8_t *rxData);
+void UART_RxIdleCallback(void);
+void RearmUART(void);
+void UART_SetFlowControl(UART_FLOW_MODE mode);
 
-extern void cbFileTransfer(void const * argument);
 extern void taskUARTReceive(void const * argument);
 
 #endif /* UARTHANDLER_H_ */
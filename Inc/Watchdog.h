@@ -0,0 +1,50 @@
+/*
+ * Watchdog.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+#include "main.h"
+#include "stm32f3xx_hal.h"
+#include "cmsis_os.h"
+
+#include <stdbool.h>
+
+// Task supervisor and independent watchdog
+// ========================================
+//
+// Only WD_Supervise() (the default task, raised to the top priority) feeds
+// the IWDG, and only while every registered task has checked in within its
+// own deadline.  A task that misses one gets a CR_REASON_WATCHDOG crash
+// record naming it and the node resets straight away; the IWDG itself only
+// fires when the supervisor cannot run at all (interrupts off, a runaway
+// higher priority loop), which CR_Init() records as WATCHDOG in "?".
+//
+// A task registers once with WD_Register() and then calls WD_CheckIn() --
+// it finds the calling task by handle, so code shared between tasks can
+// check in for whichever one runs it.  Event driven tasks bound their waits
+// with WD_Wait() so they wake to check in even when there is nothing to do.
+// A task that ends itself calls WD_Unregister() first.
+//
+// Deadlines cover the longest wait a task does on purpose: the job task's
+// load start waits out a 5s CAN error window, the UART task can be held off
+// by the host's flow control.
+
+#define WD_IWDG_TIMEOUT_MS		2000		// nominal -- the LSI is anything from 30 to 50 kHz
+#define WD_SUPERVISE_MS			250
+#define WD_CHECKIN_MS			500			// longest an idle task sleeps between check-ins
+#define WD_DEADLINE_MS			3000
+#define WD_DEADLINE_LONG_MS		10000
+#define WD_MAX_TASKS			6
+
+void WD_Register(uint32_t deadlineMs);
+void WD_CheckIn(void);
+void WD_Unregister(void);
+uint32_t WD_Wait(uint32_t waitMs);
+void WD_Supervise(void) __attribute__((noreturn));
+
+#endif /* WATCHDOG_H_ */
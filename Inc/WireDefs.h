@@ -11,6 +11,8 @@
 // UART 2 - RX	D0	CN9.0		LC231X.TX
 // UART 2 - TX	D1	CN9.1		LC231X.RX
 // UART 2 - GND		CN6.6		LC231.GND
+// UART 2 - CTS	A0	CN8.1		LC231X.RTS	(FLOW RTS only)
+// UART 2 - RTS	A1	CN8.2		LC231X.CTS	(FLOW RTS only)
 //
 // CAN 3.3VDC 	 		CN7.16
 // CAN GND				CN7.20
@@ -83,7 +83,21 @@
 /* #define USE_FULL_ASSERT    1U */
 
 /* USER CODE BEGIN Private defines */
+// CCM-RAM placement -- see the .ccm* output sections in the linker scripts.
+// CCM-RAM is zero wait state for code and data and off the bus matrix the DMA
+// uses, but the DMA cannot reach it: never put a DMA buffer there.  Code runs
+// from it too; the linker adds long-branch veneers to and from FLASH.
+#define CCM_BSS			__attribute__((section(".ccmbss")))		// zeroed at reset
+#define CCM_NOINIT		__attribute__((section(".ccmnoinit")))	// left as found
+#define CCM_FUNC		__attribute__((section(".ccmram.text"), noinline))	// copied from FLASH at reset
 
+// USART2 flow control pins.  Not in the .ioc: MX_USART2_SetFlowControl()
+// (usart.c) claims and releases them as FLOW switches, so CubeMX must not
+// set them up in MX_GPIO_Init().
+#define USART_CTS_Pin GPIO_PIN_0
+#define USART_CTS_GPIO_Port GPIOA
+#define USART_RTS_Pin GPIO_PIN_1
+#define USART_RTS_GPIO_Port GPIOA
 /* USER CODE END Private defines */
 
 #ifdef __cplusplus
@@ -58,13 +58,15 @@
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include <stdbool.h>
 /* USER CODE END Includes */
 
 extern UART_HandleTypeDef huart2;
 
 /* USER CODE BEGIN Private defines */
-
+#define USART2_DEFAULT_BAUD		115200
+#define USART2_MIN_BAUD			1200
+#define USART2_MAX_BAUD_ERROR	20		/* per mille */
 /* USER CODE END Private defines */
 
 extern void _Error_Handler(char *, int);
@@ -72,7 +74,10 @@ extern void _Error_Handler(char *, int);
 void MX_USART2_UART_Init(void);
 
 /* USER CODE BEGIN Prototypes */
-
+bool MX_USART2_BaudSupported(uint32_t baud, uint32_t *overSamplingPtr);
+HAL_StatusTypeDef MX_USART2_SetBaud(uint32_t baud);
+HAL_StatusTypeDef MX_USART2_SetFlowControl(bool rtsCts);
+void MX_USART2_SetRTS(bool stop);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
@@ -0,0 +1,312 @@
+/*
+ * CANBitrate.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "CANBitrate.h"
+#include "CANHandler.h"
+#include "SysBlock.h"
+#include "UARTHandler.h"
+
+#include "can.h"
+
+#include <stdio.h>
+
+typedef enum _BR_STATE
+{
+	BR_IDLE,
+	BR_PREPARED,		// brPending solved, waiting for COMMIT
+	BR_SWITCHING,		// COMMIT heard, switching at brDeadline
+	BR_TRIAL			// at the new rate until confirmed or brDeadline
+} BR_STATE;
+
+static BR_STATE		brState = BR_IDLE;
+static CT_TIMING	brCurrent;
+static CT_TIMING	brPrevious;
+static CT_TIMING	brPending;
+static uint16_t		brPendingKbit;
+static uint16_t		brPendingSample;
+static uint32_t		brDeadline;
+static uint32_t		brConfirmAt;
+static bool			brConfirmSent;
+
+typedef enum _BR_LISTEN
+{
+	BR_LISTEN_QUIET,
+	BR_LISTEN_FRAME,
+	BR_LISTEN_ERROR
+} BR_LISTEN;
+
+// After the stored rate, most likely first (kbit/s)
+static const uint16_t brCandidates[] = {500, 250, 125, 1000, 800, 100, 50, 20, 10};
+
+// Write a timing into the controller.  It comes back stopped -- the caller
+// restarts it with its filters.
+static void brProgram(const CT_TIMING *timingPtr)
+{
+	HAL_CAN_Stop(&hcan);		// "not started" is fine too
+
+	hcan.Init.Prescaler = timingPtr->prescaler;
+	hcan.Init.TimeSeg1 = (uint32_t)(timingPtr->bs1 - 1) << CAN_BTR_TS1_Pos;
+	hcan.Init.TimeSeg2 = (uint32_t)(timingPtr->bs2 - 1) << CAN_BTR_TS2_Pos;
+	hcan.Init.SyncJumpWidth = (uint32_t)(timingPtr->sjw - 1) << CAN_BTR_SJW_Pos;
+	if (HAL_OK != HAL_CAN_Init(&hcan))
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+}
+
+static bool brExpired(uint32_t now, uint32_t deadline)
+{
+	return(0 <= (int32_t)(now - deadline));
+}
+
+// CAN task, before the first filter setup
+void BR_Init(void)
+{
+	uint16_t kbit;
+	uint16_t sample;
+
+	// Whatever MX_CAN_Init() left, in solver terms
+	brCurrent.prescaler = (uint16_t)hcan.Init.Prescaler;
+	brCurrent.bs1 = (uint8_t)((hcan.Init.TimeSeg1 >> CAN_BTR_TS1_Pos) + 1);
+	brCurrent.bs2 = (uint8_t)((hcan.Init.TimeSeg2 >> CAN_BTR_TS2_Pos) + 1);
+	brCurrent.sjw = (uint8_t)((hcan.Init.SyncJumpWidth >> CAN_BTR_SJW_Pos) + 1);
+
+	if ((false == SB_Read(SB_KEY_CAN_BITRATE, &kbit)) || (false == SB_Read(SB_KEY_CAN_SAMPLE, &sample)))
+	{
+		return;
+	}
+	if (true == CT_Solve(HAL_RCC_GetPCLK1Freq(), (uint32_t)kbit * 1000, sample, &brCurrent))
+	{
+		brProgram(&brCurrent);
+	}
+}
+
+// One candidate timing, silent, bank 0 taking everything
+static BR_LISTEN brListen(const CT_TIMING *timingPtr)
+{
+	CAN_FilterTypeDef acceptAll = {0};
+	CAN_RxHeaderTypeDef header;
+	uint8_t data[8];
+	uint32_t start;
+	uint32_t lec;
+
+	brProgram(timingPtr);
+
+	acceptAll.FilterMode = CAN_FILTERMODE_IDMASK;
+	acceptAll.FilterScale = CAN_FILTERSCALE_32BIT;
+	acceptAll.FilterActivation = ENABLE;
+	acceptAll.FilterBank = 0;
+	acceptAll.FilterFIFOAssignment = CAN_RX_FIFO0;
+	if ((HAL_OK != HAL_CAN_ConfigFilter(&hcan, &acceptAll)) || (HAL_OK != HAL_CAN_Start(&hcan)))
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+
+	// LEC 7 is "set by software" -- the hardware overwrites it on the next
+	// frame, 0 for a good one
+	hcan.Instance->ESR = CAN_ESR_LEC;
+	start = osKernelSysTick();
+	while (BR_AUTO_LISTEN_MS > (osKernelSysTick() - start))
+	{
+		if (0 != HAL_CAN_GetRxFifoFillLevel(&hcan, CAN_RX_FIFO0))
+		{
+			HAL_CAN_GetRxMessage(&hcan, CAN_RX_FIFO0, &header, data);		// nobody to give it to yet
+			return(BR_LISTEN_FRAME);
+		}
+		lec = hcan.Instance->ESR & CAN_ESR_LEC;
+		if ((0 != lec) && (CAN_ESR_LEC != lec))
+		{
+			return(BR_LISTEN_ERROR);
+		}
+		osDelay(1);
+	}
+	return(BR_LISTEN_QUIET);
+}
+
+bool BR_AutoEnabled(void)
+{
+	uint16_t enabled;
+
+	return((true == SB_Read(SB_KEY_CAN_AUTO, &enabled)) && (0 != enabled));
+}
+
+void BR_SetAuto(bool enabled)
+{
+	if (enabled != BR_AutoEnabled())
+	{
+		SB_Write(SB_KEY_CAN_AUTO, (true == enabled) ? 1 : 0);
+	}
+}
+
+// CAN task, after BR_Init() and before the first filter setup.  Leaves the
+// controller stopped in normal mode at the rate found (or the stored one);
+// true when a frame was heard.
+bool BR_AutoDetect(void)
+{
+	CT_TIMING stored = brCurrent;
+	CT_TIMING candidate;
+	uint32_t clockHz = HAL_RCC_GetPCLK1Freq();
+	uint16_t storedKbit = (uint16_t)(CT_Bitrate(clockHz, &stored) / 1000);
+	uint16_t sample;
+	bool found = false;
+
+	if (false == SB_Read(SB_KEY_CAN_SAMPLE, &sample))
+	{
+		sample = BR_DEFAULT_SAMPLE;		// what a BITRATE command would have used
+	}
+
+	hcan.Init.Mode = CAN_MODE_SILENT;
+	for (int round = 0; (false == found) && (BR_AUTO_ROUNDS > round); round++)
+	{
+		// -1 is the stored rate
+		for (int i = -1; (false == found) && ((int)(sizeof(brCandidates) / sizeof(brCandidates[0])) > i); i++)
+		{
+			if (0 > i)
+			{
+				candidate = stored;
+			}
+			else if ((storedKbit == brCandidates[i]) ||
+					 (false == CT_Solve(clockHz, (uint32_t)brCandidates[i] * 1000, sample, &candidate)))
+			{
+				continue;
+			}
+			if (BR_LISTEN_FRAME == brListen(&candidate))
+			{
+				brCurrent = candidate;
+				found = true;
+			}
+		}
+	}
+	hcan.Init.Mode = CAN_MODE_NORMAL;
+	brProgram(&brCurrent);
+
+	// Joined at a new rate -- the bus moved on while this node was away
+	if ((true == found) && (storedKbit != (uint16_t)(BR_Bitrate() / 1000)))
+	{
+		SB_Write(SB_KEY_CAN_BITRATE, (uint16_t)(BR_Bitrate() / 1000));
+		SB_Write(SB_KEY_CAN_SAMPLE, CT_SamplePermille(&brCurrent));
+	}
+	return(found);
+}
+
+bool BR_Prepare(uint32_t kbitPerSec, uint16_t samplePermille)
+{
+	if ((BR_SWITCHING == brState) || (BR_TRIAL == brState) || (0xFFFF < kbitPerSec))
+	{
+		return(false);
+	}
+	if (false == CT_Solve(HAL_RCC_GetPCLK1Freq(), kbitPerSec * 1000, samplePermille, &brPending))
+	{
+		brState = BR_IDLE;
+		return(false);
+	}
+	brPendingKbit = (uint16_t)kbitPerSec;
+	brPendingSample = samplePermille;
+	brState = BR_PREPARED;
+	return(true);
+}
+
+bool BR_Commit(uint16_t delayMs)
+{
+	if (BR_PREPARED != brState)
+	{
+		return(false);
+	}
+	brDeadline = osKernelSysTick() + delayMs;
+	brState = BR_SWITCHING;
+	CAN_Wake();		// the switch is the CAN task's job
+	return(true);
+}
+
+// Master: a child cannot run the prepared rate, so nobody switches to it
+void BR_Refused(void)
+{
+	if (BR_PREPARED == brState)
+	{
+		brState = BR_IDLE;
+	}
+}
+
+// Somebody answered at the new rate -- keep it.  False when not on trial.
+bool BR_Confirm(void)
+{
+	if (BR_TRIAL != brState)
+	{
+		return(false);
+	}
+	SB_Write(SB_KEY_CAN_BITRATE, brPendingKbit);
+	SB_Write(SB_KEY_CAN_SAMPLE, brPendingSample);
+	brState = BR_IDLE;
+	return(true);
+}
+
+// CAN task, every wake.  One event per call; *waitMsPtr says when to call
+// again if nothing else wakes the task first.
+BR_EVENT BR_Poll(uint32_t *waitMsPtr)
+{
+	uint32_t now = osKernelSysTick();
+
+	*waitMsPtr = osWaitForever;
+	switch (brState)
+	{
+	case BR_SWITCHING:
+		if (false == brExpired(now, brDeadline))
+		{
+			*waitMsPtr = brDeadline - now;
+			return(BR_EVENT_NONE);
+		}
+		brPrevious = brCurrent;
+		brCurrent = brPending;
+		brProgram(&brCurrent);
+		CAN_Restart();
+
+		brDeadline = now + BR_TRIAL_MS;
+		brConfirmAt = now + BR_CONFIRM_DELAY_MS;
+		brConfirmSent = (false == CAN_IAmMaster());
+		brState = BR_TRIAL;
+		*waitMsPtr = 0;
+		return(BR_EVENT_SWITCHED);
+
+	case BR_TRIAL:
+		if ((false == brConfirmSent) && (true == brExpired(now, brConfirmAt)))
+		{
+			brConfirmSent = true;
+			*waitMsPtr = 0;
+			return(BR_EVENT_CONFIRM_DUE);
+		}
+		if (true == brExpired(now, brDeadline))
+		{
+			brCurrent = brPrevious;
+			brProgram(&brCurrent);
+			CAN_Restart();
+			brState = BR_IDLE;
+			return(BR_EVENT_FALLBACK);
+		}
+		*waitMsPtr = ((false == brConfirmSent) ? brConfirmAt : brDeadline) - now;
+		return(BR_EVENT_NONE);
+
+	default:
+		return(BR_EVENT_NONE);
+	}
+}
+
+uint32_t BR_Bitrate(void)
+{
+	return(CT_Bitrate(HAL_RCC_GetPCLK1Freq(), &brCurrent));
+}
+
+void BR_Report(void)
+{
+	static const char *stateNames[] = {"", " PREPARED", " SWITCHING", " TRIAL"};
+	char reportBuffer[80];
+	uint16_t sample = CT_SamplePermille(&brCurrent);
+
+	sprintf(reportBuffer, "BITRATE %lu SP %u.%u%% PRESC %u BS1 %u BS2 %u SJW %u%s%s\n", BR_Bitrate(),
+			sample / 10, sample % 10, brCurrent.prescaler, brCurrent.bs1, brCurrent.bs2, brCurrent.sjw,
+			stateNames[brState], (true == BR_AutoEnabled()) ? " AUTO" : "");
+	WriteUARTString(reportBuffer);
+}
@@ -0,0 +1,217 @@
+/*
+ * CANBusState.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "CANBusState.h"
+#include "SysBlock.h"
+#include "UARTHandler.h"
+
+#include "can.h"
+
+#include <stdio.h>
+
+static BS_STATE			bsState = BS_ERROR_ACTIVE;
+static BS_TRANSITION	bsLog[BS_LOG_ENTRIES];
+static uint32_t			bsLogged = 0;			// entries ever written
+static uint32_t			bsReported = 0;			// entries ever handed to BS_NextReport()
+static uint32_t			bsBusOffCount = 0;
+static uint32_t			bsRecoveries = 0;
+static uint32_t			bsBackoffMin = BS_BACKOFF_MIN_MS;
+static uint32_t			bsBackoffMax = BS_BACKOFF_MAX_MS;
+static uint32_t			bsBackoff = BS_BACKOFF_MIN_MS;
+static uint32_t			bsRecoverAt;
+static uint32_t			bsActiveSince;
+
+static const char *bsStateNames[] = {"ERROR_ACTIVE", "WARNING", "PASSIVE", "BUS_OFF"};
+
+static BS_STATE bsStateFromEsr(uint32_t esr)
+{
+	if (0 != (esr & CAN_ESR_BOFF))
+	{
+		return(BS_BUS_OFF);
+	}
+	if (0 != (esr & CAN_ESR_EPVF))
+	{
+		return(BS_PASSIVE);
+	}
+	if (0 != (esr & CAN_ESR_EWGF))
+	{
+		return(BS_WARNING);
+	}
+	return(BS_ERROR_ACTIVE);
+}
+
+static bool bsExpired(uint32_t now, uint32_t deadline)
+{
+	return(0 <= (int32_t)(now - deadline));
+}
+
+static void bsLogTransition(BS_STATE state, uint32_t esr, uint32_t now)
+{
+	BS_TRANSITION *entryPtr = &bsLog[bsLogged % BS_LOG_ENTRIES];
+
+	entryPtr->state = (uint8_t)state;
+	entryPtr->tec = (uint8_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos);
+	entryPtr->rec = (uint8_t)((esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos);
+	entryPtr->seq = (uint8_t)bsLogged;
+	entryPtr->tick = now;
+	bsLogged++;
+}
+
+// With ABOM off, bus-off only ends after software passes the controller
+// through initialization mode.  Register level so the HAL state (and with it
+// HAL_CAN_AddTxMessage() for the TX ring) is left alone.
+static void bsRestartController(void)
+{
+	SET_BIT(hcan.Instance->MCR, CAN_MCR_INRQ);
+	for (int tries = 0; (tries < 10) && (0 == (hcan.Instance->MSR & CAN_MSR_INAK)); tries++)
+	{
+		osDelay(1);
+	}
+	CLEAR_BIT(hcan.Instance->MCR, CAN_MCR_INRQ);
+}
+
+// CAN task, before the first filter setup
+void BS_Init(void)
+{
+	uint16_t minMs;
+	uint16_t maxMs;
+
+	if ((true == SB_Read(SB_KEY_CAN_BACKOFF_MIN, &minMs)) && (true == SB_Read(SB_KEY_CAN_BACKOFF_MAX, &maxMs)) &&
+		(0 != minMs) && (minMs <= maxMs))
+	{
+		bsBackoffMin = minMs;
+		bsBackoffMax = maxMs;
+	}
+	bsBackoff = bsBackoffMin;
+	bsActiveSince = osKernelSysTick();
+}
+
+// CAN task, every wake.  *waitMsPtr says when to look again if nothing else
+// wakes the task first.
+void BS_Poll(uint32_t *waitMsPtr)
+{
+	uint32_t esr = hcan.Instance->ESR;
+	uint32_t now = osKernelSysTick();
+	BS_STATE state = bsStateFromEsr(esr);
+
+	if (state != bsState)
+	{
+		bsLogTransition(state, esr, now);
+		if (BS_BUS_OFF == state)
+		{
+			// Straight back into bus-off: whatever caused it is still there
+			if ((0 != bsBusOffCount) && (BS_STABLE_MS > (now - bsActiveSince)))
+			{
+				bsBackoff = (bsBackoffMax < (bsBackoff * 2)) ? bsBackoffMax : (bsBackoff * 2);
+			}
+			else
+			{
+				bsBackoff = bsBackoffMin;
+			}
+			bsBusOffCount++;
+			bsRecoverAt = now + bsBackoff;
+		}
+		else if (BS_BUS_OFF == bsState)
+		{
+			bsRecoveries++;
+		}
+		if (BS_ERROR_ACTIVE == state)
+		{
+			bsActiveSince = now;
+		}
+		bsState = state;
+	}
+
+	switch (bsState)
+	{
+	case BS_BUS_OFF:
+		if (true == bsExpired(now, bsRecoverAt))
+		{
+			bsRestartController();
+			bsRecoverAt = now + bsBackoffMax;		// 128 x 11 recessive bits should not take this long
+		}
+		*waitMsPtr = bsRecoverAt - now;
+		break;
+
+	case BS_WARNING:
+	case BS_PASSIVE:
+		*waitMsPtr = BS_POLL_MS;
+		break;
+
+	default:
+		*waitMsPtr = osWaitForever;
+		break;
+	}
+}
+
+BS_STATE BS_State(void)
+{
+	return(bsState);
+}
+
+// Oldest unreported transition, once back at error-active.  Entries the log
+// has already overwritten are skipped (the SEQ gap shows it).
+bool BS_NextReport(BS_TRANSITION *transitionPtr)
+{
+	if ((BS_ERROR_ACTIVE != bsState) || (bsReported == bsLogged))
+	{
+		return(false);
+	}
+	if (BS_LOG_ENTRIES < (bsLogged - bsReported))
+	{
+		bsReported = bsLogged - BS_LOG_ENTRIES;
+	}
+	*transitionPtr = bsLog[bsReported % BS_LOG_ENTRIES];
+	bsReported++;
+	return(true);
+}
+
+const char *BS_StateName(uint8_t state)
+{
+	return((BS_BUS_OFF >= state) ? bsStateNames[state] : "?");
+}
+
+bool BS_BackoffValid(uint32_t minMs, uint32_t maxMs)
+{
+	return((0 != minMs) && (minMs <= maxMs) && (0xFFFF >= maxMs));
+}
+
+bool BS_SetBackoff(uint32_t minMs, uint32_t maxMs)
+{
+	if (false == BS_BackoffValid(minMs, maxMs))
+	{
+		return(false);
+	}
+	bsBackoffMin = minMs;
+	bsBackoffMax = maxMs;
+	bsBackoff = minMs;
+	SB_Write(SB_KEY_CAN_BACKOFF_MIN, (uint16_t)minMs);
+	SB_Write(SB_KEY_CAN_BACKOFF_MAX, (uint16_t)maxMs);
+	return(true);
+}
+
+void BS_Report(void)
+{
+	char reportBuffer[80];
+	uint32_t esr = hcan.Instance->ESR;
+	uint32_t now = osKernelSysTick();
+	uint32_t first = (BS_LOG_ENTRIES < bsLogged) ? (bsLogged - BS_LOG_ENTRIES) : 0;
+
+	sprintf(reportBuffer, "CANERR %s TEC %lu REC %lu BUS_OFF %lu RECOVERED %lu BACKOFF %lu..%lu ms\n",
+			bsStateNames[bsStateFromEsr(esr)], (esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos,
+			(esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos, bsBusOffCount, bsRecoveries, bsBackoffMin, bsBackoffMax);
+	WriteUARTString(reportBuffer);
+
+	for (uint32_t i = first; i < bsLogged; i++)
+	{
+		const BS_TRANSITION *entryPtr = &bsLog[i % BS_LOG_ENTRIES];
+
+		sprintf(reportBuffer, "  -%lu ms %s TEC %u REC %u\n", now - entryPtr->tick,
+				bsStateNames[entryPtr->state], entryPtr->tec, entryPtr->rec);
+		WriteUARTString(reportBuffer);
+	}
+}
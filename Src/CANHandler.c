@@ -12,14 +12,24 @@
 #include "can.h"
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "FlashSupport.h"
 #include "CAN_Exports.h"
 #include "CANHandler.h"
 #include "UARTHandler.h"
+#include "CANMonitor.h"
+#include "TaskStats.h"
+#include "MemPool.h"
+#include "Trace.h"
+#include "CANBitrate.h"
+#include "CANBusState.h"
+#include "Crash.h"
+#include "Watchdog.h"
 
 extern osMessageQId CAN_ReceiveHandle;
+extern osThreadId CANReceiveTaskHandle;
 extern osTimerId CAN_LoadErrorHandle;
 extern osTimerId LEDFlashHandle;
 
@@ -27,13 +37,27 @@ static int			errorOnCAN = false;
 static int			errorCountCAN = 0;
 
 CAN_FilterTypeDef  	sFilterConfig;
-CAN_TxHeaderTypeDef	TxHeader;
 CAN_RxHeaderTypeDef	RxHeader_0;
 CAN_RxHeaderTypeDef RxHeader_1;
-uint8_t            	TxData[8];
+uint8_t            	TxData[8];			// reply() payload -- CAN task only
 uint8_t        		RxData_0[8];
 uint8_t				RxData_1[8];
-uint32_t          	TxMailbox;
+
+#define CAN_TX_RING_FRAMES	64		// a command to every node fits without waiting
+#define CAN_TX_FLUSH_MS		5		// a frame takes ~0.25 ms at 500 kbit/s, retries included
+#define CAN_SIGNAL_EVENT	0x0001
+
+typedef struct _CAN_TX_FRAME
+{
+	uint32_t	extId;
+	uint8_t		dlc;
+	uint8_t		data[8];
+} CAN_TX_FRAME;
+
+static CAN_TX_FRAME			canTxRing[CAN_TX_RING_FRAMES];
+static volatile uint16_t	canTxHead = 0;
+static volatile uint16_t	canTxTail = 0;
+static volatile uint32_t	canTxDropped = 0;
 
 bool 				LEDState_On	= false;
 bool 				flashMe		= false;
@@ -42,7 +66,60 @@ bool					loadTimerExpired = false;
 bool					nodeSentLoadError = false;
 static bool 			sendFromSwitch = false;
 
+// The master's filter banks, in the bxCAN's register layout.  Also what the
+// monitor, which opens the filters, holds frames to before passing them on.
+typedef struct _CAN_FILTER_BANK
+{
+	uint32_t	id;
+	uint32_t	mask;
+} CAN_FILTER_BANK;
+
+#define CAN_MASTER_FILTERS	3
+
+static const CAN_FILTER_BANK canMasterFilters[CAN_MASTER_FILTERS] =
+{
+	//					Source ID		| Dest ID		| CAN Command
+	// Filter for eid CAN_TEMPORARY_ID | CAN_MASTER_ID | CAN_REQUEST_ADDRESS
+	{
+		(CAN_TEMPORARY_ID << (32-9))	| \
+		(CAN_MASTER_ID << (32-18))		| \
+		(CAN_REQUEST_NEW_ADDRESS << 3)	| \
+		CAN_ID_EXT						| \
+		CAN_RTR_DATA,
+		0xFFFFFFFE						// ALL BITS MUST MATCH
+	},
+	//					Source ID		| Dest ID		| CAN Command with OR'd ACK bit
+	// Filter for eid <anyValidTarget> | CAN_MASTER_ID | <anyValidCommand | AckResponseBit>
+	{
+		(0x0FF << (32-9))				| \
+		(CAN_MASTER_ID << (32-18))		| \
+		(0x7FF <<  3)					| \
+		CAN_ID_EXT						| \
+		CAN_RTR_DATA,
+		(0x100 << (32-9))				| \
+		(CAN_MASTER_ID << (32-18))		| \
+		(CAN_ACK_RESPONSE_BIT << 3)		| \
+		CAN_ID_EXT						| \
+		CAN_RTR_DATA
+	},
+	//					Source ID		| Dest ID		| CAN Command with OR'd Error bit
+	// Filter for eid <anyValidTarget> | CAN_MASTER_ID | <anyValidCommand | ErrorResponseBit>
+	{
+		(0x0FF << (32-9))				| \
+		(CAN_MASTER_ID << (32-18))		| \
+		(0x7FF << 3)					| \
+		CAN_ID_EXT						| \
+		CAN_RTR_DATA,
+		(0x100 << (32-9))				| \
+		(CAN_MASTER_ID << (32-18))		| \
+		(CAN_ERROR_RESPONSE_BIT << 3)	| \
+		CAN_ID_EXT						| \
+		CAN_RTR_DATA
+	},
+};
+
 static uint32_t 		myCANId = CAN_DEFAULT_ID;
+static uint32_t			canWaitMs = osWaitForever;	// next bitrate or bus-state deadline
 
 uint8_t packetSequenceIndex = 0;	// recycling sequence number to assure packet order
 uint8_t packetByteIndex = 0;		// where in the packet does the byte go?
@@ -132,6 +209,14 @@ bool		masterLoadError = false;
 //			GET_ID
 //
 //		Diagnostic:
+//			REPORT_STATS - per task CPU and stack, one reply frame per task
+//			REPORT_CRASH - a post-mortem record, in chunks - see Crash.h
+//
+//		Bus:
+//			BITRATE_PREPARE / COMMIT / CONFIRM / AUTO - see CANBitrate.h
+//			BUS_STATE - error state, TEC/REC, and transitions after a recovery -
+//				see CANBusState.h
+//			BUS_BACKOFF - the bus-off recovery wait - see CANBusState.h
 //
 //		Runtime:
 //
@@ -200,14 +285,6 @@ void setTestFilters(void)
 		Error_Handler();
 	}
 
-	/*##-5- Configure Transmission process #####################################*/
-	TxHeader.StdId = 0x3FF;		// Start up with a bogus address to get a legit address from Master
-	TxHeader.ExtId = 0x1FFFFFFF;
-
-	TxHeader.RTR = CAN_RTR_DATA;
-	TxHeader.IDE = CAN_ID_EXT;//CAN_ID_STD;
-	TxHeader.TransmitGlobalTime = DISABLE;
-
 }
 void setFilters(CAN_FILTER_TYPES filterType)
 {
@@ -247,79 +324,20 @@ void setFilters(CAN_FILTER_TYPES filterType)
 	}
 	else if (CAN_FILTER_MASTER == filterType)
 	{
-		  {
-			  //					Source ID		| Dest ID		| CAN Command
-			  // Filter for eid CAN_TEMPORARY_ID | CAN_MASTER_ID | CAN_REQUEST_ADDRESS
-			  uint32_t filterId = (CAN_TEMPORARY_ID << (32-9)) 	| \
-								  (CAN_MASTER_ID << (32-18)) 	| \
-								  (CAN_REQUEST_NEW_ADDRESS << 3)	| \
-								  CAN_ID_EXT						| \
-								  CAN_RTR_DATA;
-			  uint32_t filterMask = 0xFFFFFFFE;	// ALL BITS MUST MATCH
-			  sFilterConfig.FilterBank = 0;
-			  sFilterConfig.FilterIdHigh = (filterId >> 16) & 0xFFFF;
-			  sFilterConfig.FilterIdLow = (filterId & 0xFFFF);
-			  sFilterConfig.FilterMaskIdHigh = ((filterMask >> 16) & 0xFFFF);
-			  sFilterConfig.FilterMaskIdLow = (filterMask & 0xFFFF);
-			  sFilterConfig.FilterFIFOAssignment = CAN_RX_FIFO0;
-		  }
-		  if (HAL_CAN_ConfigFilter(&hcan, &sFilterConfig) != HAL_OK)
-		  {
-		    /* Filter configuration Error */
-		    Error_Handler();
-		  }
-
-		  {
-			  //					Source ID		| Dest ID		| CAN Command with OR'd ACK bit
-			  // Filter for eid <anyValidTarget> | CAN_MASTER_ID | <anyValidCommand | AckResponseBit>
-			  uint32_t filterId = (0x0FF << (32-9)) 			| \
-					  	  	  	  (CAN_MASTER_ID << (32-18))	| \
-								  (0x7FF <<  3) 				| \
-								  CAN_ID_EXT | \
-								  CAN_RTR_DATA;
-			  uint32_t filterMask =	(0x100 << (32-9))			| \
-									(CAN_MASTER_ID << (32-18))	| \
-									(CAN_ACK_RESPONSE_BIT << 3)	| \
-									CAN_ID_EXT | \
-									CAN_RTR_DATA;
-			  sFilterConfig.FilterBank = 1;
-			  sFilterConfig.FilterIdHigh = (filterId >> 16) & 0xFFFF;
-			  sFilterConfig.FilterIdLow = (filterId & 0xFFFF);
-			  sFilterConfig.FilterMaskIdHigh = ((filterMask >> 16) & 0xFFFF);
-			  sFilterConfig.FilterMaskIdLow = (filterMask & 0xFFFF);
-			  sFilterConfig.FilterFIFOAssignment = CAN_RX_FIFO0;
-		  }
-		  if (HAL_CAN_ConfigFilter(&hcan, &sFilterConfig) != HAL_OK)
-		  {
-		    /* Filter configuration Error */
-		    Error_Handler();
-		  }
-		  {
-			  //					Source ID		| Dest ID		| CAN Command with OR'd Error bit
-			  // Filter for eid <anyValidTarget> | CAN_MASTER_ID | <anyValidCommand | ErrorResponseBit>
-			  uint32_t filterId = (0x0FF << (32-9))			| \
-					  	  	  	  (CAN_MASTER_ID << (32-18))	| \
-								  (0x7FF << 3)				| \
-								  CAN_ID_EXT 				| \
-								  CAN_RTR_DATA;
-			  uint32_t filterMask = (0x100 << (32-9))	| \
-					  (CAN_MASTER_ID << (32-18))			| \
-					  (CAN_ERROR_RESPONSE_BIT << 3)		| \
-					  CAN_ID_EXT							| \
-					  CAN_RTR_DATA;
-			  sFilterConfig.FilterBank = 2;
-			  sFilterConfig.FilterIdHigh = (filterId >> 16) & 0xFFFF;
-			  sFilterConfig.FilterIdLow = (filterId & 0xFFFF);
-			  sFilterConfig.FilterMaskIdHigh = ((filterMask >> 16) & 0xFFFF);
-			  sFilterConfig.FilterMaskIdLow = (filterMask & 0xFFFF);
-			  sFilterConfig.FilterFIFOAssignment = CAN_RX_FIFO0;
-		  }
-		  if (HAL_CAN_ConfigFilter(&hcan, &sFilterConfig) != HAL_OK)
-		  {
-		    /* Filter configuration Error */
-		    Error_Handler();
-		  }
-
+		for (int bank = 0; bank < CAN_MASTER_FILTERS; bank++)
+		{
+			sFilterConfig.FilterBank = bank;
+			sFilterConfig.FilterIdHigh = (canMasterFilters[bank].id >> 16) & 0xFFFF;
+			sFilterConfig.FilterIdLow = (canMasterFilters[bank].id & 0xFFFF);
+			sFilterConfig.FilterMaskIdHigh = ((canMasterFilters[bank].mask >> 16) & 0xFFFF);
+			sFilterConfig.FilterMaskIdLow = (canMasterFilters[bank].mask & 0xFFFF);
+			sFilterConfig.FilterFIFOAssignment = CAN_RX_FIFO0;
+			if (HAL_CAN_ConfigFilter(&hcan, &sFilterConfig) != HAL_OK)
+			{
+				/* Filter configuration Error */
+				Error_Handler();
+			}
+		}
 	}
 	else if (CAN_FILTER_TEMPORARY == filterType)
 	{
@@ -424,43 +442,40 @@ void setFilters(CAN_FILTER_TYPES filterType)
 	    /* Notification Error */
 	    Error_Handler();
 	  }
-
-	  /*##-5- Configure Transmission process #####################################*/
-		TxHeader.StdId = 0x3FF;		// Start up with a bogus address to get a legit address from Master
-		TxHeader.ExtId = 0x1FFFFFFF;
-
-		TxHeader.RTR = CAN_RTR_DATA;
-		TxHeader.IDE = CAN_ID_EXT;//CAN_ID_STD;
-		TxHeader.TransmitGlobalTime = DISABLE;
 }
 
-void setFiltersForNodeType(void)
+static CAN_FILTER_TYPES filterTypeForNode(void)
 {
-	static uint32_t myLastId = CAN_DEFAULT_ID;
-
-	CAN_FILTER_TYPES newFiltering;
+	if (true == MON_Active())
+	{
+		return(CAN_FILTER_GLOBAL);	// bank 0 takes everything ahead of banks 1 and 2
+	}
 
 	switch(myCANId)
 	{
 	case CAN_DEFAULT_ID:
-		newFiltering = CAN_FILTER_GLOBAL;
-		break;
+		return(CAN_FILTER_GLOBAL);
 	case CAN_TEMPORARY_ID:
-		newFiltering = CAN_FILTER_TEMPORARY;
-		break;
+		return(CAN_FILTER_TEMPORARY);
 	case CAN_MASTER_ID:
-		newFiltering = CAN_FILTER_MASTER;
-		break;
+		return(CAN_FILTER_MASTER);
 	default:
-		newFiltering = CAN_FILTER_CHILD;
-		break;
+		return(CAN_FILTER_CHILD);
 	}
-	if (myLastId != myCANId)
+}
+
+void setFiltersForNodeType(void)
+{
+	static uint32_t myLastId = CAN_DEFAULT_ID;
+	static bool lastMonitor = false;
+
+	if ((myLastId != myCANId) || (lastMonitor != MON_Active()))
 	{
-		setFilters(newFiltering);
+		setFilters(filterTypeForNode());
 	}
 
 	myLastId = myCANId;
+	lastMonitor = MON_Active();
 }
 
 uint32_t formExtendedIdentifier(uint32_t destinationId, uint16_t command)
@@ -484,13 +499,129 @@ void getEIDParts(uint32_t extId, uint16_t *source, uint16_t *destination, uint16
 	*command = (uint16_t)(extId & 0x7FF);
 }
 
-bool reply(uint8_t codeToReply)
+// Wait a few ticks for the interrupt to move the ring on before piling on
+// another frame.
+static bool waitTxRoom(void)
+{
+	for (int tries = 0; tries < 10; tries++)
+	{
+		if (((canTxHead + 1) % CAN_TX_RING_FRAMES) != canTxTail)
+		{
+			return(true);
+		}
+		osDelay(1);
+	}
+	return(false);
+}
+
+// Move queued frames into free mailboxes.  Interrupts masked or from the
+// CAN TX interrupt itself.  False if the controller refused one.
+static bool canTxPump(void)
 {
+	CAN_TxHeaderTypeDef header;
+	uint32_t mailbox;
+	bool res = true;
+
+	header.StdId = 0;
+	header.IDE = CAN_ID_EXT;
+	header.RTR = CAN_RTR_DATA;
+	header.TransmitGlobalTime = DISABLE;
+
+	while ((canTxTail != canTxHead) && (0 != HAL_CAN_GetTxMailboxesFreeLevel(&hcan)))
+	{
+		CAN_TX_FRAME *framePtr = &canTxRing[canTxTail];
+
+		header.ExtId = framePtr->extId;
+		header.DLC = framePtr->dlc;
+		if (HAL_OK != HAL_CAN_AddTxMessage(&hcan, &header, framePtr->data, &mailbox))
+		{
+			canTxDropped++;		// controller not started -- don't spin on it
+			res = false;
+		}
+		canTxTail = (canTxTail + 1) % CAN_TX_RING_FRAMES;
+	}
+	return(res);
+}
 
-	TxHeader.DLC = 8;
-	TxHeader.ExtId = formExtendedIdentifier(CAN_MASTER_ID, codeToReply | CAN_ACK_RESPONSE_BIT);
+// Until every queued frame has left the controller, or LIMIT ms go by -- for
+// a sender about to reset, which would abort whatever is still queued
+static bool canTxFlush(uint32_t limitMs)
+{
+	uint32_t start = osKernelSysTick();
 
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) != HAL_OK)
+	for (;;)
+	{
+		taskENTER_CRITICAL();
+		canTxPump();
+		taskEXIT_CRITICAL();
+		if ((canTxTail == canTxHead) && (3 == HAL_CAN_GetTxMailboxesFreeLevel(&hcan)))
+		{
+			return(true);
+		}
+		if (limitMs <= (osKernelSysTick() - start))
+		{
+			return(false);
+		}
+		osDelay(1);
+	}
+}
+
+// Every sender goes through the ring, so frames leave in the order they were
+// handed over no matter which task sent them, and a burst (FLASH 2..61) is
+// queued at memory speed instead of being paced by three mailboxes.  False
+// if the ring is full or the controller is refusing frames -- then this one
+// is going nowhere either.
+static bool canTransmit(uint32_t extId, uint8_t dlc, const uint8_t *dataPtr)
+{
+	uint16_t next;
+	bool res = false;
+
+	taskENTER_CRITICAL();
+	next = (canTxHead + 1) % CAN_TX_RING_FRAMES;
+	if (next != canTxTail)
+	{
+		CAN_TX_FRAME *framePtr = &canTxRing[canTxHead];
+
+		framePtr->extId = extId & 0x1FFFFFFF;
+		framePtr->dlc = dlc;
+		memset(framePtr->data, 0, sizeof(framePtr->data));
+		if (NULL != dataPtr)
+		{
+			memcpy(framePtr->data, dataPtr, dlc);
+		}
+		canTxHead = next;
+		res = true;
+	}
+	else
+	{
+		canTxDropped++;
+	}
+	if (false == canTxPump())
+	{
+		res = false;
+	}
+	taskEXIT_CRITICAL();
+	return(res);
+}
+
+void HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef *hcan)
+{
+	canTxPump();
+}
+
+void HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef *hcan)
+{
+	canTxPump();
+}
+
+void HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef *hcan)
+{
+	canTxPump();
+}
+
+bool reply(uint8_t codeToReply)
+{
+	if (false == canTransmit(formExtendedIdentifier(CAN_MASTER_ID, codeToReply | CAN_ACK_RESPONSE_BIT), 8, TxData))
 	{
 		/* Transmission request Error */
 		return(false);
@@ -500,11 +631,9 @@ bool reply(uint8_t codeToReply)
 
 bool replyWithError(uint8_t codeToReply, uint8_t errorCode)
 {
-	TxHeader.DLC = 1;
-	TxHeader.ExtId = formExtendedIdentifier(CAN_MASTER_ID, codeToReply | CAN_ERROR_RESPONSE_BIT);
 	TxData[0] = errorCode;
 
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(CAN_MASTER_ID, codeToReply | CAN_ERROR_RESPONSE_BIT), 1, TxData))
 	{
 		/* Transmission request Error */
 		return(false);
@@ -585,15 +714,30 @@ void CAN_ClaimMaster(void)
 	myCANId = GetIdFromFlash();
 
 	setFilters(CAN_FILTER_MASTER);
+	CAN_Wake();
+}
+
+// The CAN task sleeps until there is something for it: a received frame, the
+// button, a bus error, a new ID or filter setup.  Task or ISR.
+CCM_FUNC void CAN_Wake(void)
+{
+	if (NULL != CANReceiveTaskHandle)
+	{
+		osSignalSet(CANReceiveTaskHandle, CAN_SIGNAL_EVENT);
+	}
+}
+
+// Back on the bus after the controller was re-initialized (new bit timing)
+void CAN_Restart(void)
+{
+	setFilters(filterTypeForNode());
 }
 
 bool CAN_GetAddresses(void)
 {
-	TxHeader.DLC = 1;
-	TxHeader.ExtId = formExtendedIdentifier(CAN_GLOBAL_ID, CAN_GET_ADDRESS);
+	uint8_t data[1] = {0x00};
 
-	TxData[0] = 0x00;
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(CAN_GLOBAL_ID, CAN_GET_ADDRESS), 1, data))
 	{
 		/* Transmission request Error */
 		return(false);
@@ -603,6 +747,8 @@ bool CAN_GetAddresses(void)
 
 bool CAN_AssignAddress(uint32_t addr)
 {
+	uint8_t data[2];
+
 	if ((CAN_GLOBAL_ID == addr) ||
 		(CAN_MASTER_ID == addr) ||
 		(100 <= addr))
@@ -611,13 +757,10 @@ bool CAN_AssignAddress(uint32_t addr)
 		return(false);
 	}
 
-	TxHeader.DLC = 2;
-	TxHeader.ExtId = formExtendedIdentifier(CAN_TEMPORARY_ID, CAN_ASSIGN_ADDRESS);
-
-	TxData[0]=(addr >> 8) & 0x01;
-	TxData[1]=(addr >> 0) & 0xFF;
+	data[0]=(addr >> 8) & 0x01;
+	data[1]=(addr >> 0) & 0xFF;
 
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(CAN_TEMPORARY_ID, CAN_ASSIGN_ADDRESS), 2, data))
     {
       /* Transmission request Error */
       return(false);
@@ -627,10 +770,7 @@ bool CAN_AssignAddress(uint32_t addr)
 
 bool CAN_RequestAddress(void)
 {
-	TxHeader.DLC = 0;
-	TxHeader.ExtId = formExtendedIdentifier(CAN_MASTER_ID, CAN_REQUEST_NEW_ADDRESS);
-
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(CAN_MASTER_ID, CAN_REQUEST_NEW_ADDRESS), 0, NULL))
     {
       /* Transmission request Error */
       return(false);
@@ -641,6 +781,8 @@ bool CAN_RequestAddress(void)
 
 bool CAN_LEDFlashControl(uint32_t addr, bool state)
 {
+	uint8_t data[1];
+
 	if (CAN_MASTER_ID == myCANId)
 	{
 		if (CAN_MASTER_ID == addr)
@@ -654,12 +796,9 @@ bool CAN_LEDFlashControl(uint32_t addr, bool state)
 		}
 	}
 
-	TxHeader.DLC = 1;
-	TxHeader.ExtId = formExtendedIdentifier(addr, CAN_LED_FLASH_CONTROL);
-
-	TxData[0]=(false == state) ? 0x00 : 0x01;
+	data[0]=(false == state) ? 0x00 : 0x01;
 
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(addr, CAN_LED_FLASH_CONTROL), 1, data))
     {
       /* Transmission request Error */
       return(false);
@@ -669,6 +808,8 @@ bool CAN_LEDFlashControl(uint32_t addr, bool state)
 
 bool CAN_LEDStateControl(uint32_t addr, bool state)
 {
+	uint8_t data[1];
+
 	if (CAN_MASTER_ID == myCANId)
 	{
 		if (CAN_MASTER_ID == addr)
@@ -682,12 +823,9 @@ bool CAN_LEDStateControl(uint32_t addr, bool state)
 		}
 	}
 
-	TxHeader.DLC = 1;
-	TxHeader.ExtId = formExtendedIdentifier(addr, CAN_LED_STATE_CONTROL);
+	data[0]=(false == state) ? 0x00 : 0x01;
 
-	TxData[0]=(false == state) ? 0x00 : 0x01;
-
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(addr, CAN_LED_STATE_CONTROL), 1, data))
     {
       /* Transmission request Error */
       return(false);
@@ -709,10 +847,7 @@ bool CAN_EraseSysBlock(uint32_t addr)
 		EraseSystemBlock();
 	}
 
-	TxHeader.DLC = 0;
-	TxHeader.ExtId = formExtendedIdentifier(addr, CAN_ERASE_SYS_BLOCK);
-
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(addr, CAN_ERASE_SYS_BLOCK), 0, NULL))
 	{
 	  /* Transmission request Error */
 	  return(false);
@@ -734,10 +869,7 @@ bool CAN_EraseProgramBlock(uint32_t addr)
 		InvalidateProgram();
 	}
 
-	TxHeader.DLC = 0;
-	TxHeader.ExtId = formExtendedIdentifier(addr, CAN_ERASE_PROGRAM_BLOCK);
-
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(addr, CAN_ERASE_PROGRAM_BLOCK), 0, NULL))
 	{
 	  /* Transmission request Error */
 	  return(false);
@@ -749,13 +881,9 @@ bool CAN_EraseProgramBlock(uint32_t addr)
 
 bool reportSwitch(bool state)
 {
-
-	TxHeader.DLC = 1;
-	TxHeader.ExtId = formExtendedIdentifier(CAN_MASTER_ID, CAN_SWITCH_STATE | CAN_ACK_RESPONSE_BIT);
-
 	TxData[0] = (false == state) ? 0x00 : 0x01;
 
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(CAN_MASTER_ID, CAN_SWITCH_STATE | CAN_ACK_RESPONSE_BIT), 1, TxData))
 	{
 	  /* Transmission request Error */
 	  return(false);
@@ -766,6 +894,7 @@ bool reportSwitch(bool state)
 bool loadStartChildren(void)
 {
 	uint32_t tmp = GetLoadBase();
+	uint8_t data[4];
 
 	// CREATE AND START LOAD Error Timer
 	if (NULL == CAN_LoadErrorHandle)
@@ -777,14 +906,12 @@ bool loadStartChildren(void)
 	nodeSentLoadError = false;
 	osTimerStart(CAN_LoadErrorHandle, 5000);
 
-	TxHeader.DLC = 4;
-	TxHeader.ExtId = formExtendedIdentifier(GetLoadId(), CAN_PROGRAM_SET_BASE);
-	TxData[0] = (uint8_t)((tmp>>24) & 0xFF);
-	TxData[1] = (uint8_t)((tmp>>16) & 0xFF);
-	TxData[2] = (uint8_t)((tmp>>8) & 0xFF);
-	TxData[3] = (uint8_t)(tmp & 0xFF);
+	data[0] = (uint8_t)((tmp>>24) & 0xFF);
+	data[1] = (uint8_t)((tmp>>16) & 0xFF);
+	data[2] = (uint8_t)((tmp>>8) & 0xFF);
+	data[3] = (uint8_t)(tmp & 0xFF);
 
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, TxData, &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(GetLoadId(), CAN_PROGRAM_SET_BASE), 4, data))
 	{
 	  /* Transmission request Error */
 	  return(false);
@@ -799,6 +926,7 @@ bool loadStartChildren(void)
 		{
 			return(false);
 		}
+		osDelay(10);	// the CAN task has to run to hear the error
 	}
 	return(true);
 }
@@ -869,11 +997,12 @@ bool CAN_ProgramChar(uint8_t ch)
 
 	if (true == packetReady(ch))
 	{
+		if (false == waitTxRoom())
+		{
+			return(false);
+		}
 		// Write to CAN
-		TxHeader.DLC = 8;
-		TxHeader.ExtId = formExtendedIdentifier(GetLoadId(), CAN_PROGRAM_BLOCK + packetSequenceIndex);
-
-		res = HAL_CAN_AddTxMessage(&hcan, &TxHeader, payload, &TxMailbox) == HAL_OK;
+		res = canTransmit(formExtendedIdentifier(GetLoadId(), CAN_PROGRAM_BLOCK + packetSequenceIndex), 8, payload);
 		memset(payload, 0, 8);
 		packetSequenceIndex++;
 		packetSequenceIndex &= 0x07;
@@ -883,6 +1012,17 @@ bool CAN_ProgramChar(uint8_t ch)
 }
 
 
+// A cancelled or stalled load: whoever took SET_BASE drops back out of
+// programming without validating anything
+bool CAN_ProgramAbort(void)
+{
+	if ((myCANId == CAN_MASTER_ID) && (GetLoadId() == CAN_MASTER_ID))
+	{
+		return(true);
+	}
+	return(canTransmit(formExtendedIdentifier(GetLoadId(), CAN_PROGRAM_ABORT), 0, NULL));
+}
+
 bool CAN_ProgramClose(void)
 {
 	if ((myCANId == CAN_MASTER_ID) && (GetLoadId() == CAN_MASTER_ID))
@@ -901,10 +1041,7 @@ bool CAN_ProgramClose(void)
 	}
 
 	// Write whatever is in the accumulated packet to CAN
-	TxHeader.DLC = 8;
-	TxHeader.ExtId = formExtendedIdentifier(GetLoadId(), CAN_PROGRAM_CLOSE);
-
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, payload , &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(GetLoadId(), CAN_PROGRAM_CLOSE), 8, payload))
 	{
 	  /* Transmission request Error */
 	  return(false);
@@ -936,10 +1073,7 @@ bool CAN_RestartNode(int id)
 	}
 
 	// Write to CAN
-	TxHeader.DLC = 0;
-	TxHeader.ExtId = formExtendedIdentifier(id, CAN_RESTART_NODE);
-
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, GetPacket() , &TxMailbox) != HAL_OK)
+	if (false == canTransmit(formExtendedIdentifier(id, CAN_RESTART_NODE), 0, NULL))
 	{
 	  /* Transmission request Error */
 	  return(false);
@@ -947,6 +1081,7 @@ bool CAN_RestartNode(int id)
 
 	if (CAN_GLOBAL_ID == id)
 	{
+		canTxFlush(CAN_TX_FLUSH_MS);	// the reset aborts a frame still in a mailbox
 		RestartNode();	// RESTART AFTER telling others to restart!
 	}
 	return(true);
@@ -971,10 +1106,17 @@ bool CAN_GetReportVersion(int id)
 	}
 
 	// Write to CAN
-	TxHeader.DLC = 0;
-	TxHeader.ExtId = formExtendedIdentifier(id, CAN_REPORT_VERSION);
+	if (false == canTransmit(formExtendedIdentifier(id, CAN_REPORT_VERSION), 0, NULL))
+	{
+	  /* Transmission request Error */
+	  return(false);
+	}
+	return(true);
+}
 
-	if (HAL_CAN_AddTxMessage(&hcan, &TxHeader, GetPacket() , &TxMailbox) != HAL_OK)
+bool CAN_GetReportStats(int id)
+{
+	if (false == canTransmit(formExtendedIdentifier(id, CAN_REPORT_STATS), 0, NULL))
 	{
 	  /* Transmission request Error */
 	  return(false);
@@ -982,13 +1124,290 @@ bool CAN_GetReportVersion(int id)
 	return(true);
 }
 
+bool CAN_GetCrashRecord(int id, uint8_t index)
+{
+	uint8_t data[1] = {index};
+
+	if (false == canTransmit(formExtendedIdentifier(id, CAN_REPORT_CRASH), 1, data))
+	{
+	  /* Transmission request Error */
+	  return(false);
+	}
+	return(true);
+}
+
+bool CAN_GetBusState(int id)
+{
+	if (false == canTransmit(formExtendedIdentifier(id, CAN_BUS_STATE), 0, NULL))
+	{
+	  /* Transmission request Error */
+	  return(false);
+	}
+	return(true);
+}
+
+// Master: a child's bus-off recovery wait
+bool CAN_SetBusBackoff(int id, uint16_t minMs, uint16_t maxMs)
+{
+	uint8_t data[4] = {(uint8_t)(minMs >> 8), (uint8_t)minMs, (uint8_t)(maxMs >> 8), (uint8_t)maxMs};
+
+	return(canTransmit(formExtendedIdentifier(id, CAN_BUS_BACKOFF), 4, data));
+}
+
+// Master: every node, this one included, solves the new timing and holds it
+bool CAN_BitratePrepare(uint32_t kbitPerSec, uint16_t samplePermille)
+{
+	uint8_t data[4];
+
+	if (false == BR_Prepare(kbitPerSec, samplePermille))
+	{
+		return(false);
+	}
+
+	data[0] = (uint8_t)(kbitPerSec >> 8);
+	data[1] = (uint8_t)kbitPerSec;
+	data[2] = (uint8_t)(samplePermille >> 8);
+	data[3] = (uint8_t)samplePermille;
+	return(canTransmit(formExtendedIdentifier(CAN_GLOBAL_ID, CAN_BITRATE_PREPARE), 4, data));
+}
+
+// Master: everyone switches BR_SWITCH_DELAY_MS from now -- unless nothing is
+// prepared here, or a child refused what was
+bool CAN_BitrateCommit(void)
+{
+	uint8_t data[2] = {(uint8_t)(BR_SWITCH_DELAY_MS >> 8), (uint8_t)BR_SWITCH_DELAY_MS};
+
+	if (false == BR_Commit(BR_SWITCH_DELAY_MS))
+	{
+		return(false);
+	}
+	return(canTransmit(formExtendedIdentifier(CAN_GLOBAL_ID, CAN_BITRATE_COMMIT), 2, data));
+}
+
+// Master: auto-bitrate on or off at a child's next power-up
+bool CAN_BitrateAuto(int id, bool enabled)
+{
+	uint8_t data[1] = {(true == enabled) ? 1 : 0};
+
+	return(canTransmit(formExtendedIdentifier(id, CAN_BITRATE_AUTO), 1, data));
+}
+
+// One console line from the CAN task -- dropped if the UART is backed up
+static void reportLine(const char *formatPtr, uint32_t value)
+{
+	char *linePtr = MP_Alloc(MP_MEDIUM_SIZE);
+
+	if (NULL == linePtr)
+	{
+		return;
+	}
+	snprintf(linePtr, MP_MEDIUM_SIZE, formatPtr, value);
+	UART_TryWriteString(linePtr);
+	MP_Free(linePtr);
+}
+
+// Run the bitrate switch/trial clock and say when it next needs the task
+static void pollBitrate(void)
+{
+	BR_EVENT event;
+
+	while (BR_EVENT_NONE != (event = BR_Poll(&canWaitMs)))
+	{
+		switch (event)
+		{
+		case BR_EVENT_SWITCHED:
+			reportLine("BITRATE: now %lu, on trial\n", BR_Bitrate());
+			break;
+
+		case BR_EVENT_CONFIRM_DUE:
+			canTransmit(formExtendedIdentifier(CAN_GLOBAL_ID, CAN_BITRATE_CONFIRM), 0, NULL);
+			break;
+
+		case BR_EVENT_FALLBACK:
+			reportLine("BITRATE: nobody heard, back to %lu\n", BR_Bitrate());
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+// Master: a child's CAN_BUS_STATE frame.  SEQ 0xFF is the answer to a
+// request, anything else a logged transition.
+static void reportChildBusState(uint16_t source, const uint8_t *dataPtr)
+{
+	char *linePtr = MP_Alloc(MP_LARGE_SIZE);		// 65 bytes at the longest: the age is off the wire
+	uint32_t age = ((uint32_t)dataPtr[4] << 24) | ((uint32_t)dataPtr[5] << 16) | ((uint32_t)dataPtr[6] << 8) | dataPtr[7];
+
+	if (NULL == linePtr)
+	{
+		return;
+	}
+	if (0xFF == dataPtr[3])
+	{
+		snprintf(linePtr, MP_LARGE_SIZE, "CANERR %u: %s TEC %u REC %u\n", source, BS_StateName(dataPtr[0]), dataPtr[1], dataPtr[2]);
+	}
+	else
+	{
+		snprintf(linePtr, MP_LARGE_SIZE, "CANERR %u: #%u %s TEC %u REC %u %lu ms ago\n", source, dataPtr[3],
+				BS_StateName(dataPtr[0]), dataPtr[1], dataPtr[2], age);
+	}
+	UART_TryWriteString(linePtr);
+	MP_Free(linePtr);
+}
+
+// Watch the error state, recover from bus-off, and once back at error-active
+// tell the master what happened (the master just prints its own).  Unassigned
+// nodes may not talk, so their log is only seen through CANERR.
+static void pollBusState(void)
+{
+	BS_TRANSITION transition;
+	uint32_t busWaitMs;
+	uint8_t data[8];
+
+	BS_Poll(&busWaitMs);
+	if (busWaitMs < canWaitMs)
+	{
+		canWaitMs = busWaitMs;
+	}
+
+	while (true == BS_NextReport(&transition))
+	{
+		uint32_t age = osKernelSysTick() - transition.tick;
+
+		data[0] = transition.state;
+		data[1] = transition.tec;
+		data[2] = transition.rec;
+		data[3] = transition.seq;
+		data[4] = (uint8_t)(age >> 24);
+		data[5] = (uint8_t)(age >> 16);
+		data[6] = (uint8_t)(age >> 8);
+		data[7] = (uint8_t)age;
+		if (true == CAN_IAmMaster())
+		{
+			reportChildBusState(CAN_MASTER_ID, data);
+		}
+		else if (true == CAN_IAmAssignedChild())
+		{
+			canTransmit(formExtendedIdentifier(CAN_MASTER_ID, CAN_BUS_STATE | CAN_ACK_RESPONSE_BIT), 8, data);
+		}
+	}
+}
+
+// Child: crash record INDEX as CR_CHUNKS ACK frames
+static void reportCrash(uint8_t index)
+{
+	CR_RECORD record;
+	uint8_t data[8];
+
+	if (false == CR_Get(index, &record))
+	{
+		replyWithError(CAN_REPORT_CRASH, CRASH_ERR_NO_RECORD);
+		return;
+	}
+	for (uint32_t chunk = 0; chunk < CR_CHUNKS; chunk++)
+	{
+		uint32_t offset = chunk * CR_CHUNK_BYTES;
+		uint32_t bytes = ((offset + CR_CHUNK_BYTES) > sizeof(record)) ? (sizeof(record) - offset) : CR_CHUNK_BYTES;
+
+		memset(data, 0, sizeof(data));
+		data[0] = index;
+		data[1] = (uint8_t)chunk;
+		memcpy(&data[2], (uint8_t *)&record + offset, bytes);
+		if (false == waitTxRoom())
+		{
+			return;		// the master sees the record is short and can ask again
+		}
+		canTransmit(formExtendedIdentifier(CAN_MASTER_ID, CAN_REPORT_CRASH | CAN_ACK_RESPONSE_BIT), 8, data);
+	}
+}
+
+// Child: one ACK frame per task -- index, CPU %, free stack words (MSB first)
+// and the first four characters of the task name.
+static void reportStats(void)
+{
+	TS_TASK tasks[TS_MAX_TASKS];
+	uint8_t data[8];
+	int count = TS_Sample(tasks, TS_MAX_TASKS);
+
+	for (int i = 0; i < count; i++)
+	{
+		data[0] = (uint8_t)i;
+		data[1] = (uint8_t)((tasks[i].cpuTenths + 5) / 10);
+		data[2] = (uint8_t)(tasks[i].stackFree >> 8);
+		data[3] = (uint8_t)tasks[i].stackFree;
+		memset(&data[4], 0, 4);
+		memcpy(&data[4], tasks[i].namePtr, strnlen(tasks[i].namePtr, 4));
+		canTransmit(formExtendedIdentifier(CAN_MASTER_ID, CAN_REPORT_STATS | CAN_ACK_RESPONSE_BIT), 8, data);
+	}
+}
+
+// Master: one of the frames above, as a TOP line
+static void reportChildStats(uint16_t source, const uint8_t *dataPtr)
+{
+	char *linePtr = MP_Alloc(MP_MEDIUM_SIZE);
+
+	if (NULL == linePtr)
+	{
+		return;
+	}
+	snprintf(linePtr, MP_MEDIUM_SIZE, "TOP %u: %-4.4s %3u%% %5u\n", source, (const char *)&dataPtr[4],
+			dataPtr[1], (unsigned)((dataPtr[2] << 8) | dataPtr[3]));
+	UART_TryWriteString(linePtr);
+	MP_Free(linePtr);
+}
+
 /**
   * @brief  Rx Fifo 0 message pending callback
   * @param  hcan: pointer to a CAN_HandleTypeDef structure that contains
   *         the configuration information for the specified CAN.
   * @retval None
   */
-void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
+// Would the master's own filter banks have taken it?
+CCM_FUNC static bool masterFilterMatch(const CAN_RxHeaderTypeDef *headerPtr)
+{
+	uint32_t value = (headerPtr->ExtId << 3) | headerPtr->IDE | headerPtr->RTR;
+
+	for (int bank = 0; bank < CAN_MASTER_FILTERS; bank++)
+	{
+		if (0 == ((value ^ canMasterFilters[bank].id) & canMasterFilters[bank].mask))
+		{
+			return(true);
+		}
+	}
+	return(false);
+}
+
+// With the filters open for the monitor, only frames for this node that its
+// normal filters would take go on to the CAN task -- the rest are just recorded.
+CCM_FUNC static bool monitorOnly(const CAN_RxHeaderTypeDef *headerPtr, const uint8_t *dataPtr)
+{
+	uint16_t source, destination, command;
+
+	if (false == MON_Active())
+	{
+		return(false);
+	}
+	MON_Capture(headerPtr, dataPtr);
+
+	if (CAN_ID_EXT != headerPtr->IDE)
+	{
+		return(true);
+	}
+	getEIDParts(headerPtr->ExtId, &source, &destination, &command);
+	if (destination != myCANId)
+	{
+		return(true);
+	}
+	if (CAN_MASTER_ID != myCANId)
+	{
+		return(false);
+	}
+	return(false == masterFilterMatch(headerPtr));
+}
+
+CCM_FUNC void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
 {
 	COMPLETE_CAN_RX_MSG messageGuts;
 	BaseType_t pxHigherPriorityTaskWoken;
@@ -1000,15 +1419,20 @@ void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
     Error_Handler();
   }
 
+  errorCountCAN = 0;
+  TR_Event(TR_EV_CAN_RX, 0, (uint16_t)(RxHeader_0.ExtId & 0x7FF));
+  if (true == monitorOnly(&RxHeader_0, RxData_0))
+  {
+	  return;
+  }
+
   messageGuts.RxHeader = RxHeader_0;
   memcpy(messageGuts.RxData, RxData_0, 8);
   xQueueSendFromISR(CAN_ReceiveHandle, (const void *)&messageGuts, &pxHigherPriorityTaskWoken);
-
-  errorCountCAN = 0;
-
+  CAN_Wake();
 }
 
-void HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef *hcan)
+CCM_FUNC void HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef *hcan)
 {
 	COMPLETE_CAN_RX_MSG messageGuts;
 	BaseType_t pxHigherPriorityTaskWoken;
@@ -1020,18 +1444,51 @@ void HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef *hcan)
     Error_Handler();
   }
 
+  errorCountCAN = 0;
+  TR_Event(TR_EV_CAN_RX, 1, (uint16_t)(RxHeader_1.ExtId & 0x7FF));
+  if (true == monitorOnly(&RxHeader_1, RxData_1))
+  {
+	  return;
+  }
+
   messageGuts.RxHeader = RxHeader_1;
   memcpy(messageGuts.RxData, RxData_1, 8);
   xQueueSendFromISR(CAN_ReceiveHandle, (const void *)&messageGuts, &pxHigherPriorityTaskWoken);
+  CAN_Wake();
 
   HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
-
-  errorCountCAN = 0;
 }
 
 void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
 {
 	errorCountCAN++;
+
+	if (0 != (hcan->ErrorCode & (HAL_CAN_ERROR_RX_FOV0 | HAL_CAN_ERROR_RX_FOV1)))
+	{
+		MON_CountOverrun();
+		hcan->ErrorCode &= ~(HAL_CAN_ERROR_RX_FOV0 | HAL_CAN_ERROR_RX_FOV1);	// the HAL only ever ORs these in
+	}
+	CAN_Wake();		// refresh() switches the LED to the error blink
+}
+
+uint32_t CAN_ErrorCount(void)
+{
+	return(errorCountCAN);
+}
+
+uint32_t CAN_TxDropped(void)
+{
+	return(canTxDropped);
+}
+
+// Raw frame from the host link -- sent exactly as given.
+bool CAN_InjectFrame(uint32_t extId, uint8_t dlc, const uint8_t *dataPtr)
+{
+	if (false == waitTxRoom())
+	{
+		return(false);
+	}
+	return(canTransmit(extId, dlc, dataPtr));
 }
 
 /**
@@ -1046,6 +1503,7 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
   {
     /* Toggle LED2 */
     sendFromSwitch = true;
+    CAN_Wake();
   }
 }
 
@@ -1066,7 +1524,7 @@ void doMASTER(COMPLETE_CAN_RX_MSG *messageGutsPtr)
 	{
 		if	 (CAN_TEMPORARY_ID == source)
 		{
-			WriteUARTString("Need Node address: ");
+			UART_TryWriteString("Need Node address: ");
 			//strcat(msgPtr, "CAN_REQUEST_NEW_ADDRESS\n");
 		}
 	}
@@ -1118,6 +1576,58 @@ void doMASTER(COMPLETE_CAN_RX_MSG *messageGutsPtr)
 		}
 	  break;
 
+	case (CAN_REPORT_STATS | CAN_ACK_RESPONSE_BIT):
+		reportChildStats(source, messageGutsPtr->RxData);
+		break;
+
+	case (CAN_BITRATE_PREPARE | CAN_ACK_RESPONSE_BIT):
+		reportLine("BITRATE %lu: READY\n", source);
+		break;
+
+	case (CAN_BITRATE_PREPARE | CAN_ERROR_RESPONSE_BIT):
+		BR_Refused();
+		reportLine("BITRATE %lu: NO TIMING\n", source);
+		break;
+
+	case (CAN_BITRATE_CONFIRM | CAN_ACK_RESPONSE_BIT):
+		if (true == BR_Confirm())
+		{
+			reportLine("BITRATE: %lu kept\n", BR_Bitrate());
+		}
+		reportLine("BITRATE %lu: OK\n", source);
+		break;
+
+	case (CAN_BITRATE_AUTO | CAN_ACK_RESPONSE_BIT):
+		reportLine((0 != messageGutsPtr->RxData[0]) ? "BITRATE %lu: AUTO ON\n" : "BITRATE %lu: AUTO OFF\n", source);
+		break;
+
+	case (CAN_BUS_STATE | CAN_ACK_RESPONSE_BIT):
+		reportChildBusState(source, messageGutsPtr->RxData);
+		break;
+
+	case (CAN_BUS_BACKOFF | CAN_ACK_RESPONSE_BIT):
+		reportLine("CANERR %lu: BACKOFF SET\n", source);
+		break;
+
+	case (CAN_BUS_BACKOFF | CAN_ERROR_RESPONSE_BIT):
+		reportLine("CANERR %lu: BACKOFF REFUSED\n", source);
+		break;
+
+	case (CAN_REPORT_CRASH | CAN_ACK_RESPONSE_BIT):
+	{
+		static CR_RECORD crashRecord;		// one CRASH <ID> at a time
+
+		if (true == CR_Assemble(messageGutsPtr->RxData, &crashRecord))
+		{
+			CR_Print(source, messageGutsPtr->RxData[0], &crashRecord);
+		}
+	}
+		break;
+
+	case (CAN_REPORT_CRASH | CAN_ERROR_RESPONSE_BIT):
+		reportLine("CRASH %lu: no such record\n", source);
+		break;
+
 	default:
 	  //strcat(msgPtr, "Unsupported Message\n");
 	  break;
@@ -1141,7 +1651,6 @@ void doTEMPORARY(COMPLETE_CAN_RX_MSG *messageGutsPtr)
 		uint32_t newNodeAddress = 0;
 		newNodeAddress |= messageGutsPtr->RxData[0];	newNodeAddress <<= 8;
 		newNodeAddress |= messageGutsPtr->RxData[1];
-		TxHeader.ExtId = newNodeAddress << 20;
 		myCANId = newNodeAddress;
 		ProgramIdIntoFlash(myCANId);
 		reply(CAN_ASSIGN_ADDRESS);
@@ -1261,6 +1770,15 @@ bool programmingChild(COMPLETE_CAN_RX_MSG *messageGutsPtr)
 	  }
 		  break;
 
+	  case CAN_PROGRAM_ABORT:
+	  {
+		  // Nothing gets validated and nothing is answered -- it may be global
+		  cpState = CPS_INIT;
+		  childLoadError = false;
+		  return(true);
+	  }
+		  break;
+
 	  case CAN_PROGRAM_CLOSE:
 	  {
 
@@ -1334,7 +1852,6 @@ void doCHILD(COMPLETE_CAN_RX_MSG *messageGutsPtr)
 	  {
 		uint32_t tmp = GetMyLocationInFlash();
 
-		TxHeader.DLC = 4;
 		TxData[0] = (uint8_t)((tmp>>24) & 0xFF);
 		TxData[1] = (uint8_t)((tmp>>16) & 0xFF);
 		TxData[2] = (uint8_t)((tmp>>8) & 0xFF);
@@ -1361,7 +1878,6 @@ void doCHILD(COMPLETE_CAN_RX_MSG *messageGutsPtr)
 
 	  case CAN_REPORT_VERSION:
 	  {
-			TxHeader.DLC = 4;
 			TxData[0] = versionCode[0];
 			TxData[1] = versionCode[1];
 			TxData[2] = versionCode[2];
@@ -1370,6 +1886,64 @@ void doCHILD(COMPLETE_CAN_RX_MSG *messageGutsPtr)
 		  break;
 
 
+	  case CAN_REPORT_STATS:
+		  reportStats();
+		  return; // the frames went out already
+		  break;
+
+	  case CAN_REPORT_CRASH:
+		  reportCrash(messageGutsPtr->RxData[0]);
+		  return; // so did these
+		  break;
+
+	  case CAN_BITRATE_PREPARE:
+		  if (false == BR_Prepare(((uint32_t)messageGutsPtr->RxData[0] << 8) | messageGutsPtr->RxData[1],
+				  (uint16_t)((messageGutsPtr->RxData[2] << 8) | messageGutsPtr->RxData[3])))
+		  {
+			  replyWithError(command, BITRATE_ERR_NO_TIMING);
+			  return;
+		  }
+		  break;
+
+	  case CAN_BITRATE_COMMIT:
+		  BR_Commit((uint16_t)((messageGutsPtr->RxData[0] << 8) | messageGutsPtr->RxData[1]));
+		  return;	// no reply -- the bus is about to change under it
+		  break;
+
+	  case CAN_BITRATE_CONFIRM:
+		  if (true == BR_Confirm())
+		  {
+			  reportLine("BITRATE: %lu kept\n", BR_Bitrate());
+		  }
+		  break;
+
+	  case CAN_BITRATE_AUTO:
+		  BR_SetAuto(0 != messageGutsPtr->RxData[0]);
+		  memset(TxData, 0, sizeof(TxData));
+		  TxData[0] = (true == BR_AutoEnabled()) ? 1 : 0;
+		  break;
+
+	  case CAN_BUS_STATE:
+	  {
+		  uint32_t esr = hcan.Instance->ESR;
+
+		  memset(TxData, 0, sizeof(TxData));
+		  TxData[0] = (uint8_t)BS_State();
+		  TxData[1] = (uint8_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos);
+		  TxData[2] = (uint8_t)((esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos);
+		  TxData[3] = 0xFF;
+	  }
+		  break;
+
+	  case CAN_BUS_BACKOFF:
+		  if (false == BS_SetBackoff(((uint32_t)messageGutsPtr->RxData[0] << 8) | messageGutsPtr->RxData[1],
+				  ((uint32_t)messageGutsPtr->RxData[2] << 8) | messageGutsPtr->RxData[3]))
+		  {
+			  replyWithError(command, BUS_ERR_BAD_BACKOFF);
+			  return;
+		  }
+		  break;
+
 	  case CAN_ERASE_PROGRAM_BLOCK:
 		  InvalidateProgram();
 		  break;
@@ -1408,11 +1982,11 @@ void	 DoCANProcessing(void)
 		{
 			  if (GPIO_PIN_RESET == HAL_GPIO_ReadPin(B1_GPIO_Port, B1_Pin))
 			  {
-				  WriteUARTString("Msg node 1: CLOSED\n");
+				  UART_TryWriteString("Msg node 1: CLOSED\n");
 			  }
 			  else
 			  {
-				  WriteUARTString("Msg node 1: OPEN\n");
+				  UART_TryWriteString("Msg node 1: OPEN\n");
 			  }
 		}
 		else if (CAN_DEFAULT_ID == myCANId)
@@ -1431,7 +2005,8 @@ void	 DoCANProcessing(void)
 		sendFromSwitch = false;
 	}
 
-  if (pdTRUE == xQueueReceive(CAN_ReceiveHandle, &messageGuts, 0))
+  // Everything queued since the last wake -- one signal may cover many frames
+  while (pdTRUE == xQueueReceive(CAN_ReceiveHandle, &messageGuts, 0))
   {
 	  switch(myCANId)
 	  {
@@ -1449,6 +2024,9 @@ void	 DoCANProcessing(void)
 		  break;
 	  }
   }
+  setFiltersForNodeType();		// an ASSIGN above takes effect now, not at the next wake
+  pollBitrate();
+  pollBusState();
   refresh();
 
 }
@@ -1456,6 +2034,13 @@ void	 DoCANProcessing(void)
 void taskCANReceive(void const * argument)
 {
 	myCANId = GetIdFromFlash();
+	BR_Init();
+	BS_Init();
+	if ((false == CAN_IAmMaster()) && (true == BR_AutoEnabled()))
+	{
+		reportLine((true == BR_AutoDetect()) ? "BITRATE: heard the bus at %lu\n" :
+				"BITRATE: bus quiet, staying at %lu\n", BR_Bitrate());
+	}
 	setFilters(CAN_FILTER_GLOBAL);
 
 
@@ -1469,11 +2054,13 @@ void taskCANReceive(void const * argument)
 	}
 	osTimerStart(LEDFlashHandle, flashRate);
 	flashMe = true;
+	WD_Register(WD_DEADLINE_MS);
 
 	/* Infinite loop */
 	for(;;)
 	{
 	  DoCANProcessing();
-	  osThreadYield();
+	  WD_CheckIn();
+	  osSignalWait(CAN_SIGNAL_EVENT, WD_Wait(canWaitMs));
 	}
 }
@@ -0,0 +1,226 @@
+/*
+ * CANMonitor.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "CANMonitor.h"
+#include "HostLink.h"
+#include "FrameLog.h"
+#include "CANHandler.h"
+
+#include <string.h>
+
+#define MON_MAX_RECORD			(1 + 5 + 5 + 8)		// flags, two varints, data
+
+typedef struct _MON_ENTRY
+{
+	uint32_t	time;		// us
+	uint32_t	id;
+	uint8_t		flags;
+	uint8_t		data[8];
+} MON_ENTRY;
+
+static MON_ENTRY			monRing[MON_RING_RECORDS];
+static volatile uint16_t	monHead = 0;
+static volatile uint16_t	monTail = 0;
+static volatile uint32_t	monDropped = 0;
+static volatile bool		monActive = false;
+static bool					monDelta = false;
+static uint8_t				monSeq = 0;
+
+// Microsecond clock built on DWT->CYCCNT.  The counter wraps every ~60s at
+// 72MHz, so it is folded into monMicros on every capture and on every pump.
+static uint32_t				monLastCycles;
+static uint32_t				monCycleRemainder;
+static uint32_t				monMicros;
+
+// Interrupts masked
+static uint32_t monClock(void)
+{
+	uint32_t cyclesPerMicro = SystemCoreClock / 1000000;
+	uint32_t now = DWT->CYCCNT;
+	uint32_t elapsed = (now - monLastCycles) + monCycleRemainder;
+
+	monLastCycles = now;
+	monMicros += elapsed / cyclesPerMicro;
+	monCycleRemainder = elapsed % cyclesPerMicro;
+	return(monMicros);
+}
+
+void MON_Start(bool delta)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	taskENTER_CRITICAL();
+	monLastCycles = DWT->CYCCNT;
+	monCycleRemainder = 0;
+	monMicros = 0;
+	monHead = 0;
+	monTail = 0;
+	monDropped = 0;
+	monDelta = delta;
+	monActive = true;
+	taskEXIT_CRITICAL();
+
+	FL_Wake();		// start pumping
+	CAN_Wake();		// open the filters
+}
+
+void MON_Stop(void)
+{
+	monActive = false;
+	CAN_Wake();
+}
+
+bool MON_Active(void)
+{
+	return(monActive);
+}
+
+uint32_t MON_Dropped(void)
+{
+	return(monDropped);
+}
+
+// RX interrupt
+void MON_Capture(const CAN_RxHeaderTypeDef *headerPtr, const uint8_t *dataPtr)
+{
+	UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+	uint16_t next = (monHead + 1) % MON_RING_RECORDS;
+
+	if (next == monTail)
+	{
+		monDropped++;
+	}
+	else
+	{
+		MON_ENTRY *entryPtr = &monRing[monHead];
+
+		entryPtr->time = monClock();
+		entryPtr->id = (CAN_ID_EXT == headerPtr->IDE) ? headerPtr->ExtId : headerPtr->StdId;
+		entryPtr->flags = (uint8_t)(headerPtr->DLC & MON_FLAG_DLC_MASK);
+		if (CAN_ID_EXT == headerPtr->IDE)
+		{
+			entryPtr->flags |= MON_FLAG_EXT;
+		}
+		if (CAN_RTR_REMOTE == headerPtr->RTR)
+		{
+			entryPtr->flags |= MON_FLAG_RTR;
+		}
+		memcpy(entryPtr->data, dataPtr, sizeof(entryPtr->data));
+		monHead = next;
+	}
+	taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+// CAN error interrupt -- the hardware FIFO overflowed before we could read it
+void MON_CountOverrun(void)
+{
+	if (true == monActive)
+	{
+		monDropped++;
+	}
+}
+
+static uint8_t *putLE32(uint8_t *ptr, uint32_t value)
+{
+	*ptr++ = (uint8_t)value;
+	*ptr++ = (uint8_t)(value >> 8);
+	*ptr++ = (uint8_t)(value >> 16);
+	*ptr++ = (uint8_t)(value >> 24);
+	return(ptr);
+}
+
+static uint8_t *putVarint(uint8_t *ptr, uint32_t value)
+{
+	while (0x80 <= value)
+	{
+		*ptr++ = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	*ptr++ = (uint8_t)value;
+	return(ptr);
+}
+
+static uint8_t *encodeEntry(uint8_t *ptr, const MON_ENTRY *entryPtr, uint32_t *prevTimePtr, uint32_t *prevIdPtr)
+{
+	uint8_t dlc = entryPtr->flags & MON_FLAG_DLC_MASK;
+	uint8_t *flagsPtr = ptr++;
+
+	*flagsPtr = entryPtr->flags;
+
+	if (false == monDelta)
+	{
+		ptr = putLE32(ptr, entryPtr->time);
+		ptr = putLE32(ptr, entryPtr->id);
+	}
+	else
+	{
+		int32_t idDelta = (int32_t)(entryPtr->id - *prevIdPtr);
+
+		ptr = putVarint(ptr, entryPtr->time - *prevTimePtr);
+		if (0 == idDelta)
+		{
+			*flagsPtr |= MON_FLAG_SAME_ID;
+		}
+		else
+		{
+			ptr = putVarint(ptr, ((uint32_t)idDelta << 1) ^ (uint32_t)(idDelta >> 31));
+		}
+	}
+	*prevTimePtr = entryPtr->time;
+	*prevIdPtr = entryPtr->id;
+
+	if (8 < dlc)
+	{
+		dlc = 8;
+	}
+	if (0 == (entryPtr->flags & MON_FLAG_RTR))
+	{
+		memcpy(ptr, entryPtr->data, dlc);
+		ptr += dlc;
+	}
+	return(ptr);
+}
+
+// FrameLog task.  Sends whatever is in the ring, one HL frame at a time.
+// Returns true if anything went out.
+bool MON_Pump(void)
+{
+	bool sent = false;
+
+	if (false == monActive)
+	{
+		return(false);
+	}
+
+	taskENTER_CRITICAL();
+	monClock();
+	taskEXIT_CRITICAL();
+
+	while (monTail != monHead)
+	{
+		uint8_t payload[HL_MAX_PAYLOAD];
+		uint8_t *ptr = payload;
+		uint32_t prevTime = monRing[monTail].time;
+		uint32_t prevId = monRing[monTail].id;
+
+		*ptr++ = monDelta ? MON_FORMAT_DELTA : MON_FORMAT_PLAIN;
+		ptr = putLE32(ptr, monDropped);
+		ptr = putLE32(ptr, prevTime);
+		ptr = putLE32(ptr, prevId);
+
+		while ((monTail != monHead) && ((ptr + MON_MAX_RECORD) <= &payload[HL_MAX_PAYLOAD]))
+		{
+			ptr = encodeEntry(ptr, &monRing[monTail], &prevTime, &prevId);
+			monTail = (monTail + 1) % MON_RING_RECORDS;
+		}
+
+		HL_Send(HL_MSG_CAN_MONITOR, monSeq++, payload, ptr - payload, true);
+		sent = true;
+	}
+	return(sent);
+}
@@ -0,0 +1,80 @@
+/*
+ * CANTiming.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "CANTiming.h"
+
+#include <stddef.h>
+
+static uint32_t ctDifference(uint32_t a, uint32_t b)
+{
+	return((a > b) ? (a - b) : (b - a));
+}
+
+bool CT_Solve(uint32_t clockHz, uint32_t bitrate, uint16_t samplePermille, CT_TIMING *timingPtr)
+{
+	uint32_t bestRateError = UINT32_MAX;
+	uint32_t bestSampleError = UINT32_MAX;
+	bool found = false;
+
+	if ((0 == bitrate) || (CT_BITRATE_MAX < bitrate) || (NULL == timingPtr))
+	{
+		return(false);
+	}
+
+	// Most quanta first, so a tie on both errors keeps the finer split
+	for (uint32_t quanta = CT_QUANTA_MAX; quanta >= CT_QUANTA_MIN; quanta--)
+	{
+		uint32_t perBit = bitrate * quanta;
+		uint32_t prescaler = (clockHz + (perBit / 2)) / perBit;
+		uint32_t rateError;
+
+		if ((0 == prescaler) || (CT_PRESCALER_MAX < prescaler))
+		{
+			continue;
+		}
+		rateError = (uint32_t)(((uint64_t)ctDifference(clockHz / (prescaler * quanta), bitrate) * 1000000) / bitrate);
+		if ((CT_RATE_TOLERANCE_PPM < rateError) || (rateError > bestRateError))
+		{
+			continue;
+		}
+
+		for (uint32_t bs2 = CT_BS2_MIN; bs2 <= CT_BS2_MAX; bs2++)
+		{
+			uint32_t bs1 = quanta - 1 - bs2;
+			uint32_t sampleError;
+
+			if ((1 > bs1) || (CT_BS1_MAX < bs1))
+			{
+				continue;
+			}
+			sampleError = ctDifference(((1 + bs1) * 1000) / quanta, samplePermille);
+			if ((rateError == bestRateError) && (sampleError >= bestSampleError))
+			{
+				continue;
+			}
+
+			bestRateError = rateError;
+			bestSampleError = sampleError;
+			timingPtr->prescaler = (uint16_t)prescaler;
+			timingPtr->bs1 = (uint8_t)bs1;
+			timingPtr->bs2 = (uint8_t)bs2;
+			timingPtr->sjw = (uint8_t)((CT_SJW_MAX < bs2) ? CT_SJW_MAX : bs2);
+			found = true;
+		}
+	}
+	return(found);
+}
+
+uint32_t CT_Bitrate(uint32_t clockHz, const CT_TIMING *timingPtr)
+{
+	return(clockHz / (timingPtr->prescaler * (1 + timingPtr->bs1 + timingPtr->bs2)));
+}
+
+uint16_t CT_SamplePermille(const CT_TIMING *timingPtr)
+{
+	return((uint16_t)(((1 + timingPtr->bs1) * 1000) / (1 + timingPtr->bs1 + timingPtr->bs2)));
+}
@@ -0,0 +1,180 @@
+/*
+ * CLIParse.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "CLIParse.h"
+
+#include <string.h>
+
+#define IS_SEPARATOR(ch)	((' ' == (ch)) || ('\t' == (ch)))
+
+// Terminate the word at *linePtrPtr and step past it -- NULL at end of line
+static char *nextWord(char **linePtrPtr)
+{
+	char *linePtr = *linePtrPtr;
+	char *wordPtr;
+
+	while (IS_SEPARATOR(*linePtr))
+	{
+		linePtr++;
+	}
+	if ('\0' == *linePtr)
+	{
+		*linePtrPtr = linePtr;
+		return(NULL);
+	}
+
+	wordPtr = linePtr;
+	while ((false == IS_SEPARATOR(*linePtr)) && ('\0' != *linePtr))
+	{
+		linePtr++;
+	}
+	if ('\0' != *linePtr)
+	{
+		*linePtr++ = '\0';
+	}
+	*linePtrPtr = linePtr;
+	return(wordPtr);
+}
+
+int CLI_Tokenize(char *linePtr, char *argv[], int maxArgs)
+{
+	int argc = 0;
+
+	while ((argc < maxArgs) && (NULL != (argv[argc] = nextWord(&linePtr))))
+	{
+		argc++;
+	}
+	return(argc);
+}
+
+int CLI_TokenizeHead(char *linePtr, char *argv[], int headArgs)
+{
+	int argc = 0;
+
+	while ((argc < headArgs) && (NULL != (argv[argc] = nextWord(&linePtr))))
+	{
+		argc++;
+	}
+	if (argc < headArgs)
+	{
+		return(argc);
+	}
+
+	while (IS_SEPARATOR(*linePtr))
+	{
+		linePtr++;
+	}
+	if ('\0' != *linePtr)
+	{
+		argv[argc++] = linePtr;		// the rest of the line, untouched
+	}
+	return(argc);
+}
+
+char *CLI_NextCommand(char **linePtrPtr)
+{
+	char *commandPtr = *linePtrPtr;
+	char *endPtr;
+
+	if (NULL == commandPtr)
+	{
+		return(NULL);
+	}
+
+	endPtr = strchr(commandPtr, CLI_COMMAND_SEPARATOR);
+	if (NULL != endPtr)
+	{
+		*endPtr++ = '\0';
+	}
+	*linePtrPtr = endPtr;
+	return(commandPtr);
+}
+
+uint32_t CLI_Hash(const char *strPtr)
+{
+	uint32_t hash = CLI_HASH_SEED;
+
+	while ('\0' != *strPtr)
+	{
+		hash ^= (uint8_t)*strPtr++;
+		hash *= 16777619UL;		// FNV prime
+	}
+	return(hash >> (32 - CLI_HASH_BITS));
+}
+
+// Radix 10 or 16 (optional 0x).  The whole token must be digits and fit in
+// 32 bits.
+bool CLI_ParseUnsigned(const char *strPtr, uint8_t radix, uint32_t *valuePtr)
+{
+	uint32_t value = 0;
+
+	if ((16 == radix) && ('0' == strPtr[0]) && (('x' == strPtr[1]) || ('X' == strPtr[1])))
+	{
+		strPtr += 2;
+	}
+	if ('\0' == *strPtr)
+	{
+		return(false);
+	}
+
+	for (; '\0' != *strPtr; strPtr++)
+	{
+		char ch = *strPtr;
+		uint32_t digit;
+
+		if (('0' <= ch) && ('9' >= ch))
+		{
+			digit = ch - '0';
+		}
+		else if (('A' <= ch) && ('F' >= ch))
+		{
+			digit = ch - 'A' + 10;
+		}
+		else if (('a' <= ch) && ('f' >= ch))
+		{
+			digit = ch - 'a' + 10;
+		}
+		else
+		{
+			return(false);
+		}
+
+		if ((digit >= radix) || (value > ((0xFFFFFFFFUL - digit) / radix)))
+		{
+			return(false);
+		}
+		value = (value * radix) + digit;
+	}
+	*valuePtr = value;
+	return(true);
+}
+
+bool CLI_ParseRange(const char *strPtr, uint8_t radix, uint32_t *firstPtr, uint32_t *lastPtr)
+{
+	char first[12];
+	const char *dotsPtr = strstr(strPtr, CLI_RANGE_SEPARATOR);
+	size_t length;
+
+	if (NULL == dotsPtr)
+	{
+		return(false);
+	}
+	length = dotsPtr - strPtr;
+	if (sizeof(first) <= length)
+	{
+		return(false);
+	}
+	memcpy(first, strPtr, length);
+	first[length] = '\0';
+
+	if ((false == CLI_ParseUnsigned(first, radix, firstPtr)) ||
+		(false == CLI_ParseUnsigned(dotsPtr + strlen(CLI_RANGE_SEPARATOR), radix, lastPtr)))
+	{
+		return(false);
+	}
+	return(*firstPtr <= *lastPtr);
+}
@@ -29,6 +29,7 @@
 ** MODULES USED
 **
 ******************************************************************************/
+#include "main.h"
 #include "stm32f3xx_hal.h"
 #include "cmsis_os.h"
 
@@ -216,7 +217,7 @@ bool CQ_AboveWaterMark(QUEUE_MGT_STRUCT *inst_ptr)
  *                      -- false on failure (queue is full)
  *
  ******************************************************************************/
-bool CQ_EnqueueChar(QUEUE_MGT_STRUCT *inst_ptr, uint8_t ch)
+CCM_FUNC bool CQ_EnqueueChar(QUEUE_MGT_STRUCT *inst_ptr, uint8_t ch)
 {
     // GUARDING CHECK
     if (NULL == inst_ptr)
@@ -263,6 +264,64 @@ bool CQ_EnqueueChar(QUEUE_MGT_STRUCT *inst_ptr, uint8_t ch)
 }
 
 
+/*! ** Public *****************************************************************
+ *
+ * \fn      bool CQ_EnqueueBlock(QUEUE_MGT_STRUCT *inst_ptr,
+ *                               const uint8_t *block_ptr,
+ *                               int16_t length)
+ *
+ * \brief   stuffs a run of characters into the queue under a single
+ *          interrupt lock.  Meant for DMA spans delivered from an ISR.
+ *          Characters that do not fit are dropped.
+ *
+ * \param   [inst_ptr]   QUEUE_MGT_STRUCT *   -- pointer to initialized instance
+ *                                              struct
+ *          [block_ptr]  const uint8_t *  -- characters to be queued
+ *          [length]     int16_t  -- number of characters at block_ptr
+ *
+ * \return  bool        -- true when every character was queued
+ *                      -- false when the queue filled up
+ *
+ ******************************************************************************/
+CCM_FUNC bool CQ_EnqueueBlock(QUEUE_MGT_STRUCT *inst_ptr, const uint8_t *block_ptr, int16_t length)
+{
+    bool result = true;
+
+    // GUARDING CHECK
+    if ((NULL == inst_ptr) || (NULL == block_ptr))
+    {
+       return(false);
+    }
+
+    __disable_irq();//portDISABLE_INTERRUPTS();//__disable_interrupt();  // DISABLE INTERRUPTS
+    for (; 0 < length; length--, block_ptr++)
+    {
+        if (INST_MAX_QUEUE_SIZE <= INST_CHAR_COUNT)
+        {
+            result = false;
+            break;
+        }
+
+        INST_ENQUEUE_INDEX++;
+        if (INST_MAX_QUEUE_SIZE <= INST_ENQUEUE_INDEX)
+        {
+            INST_ENQUEUE_INDEX = 0;
+        }
+
+        INST_CHAR_QUEUE[INST_ENQUEUE_INDEX] = *block_ptr;
+        INST_CHAR_COUNT++;
+
+        if (IS_TERMINATOR(*block_ptr))
+        {
+            INST_TERM_COUNT++;
+        }
+    }
+    __enable_irq();//portENABLE_INTERRUPTS();//__enable_interrupt();   // ENABLE INTERRUPTS
+
+    return(result);
+}
+
+
 /*! ** Public *****************************************************************
  *
  * \fn      bool CQ_DequeueChar(QUEUE_MGT_STRUCT *inst_ptr, uint8_t *ch_ptr)
@@ -0,0 +1,405 @@
+/*
+ * Crash.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "Crash.h"
+#include "SysBlock.h"
+#include "UARTHandler.h"
+#include "CANHandler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define CR_MAGIC				((uint32_t)0x43524153)		// "CRAS"
+#define CR_ERASED_WORD			((uint32_t)0xFFFFFFFF)
+#define CR_RECORD_WORDS			(sizeof(CR_RECORD) / sizeof(uint32_t))
+
+extern void FLASH_PageErase(uint32_t PageAddress);
+
+// Written by the fault handler, picked up by CR_Init() after the reset
+static CR_RECORD	crPending CCM_NOINIT;
+
+static const char *crReasonNames[] = {"?", "HARDFAULT", "MEMMANAGE", "BUSFAULT", "USAGEFAULT", "ERROR", "WATCHDOG"};
+
+static uint32_t crCheck(const CR_RECORD *recordPtr)
+{
+	const uint32_t *wordPtr = (const uint32_t *)recordPtr;
+	uint32_t check = 0xA5C3A5C3;
+
+	for (uint32_t i = 0; i < (CR_RECORD_WORDS - 1); i++)
+	{
+		check = ((check << 5) | (check >> 27)) ^ wordPtr[i];
+	}
+	return(check);
+}
+
+static bool crValid(const CR_RECORD *recordPtr)
+{
+	return((CR_MAGIC == recordPtr->magic) && (crCheck(recordPtr) == recordPtr->check));
+}
+
+// A corrupt SP must not fault the fault handler
+static bool crReadable(const uint32_t *wordPtr, uint32_t words)
+{
+	uint32_t start = (uint32_t)wordPtr;
+	uint32_t end = start + (words * sizeof(uint32_t));
+
+	if (0 != (start & 3))
+	{
+		return(false);
+	}
+	return(((SRAM_BASE <= start) && ((SRAM_BASE + (64 * 1024)) >= end)) ||
+			((CCMDATARAM_BASE <= start) && ((CCMDATARAM_BASE + (16 * 1024)) >= end)));
+}
+
+static void crCopyName(char *destPtr, size_t size, const char *srcPtr)
+{
+	size_t i;
+
+	for (i = 0; (i < (size - 1)) && ('\0' != srcPtr[i]); i++)
+	{
+		destPtr[i] = srcPtr[i];
+	}
+	for (; i < size; i++)
+	{
+		destPtr[i] = '\0';
+	}
+}
+
+static void crTaskName(CR_RECORD *recordPtr)
+{
+	if (0 != (recordPtr->flags & CR_FLAG_HANDLER))
+	{
+		crCopyName(recordPtr->task, sizeof(recordPtr->task), "ISR");
+	}
+	else if (taskSCHEDULER_NOT_STARTED == xTaskGetSchedulerState())
+	{
+		crCopyName(recordPtr->task, sizeof(recordPtr->task), "main");
+	}
+	else
+	{
+		crCopyName(recordPtr->task, sizeof(recordPtr->task), pcTaskGetName(NULL));
+	}
+}
+
+static void crCommit(CR_RECORD *recordPtr) __attribute__((noreturn));
+static void crCommit(CR_RECORD *recordPtr)
+{
+	recordPtr->magic = CR_MAGIC;
+	recordPtr->uptimeMs = HAL_GetTick();
+	recordPtr->check = crCheck(recordPtr);
+	NVIC_SystemReset();
+	for (;;)
+	{
+	}
+}
+
+// Reached from CR_FAULT_ENTRY() with the frame the exception pushed
+void CR_Fault(uint32_t *framePtr, uint32_t excReturn, uint32_t reason)
+{
+	CR_RECORD *recordPtr = &crPending;
+	uint32_t frameWords = 8;
+
+	__disable_irq();
+	memset(recordPtr, 0, sizeof(CR_RECORD));
+	recordPtr->reason = (uint8_t)reason;
+	recordPtr->excReturn = excReturn;
+	recordPtr->cfsr = SCB->CFSR;
+	recordPtr->hfsr = SCB->HFSR;
+	recordPtr->mmfar = SCB->MMFAR;
+	recordPtr->bfar = SCB->BFAR;
+
+	if (0 != (excReturn & 0x04))
+	{
+		recordPtr->flags |= CR_FLAG_PSP;
+	}
+	if (0 == (excReturn & 0x08))
+	{
+		recordPtr->flags |= CR_FLAG_HANDLER;
+	}
+	if (0 == (excReturn & 0x10))
+	{
+		recordPtr->flags |= CR_FLAG_FPU_FRAME;
+		frameWords = 26;		// S0-S15, FPSCR and a reserved word follow
+	}
+
+	if (true == crReadable(framePtr, 8))
+	{
+		memcpy(recordPtr->frame, framePtr, sizeof(recordPtr->frame));
+		recordPtr->flags |= CR_FLAG_FRAME;
+
+		// xPSR bit 9: the frame was padded to keep the stack 8 byte aligned
+		recordPtr->sp = (uint32_t)(framePtr + frameWords) + ((0 != (framePtr[7] & (1UL << 9))) ? 4 : 0);
+		if (true == crReadable((uint32_t *)recordPtr->sp, CR_STACK_WORDS))
+		{
+			memcpy(recordPtr->stack, (uint32_t *)recordPtr->sp, sizeof(recordPtr->stack));
+		}
+	}
+	crTaskName(recordPtr);
+	crCommit(recordPtr);
+}
+
+void CR_Error(const char *filePtr, int line)
+{
+	CR_RECORD *recordPtr = &crPending;
+	const char *namePtr = filePtr;
+
+	__disable_irq();
+	memset(recordPtr, 0, sizeof(CR_RECORD));
+	recordPtr->reason = CR_REASON_ERROR;
+	recordPtr->line = (uint16_t)line;
+	recordPtr->frame[5] = (uint32_t)__builtin_return_address(0);	// LR: who called it
+	recordPtr->sp = __get_MSP();
+	if (0 != (__get_CONTROL() & CONTROL_SPSEL_Msk))
+	{
+		recordPtr->sp = __get_PSP();
+		recordPtr->flags |= CR_FLAG_PSP;
+	}
+	if (0 != (__get_IPSR() & 0x1FF))
+	{
+		recordPtr->flags |= CR_FLAG_HANDLER;
+	}
+
+	// Just the file name -- the path is the same for every node
+	for (const char *charPtr = filePtr; '\0' != *charPtr; charPtr++)
+	{
+		if (('/' == *charPtr) || ('\\' == *charPtr))
+		{
+			namePtr = charPtr + 1;
+		}
+	}
+	crCopyName(recordPtr->file, sizeof(recordPtr->file), namePtr);
+	crTaskName(recordPtr);
+	crCommit(recordPtr);
+}
+
+// The supervisor: TASK_NAME is the one that stopped checking in, the
+// supervisor itself is what was running.
+void CR_Watchdog(const char *taskNamePtr, uint32_t lateMs)
+{
+	CR_RECORD *recordPtr = &crPending;
+
+	__disable_irq();
+	memset(recordPtr, 0, sizeof(CR_RECORD));
+	recordPtr->reason = CR_REASON_WATCHDOG;
+	recordPtr->line = (uint16_t)((0xFFFF < lateMs) ? 0xFFFF : lateMs);
+	crCopyName(recordPtr->task, sizeof(recordPtr->task), taskNamePtr);
+	crCommit(recordPtr);
+}
+
+uint32_t CR_StoreBase(void)
+{
+	return(SB_StoreBase() - FLASH_PAGE_SIZE);
+}
+
+static const CR_RECORD *crSlot(uint32_t slot)
+{
+	return((const CR_RECORD *)(CR_StoreBase() + (slot * sizeof(CR_RECORD))));
+}
+
+static uint32_t crUsedSlots(void)
+{
+	uint32_t slot;
+
+	for (slot = 0; (slot < CR_SLOTS) && (CR_ERASED_WORD != crSlot(slot)->magic); slot++)
+	{
+	}
+	return(slot);
+}
+
+static void crErase(void)
+{
+	HAL_FLASH_Unlock();
+	FLASH_PageErase(CR_StoreBase());
+	FLASH_WaitForLastOperation(FLASH_TIMEOUT_VALUE);
+	CLEAR_BIT (FLASH->CR, (FLASH_CR_PER));  // https://stackoverflow.com/questions/28498191/cant-write-to-flash-memory-after-erase
+	HAL_FLASH_Lock();
+}
+
+// main(), straight after HAL_Init(): move a record left by the last reset into
+// flash.  A full page is erased first -- only the newest crashes matter.
+void CR_Init(void)
+{
+	uint32_t slot;
+	const uint32_t *wordPtr = (const uint32_t *)&crPending;
+	bool iwdgReset = (0 != __HAL_RCC_GET_FLAG(RCC_FLAG_IWDGRST));
+
+	__HAL_RCC_CLEAR_RESET_FLAGS();
+
+	// Own handlers for these instead of everything escalating to HARDFAULT
+	SCB->SHCSR |= (SCB_SHCSR_MEMFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk | SCB_SHCSR_USGFAULTENA_Msk);
+
+	if ((false == crValid(&crPending)) && (true == iwdgReset))
+	{
+		// The IWDG, not the supervisor -- nothing got the chance to say why
+		memset(&crPending, 0, sizeof(crPending));
+		crPending.reason = CR_REASON_WATCHDOG;
+		crCopyName(crPending.task, sizeof(crPending.task), "?");
+		crPending.magic = CR_MAGIC;
+		crPending.check = crCheck(&crPending);
+	}
+	if (false == crValid(&crPending))
+	{
+		return;
+	}
+
+	slot = crUsedSlots();
+	if (CR_SLOTS <= slot)
+	{
+		crErase();
+		slot = 0;
+	}
+
+	HAL_FLASH_Unlock();
+	for (uint32_t i = 0; i < CR_RECORD_WORDS; i++)
+	{
+		uint32_t address = (uint32_t)crSlot(slot) + (i * sizeof(uint32_t));
+
+		if (HAL_OK != HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address, wordPtr[i]))
+		{
+			break;
+		}
+	}
+	HAL_FLASH_Lock();
+
+	crPending.magic = 0;
+}
+
+int CR_Count(void)
+{
+	return((int)crUsedSlots());
+}
+
+// Index 0 is the newest record
+bool CR_Get(int index, CR_RECORD *recordPtr)
+{
+	int used = (int)crUsedSlots();
+
+	if ((0 > index) || (index >= used))
+	{
+		return(false);
+	}
+	memcpy(recordPtr, crSlot(used - 1 - index), sizeof(CR_RECORD));
+	return(crValid(recordPtr));
+}
+
+void CR_Clear(void)
+{
+	if (0 != crUsedSlots())
+	{
+		crErase();
+	}
+}
+
+// Master: one CAN_REPORT_CRASH chunk.  True when the last one is in.
+bool CR_Assemble(const uint8_t *dataPtr, CR_RECORD *recordPtr)
+{
+	uint32_t offset = (uint32_t)dataPtr[1] * CR_CHUNK_BYTES;
+	uint32_t bytes = CR_CHUNK_BYTES;
+
+	if (sizeof(CR_RECORD) <= offset)
+	{
+		return(false);
+	}
+	if ((offset + bytes) > sizeof(CR_RECORD))
+	{
+		bytes = sizeof(CR_RECORD) - offset;
+	}
+	memcpy((uint8_t *)recordPtr + offset, &dataPtr[2], bytes);
+	return((CR_CHUNKS - 1) == dataPtr[1]);
+}
+
+static void crWrite(const char *linePtr, bool wait)
+{
+	if (true == wait)
+	{
+		WriteUARTString((char *)linePtr);
+	}
+	else
+	{
+		UART_TryWriteString(linePtr);
+	}
+}
+
+static void crPrint(uint16_t source, uint8_t index, const CR_RECORD *recordPtr, bool wait)
+{
+	char lineBuffer[96];
+	const char *reasonPtr = (CR_REASON_WATCHDOG >= recordPtr->reason) ? crReasonNames[recordPtr->reason] : "?";
+
+	if (false == crValid(recordPtr))
+	{
+		sprintf(lineBuffer, "CRASH %u #%u: garbled\n", source, index);
+		crWrite(lineBuffer, wait);
+		return;
+	}
+
+	sprintf(lineBuffer, "CRASH %u #%u: %s in %.8s at %lu ms", source, index, reasonPtr,
+			recordPtr->task, recordPtr->uptimeMs);
+	if (CR_REASON_ERROR == recordPtr->reason)
+	{
+		sprintf(lineBuffer + strlen(lineBuffer), " %.16s:%u", recordPtr->file, recordPtr->line);
+	}
+	else if (CR_REASON_WATCHDOG == recordPtr->reason)
+	{
+		sprintf(lineBuffer + strlen(lineBuffer), ", %u ms late", recordPtr->line);
+	}
+	strcat(lineBuffer, "\n");
+	crWrite(lineBuffer, wait);
+
+	sprintf(lineBuffer, "  PC %08lX LR %08lX PSR %08lX SP %08lX EXC %08lX\n", recordPtr->frame[6],
+			recordPtr->frame[5], recordPtr->frame[7], recordPtr->sp, recordPtr->excReturn);
+	crWrite(lineBuffer, wait);
+	sprintf(lineBuffer, "  CFSR %08lX HFSR %08lX MMFAR %08lX BFAR %08lX\n",
+			recordPtr->cfsr, recordPtr->hfsr, recordPtr->mmfar, recordPtr->bfar);
+	crWrite(lineBuffer, wait);
+	sprintf(lineBuffer, "  R0 %08lX R1 %08lX R2 %08lX R3 %08lX R12 %08lX\n",
+			recordPtr->frame[0], recordPtr->frame[1], recordPtr->frame[2], recordPtr->frame[3], recordPtr->frame[4]);
+	crWrite(lineBuffer, wait);
+	sprintf(lineBuffer, "  STACK %08lX %08lX %08lX %08lX %08lX %08lX %08lX %08lX\n",
+			recordPtr->stack[0], recordPtr->stack[1], recordPtr->stack[2], recordPtr->stack[3],
+			recordPtr->stack[4], recordPtr->stack[5], recordPtr->stack[6], recordPtr->stack[7]);
+	crWrite(lineBuffer, wait);
+}
+
+// CAN task -- never waits on the UART
+void CR_Print(uint16_t source, uint8_t index, const CR_RECORD *recordPtr)
+{
+	crPrint(source, index, recordPtr, false);
+}
+
+// CRASH <own ID> [n]: just the one, worded as a child's answer would be
+void CR_ReportRecord(uint8_t index)
+{
+	CR_RECORD record;
+	char reportBuffer[40];
+
+	if (false == CR_Get(index, &record))
+	{
+		sprintf(reportBuffer, "CRASH %lu: no such record\n", CAN_MyID());
+		WriteUARTString(reportBuffer);
+		return;
+	}
+	crPrint((uint16_t)CAN_MyID(), index, &record, true);
+}
+
+void CR_Report(void)
+{
+	CR_RECORD record;
+	int count = CR_Count();
+
+	if (0 == count)
+	{
+		WriteUARTString("CRASH: none\n");
+		return;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		if (true == CR_Get(i, &record))
+		{
+			crPrint((uint16_t)CAN_MyID(), (uint8_t)i, &record, true);
+		}
+	}
+}
@@ -7,8 +7,12 @@
 
 #include "UARTHandler.h"
 #include "FlashSupport.h"
+#include "BootHandoff.h"
+#include "SysBlock.h"
+#include "Crash.h"
+#include "Watchdog.h"
 
-#define VALID_PROGRAM_SIGNATURE ((uint32_t)0xAA55CC33)
+#define PLL_LOCK_SPIN_LIMIT		((uint32_t)100000)	// ~40 ms at 8 MHz HSI -- lock takes ~200 us
 
 
 // Bootloader Stuff:
@@ -30,8 +34,6 @@ typedef  void (*pFunction)(void);
 pFunction			JumpToApplication;
 volatile uint32_t 	JumpAddress;
 volatile uint32_t 	BaseOfUpperExec;
-volatile uint32_t	BaseOfLowerExec;
-volatile uint32_t	StackVal;
 
 static const char 	*locationString = "I'M HERE!";
 #ifdef _MY_RELOCATED_RELEASE
@@ -102,19 +104,17 @@ bool IAmInLowFlash(void)
 
 bool UpperBlockIsEmpty(void)
 {
-	uint16_t flashBlocks = *((uint16_t *)FLASHSIZE_BASE);
-
-	uint32_t *baseOfSysBlock = (uint32_t *)(FLASH_BASE + ((flashBlocks-1) * 1024));
+	uint32_t *crashStoreBase = (uint32_t *)CR_StoreBase();	// what EraseProgramBlock() stops at
 	uint32_t *baseOfUpperExec = (uint32_t *)(RELO_APP_BASE);
-	uint32_t *baseOfValidationSignature = baseOfSysBlock + 1;
+	uint16_t programValid;
 
-
-	if (0xFFFFFFFF != *baseOfValidationSignature)
+	if ((true == SB_Read(SB_KEY_PROGRAM_VALID, &programValid)) &&
+		(SB_PROGRAM_VALID_MARK == programValid))
 	{
 		return(false);
 	}
 
-	while (baseOfUpperExec < baseOfSysBlock)
+	while (baseOfUpperExec < crashStoreBase)
 	{
 		for (int i = 0; i < 256; i++)
 		{
@@ -131,14 +131,11 @@ bool UpperBlockIsEmpty(void)
 
 bool ValidProgramInHighFlash(void)
 {
-	uint16_t flashBlocks = *((uint16_t *)FLASHSIZE_BASE);
-
-	uint32_t *baseOfSysBlock = (uint32_t *)(FLASH_BASE + ((flashBlocks-1) * 1024));
 	uint32_t *baseOfUpperExec = (uint32_t *)(RELO_APP_BASE);
+	uint16_t programValid;
 
-	baseOfSysBlock++;
-
-	if (VALID_PROGRAM_SIGNATURE != *baseOfSysBlock)
+	if ((false == SB_Read(SB_KEY_PROGRAM_VALID, &programValid)) ||
+		(SB_PROGRAM_VALID_MARK != programValid))
 	{
 		return(false);
 	}
@@ -155,15 +152,15 @@ bool ValidProgramInHighFlash(void)
 
 void JumpToHighFlash(void)
 {
-	uint16_t flashBlocks = *((uint16_t *)FLASHSIZE_BASE);
-
 	uint8_t *baseOfUpperExec = (uint8_t *)(RELO_APP_BASE);
 	BaseOfUpperExec = (uint32_t *)baseOfUpperExec;
     JumpAddress = *(volatile unsigned long*) (baseOfUpperExec + 4);
 
 	__disable_irq();
+	SCB->VTOR = RELO_APP_BASE;
 	__set_CONTROL(0); // Assure privileged operation
 	__set_MSP(*(__IO uint32_t*) BaseOfUpperExec);
+	__enable_irq();	// Nothing is enabled in the NVIC yet -- see BootHandoff.h
 
      JumpToApplication = (pFunction) JumpAddress;
      JumpToApplication();
@@ -171,65 +168,89 @@ void JumpToHighFlash(void)
 
 }
 
-void RestartNode(void)
+// Runs from Reset_Handler BEFORE .data/.bss are initialized and before
+// SystemInit() turns on the FPU.  Only touch registers and locals in here.
+static void bootClockHandoff(void)
 {
-	uint8_t *baseOfLowerExec = (uint8_t *)(FLASH_BASE);
-	BaseOfLowerExec = (uint32_t *)baseOfLowerExec;
-    JumpAddress = *(volatile unsigned long*) (baseOfLowerExec + 4);
+	uint32_t spin = PLL_LOCK_SPIN_LIMIT;
 
-	portDISABLE_INTERRUPTS();
+	FLASH->ACR = FLASH_ACR_PRFTBE | FLASH_ACR_LATENCY_1;
+	RCC->CFGR = RCC_CFGR_PLLSRC_HSI_PREDIV | RCC_CFGR_PLLMUL9 | RCC_CFGR_PPRE1_DIV2;
+	RCC->CR |= RCC_CR_PLLON;
 
-	__disable_irq();
-	__set_CONTROL(0); // Assure privileged operation
-	__set_MSP(*(__IO uint32_t*) BaseOfLowerExec);
+	while (0 == (RCC->CR & RCC_CR_PLLRDY))
+	{
+		if (0 == --spin)
+		{
+			// No lock -- put everything back and let the application do the full bring-up
+			RCC->CR &= ~RCC_CR_PLLON;
+			RCC->CFGR = 0;
+			FLASH->ACR = FLASH_ACR_PRFTBE;
+			return;
+		}
+	}
 
-     JumpToApplication = (pFunction) JumpAddress;
-     JumpToApplication();
-     while(1);
+	RCC->CFGR |= RCC_CFGR_SW_PLL;
+	while (RCC_CFGR_SWS_PLL != (RCC->CFGR & RCC_CFGR_SWS))
+	{
+	}
+}
 
+void LoaderEarlyEntry(void)
+{
+#ifndef _MY_RELOCATED_RELEASE
+	if (false == IAmInLowFlash())
+	{
+		return;
+	}
+
+	// A signature in the system block means UpperBlockIsEmpty() returns on its
+	// first check, so a valid image is handed off without scanning flash.
+	if ((false == UpperBlockIsEmpty()) && (true == ValidProgramInHighFlash()))
+	{
+		bootClockHandoff();
+		JumpToHighFlash();
+	}
+#endif
+}
+
+void RestartNode(void)
+{
+	// Reset rather than jump to FLASH_BASE so LoaderEarlyEntry() always starts
+	// from peripherals, clocks and NVIC in reset state.
+	portDISABLE_INTERRUPTS();
+	NVIC_SystemReset();
 }
 
 uint16_t GetIdFromFlash(void)
 {
 	uint16_t myCANId;
 
-	uint16_t flashBlocks = *((uint16_t *)FLASHSIZE_BASE);
-	uint32_t *sysBlockBase = (uint32_t *)(FLASH_BASE + ((flashBlocks-1) * 1024));
-
-	myCANId = ((*sysBlockBase) & 0x1FF);
-	return(myCANId);
+	if (false == SB_Read(SB_KEY_NODE_ID, &myCANId))
+	{
+		return(0x1FF);	// Never assigned -- CAN_DEFAULT_ID
+	}
+	return(myCANId & 0x1FF);
 }
 
 void ProgramIdIntoFlash(uint32_t id)
 {
-	uint16_t flashBlocks = *((uint16_t *)FLASHSIZE_BASE);
-	uint32_t *sysBlockBase = (uint32_t *)(FLASH_BASE + ((flashBlocks-1) * 1024));
-
-	HAL_FLASH_Unlock();
-	HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, sysBlockBase, id);
-	HAL_FLASH_Lock();
+	SB_Write(SB_KEY_NODE_ID, (uint16_t)(id & 0x1FF));
 }
 
 void EraseSystemBlock(void)
 {
-	uint16_t flashBlocks = *((uint16_t *)FLASHSIZE_BASE);
-	uint32_t *sysBlockBase = (uint32_t *)(FLASH_BASE + (flashBlocks *1024) - FLASH_PAGE_SIZE);
-
-	HAL_FLASH_Unlock();
-	FLASH_PageErase(sysBlockBase);
-    FLASH_WaitForLastOperation(FLASH_TIMEOUT_VALUE);
-    CLEAR_BIT (FLASH->CR, (FLASH_CR_PER));  // HOLY SHIT:  https://stackoverflow.com/questions/28498191/cant-write-to-flash-memory-after-erase
-	HAL_FLASH_Lock();
-
+	// Back to square 1 -- appended like any other update, no page erase.
+	SB_Write(SB_KEY_NODE_ID, 0x1FF);
+	SB_Write(SB_KEY_PROGRAM_VALID, SB_PROGRAM_INVALID_MARK);
 }
 
 void EraseProgramBlock(void)
 {
-	uint16_t flashBlocks = *((uint16_t *)FLASHSIZE_BASE);
-	uint32_t *sysBlockBase = (uint32_t *)(FLASH_BASE + (flashBlocks * 1024) - FLASH_PAGE_SIZE);
+	uint32_t *crashStoreBase = (uint32_t *)CR_StoreBase();	// crash records outlive the program
 	uint32_t *baseOfUpperExec = (uint32_t *)(RELO_APP_BASE);
 
-	while(baseOfUpperExec < sysBlockBase)
+	while(baseOfUpperExec < crashStoreBase)
 	{
 		HAL_FLASH_Unlock();
 		FLASH_PageErase(baseOfUpperExec);
@@ -238,27 +259,18 @@ void EraseProgramBlock(void)
 		HAL_FLASH_Lock();
 		baseOfUpperExec += 256;
 		baseOfUpperExec += 256;
+		WD_CheckIn();		// ~150 pages at up to 40ms each
 	}
 }
 
 void InvalidateProgram(void)
 {
-	int myID = GetIdFromFlash();
-	EraseSystemBlock();
-	ProgramIdIntoFlash(myID);
+	SB_Write(SB_KEY_PROGRAM_VALID, SB_PROGRAM_INVALID_MARK);
 }
 
 void ValidateProgram(void)
 {
-	uint16_t flashBlocks = *((uint16_t *)FLASHSIZE_BASE);
-	uint32_t *sysBlockBase = (uint32_t *)(FLASH_BASE + ((flashBlocks-1) * 1024));
-	sysBlockBase += 1;
-
-	InvalidateProgram();
-
-	HAL_FLASH_Unlock();
-	HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, sysBlockBase, VALID_PROGRAM_SIGNATURE);
-	HAL_FLASH_Lock();
+	SB_Write(SB_KEY_PROGRAM_VALID, SB_PROGRAM_VALID_MARK);
 }
 
 
@@ -302,22 +314,20 @@ void ReportFlash(void)
 {
 	uint16_t flashBlocks = *((uint16_t *)FLASHSIZE_BASE);
 	static bool report = false;
-	char *ptr;
+	char ptr[64];
 
 	if (true == report)
 	{
 		return;
 	}
 
-	ptr = (char *)pvPortMalloc(64);
 	sprintf(ptr, "MemStats: 0x%08LX 0x%04X 0x%08LX 0x%08LX\n",
 			FLASH_BASE,
 			flashBlocks,
 			FLASH_BASE + (flashBlocks*1024) - 1,
-			FLASH_BASE + ((flashBlocks-1) * 1024));
+			SB_StoreBase());
 	WriteUARTString(ptr);
 	sprintf(ptr, "%s memory\n", (IAmInLowFlash() ? "LOW" : "HIGH"));
 	WriteUARTString(ptr);
-	vPortFree(ptr);
 	report = true;
 }
@@ -0,0 +1,172 @@
+/*
+ * FrameLog.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "FrameLog.h"
+#include "UARTHandler.h"
+#include "HostLink.h"
+#include "CANMonitor.h"
+#include "Watchdog.h"
+
+#include <string.h>
+
+#define FL_MONITOR_POLL_MS	1		// monitor captures batch up between looks
+#define FL_SIGNAL_RECORD	0x0001
+
+extern osThreadId FrameLogTaskHandle;
+
+static FL_RECORD			flRing[FL_RING_RECORDS];
+static volatile uint16_t	flHead = 0;
+static volatile uint16_t	flTail = 0;
+static volatile uint32_t	flDropped = 0;
+static volatile bool		flBinary = false;
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+void FL_Record(uint16_t source, uint16_t destination, uint16_t command, const uint8_t *dataPtr)
+{
+	UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+	uint16_t next = (flHead + 1) % FL_RING_RECORDS;
+
+	if (next == flTail)
+	{
+		flDropped++;
+	}
+	else
+	{
+		FL_RECORD *recPtr = &flRing[flHead];
+
+		recPtr->timestamp = xTaskGetTickCountFromISR();
+		recPtr->source = source;
+		recPtr->destination = destination;
+		recPtr->command = command;
+		memcpy(recPtr->data, dataPtr, sizeof(recPtr->data));
+		flHead = next;
+	}
+	taskEXIT_CRITICAL_FROM_ISR(mask);
+	FL_Wake();
+}
+
+// Task or ISR
+void FL_Wake(void)
+{
+	if (NULL != FrameLogTaskHandle)
+	{
+		osSignalSet(FrameLogTaskHandle, FL_SIGNAL_RECORD);
+	}
+}
+
+void FL_SetBinary(bool binary)
+{
+	flBinary = binary;
+}
+
+bool FL_IsBinary(void)
+{
+	return(flBinary);
+}
+
+uint32_t FL_Dropped(void)
+{
+	return(flDropped);
+}
+
+static char *putHex(char *ptr, uint32_t value, int digits, bool upper)
+{
+	*ptr++ = '0';
+	*ptr++ = 'x';
+	for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4)
+	{
+		char ch = hexDigits[(value >> shift) & 0x0F];
+
+		*ptr++ = ((false == upper) && (ch > '9')) ? (ch + ('a' - 'A')) : ch;
+	}
+	return(ptr);
+}
+
+// Same line UART_ReportReceivedMessage always printed:
+// "0x%04X 0x%04X 0x%04X 0x%02x 0x%02x ... 0x%02x\n"
+static void emitText(const FL_RECORD *recPtr)
+{
+	char line[80];
+	char *ptr = line;
+
+	ptr = putHex(ptr, recPtr->source, 4, true);
+	*ptr++ = ' ';
+	ptr = putHex(ptr, recPtr->destination, 4, true);
+	*ptr++ = ' ';
+	ptr = putHex(ptr, recPtr->command, 4, true);
+	for (int i = 0; i < sizeof(recPtr->data); i++)
+	{
+		*ptr++ = ' ';
+		ptr = putHex(ptr, recPtr->data[i], 2, false);
+	}
+	*ptr++ = '\n';
+	*ptr = '\0';
+
+	WriteUARTString(line);
+}
+
+static void emitBinary(const FL_RECORD *recPtr)
+{
+	HL_Send(HL_MSG_CAN_CAPTURE, 0, (const uint8_t *)recPtr, sizeof(FL_RECORD), true);
+}
+
+static void reportDrops(uint32_t dropped)
+{
+	char line[32] = "LOG DROPPED ";
+	char *ptr = putHex(&line[strlen(line)], dropped, 8, true);
+
+	*ptr++ = '\n';
+	*ptr = '\0';
+	WriteUARTString(line);
+}
+
+void taskFrameLog(void const * argument)
+{
+	uint32_t droppedReported = 0;
+
+	WD_Register(WD_DEADLINE_MS);
+
+	/* Infinite loop */
+	for(;;)
+	{
+		FL_RECORD record;
+
+		WD_CheckIn();
+
+		if (true == MON_Pump())
+		{
+			continue;
+		}
+
+		if (flTail == flHead)
+		{
+			uint32_t dropped = flDropped;
+
+			if ((dropped != droppedReported) && (false == flBinary) && (false == HL_Active()))
+			{
+				reportDrops(dropped - droppedReported);
+			}
+			droppedReported = dropped;
+			osSignalWait(FL_SIGNAL_RECORD, WD_Wait(MON_Active() ? FL_MONITOR_POLL_MS : osWaitForever));
+			continue;
+		}
+
+		// Only this task moves the tail -- copy out, then release the slot.
+		record = flRing[flTail];
+		flTail = (flTail + 1) % FL_RING_RECORDS;
+
+		if ((true == flBinary) || (true == HL_Active()))
+		{
+			emitBinary(&record);
+		}
+		else
+		{
+			emitText(&record);
+		}
+	}
+}
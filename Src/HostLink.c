@@ -0,0 +1,356 @@
+/*
+ * HostLink.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "HostLink.h"
+#include "UARTHandler.h"
+#include "CANHandler.h"
+#include "FrameLog.h"
+#include "CANMonitor.h"
+#include "Jobs.h"
+
+#include <string.h>
+
+#define HL_MAX_FRAME		(2 + HL_MAX_PAYLOAD + 2)
+#define HL_MAX_ENCODED		(HL_MAX_FRAME + (HL_MAX_FRAME / 254) + 2)	// COBS overhead + delimiter
+#define HL_FW_FEED_MS		50		// longest a DATA frame waits for the load job to make room
+
+static volatile bool	hlActive = false;
+
+static uint8_t			hlRxBuffer[HL_MAX_ENCODED];
+static uint16_t			hlRxCount = 0;
+static bool				hlRxOverflow = false;
+
+static HL_STATS			hlStats;
+
+static uint16_t crc16(const uint8_t *dataPtr, uint16_t length)
+{
+	uint16_t crc = 0xFFFF;
+
+	while (0 != length--)
+	{
+		crc ^= (uint16_t)(*dataPtr++) << 8;
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+		}
+	}
+	return(crc);
+}
+
+static uint16_t cobsEncode(const uint8_t *inPtr, uint16_t length, uint8_t *outPtr)
+{
+	uint16_t codeIndex = 0;
+	uint16_t out = 1;
+	uint8_t code = 1;
+
+	for (uint16_t in = 0; in < length; in++)
+	{
+		if (0 == inPtr[in])
+		{
+			outPtr[codeIndex] = code;
+			codeIndex = out++;
+			code = 1;
+			continue;
+		}
+		outPtr[out++] = inPtr[in];
+		if (0xFF == ++code)
+		{
+			outPtr[codeIndex] = code;
+			codeIndex = out++;
+			code = 1;
+		}
+	}
+	outPtr[codeIndex] = code;
+	return(out);
+}
+
+// Returns the decoded length, -1 on a malformed frame.
+static int cobsDecode(const uint8_t *inPtr, uint16_t length, uint8_t *outPtr)
+{
+	uint16_t in = 0;
+	uint16_t out = 0;
+
+	while (in < length)
+	{
+		uint8_t code = inPtr[in++];
+
+		if (0 == code)
+		{
+			return(-1);
+		}
+		for (uint8_t i = 1; i < code; i++)
+		{
+			if (in >= length)
+			{
+				return(-1);
+			}
+			outPtr[out++] = inPtr[in++];
+		}
+		if ((0xFF != code) && (in < length))
+		{
+			outPtr[out++] = 0;
+		}
+	}
+	return(out);
+}
+
+static uint32_t getLE32(const uint8_t *ptr)
+{
+	return((uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24));
+}
+
+static void replyStatus(uint8_t type, uint8_t seq, uint8_t status)
+{
+	HL_Send(type | HL_REPLY_BIT, seq, &status, 1, true);
+}
+
+static uint8_t doInject(const uint8_t *payloadPtr, uint16_t length)
+{
+	if ((5 > length) || (8 < payloadPtr[4]) || ((5 + payloadPtr[4]) != length))
+	{
+		return(HL_STATUS_BAD_LENGTH);
+	}
+	if (false == CAN_InjectFrame(getLE32(payloadPtr), payloadPtr[4], &payloadPtr[5]))
+	{
+		return(HL_STATUS_FAILED);
+	}
+	return(HL_STATUS_OK);
+}
+
+// The load runs as a job (Jobs.h); START answers with its ID, DATA only
+// queues the bytes, so STATS and COMMAND frames keep being served meanwhile.
+static void doFirmwareChunk(uint8_t seq, const uint8_t *payloadPtr, uint16_t length)
+{
+	uint8_t reply[3] = {HL_STATUS_BAD_LENGTH, 0, 0};
+	uint32_t start;
+	uint16_t job;
+
+	if (0 == length)
+	{
+		replyStatus(HL_MSG_FW_CHUNK, seq, HL_STATUS_BAD_LENGTH);
+		return;
+	}
+
+	switch (payloadPtr[0])
+	{
+	case HL_FW_START:
+		if (7 == length)
+		{
+			job = JOB_LoadStart(payloadPtr[1] | (payloadPtr[2] << 8), getLE32(&payloadPtr[3]));
+			reply[0] = (0 == job) ? HL_STATUS_FAILED : HL_STATUS_OK;
+			reply[1] = (uint8_t)job;
+			reply[2] = (uint8_t)(job >> 8);
+		}
+		HL_Send(HL_MSG_FW_CHUNK | HL_REPLY_BIT, seq, reply, sizeof(reply), true);
+		return;
+
+	case HL_FW_DATA:
+		if (false == JOB_LoadActive())
+		{
+			replyStatus(HL_MSG_FW_CHUNK, seq, HL_STATUS_FAILED);
+			return;
+		}
+		start = osKernelSysTick();
+		while (false == JOB_LoadFeed(&payloadPtr[1], length - 1))
+		{
+			if ((false == JOB_LoadActive()) || (HL_FW_FEED_MS <= (osKernelSysTick() - start)))
+			{
+				replyStatus(HL_MSG_FW_CHUNK, seq, HL_STATUS_BUSY);
+				return;
+			}
+			osDelay(1);
+		}
+		replyStatus(HL_MSG_FW_CHUNK, seq, HL_STATUS_OK);
+		return;
+
+	case HL_FW_CLOSE:
+		replyStatus(HL_MSG_FW_CHUNK, seq, JOB_LoadClose() ? HL_STATUS_OK : HL_STATUS_FAILED);
+		return;
+
+	default:
+		replyStatus(HL_MSG_FW_CHUNK, seq, HL_STATUS_UNKNOWN);
+		return;
+	}
+}
+
+static void doCommand(uint8_t seq, const uint8_t *payloadPtr, uint16_t length)
+{
+	char line[HL_MAX_PAYLOAD + 1];
+
+	memcpy(line, payloadPtr, length);
+	line[length] = '\0';
+	DoUARTCommand(line);		// output comes back as HL_MSG_TEXT frames
+	replyStatus(HL_MSG_COMMAND, seq, HL_STATUS_OK);
+}
+
+static void doStats(uint8_t seq)
+{
+	uint8_t reply[1 + sizeof(HL_STATS)];
+
+	hlStats.logDropped = FL_Dropped();
+	hlStats.uartTxDropped = UART_TxDropped();
+	hlStats.canErrors = CAN_ErrorCount();
+	hlStats.monitorDropped = MON_Dropped();
+	hlStats.canTxDropped = CAN_TxDropped();
+
+	reply[0] = HL_STATUS_OK;
+	memcpy(&reply[1], &hlStats, sizeof(HL_STATS));
+	HL_Send(HL_MSG_STATS | HL_REPLY_BIT, seq, reply, sizeof(reply), true);
+}
+
+static void dispatch(const uint8_t *framePtr, uint16_t length)
+{
+	uint8_t type = framePtr[0];
+	uint8_t seq = framePtr[1];
+	const uint8_t *payloadPtr = &framePtr[2];
+
+	length -= 2;
+	hlStats.rxFrames++;
+
+	switch (type)
+	{
+	case HL_MSG_CAN_INJECT:
+		replyStatus(type, seq, doInject(payloadPtr, length));
+		break;
+
+	case HL_MSG_COMMAND:
+		doCommand(seq, payloadPtr, length);
+		break;
+
+	case HL_MSG_FW_CHUNK:
+		doFirmwareChunk(seq, payloadPtr, length);
+		break;
+
+	case HL_MSG_STATS:
+		doStats(seq);
+		break;
+
+	case HL_MSG_MODE:
+		replyStatus(type, seq, HL_STATUS_OK);
+		if ((0 != length) && (0 == payloadPtr[0]))
+		{
+			hlActive = false;
+		}
+		break;
+
+	default:
+		replyStatus(type, seq, HL_STATUS_UNKNOWN);
+		break;
+	}
+}
+
+static void frameComplete(void)
+{
+	uint8_t frame[HL_MAX_ENCODED];
+	int length;
+
+	if (true == hlRxOverflow)
+	{
+		hlStats.rxErrors++;
+		return;
+	}
+	if (0 == hlRxCount)
+	{
+		return;		// back to back delimiters
+	}
+
+	length = cobsDecode(hlRxBuffer, hlRxCount, frame);
+	if ((4 > length) || (HL_MAX_FRAME < length))
+	{
+		hlStats.rxErrors++;
+		return;
+	}
+	if (crc16(frame, length - 2) != (frame[length - 2] | (frame[length - 1] << 8)))
+	{
+		hlStats.rxErrors++;
+		return;
+	}
+	dispatch(frame, length - 2);
+}
+
+void HL_Enter(void)
+{
+	hlRxCount = 0;
+	hlRxOverflow = false;
+	hlActive = true;
+}
+
+bool HL_Active(void)
+{
+	return(hlActive);
+}
+
+// Fed one byte at a time by the UART task while framed mode is active.
+void HL_RxByte(uint8_t ch)
+{
+	if (0 == ch)
+	{
+		frameComplete();
+		hlRxCount = 0;
+		hlRxOverflow = false;
+		return;
+	}
+
+	if (sizeof(hlRxBuffer) <= hlRxCount)
+	{
+		hlRxOverflow = true;	// swallow the rest up to the delimiter
+		return;
+	}
+	hlRxBuffer[hlRxCount++] = ch;
+}
+
+bool HL_Send(uint8_t type, uint8_t seq, const uint8_t *payloadPtr, uint16_t length, bool wait)
+{
+	uint8_t frame[HL_MAX_FRAME];
+	uint8_t encoded[HL_MAX_ENCODED];
+	uint16_t crc;
+	uint16_t encodedLength;
+
+	if (HL_MAX_PAYLOAD < length)
+	{
+		return(false);
+	}
+
+	frame[0] = type;
+	frame[1] = seq;
+	memcpy(&frame[2], payloadPtr, length);
+	crc = crc16(frame, length + 2);
+	frame[length + 2] = (uint8_t)crc;
+	frame[length + 3] = (uint8_t)(crc >> 8);
+
+	encodedLength = cobsEncode(frame, length + 4, encoded);
+	encoded[encodedLength++] = 0;
+
+	if (true == wait)
+	{
+		UART_Write(encoded, encodedLength);
+	}
+	else if (false == UART_TryWrite(encoded, encodedLength))
+	{
+		return(false);
+	}
+	hlStats.txFrames++;
+	return(true);
+}
+
+bool HL_SendText(const char *strPtr, bool wait)
+{
+	uint16_t length = strlen(strPtr);
+
+	while (0 != length)
+	{
+		uint16_t chunk = (HL_MAX_PAYLOAD < length) ? HL_MAX_PAYLOAD : length;
+
+		if (false == HL_Send(HL_MSG_TEXT, 0, (const uint8_t *)strPtr, chunk, wait))
+		{
+			return(false);
+		}
+		strPtr += chunk;
+		length -= chunk;
+	}
+	return(true);
+}
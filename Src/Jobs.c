@@ -0,0 +1,314 @@
+/*
+ * Jobs.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "Jobs.h"
+#include "CharQueue.h"
+#include "CANHandler.h"
+#include "UARTHandler.h"
+#include "Watchdog.h"
+
+#include <stdio.h>
+
+extern osMessageQId JobQueueHandle;
+
+typedef struct _JOB_ENTRY
+{
+	uint16_t			id;
+	volatile JOB_STATE	state;
+	volatile bool		cancel;
+	const char			*namePtr;
+	JOB_FUNCTION		function;
+	uint32_t			arg0;
+	uint32_t			arg1;
+	volatile uint32_t	progress;
+} JOB_ENTRY;
+
+static const char * const jobStateNames[] =
+{
+	"FREE", "QUEUED", "RUNNING", "DONE", "FAILED", "CANCELLED"
+};
+
+static JOB_ENTRY			jobTable[JOB_SLOTS];
+static JOB_ENTRY * volatile	jobCurrent = NULL;
+static uint16_t				jobNextId = 1;
+
+static QUEUE_MGT_STRUCT		loadPipe;
+static uint8_t				loadPipeBuffer[JOB_LOAD_PIPE_LENGTH];
+static uint16_t				loadJobId = 0;
+static volatile bool		loadClosed = false;
+
+static bool jobBusy(JOB_STATE state)
+{
+	return((JOB_QUEUED == state) || (JOB_RUNNING == state));
+}
+
+static JOB_ENTRY *jobFind(uint16_t id)
+{
+	for (int i = 0; i < JOB_SLOTS; i++)
+	{
+		if ((0 != id) && (id == jobTable[i].id) && (JOB_FREE != jobTable[i].state))
+		{
+			return(&jobTable[i]);
+		}
+	}
+	return(NULL);
+}
+
+// A free slot, else the finished job with the oldest ID.  Interrupts masked.
+static JOB_ENTRY *jobClaimSlot(void)
+{
+	JOB_ENTRY *slotPtr = NULL;
+
+	for (int i = 0; i < JOB_SLOTS; i++)
+	{
+		if (JOB_FREE == jobTable[i].state)
+		{
+			return(&jobTable[i]);
+		}
+		if (true == jobBusy(jobTable[i].state))
+		{
+			continue;
+		}
+		if ((NULL == slotPtr) || (0 > (int16_t)(jobTable[i].id - slotPtr->id)))
+		{
+			slotPtr = &jobTable[i];
+		}
+	}
+	return(slotPtr);
+}
+
+uint16_t JOB_Submit(const char *namePtr, JOB_FUNCTION function, uint32_t arg0, uint32_t arg1)
+{
+	JOB_ENTRY *slotPtr;
+	uint16_t id;
+
+	taskENTER_CRITICAL();
+	slotPtr = jobClaimSlot();
+	if (NULL == slotPtr)
+	{
+		taskEXIT_CRITICAL();
+		return(0);
+	}
+
+	id = jobNextId++;
+	if (0 == jobNextId)
+	{
+		jobNextId = 1;
+	}
+	slotPtr->id = id;
+	slotPtr->cancel = false;
+	slotPtr->namePtr = namePtr;
+	slotPtr->function = function;
+	slotPtr->arg0 = arg0;
+	slotPtr->arg1 = arg1;
+	slotPtr->progress = 0;
+	slotPtr->state = JOB_QUEUED;
+	taskEXIT_CRITICAL();
+
+	// Never more than JOB_SLOTS entries queued, so this cannot be full.
+	if (osOK != osMessagePut(JobQueueHandle, (uint32_t)(slotPtr - jobTable), 0))
+	{
+		slotPtr->state = JOB_FAILED;
+		return(0);
+	}
+	return(id);
+}
+
+bool JOB_Cancel(uint16_t id)
+{
+	JOB_ENTRY *jobPtr = jobFind(id);
+
+	if ((NULL == jobPtr) || (false == jobBusy(jobPtr->state)))
+	{
+		return(false);
+	}
+	jobPtr->cancel = true;
+	return(true);
+}
+
+JOB_STATE JOB_State(uint16_t id)
+{
+	JOB_ENTRY *jobPtr = jobFind(id);
+
+	return((NULL == jobPtr) ? JOB_FREE : jobPtr->state);
+}
+
+// Only meaningful from inside a job function
+bool JOB_Cancelled(void)
+{
+	JOB_ENTRY *jobPtr = jobCurrent;
+
+	return((NULL != jobPtr) && (true == jobPtr->cancel));
+}
+
+void JOB_Progress(uint32_t count)
+{
+	JOB_ENTRY *jobPtr = jobCurrent;
+
+	if (NULL != jobPtr)
+	{
+		jobPtr->progress = count;
+	}
+}
+
+// id 0 lists every job in the table
+void JOB_Report(uint16_t id)
+{
+	char reportBuffer[48];
+	bool found = false;
+
+	for (int i = 0; i < JOB_SLOTS; i++)
+	{
+		JOB_ENTRY *jobPtr = &jobTable[i];
+
+		if ((JOB_FREE == jobPtr->state) || ((0 != id) && (id != jobPtr->id)))
+		{
+			continue;
+		}
+		sprintf(reportBuffer, "JOB %u %s %s %lu\n", jobPtr->id, jobPtr->namePtr,
+				jobStateNames[jobPtr->state], jobPtr->progress);
+		WriteUARTString(reportBuffer);
+		found = true;
+	}
+
+	if (false == found)
+	{
+		WriteUARTString((0 == id) ? "NO JOBS\n" : "NO SUCH JOB\n");
+	}
+}
+
+static bool loadJob(uint32_t id, uint32_t baseAddress)
+{
+	uint32_t count = 0;
+	uint32_t lastByte;
+	uint8_t ch;
+
+	if (true == CAN_ProgramStart(id, baseAddress))
+	{
+		lastByte = osKernelSysTick();
+		while (false == JOB_Cancelled())
+		{
+			if (true == CQ_DequeueChar(&loadPipe, &ch))
+			{
+				CAN_ProgramChar(ch);
+				JOB_Progress(++count);
+				lastByte = osKernelSysTick();
+				continue;
+			}
+
+			if (true == loadClosed)
+			{
+				return(CAN_ProgramClose());
+			}
+			if (JOB_LOAD_STALL_MS <= (osKernelSysTick() - lastByte))
+			{
+				break;			// the host went away without closing
+			}
+			WD_CheckIn();		// waiting on the host, not stuck
+			osDelay(1);
+		}
+	}
+
+	// Cancelled, stalled, or a child refused SET_BASE while others took it
+	CAN_ProgramAbort();
+	return(false);
+}
+
+uint16_t JOB_LoadStart(uint32_t id, uint32_t baseAddress)
+{
+	if (true == JOB_LoadActive())
+	{
+		return(0);
+	}
+
+	CQ_Init(&loadPipe, loadPipeBuffer, JOB_LOAD_PIPE_LENGTH);
+	loadClosed = false;
+	loadJobId = JOB_Submit("LOAD", loadJob, id, baseAddress);
+	return(loadJobId);
+}
+
+bool JOB_LoadActive(void)
+{
+	return(jobBusy(JOB_State(loadJobId)));
+}
+
+uint16_t JOB_LoadSpace(void)
+{
+	if ((false == JOB_LoadActive()) || (true == loadClosed))
+	{
+		return(0);
+	}
+	return((uint16_t)(loadPipe.max_queue_size - loadPipe.char_count));
+}
+
+// All or nothing -- the caller keeps what does not fit and offers it again.
+bool JOB_LoadFeed(const uint8_t *dataPtr, uint16_t length)
+{
+	if (JOB_LoadSpace() < length)
+	{
+		return(false);
+	}
+	return(CQ_EnqueueBlock(&loadPipe, dataPtr, length));
+}
+
+bool JOB_LoadClose(void)
+{
+	if (false == JOB_LoadActive())
+	{
+		return(false);
+	}
+	loadClosed = true;
+	return(true);
+}
+
+bool JOB_LoadCancel(void)
+{
+	return(JOB_Cancel(loadJobId));
+}
+
+void taskJob(void const * argument)
+{
+	osEvent event;
+	JOB_ENTRY *jobPtr;
+	bool result;
+
+	WD_Register(WD_DEADLINE_LONG_MS);
+
+	/* Infinite loop */
+	for(;;)
+	{
+		WD_CheckIn();
+		event = osMessageGet(JobQueueHandle, WD_Wait(osWaitForever));
+		if ((osEventMessage != event.status) || (JOB_SLOTS <= event.value.v))
+		{
+			continue;
+		}
+		jobPtr = &jobTable[event.value.v];
+
+		if (true == jobPtr->cancel)
+		{
+			jobPtr->state = JOB_CANCELLED;		// cancelled while still queued
+		}
+		else
+		{
+			jobPtr->state = JOB_RUNNING;
+			jobCurrent = jobPtr;
+			result = (jobPtr->function)(jobPtr->arg0, jobPtr->arg1);
+			jobCurrent = NULL;
+
+			if (true == jobPtr->cancel)
+			{
+				jobPtr->state = JOB_CANCELLED;
+			}
+			else
+			{
+				jobPtr->state = (true == result) ? JOB_DONE : JOB_FAILED;
+			}
+		}
+		JOB_Report(jobPtr->id);
+	}
+}
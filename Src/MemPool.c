@@ -0,0 +1,161 @@
+/*
+ * MemPool.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "MemPool.h"
+#include "main.h"
+#include "cmsis_os.h"
+#include "UARTHandler.h"
+
+#include <stdio.h>
+
+typedef struct _MP_BLOCK
+{
+	struct _MP_BLOCK	*nextPtr;
+} MP_BLOCK;
+
+typedef struct _MP_CLASS
+{
+	uint8_t		*basePtr;
+	uint16_t	blockSize;
+	uint16_t	blockCount;
+	MP_BLOCK	*freePtr;		// blocks given back
+	uint16_t	fresh;			// blocks never handed out start here
+	uint16_t	inUse;
+	uint16_t	highWater;
+	uint32_t	failures;
+} MP_CLASS;
+
+// uint32_t storage keeps every block word aligned
+static uint32_t	mpSmall[(MP_SMALL_SIZE * MP_SMALL_BLOCKS) / 4];
+static uint32_t	mpMedium[(MP_MEDIUM_SIZE * MP_MEDIUM_BLOCKS) / 4];
+static uint32_t	mpLarge[(MP_LARGE_SIZE * MP_LARGE_BLOCKS) / 4];
+
+// Smallest first -- MP_Alloc() relies on the order
+static MP_CLASS	mpClasses[MP_CLASSES] =
+{
+	{(uint8_t *)mpSmall,	MP_SMALL_SIZE,	MP_SMALL_BLOCKS,	NULL, 0, 0, 0, 0},
+	{(uint8_t *)mpMedium,	MP_MEDIUM_SIZE,	MP_MEDIUM_BLOCKS,	NULL, 0, 0, 0, 0},
+	{(uint8_t *)mpLarge,	MP_LARGE_SIZE,	MP_LARGE_BLOCKS,	NULL, 0, 0, 0, 0},
+};
+
+// Interrupts masked
+static void *mpTake(MP_CLASS *classPtr)
+{
+	MP_BLOCK *blockPtr = classPtr->freePtr;
+
+	if (NULL != blockPtr)
+	{
+		classPtr->freePtr = blockPtr->nextPtr;
+	}
+	else if (classPtr->fresh < classPtr->blockCount)
+	{
+		blockPtr = (MP_BLOCK *)(classPtr->basePtr + (classPtr->fresh++ * classPtr->blockSize));
+	}
+	else
+	{
+		return(NULL);
+	}
+
+	if (++classPtr->inUse > classPtr->highWater)
+	{
+		classPtr->highWater = classPtr->inUse;
+	}
+	return(blockPtr);
+}
+
+void *MP_Alloc(uint16_t size)
+{
+	MP_CLASS *firstPtr = NULL;
+	void *blockPtr = NULL;
+	UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+
+	for (int i = 0; (NULL == blockPtr) && (i < MP_CLASSES); i++)
+	{
+		if (size > mpClasses[i].blockSize)
+		{
+			continue;
+		}
+		if (NULL == firstPtr)
+		{
+			firstPtr = &mpClasses[i];
+		}
+		blockPtr = mpTake(&mpClasses[i]);
+	}
+
+	if ((NULL == blockPtr) && (NULL != firstPtr))
+	{
+		firstPtr->failures++;
+	}
+	taskEXIT_CRITICAL_FROM_ISR(mask);
+	return(blockPtr);
+}
+
+void MP_Free(void *blockPtr)
+{
+	uint8_t *bytePtr = (uint8_t *)blockPtr;
+	UBaseType_t mask;
+
+	if (NULL == blockPtr)
+	{
+		return;
+	}
+
+	for (int i = 0; i < MP_CLASSES; i++)
+	{
+		MP_CLASS *classPtr = &mpClasses[i];
+
+		if ((bytePtr < classPtr->basePtr) ||
+			(bytePtr >= (classPtr->basePtr + (classPtr->blockSize * classPtr->blockCount))))
+		{
+			continue;
+		}
+
+		mask = taskENTER_CRITICAL_FROM_ISR();
+		((MP_BLOCK *)blockPtr)->nextPtr = classPtr->freePtr;
+		classPtr->freePtr = (MP_BLOCK *)blockPtr;
+		classPtr->inUse--;
+		taskEXIT_CRITICAL_FROM_ISR(mask);
+		return;
+	}
+
+	// Not one of ours -- freeing it would corrupt a free list later
+	_Error_Handler(__FILE__, __LINE__);
+}
+
+bool MP_Stats(int sizeClass, MP_STATS *statsPtr)
+{
+	MP_CLASS *classPtr;
+	UBaseType_t mask;
+
+	if ((0 > sizeClass) || (MP_CLASSES <= sizeClass))
+	{
+		return(false);
+	}
+	classPtr = &mpClasses[sizeClass];
+
+	mask = taskENTER_CRITICAL_FROM_ISR();
+	statsPtr->blockSize = classPtr->blockSize;
+	statsPtr->blockCount = classPtr->blockCount;
+	statsPtr->inUse = classPtr->inUse;
+	statsPtr->highWater = classPtr->highWater;
+	statsPtr->failures = classPtr->failures;
+	taskEXIT_CRITICAL_FROM_ISR(mask);
+	return(true);
+}
+
+void MP_Report(void)
+{
+	char reportBuffer[48];
+	MP_STATS stats;
+
+	for (int i = 0; true == MP_Stats(i, &stats); i++)
+	{
+		sprintf(reportBuffer, "POOL %u %u/%u HW %u FAIL %lu\n", stats.blockSize,
+				stats.inUse, stats.blockCount, stats.highWater, stats.failures);
+		WriteUARTString(reportBuffer);
+	}
+}
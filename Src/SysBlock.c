@@ -0,0 +1,253 @@
+/*
+ * SysBlock.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "SysBlock.h"
+
+#define SB_ERASED_WORD				((uint32_t)0xFFFFFFFF)
+#define SB_NO_PAGE					(-1)
+
+#define SB_RECORD(key, value)		(((uint32_t)(key) << 24) | ((uint32_t)(value) << 8) | sbCheck((key), (value)))
+#define SB_RECORD_KEY(rec)			((uint8_t)((rec) >> 24))
+#define SB_RECORD_VALUE(rec)		((uint16_t)((rec) >> 8))
+
+// Pre-store layout: ID in the first word of the last 1K, signature right after it.
+#define LEGACY_PROGRAM_SIGNATURE	((uint32_t)0xAA55CC33)
+
+extern void FLASH_PageErase(uint32_t PageAddress);
+
+static uint8_t sbCheck(uint8_t key, uint16_t value)
+{
+	return((uint8_t)(key ^ (value >> 8) ^ value ^ 0xA5));
+}
+
+static bool sbRecordValid(uint32_t record)
+{
+	uint8_t key = SB_RECORD_KEY(record);
+	uint16_t value = SB_RECORD_VALUE(record);
+
+	// KEY 0xFF is an erased or torn (half programmed) word.
+	return((0xFF != key) && (sbCheck(key, value) == (uint8_t)record));
+}
+
+static uint32_t *sbPage(int page)
+{
+	return((uint32_t *)(SB_StoreBase() + (page * FLASH_PAGE_SIZE)));
+}
+
+static int sbActivePage(void)
+{
+	int active = SB_NO_PAGE;
+	uint16_t activeSeq = 0;
+
+	for (int page = 0; page < SB_PAGE_COUNT; page++)
+	{
+		uint32_t header = sbPage(page)[0];
+
+		if ((false == sbRecordValid(header)) || (SB_KEY_PAGE_HEADER != SB_RECORD_KEY(header)))
+		{
+			continue;
+		}
+		if ((SB_NO_PAGE == active) || (0 < (int16_t)(SB_RECORD_VALUE(header) - activeSeq)))
+		{
+			active = page;
+			activeSeq = SB_RECORD_VALUE(header);
+		}
+	}
+	return(active);
+}
+
+static bool sbLegacyRead(uint8_t key, uint16_t *valuePtr)
+{
+	uint16_t flashBlocks = *((uint16_t *)FLASHSIZE_BASE);
+	uint32_t *legacyBase = (uint32_t *)(FLASH_BASE + ((flashBlocks-1) * 1024));
+
+	switch(key)
+	{
+	case SB_KEY_NODE_ID:
+		if (SB_ERASED_WORD == legacyBase[0])
+		{
+			return(false);
+		}
+		*valuePtr = (uint16_t)(legacyBase[0] & 0x1FF);
+		return(true);
+
+	case SB_KEY_PROGRAM_VALID:
+		if (LEGACY_PROGRAM_SIGNATURE != legacyBase[1])
+		{
+			return(false);
+		}
+		*valuePtr = SB_PROGRAM_VALID_MARK;
+		return(true);
+
+	default:
+		return(false);
+	}
+}
+
+// Returns the index of the first erased word, SB_PAGE_WORDS when the page is full.
+static uint32_t sbScan(int page, uint16_t *values, uint32_t *presentMask)
+{
+	uint32_t *pagePtr = sbPage(page);
+	uint32_t i;
+
+	for (i = 1; i < SB_PAGE_WORDS; i++)
+	{
+		uint32_t record = pagePtr[i];
+
+		if (SB_ERASED_WORD == record)
+		{
+			break;
+		}
+		if ((false == sbRecordValid(record)) || (SB_KEY_LIMIT <= SB_RECORD_KEY(record)))
+		{
+			continue;
+		}
+		values[SB_RECORD_KEY(record)] = SB_RECORD_VALUE(record);
+		*presentMask |= (1UL << SB_RECORD_KEY(record));
+	}
+	return(i);
+}
+
+static bool sbProgram(uint32_t *address, uint32_t record)
+{
+	HAL_StatusTypeDef res;
+
+	HAL_FLASH_Unlock();
+	res = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, (uint32_t)address, record);
+	HAL_FLASH_Lock();
+	return(HAL_OK == res);
+}
+
+// Move the latest value of every key to the page after the active one.
+static int sbRotate(int active)
+{
+	uint16_t values[SB_KEY_LIMIT];
+	uint32_t presentMask = 0;
+	uint16_t seq = 1;
+	int next = 0;
+	uint32_t *nextPtr;
+	uint32_t slot = 1;
+
+	if (SB_NO_PAGE == active)
+	{
+		// First use -- pick up whatever the old single word layout held.
+		for (uint8_t key = 1; key < SB_KEY_LIMIT; key++)
+		{
+			if (true == sbLegacyRead(key, &values[key]))
+			{
+				presentMask |= (1UL << key);
+			}
+		}
+	}
+	else
+	{
+		sbScan(active, values, &presentMask);
+		seq = SB_RECORD_VALUE(sbPage(active)[0]) + 1;
+		next = (active + 1) % SB_PAGE_COUNT;
+	}
+
+	nextPtr = sbPage(next);
+
+	HAL_FLASH_Unlock();
+	FLASH_PageErase((uint32_t)nextPtr);
+    FLASH_WaitForLastOperation(FLASH_TIMEOUT_VALUE);
+    CLEAR_BIT (FLASH->CR, (FLASH_CR_PER));  // https://stackoverflow.com/questions/28498191/cant-write-to-flash-memory-after-erase
+	HAL_FLASH_Lock();
+
+	for (uint8_t key = 1; key < SB_KEY_LIMIT; key++)
+	{
+		if (0 == (presentMask & (1UL << key)))
+		{
+			continue;
+		}
+		if (false == sbProgram(&nextPtr[slot], SB_RECORD(key, values[key])))
+		{
+			return(SB_NO_PAGE);
+		}
+		slot++;
+	}
+
+	// Header goes in last -- until now the old page is still the live one.
+	if (false == sbProgram(&nextPtr[0], SB_RECORD(SB_KEY_PAGE_HEADER, seq)))
+	{
+		return(SB_NO_PAGE);
+	}
+	return(next);
+}
+
+uint32_t SB_StoreBase(void)
+{
+	uint16_t flashBlocks = *((uint16_t *)FLASHSIZE_BASE);
+
+	return(FLASH_BASE + (flashBlocks * 1024) - (SB_PAGE_COUNT * FLASH_PAGE_SIZE));
+}
+
+bool SB_Read(uint8_t key, uint16_t *valuePtr)
+{
+	uint16_t values[SB_KEY_LIMIT];
+	uint32_t presentMask = 0;
+	int active = sbActivePage();
+
+	if ((SB_KEY_PAGE_HEADER == key) || (SB_KEY_LIMIT <= key))
+	{
+		return(false);
+	}
+
+	if (SB_NO_PAGE == active)
+	{
+		return(sbLegacyRead(key, valuePtr));
+	}
+
+	sbScan(active, values, &presentMask);
+	if (0 == (presentMask & (1UL << key)))
+	{
+		return(false);
+	}
+	*valuePtr = values[key];
+	return(true);
+}
+
+bool SB_Write(uint8_t key, uint16_t value)
+{
+	uint16_t values[SB_KEY_LIMIT];
+	uint32_t presentMask = 0;
+	uint32_t slot;
+	int active;
+
+	if ((SB_KEY_PAGE_HEADER == key) || (SB_KEY_LIMIT <= key))
+	{
+		return(false);
+	}
+
+	active = sbActivePage();
+	if (SB_NO_PAGE == active)
+	{
+		active = sbRotate(active);
+		if (SB_NO_PAGE == active)
+		{
+			return(false);
+		}
+	}
+
+	slot = sbScan(active, values, &presentMask);
+	if ((0 != (presentMask & (1UL << key))) && (value == values[key]))
+	{
+		return(true);	// Already current -- don't burn a word on it
+	}
+
+	if (SB_PAGE_WORDS <= slot)
+	{
+		active = sbRotate(active);
+		if (SB_NO_PAGE == active)
+		{
+			return(false);
+		}
+		slot = sbScan(active, values, &presentMask);
+	}
+
+	return(sbProgram(&sbPage(active)[slot], SB_RECORD(key, value)));
+}
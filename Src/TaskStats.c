@@ -0,0 +1,143 @@
+/*
+ * TaskStats.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "TaskStats.h"
+#include "UARTHandler.h"
+#include "MemPool.h"
+
+#include <stdio.h>
+
+typedef struct _TS_BASELINE
+{
+	UBaseType_t	taskNumber;		// 0 = unused
+	uint32_t	runTime;
+} TS_BASELINE;
+
+static TaskStatus_t	tsStatus[TS_MAX_TASKS];
+static TS_BASELINE	tsBaseline[TS_MAX_TASKS];
+
+// Kernel hook (portCONFIGURE_TIMER_FOR_RUN_TIME_STATS), before the scheduler
+// starts.  TR_Init() gets there first: leave the count running.
+void TS_ClockStart(void)
+{
+	uint32_t timerClock = HAL_RCC_GetPCLK1Freq();
+
+	if (0 != (TIM2->CR1 & TIM_CR1_CEN))
+	{
+		return;
+	}
+
+	// APB1 timers run at twice PCLK1 whenever APB1 is divided down
+	if (RCC_CFGR_PPRE1_DIV1 != (RCC->CFGR & RCC_CFGR_PPRE1))
+	{
+		timerClock *= 2;
+	}
+
+	__HAL_RCC_TIM2_CLK_ENABLE();
+	TIM2->CR1 = 0;
+	TIM2->PSC = (timerClock / TS_CLOCK_HZ) - 1;
+	TIM2->ARR = 0xFFFFFFFF;
+	TIM2->CNT = 0;
+	TIM2->EGR = TIM_EGR_UG;		// load PSC now, not at the first wrap
+	TIM2->CR1 = TIM_CR1_CEN;
+}
+
+// Kernel hook (portGET_RUN_TIME_COUNTER_VALUE)
+uint32_t TS_Clock(void)
+{
+	return(TIM2->CNT);
+}
+
+static uint32_t *tsLastRunTime(UBaseType_t taskNumber)
+{
+	TS_BASELINE *freePtr = NULL;
+
+	for (int i = 0; i < TS_MAX_TASKS; i++)
+	{
+		if (taskNumber == tsBaseline[i].taskNumber)
+		{
+			return(&tsBaseline[i].runTime);
+		}
+		if ((NULL == freePtr) && (0 == tsBaseline[i].taskNumber))
+		{
+			freePtr = &tsBaseline[i];
+		}
+	}
+
+	if (NULL == freePtr)
+	{
+		return(NULL);
+	}
+	freePtr->taskNumber = taskNumber;
+	freePtr->runTime = 0;		// new task -- its whole life so far
+	return(&freePtr->runTime);
+}
+
+// CPU figures only when sampling -- a plain list leaves the baselines alone
+static int tsCollect(TS_TASK *tasksPtr, int maxTasks, bool sample)
+{
+	uint32_t deltas[TS_MAX_TASKS];
+	uint32_t total = 0;
+	int count;
+
+	vTaskSuspendAll();		// one consistent set of counters and baselines
+	count = (int)uxTaskGetSystemState(tsStatus, TS_MAX_TASKS, NULL);
+	for (int i = 0; i < count; i++)
+	{
+		uint32_t *lastPtr = (true == sample) ? tsLastRunTime(tsStatus[i].xTaskNumber) : NULL;
+
+		deltas[i] = (NULL == lastPtr) ? 0 : (tsStatus[i].ulRunTimeCounter - *lastPtr);
+		if (NULL != lastPtr)
+		{
+			*lastPtr = tsStatus[i].ulRunTimeCounter;
+		}
+		total += deltas[i];
+	}
+	xTaskResumeAll();
+
+	if (count > maxTasks)
+	{
+		count = maxTasks;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		tasksPtr[i].namePtr = tsStatus[i].pcTaskName;
+		tasksPtr[i].number = (uint8_t)tsStatus[i].xTaskNumber;
+		tasksPtr[i].priority = (uint8_t)tsStatus[i].uxCurrentPriority;
+		tasksPtr[i].cpuTenths = (0 == total) ? 0 : (uint16_t)(((uint64_t)deltas[i] * 1000) / total);
+		tasksPtr[i].stackFree = tsStatus[i].usStackHighWaterMark;
+	}
+	return(count);
+}
+
+int TS_Sample(TS_TASK *tasksPtr, int maxTasks)
+{
+	return(tsCollect(tasksPtr, maxTasks, true));
+}
+
+int TS_List(TS_TASK *tasksPtr, int maxTasks)
+{
+	return(tsCollect(tasksPtr, maxTasks, false));
+}
+
+void TS_Report(void)
+{
+	TS_TASK tasks[TS_MAX_TASKS];
+	char reportBuffer[48];
+	int count = TS_Sample(tasks, TS_MAX_TASKS);
+
+	WriteUARTString("TASK             PRI   CPU%  STACK\n");
+	for (int i = 0; i < count; i++)
+	{
+		sprintf(reportBuffer, "%-16s %3u %4u.%u  %5u\n", tasks[i].namePtr, tasks[i].priority,
+				tasks[i].cpuTenths / 10, tasks[i].cpuTenths % 10, tasks[i].stackFree);
+		WriteUARTString(reportBuffer);
+	}
+
+	// No heap any more -- the pools are all the dynamic memory there is
+	MP_Report();
+}
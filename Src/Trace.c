@@ -0,0 +1,180 @@
+/*
+ * Trace.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "Trace.h"
+#include "HostLink.h"
+#include "TaskStats.h"
+#include "UARTHandler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TR_EVENTS_PER_FRAME		((HL_MAX_PAYLOAD - 1) / sizeof(TR_EVENT))
+
+// Never initialized by the startup code -- TR_Init() resets the indexes.
+static TR_EVENT				trRing[TR_EVENTS] CCM_NOINIT;
+static volatile uint16_t	trHead = 0;			// next slot to write
+static volatile uint16_t	trCount = 0;		// events held, up to TR_EVENTS
+static volatile uint32_t	trLost = 0;			// recorded over, or missed while paused
+static volatile bool		trRecording = false;
+static volatile bool		trPaused = false;	// dump in progress
+static uint8_t				trSeq = 0;
+
+static uint8_t *putLE32(uint8_t *ptr, uint32_t value)
+{
+	*ptr++ = (uint8_t)value;
+	*ptr++ = (uint8_t)(value >> 8);
+	*ptr++ = (uint8_t)(value >> 16);
+	*ptr++ = (uint8_t)(value >> 24);
+	return(ptr);
+}
+
+// Before the scheduler starts -- and so before the kernel starts the clock
+void TR_Init(void)
+{
+	TS_ClockStart();
+
+	TR_Clear();
+	trRecording = true;
+}
+
+// Kernel hooks, ISRs and tasks -- anywhere at or below the syscall priority
+CCM_FUNC void TR_Event(uint8_t type, uint8_t arg, uint16_t extra)
+{
+	UBaseType_t mask;
+	TR_EVENT *eventPtr;
+
+	if (false == trRecording)
+	{
+		return;
+	}
+
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	if (true == trPaused)
+	{
+		trLost++;
+		portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+		return;
+	}
+
+	eventPtr = &trRing[trHead];
+	eventPtr->stamp = TS_Clock();
+	eventPtr->type = type;
+	eventPtr->arg = arg;
+	eventPtr->extra = extra;
+
+	trHead = (trHead + 1) % TR_EVENTS;
+	if (TR_EVENTS > trCount)
+	{
+		trCount++;
+	}
+	else
+	{
+		trLost++;		// the oldest one just went
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+void TR_SetRecording(bool on)
+{
+	trRecording = on;
+}
+
+bool TR_Recording(void)
+{
+	return(trRecording);
+}
+
+void TR_Clear(void)
+{
+	UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+
+	trHead = 0;
+	trCount = 0;
+	trLost = 0;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+void TR_Report(void)
+{
+	char reportBuffer[48];
+
+	sprintf(reportBuffer, "TRACE %s %u/%u LOST %lu\n", (true == trRecording) ? "ON" : "OFF",
+			trCount, TR_EVENTS, trLost);
+	WriteUARTString(reportBuffer);
+}
+
+static bool trSend(const uint8_t *payloadPtr, uint16_t length)
+{
+	return(HL_Send(HL_MSG_TRACE, trSeq++, payloadPtr, length, true));
+}
+
+// Host link only -- the events are binary.  The ring starts over afterwards.
+bool TR_Dump(void)
+{
+	uint8_t payload[HL_MAX_PAYLOAD];
+	uint8_t *ptr = payload;
+	TS_TASK tasks[TS_MAX_TASKS];
+	UBaseType_t mask;
+	uint16_t index;
+	uint16_t count;
+	uint32_t lost;
+	int taskCount;
+
+	if (false == HL_Active())
+	{
+		return(false);
+	}
+
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	trPaused = true;
+	count = trCount;
+	lost = trLost;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+	index = (trHead + TR_EVENTS - count) % TR_EVENTS;
+
+	*ptr++ = TR_DUMP_BEGIN;
+	ptr = putLE32(ptr, TS_CLOCK_HZ);
+	ptr = putLE32(ptr, count);
+	ptr = putLE32(ptr, lost);
+	trSend(payload, ptr - payload);
+
+	taskCount = TS_List(tasks, TS_MAX_TASKS);
+	for (int i = 0; i < taskCount; i++)
+	{
+		size_t nameLength = strlen(tasks[i].namePtr);
+
+		payload[0] = TR_DUMP_TASK;
+		payload[1] = tasks[i].number;
+		memcpy(&payload[2], tasks[i].namePtr, nameLength);
+		trSend(payload, 2 + nameLength);
+	}
+
+	while (0 != count)
+	{
+		ptr = payload;
+		*ptr++ = TR_DUMP_EVENTS;
+		for (int i = 0; (0 != count) && (i < TR_EVENTS_PER_FRAME); i++, count--)
+		{
+			memcpy(ptr, &trRing[index], sizeof(TR_EVENT));
+			ptr += sizeof(TR_EVENT);
+			index = (index + 1) % TR_EVENTS;
+		}
+		trSend(payload, ptr - payload);
+	}
+
+	payload[0] = TR_DUMP_END;
+	trSend(payload, 1);
+
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	trHead = 0;
+	trCount = 0;
+	trLost -= lost;		// what is left was missed during the dump
+	trPaused = false;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+	return(true);
+}
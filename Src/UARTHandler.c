@@ -14,268 +14,582 @@
 
 #include <stdbool.h>
 #include <string.h>
-#include <ctype.h>
 
 #include "CharQueue.h"
 #include "UARTHandler.h"
 #include "CANHandler.h"
+#include "FrameLog.h"
+#include "HostLink.h"
+#include "CANMonitor.h"
+#include "CLIParse.h"
+#include "Jobs.h"
+#include "MemPool.h"
+#include "TaskStats.h"
+#include "Trace.h"
+#include "CANBitrate.h"
+#include "CANBusState.h"
+#include "Crash.h"
+#include "Watchdog.h"
 
-extern osTimerId FileTransferHandle;
 extern osSemaphoreId UARTContrlHandle;
+extern osThreadId UARTReceiveTaskHandle;
 
 bool 			trafficOnUART = false;
-uint8_t			char2q = 0;
-bool 			UART_Raw = false;
 
-#define MY_BUFFER_LENGTH 256
+// Sized for the fastest negotiated rate (4.5 Mbaud = 450 bytes/ms): a DMA half
+// is ~1ms of traffic, the queue ~4ms of UART task latency.
+#define MY_BUFFER_LENGTH 2048
+#define UART_RX_DMA_LENGTH 1024		// HT/TC every 512 bytes, IDLE flushes anything shorter
+#define UART_BAUD_ACK_MS	2000		// host must answer at the new rate within this
+#define UART_LINE_LENGTH	128			// longer command lines are cut short
+
+// Receive flow control hysteresis on the consumer queue: stop the host at 3/4
+// full, let it go again once the queue is down to 1/4.
+#define UART_RX_HIGH_WATER	((MY_BUFFER_LENGTH * 3) / 4)
+#define UART_RX_LOW_WATER	(MY_BUFFER_LENGTH / 4)
+#define UART_XON			0x11
+#define UART_XOFF			0x13
+#define UART_TX_RING_LENGTH 1024		// ~90ms of output at 115200
+#define UART_MACRO_SLOTS	4
+#define UART_MACRO_NAME		12
+#define UART_RANGE_LIMIT	512			// a range sweeps at most the 9-bit node ID space
+#define UART_SIGNAL_RX		0x0001
+
+static uint8_t	uartRxDmaBuffer[UART_RX_DMA_LENGTH];
+static uint16_t	uartRxTail = 0;		// first byte the DMA wrote that has not been delivered
+static uint32_t	uartBaud = USART2_DEFAULT_BAUD;
+
+// Output ring.  Tasks append at the head, the DMA drains from the tail one
+// contiguous span at a time.  Indexes only move with interrupts masked (or
+// from the TC interrupt itself), so head/tail/busy are always consistent.
+static uint8_t				uartTxRing[UART_TX_RING_LENGTH];
+static volatile uint16_t	uartTxHead = 0;
+static volatile uint16_t	uartTxTail = 0;
+static volatile uint16_t	uartTxSpan = 0;		// bytes in flight; 0 == DMA idle
+static volatile uint32_t	uartTxDropped = 0;
+static volatile bool		uartTxStalled = false;	// the DMA refused a span; the UART task retries
+
+static volatile UART_FLOW_MODE	uartFlow = UART_FLOW_XONXOFF;
+static volatile bool			uartRxStopped = false;
+
+static void uartTxDrain(void);
 
 static bool		startSync = false;
 
-bool				txCplt = false;
 QUEUE_MGT_STRUCT qStruct;
-bool				timerFlag_loadTimer = false;
+static char		uartLine[UART_LINE_LENGTH];	// the command line being worked on
+static bool		uartLineCut = false;		// ... and it was longer than that
+
+// Stored command lines for RUN.  RAM only -- gone after a reset.
+typedef struct _UART_MACRO
+{
+	char	name[UART_MACRO_NAME];		// "" = free slot
+	char	body[UART_LINE_LENGTH];
+} UART_MACRO;
+
+static UART_MACRO	uartMacros[UART_MACRO_SLOTS];
+static int			uartMacroDepth = 0;		// RUN inside a macro is refused
 
 typedef struct _COMMAND_TABLE_ENTRY
 {
 	const char *commandString;
-	void (*functionPtr)(char *ptr);
+	void (*functionPtr)(int argc, char *argv[]);
+	uint8_t rangeRadix;					// how a "first..last" argument is written
 	const char *argDescriptionStr;
 } COMMAND_TABLE_ENTRY;
 
-void dummy(char *ptr){}
-void printHelp(char *);
-void myID(char *);
-void getAddresses(char *);
-void assignAddress(char *);
-void flashLED(char *);
-void flashLED(char *);
-void stateLED(char *);
-void stateLED(char *);
-void eraseSysBlock(char *);
-void eraseProg(char *);
-void loadProg(char *);
-void resetNode(char *);
-void getVersion(char *);
-
-COMMAND_TABLE_ENTRY commandTable[] =
-{
-		{"?",			printHelp,		"\n"},
-		{"HELP",			printHelp,		"\n"},
-		{"MYADR",		myID,			"\n"},
-		{"GETADRS",		getAddresses,	"\n"},
-		{"ASSIGN",		assignAddress,	"\n"},
-		{"FLASH",		flashLED,		" <ID>\n"},
-		{"FLASH_OFF",	flashLED,		" <ID>\n"},
-		{"ON",			stateLED,		" <ID>\n"},
-		{"OFF",			stateLED,		" <ID>\n"},
-		{"SYS_ERA",		eraseSysBlock,	"\n"},
-		{"PROG_ERA",		eraseProg,		" <ID>\n"},
-		{"LOAD",			loadProg,		" <ID> <loadBaseAddr>\n"},
-		{"RESET",		resetNode,		" <ID>\n"},
-		{"VER",			getVersion,		" <ID>\n"},
-		{NULL,			dummy,			NULL}
+void printHelp(int, char *[]);
+void myID(int, char *[]);
+void getAddresses(int, char *[]);
+void assignAddress(int, char *[]);
+void flashLED(int, char *[]);
+void stateLED(int, char *[]);
+void eraseSysBlock(int, char *[]);
+void eraseProg(int, char *[]);
+void loadProg(int, char *[]);
+void resetNode(int, char *[]);
+void getVersion(int, char *[]);
+void logFormat(int, char *[]);
+void hostLink(int, char *[]);
+void monitor(int, char *[]);
+void setBaud(int, char *[]);
+void flowControl(int, char *[]);
+void jobStatus(int, char *[]);
+void jobCancel(int, char *[]);
+void defineMacro(int, char *[]);
+void runMacro(int, char *[]);
+void listMacros(int, char *[]);
+void poolStatus(int, char *[]);
+void topReport(int, char *[]);
+void traceControl(int, char *[]);
+void bitrate(int, char *[]);
+void canErrors(int, char *[]);
+void crashReport(int, char *[]);
+
+// HELP lists the commands in this order.  Adding one means re-running
+// Tools/CliHash/clihash.c with the names in this order and pasting its output
+// into CLI_HASH_SEED and commandIndex[].
+const COMMAND_TABLE_ENTRY commandTable[] =
+{
+		{"?",			printHelp,		10,	"\n"},
+		{"HELP",			printHelp,		10,	"\n"},
+		{"MYADR",		myID,			10,	"\n"},
+		{"GETADRS",		getAddresses,	10,	"\n"},
+		{"ASSIGN",		assignAddress,	16,	"\n"},
+		{"FLASH",		flashLED,		10,	" <ID>\n"},
+		{"FLASH_OFF",	flashLED,		10,	" <ID>\n"},
+		{"ON",			stateLED,		10,	" <ID>\n"},
+		{"OFF",			stateLED,		10,	" <ID>\n"},
+		{"SYS_ERA",		eraseSysBlock,	10,	"\n"},
+		{"PROG_ERA",		eraseProg,		10,	" <ID>\n"},
+		{"LOAD",			loadProg,		10,	" <ID> <loadBaseAddr>, then :<hex> lines, : alone ends\n"},
+		{"RESET",		resetNode,		10,	" <ID>\n"},
+		{"VER",			getVersion,		10,	" <ID>\n"},
+		{"LOGFMT",		logFormat,		10,	" <TEXT|BIN>\n"},
+		{"HOSTLINK",	hostLink,		10,	"\n"},
+		{"MONITOR",		monitor,		10,	" <ON [DELTA]|OFF>\n"},
+		{"BAUD",		setBaud,		10,	" <rate>\n"},
+		{"FLOW",		flowControl,	10,	" <NONE|XON|RTS>\n"},
+		{"JOBS",		jobStatus,		10,	" [jobID]\n"},
+		{"CANCEL",		jobCancel,		10,	" <jobID>\n"},
+		{"DEF",			defineMacro,	10,	" <name> [cmd; cmd; ...]\n"},
+		{"RUN",			runMacro,		10,	" <name>\n"},
+		{"MACROS",		listMacros,		10,	"\n"},
+		{"POOL",		poolStatus,		10,	"\n"},
+		{"TOP",			topReport,		10,	" [ID]\n"},
+		{"TRACE",		traceControl,	10,	" [ON|OFF|CLEAR|DUMP]\n"},
+		{"BITRATE",		bitrate,		10,	" [<kbit/s> [<sample permille>]|COMMIT|AUTO ON|OFF [ID]]\n"},
+		{"CANERR",		canErrors,		10,	" [ID|BACKOFF <min ms> <max ms> [ID]]\n"},
+		{"CRASH",		crashReport,	10,	" [<ID> [n]|CLEAR]\n"},
+		{NULL,			NULL,			0,	NULL}
 };
 
-
-void cbFileTransfer(void const * argument)
+// CLI_Hash(command) -> 1 + position in commandTable[], 0 = no command
+static const uint8_t commandIndex[CLI_HASH_SLOTS] =
 {
-	timerFlag_loadTimer = true;
-}
+	[0] = 4,		// GETADRS
+	[1] = 30,		// CRASH
+	[2] = 21,		// CANCEL
+	[4] = 19,		// FLOW
+	[9] = 24,		// MACROS
+	[11] = 25,		// POOL
+	[16] = 11,		// PROG_ERA
+	[17] = 9,		// OFF
+	[19] = 1,		// ?
+	[22] = 18,		// BAUD
+	[23] = 27,		// TRACE
+	[25] = 22,		// DEF
+	[29] = 7,		// FLASH_OFF
+	[30] = 2,		// HELP
+	[31] = 17,		// MONITOR
+	[32] = 26,		// TOP
+	[34] = 28,		// BITRATE
+	[36] = 10,		// SYS_ERA
+	[37] = 14,		// VER
+	[39] = 6,		// FLASH
+	[41] = 29,		// CANERR
+	[43] = 8,		// ON
+	[45] = 3,		// MYADR
+	[50] = 5,		// ASSIGN
+	[51] = 13,		// RESET
+	[52] = 20,		// JOBS
+	[53] = 23,		// RUN
+	[55] = 16,		// HOSTLINK
+	[58] = 15,		// LOGFMT
+	[62] = 12,		// LOAD
+};
 
 bool StartSync(void)
 {
 	return(startSync);
 }
 
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *UartHandle)
+// Start the next contiguous span if the DMA is idle.  Interrupts masked.
+static void uartTxKick(void)
 {
-	txCplt = true;
+	uint16_t head = uartTxHead;
+	uint16_t tail = uartTxTail;
+
+	if ((0 != uartTxSpan) || (head == tail))
+	{
+		return;
+	}
+
+	uartTxSpan = (head > tail) ? (head - tail) : (UART_TX_RING_LENGTH - tail);
+	uartTxStalled = (HAL_OK != HAL_UART_Transmit_DMA(&huart2, &uartTxRing[tail], uartTxSpan));
+	if (true == uartTxStalled)
+	{
+		uartTxSpan = 0;		// Try again on the next append, TX error or UART task wake
+	}
 }
 
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *UartHandle)
+// Task side
+static void uartTxRetry(void)
 {
+	if (true == uartTxStalled)
+	{
+		taskENTER_CRITICAL();
+		uartTxKick();
+		taskEXIT_CRITICAL();
+	}
+}
+
+// Copy a whole message into the ring, or nothing at all.  Interrupts masked.
+static bool uartTxAppend(const uint8_t *dataPtr, uint16_t length)
+{
+	uint16_t head = uartTxHead;
+	uint16_t space = (uartTxTail + UART_TX_RING_LENGTH - head - 1) % UART_TX_RING_LENGTH;
+	uint16_t first;
 
-	if (UART_Raw)
+	if (length > space)
 	{
-		CQ_EnqueueChar(&qStruct, char2q);
-		HAL_UART_Receive_IT(UartHandle, &char2q, 1);
-		if (true == CQ_AboveWaterMark(&qStruct))
-		{
-			UartHandle->Instance->TDR = 0x13; // XOFF
-		}
+		return(false);
+	}
+
+	first = UART_TX_RING_LENGTH - head;
+	if (first > length)
+	{
+		first = length;
+	}
+	memcpy(&uartTxRing[head], dataPtr, first);
+	memcpy(&uartTxRing[0], dataPtr + first, length - first);
+	uartTxHead = (head + length) % UART_TX_RING_LENGTH;
+
+	uartTxKick();
+	return(true);
+}
+
+// One flow control character, from a task or an ISR.  It queues behind
+// whatever output is pending -- never written into TDR under a running DMA.
+static void uartTxControl(uint8_t ch)
+{
+	UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+
+	if (false == uartTxAppend(&ch, 1))
+	{
+		uartTxDropped++;
+	}
+	taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+static void uartFlowSignal(bool stop)
+{
+	switch (uartFlow)
+	{
+	case UART_FLOW_XONXOFF:
+		uartTxControl(stop ? UART_XOFF : UART_XON);
+		break;
+	case UART_FLOW_RTSCTS:
+		MX_USART2_SetRTS(stop);
+		break;
+	default:
+		break;
+	}
+}
+
+// RX interrupt, after new bytes went into the queue
+static void uartFlowStop(void)
+{
+	if ((false == uartRxStopped) && (UART_RX_HIGH_WATER <= qStruct.char_count))
+	{
+		uartRxStopped = true;
+		uartFlowSignal(true);
+	}
+}
+
+// Task side, after taking bytes out of the queue
+static void uartFlowCheck(void)
+{
+	if (false == uartRxStopped)
+	{
+		return;
+	}
+
+	taskENTER_CRITICAL();
+	if ((true == uartRxStopped) && (UART_RX_LOW_WATER >= qStruct.char_count))
+	{
+		uartRxStopped = false;
+		uartFlowSignal(false);
+	}
+	taskEXIT_CRITICAL();
+}
+
+void UART_SetFlowControl(UART_FLOW_MODE mode)
+{
+	uartTxDrain();
+	if (HAL_OK != MX_USART2_SetFlowControl(UART_FLOW_RTSCTS == mode))
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+	uartFlow = mode;
+	uartRxStopped = false;
+	RearmUART();
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *UartHandle)
+{
+	uartTxTail = (uartTxTail + uartTxSpan) % UART_TX_RING_LENGTH;
+	uartTxSpan = 0;
+	uartTxKick();
+}
+
+// Hand a span of freshly DMA'd bytes to the consumer queue
+CCM_FUNC static void deliverRxSpan(uint8_t *spanPtr, uint16_t length)
+{
+	if (true == HL_Active())
+	{
+		CQ_EnqueueBlock(&qStruct, spanPtr, length);
+		uartFlowStop();
+		return;
 	}
-	else
+
+	for (; 0 != length; length--, spanPtr++)
 	{
-		if ('\0' == char2q)
+		if ('\0' == *spanPtr)
 		{
-			HAL_UART_Receive_IT(UartHandle, &char2q, 1);
-			return;
+			continue;
 		}
+		trafficOnUART = true;
+		CQ_EnqueueChar(&qStruct, *spanPtr);
+	}
+	uartFlowStop();		// a LOAD image comes in as command lines too
+}
 
+// Called from the DMA half/full transfer and the USART IDLE interrupts, all at
+// the same NVIC priority so they never race each other over uartRxTail.
+CCM_FUNC static void drainRxDma(void)
+{
+	uint16_t head = UART_RX_DMA_LENGTH - __HAL_DMA_GET_COUNTER(huart2.hdmarx);
 
-		trafficOnUART = true;
+	if (UART_RX_DMA_LENGTH <= head)
+	{
+		head = 0;
+	}
 
-		CQ_EnqueueChar(&qStruct, char2q);
+	if (head > uartRxTail)
+	{
+		deliverRxSpan(&uartRxDmaBuffer[uartRxTail], head - uartRxTail);
+	}
+	else if (head < uartRxTail)
+	{
+		deliverRxSpan(&uartRxDmaBuffer[uartRxTail], UART_RX_DMA_LENGTH - uartRxTail);
+		deliverRxSpan(&uartRxDmaBuffer[0], head);
+	}
 
-		if (1 == qStruct.term_count)
+	if (head != uartRxTail)
+	{
+		TR_Event(TR_EV_UART_RX, 0, (head + UART_RX_DMA_LENGTH - uartRxTail) % UART_RX_DMA_LENGTH);
+		if (NULL != UARTReceiveTaskHandle)
 		{
-			return;
+			osSignalSet(UARTReceiveTaskHandle, UART_SIGNAL_RX);
 		}
 	}
+	uartRxTail = head;
+}
+
+// Sleep until the receive interrupt hands over more bytes, or millisec passes.
+// Every caller loops on its condition, so waking early to check in is fine.
+// Output the DMA refused is retried every tick until it goes.
+static void uartWaitRx(uint32_t millisec)
+{
+	WD_CheckIn();
+	uartTxRetry();
+	osSignalWait(UART_SIGNAL_RX, WD_Wait((true == uartTxStalled) ? 1 : millisec));
+}
 
-	HAL_UART_Receive_IT(UartHandle, &char2q, 1);
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *UartHandle)
+{
+	drainRxDma();
 }
 
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *UartHandle)
+{
+	drainRxDma();
+}
 
+void UART_RxIdleCallback(void)
+{
+	drainRxDma();
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *UartHandle)
+{
+	// Any receive error in DMA mode aborts the transfer -- keep what made it
+	// in and start over.
+	if (HAL_UART_STATE_READY == UartHandle->RxState)
+	{
+		drainRxDma();
+		RearmUART();
+	}
+	// A transmit error aborts the span in flight -- send it again
+	if ((HAL_UART_STATE_READY == UartHandle->gState) && (0 != uartTxSpan))
+	{
+		uartTxSpan = 0;
+		uartTxKick();
+	}
+}
 
 void RearmUART(void)
 {
-	  HAL_UART_Abort_IT(&huart2);
+	uartRxTail = 0;
+	if (HAL_UART_Receive_DMA(&huart2, uartRxDmaBuffer, UART_RX_DMA_LENGTH) != HAL_OK)
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+	__HAL_UART_CLEAR_IDLEFLAG(&huart2);
+	__HAL_UART_ENABLE_IT(&huart2, UART_IT_IDLE);
 }
 
 
+// Queue output and return.  Only waits when the ring can't take the message;
+// the semaphore keeps one writer's long message from being interleaved with
+// another's while it waits.
+void UART_Write(const uint8_t *dataPtr, uint16_t length)
+{
+	osSemaphoreWait(UARTContrlHandle, osWaitForever);
+	while (0 != length)
+	{
+		uint16_t chunk = (length < UART_TX_RING_LENGTH) ? length : (UART_TX_RING_LENGTH - 1);
+		bool queued;
+
+		taskENTER_CRITICAL();
+		queued = uartTxAppend(dataPtr, chunk);
+		taskEXIT_CRITICAL();
+
+		if (false == queued)
+		{
+			osDelay(1);
+			continue;
+		}
+		dataPtr += chunk;
+		length -= chunk;
+	}
+	osSemaphoreRelease(UARTContrlHandle);
+}
+
 void WriteUARTString(char *strPtr)
 {
-	osSemaphoreWait(UARTContrlHandle, 0);
-	while (HAL_UART_STATE_BUSY_TX == (HAL_UART_GetState(&huart2) & HAL_UART_STATE_BUSY_TX))
+	if (true == HL_Active())
 	{
-		taskYIELD();
+		HL_SendText(strPtr, true);
+		return;
 	}
+	UART_Write((const uint8_t *)strPtr, strlen(strPtr));
+}
 
-	txCplt = false;
+// Never waits -- for the CAN side.  A message that doesn't fit, or that would
+// land in the middle of a UART_Write() holder's, is dropped whole and counted.
+bool UART_TryWrite(const uint8_t *dataPtr, uint16_t length)
+{
+	bool queued = false;
 
-	if (HAL_UART_Transmit_IT(&huart2, (uint8_t *)strPtr, strlen((const char *)strPtr)) != HAL_OK)
+	if (osOK == osSemaphoreWait(UARTContrlHandle, 0))
 	{
-	  _Error_Handler(__FILE__, __LINE__);
+		taskENTER_CRITICAL();
+		queued = uartTxAppend(dataPtr, length);
+		taskEXIT_CRITICAL();
+		osSemaphoreRelease(UARTContrlHandle);
 	}
 
+	if (false == queued)
+	{
+		uartTxDropped++;
+	}
+	return(queued);
+}
 
-	while (false == txCplt)
+// Wait for everything queued so far to leave the shift register.
+static void uartTxDrain(void)
+{
+	while ((uartTxHead != uartTxTail) || (0 != uartTxSpan))
 	{
-	  taskYIELD();
+		osDelay(1);
+	}
+	while (RESET == __HAL_UART_GET_FLAG(&huart2, UART_FLAG_TC))
+	{
+		taskYIELD();
 	}
-	osSemaphoreRelease(UARTContrlHandle);
 }
 
-char GetUARTChar(void)
+bool UART_TryWriteString(const char *strPtr)
 {
-	int loopCount = 0;
+	if (true == HL_Active())
+	{
+		return(HL_SendText(strPtr, false));
+	}
+	return(UART_TryWrite((const uint8_t *)strPtr, strlen(strPtr)));
+}
 
-	  if (HAL_UART_Receive_IT(&huart2, (uint8_t *)&char2q, 1) != HAL_OK)
-	  {
-		  _Error_Handler(__FILE__, __LINE__);
-	  }
+uint32_t UART_TxDropped(void)
+{
+	return(uartTxDropped);
+}
+
+char GetUARTChar(void)
+{
+	uint8_t ch = '\0';
 
-	  while ((0 == qStruct.char_count) && (10 > loopCount) && ('\0' == char2q))
+	  // Reception never stops -- sleep until a host says something.
+	  while (0 == qStruct.char_count)
 	  {
-		  osDelay(100);
-		  loopCount++;
+		  uartWaitRx(osWaitForever);
 	  }
 
-	  HAL_UART_AbortReceive(&huart2);
-	  CQ_Flush(&qStruct);
-
-	  return(char2q);
+	  CQ_Peek(&qStruct, &ch);
+	  return((char)ch);
 }
 
 char *GetUARTString(void)
 {
-	int characterCount;
-	char *strPtr = NULL;
-
-	  if (HAL_UART_Receive_IT(&huart2, (uint8_t *)&char2q, 1) != HAL_OK)
-	  {
-		  _Error_Handler(__FILE__, __LINE__);
-	  }
+	int i = 0;
+	uint8_t ch;
 
 	  while (0 == qStruct.term_count)
 	  {
-		  taskYIELD();
+		  uartWaitRx(osWaitForever);
 	  }
 
-	  characterCount = qStruct.char_count - 1;
-	  if (0 != characterCount)
+	  // Take exactly one line -- anything typed after it stays queued.
+	  uartLineCut = false;
+	  while (true == CQ_DequeueChar(&qStruct, &ch))
 	  {
-		  strPtr = pvPortMalloc(characterCount + 1);
-
-		  for(int i = 0; 0 != characterCount; characterCount--, i++)
+		  if (IS_TERMINATOR(ch))
+		  {
+			  break;
+		  }
+		  if (i < (UART_LINE_LENGTH - 1))
+		  {
+			  uartLine[i++] = (char)ch;
+		  }
+		  else
 		  {
-			  CQ_DequeueChar(&qStruct,(uint8_t *)&(strPtr[i]));
-			  strPtr[i+1] = '\0';
+			  uartLineCut = true;
 		  }
 	  }
+	  uartLine[i] = '\0';
 
-	  CQ_Flush(&qStruct);
-	  return(strPtr);
+	  return((0 == i) ? NULL : uartLine);
 }
 
-
 void UART_ReportReceivedMessage(uint16_t source, uint16_t destination, uint16_t command, uint8_t *rxData)
 {
-	char *ptr;
-
-	ptr = (char *)pvPortMalloc(128);
-	sprintf(ptr, "0x%04X 0x%04X 0x%04X 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x 0x%02x\n",
-			source,
-			destination,
-			command,
-			rxData[0],
-			rxData[1],
-			rxData[2],
-			rxData[3],
-			rxData[4],
-			rxData[5],
-			rxData[6],
-			rxData[7]);
-	WriteUARTString(ptr);
-	vPortFree(ptr);
+	// Formatting and output happen later in the FrameLog task
+	FL_Record(source, destination, command, rxData);
 }
 
-bool getArgument(char *stringPtr, int argNum, char *argPtr, int argBufSize)
+// Fetch argv[index] as a number -- false if it is missing or not a number
+static bool numericArgument(int argc, char *argv[], int index, uint8_t radix, uint32_t *valuePtr)
 {
-	int charCount = 0;
-
-	argBufSize--;	// make room for null terminator
-	for (int i = 0; i < argNum; i++)
+	if (index >= argc)
 	{
-		while(' ' != *stringPtr)
-		{
-			stringPtr++;
-			if ('\0' == *stringPtr)
-			{
-				return(false);
-			}
-		}
-
-		while(' ' == *stringPtr)	// isspace() didn't work here!
-		{
-			stringPtr++;
-			if ('\0' == *stringPtr)
-			{
-				return(false);
-			}
-		}
-	}
-
-	while((false == isspace(*stringPtr)) && ('\0' != *stringPtr))
-	{
-		*argPtr = *stringPtr;
-		argPtr++;
-		*argPtr = '\0';
-
-		stringPtr++;
-		charCount++;
-		if (charCount >= argBufSize)
-		{
-			return(false);
-		}
+		return(false);
 	}
-	return(true);
+	return(CLI_ParseUnsigned(argv[index], radix, valuePtr));
 }
 
-void printHelp(char *ptr)
+void printHelp(int argc, char *argv[])
 {
-	COMMAND_TABLE_ENTRY *cmdPtr = &commandTable[0];
+	const COMMAND_TABLE_ENTRY *cmdPtr = &commandTable[0];
 
 	while (NULL != cmdPtr->argDescriptionStr)
 	{
@@ -285,219 +599,701 @@ void printHelp(char *ptr)
 	}
 }
 
-void myID(char *ptr)
+void myID(int argc, char *argv[])
 {
-	char *reportBuffer;
-	reportBuffer = (char *)pvPortMalloc(64);
+	char reportBuffer[32];
+
 	sprintf(reportBuffer, "My ID is: %08lX\n", CAN_MyID());
 	WriteUARTString(reportBuffer);
-	vPortFree(reportBuffer);
 }
 
-void getAddresses(char *ptr)
+void getAddresses(int argc, char *argv[])
 {
 	CAN_GetAddresses();
 }
 
-void assignAddress(char *ptr)
+void assignAddress(int argc, char *argv[])
 {
-	uint32_t addr = 0;
-	char argBuffer[10];
+	uint32_t addr;
 
-	if (false == getArgument(ptr, 1, argBuffer, 10))
+	if (false == numericArgument(argc, argv, 1, 16, &addr))
 	{
 		return;
 	}
-	sscanf(argBuffer, "%lX", &addr);
 	CAN_AssignAddress(addr);
 }
 
-void flashLED(char *ptr)
+void flashLED(int argc, char *argv[])
 {
-	int channel;
-	bool state = true;
-	char argBuffer[10];
+	uint32_t channel;
 
-	state = (NULL == strstr(ptr, "OFF"));
-	if (false == getArgument(ptr, 1, argBuffer, 10))
+	if (false == numericArgument(argc, argv, 1, 10, &channel))
 	{
 		return;
 	}
-	sscanf(argBuffer, "%d", &channel);
-
-	CAN_LEDFlashControl(channel, state);
+	CAN_LEDFlashControl(channel, (0 != strcmp(argv[0], "FLASH_OFF")));
 }
 
-void stateLED(char *ptr)
+void stateLED(int argc, char *argv[])
 {
-	int channel;
-	bool state = true;
-	char argBuffer[10];
+	uint32_t channel;
 
-	state = (NULL == strstr(ptr, "OFF"));
-	if (false == getArgument(ptr, 1, argBuffer, 10))
+	if (false == numericArgument(argc, argv, 1, 10, &channel))
 	{
 		return;
 	}
-	sscanf(argBuffer, "%d", &channel);
-
-	CAN_LEDStateControl(channel, state);
+	CAN_LEDStateControl(channel, (0 != strcmp(argv[0], "OFF")));
 }
 
-void eraseSysBlock(char *ptr)
+void eraseSysBlock(int argc, char *argv[])
 {
-	int channel;
-	char argBuffer[10];
+	uint32_t channel;
 
-	if (false == getArgument(ptr, 1, argBuffer, 10))
+	if (false == numericArgument(argc, argv, 1, 10, &channel))
 	{
 		return;
 	}
-	sscanf(argBuffer, "%d", &channel);
-
 	CAN_EraseSysBlock(channel);
 }
 
-void eraseProg(char *ptr)
+void eraseProg(int argc, char *argv[])
 {
-	int channel;
-	char argBuffer[10];
+	uint32_t channel;
 
-	if (false == getArgument(ptr, 1, argBuffer, 10))
+	if (false == numericArgument(argc, argv, 1, 10, &channel))
 	{
 		return;
 	}
-	sscanf(argBuffer, "%d", &channel);
-
 	CAN_EraseProgramBlock(channel);
 }
 
-void loadProg(char *strPtr)
+// The load itself runs as a job -- see Jobs.h.  The image follows as ':' data
+// lines (uartLoadLine()) or HL_FW_DATA frames, and the console keeps taking
+// commands -- JOBS, CANCEL, VER -- in between.
+void loadProg(int argc, char *argv[])
 {
-	char argBuffer[10];
-	int id;
+	uint32_t id;
 	uint32_t baseAddress;
-	volatile int dwell = 60000;
+	uint16_t job;
+	char reportBuffer[32];
 
-	if (false == getArgument(strPtr, 1, argBuffer, 10))
+	if (false == numericArgument(argc, argv, 1, 10, &id))
 	{
 		WriteUARTString("\n1) No ID! Aborting.\n");
 		return;
 	}
-	sscanf(argBuffer, "%d", &id);
 
-	if (false == getArgument(strPtr, 2, argBuffer, 10))
+	if (false == numericArgument(argc, argv, 2, 16, &baseAddress))
 	{
 		WriteUARTString("\n2) No base address! Aborting.\n");
 		return;
 	}
-	sscanf(argBuffer, "%lX", &baseAddress);
 
-	// FLUSH COM BUFFER so errant terminators don't get sent to the target
-	if (true == CAN_ProgramStart(id, baseAddress))
+	job = JOB_LoadStart(id, baseAddress);
+	if (0 == job)
 	{
-		uint8_t byteIn;
-		timerFlag_loadTimer = false;
-		osTimerStart(FileTransferHandle,dwell);
+		WriteUARTString("\nAbort - no load\n");
+		return;
+	}
+	sprintf(reportBuffer, "JOB %u LOAD\n", job);
+	WriteUARTString(reportBuffer);
+}
 
-		osDelay(100);
-		UART_Raw = true;
-		if (HAL_UART_Receive_IT(&huart2, (uint8_t *)&char2q, 1) != HAL_OK)
-		{
-		  _Error_Handler(__FILE__, __LINE__);
-		}
-		osDelay(100);
+void resetNode(int argc, char *argv[])
+{
+	uint32_t channel;
 
-		CQ_Flush(&qStruct);
+	if (false == numericArgument(argc, argv, 1, 10, &channel))
+	{
+		return;
+	}
+	CAN_RestartNode(channel);
+}
+
+void getVersion(int argc, char *argv[])
+{
+	uint32_t channel;
 
-		while(false == timerFlag_loadTimer)
+	if (false == numericArgument(argc, argv, 1, 10, &channel))
+	{
+		return;
+	}
+	CAN_GetReportVersion(channel);
+}
+
+// TOP: this node.  TOP <ID>: a child answers over CAN, one line per task.
+void topReport(int argc, char *argv[])
+{
+	uint32_t id;
+
+	if (2 > argc)
+	{
+		TS_Report();
+		return;
+	}
+	if (false == numericArgument(argc, argv, 1, 10, &id))
+	{
+		return;
+	}
+	if (CAN_MyID() == id)
+	{
+		TS_Report();
+		return;
+	}
+	CAN_GetReportStats(id);
+}
+
+void jobStatus(int argc, char *argv[])
+{
+	uint32_t id = 0;
+
+	if ((1 < argc) && (false == numericArgument(argc, argv, 1, 10, &id)))
+	{
+		return;
+	}
+	JOB_Report((uint16_t)id);
+}
+
+void jobCancel(int argc, char *argv[])
+{
+	uint32_t id;
+
+	if (false == numericArgument(argc, argv, 1, 10, &id))
+	{
+		return;
+	}
+	WriteUARTString((true == JOB_Cancel((uint16_t)id)) ? "CANCEL OK\n" : "CANCEL ERR\n");
+}
+
+void logFormat(int argc, char *argv[])
+{
+	if (2 > argc)
+	{
+		WriteUARTString(FL_IsBinary() ? "LOGFMT BIN\n" : "LOGFMT TEXT\n");
+		return;
+	}
+
+	if (0 == strcmp(argv[1], "BIN"))
+	{
+		FL_SetBinary(true);
+	}
+	else if (0 == strcmp(argv[1], "TEXT"))
+	{
+		FL_SetBinary(false);
+	}
+}
+
+void hostLink(int argc, char *argv[])
+{
+	WriteUARTString("HOSTLINK\n");
+	HL_Enter();
+}
+
+void monitor(int argc, char *argv[])
+{
+	if (2 > argc)
+	{
+		WriteUARTString(MON_Active() ? "MONITOR ON\n" : "MONITOR OFF\n");
+		return;
+	}
+
+	if (0 == strcmp(argv[1], "OFF"))
+	{
+		MON_Stop();
+		return;
+	}
+	if (0 != strcmp(argv[1], "ON"))
+	{
+		return;
+	}
+	if (false == CAN_IAmMaster())
+	{
+		WriteUARTString("MONITOR: master only\n");
+		return;
+	}
+	MON_Start((3 <= argc) && (0 == strcmp(argv[2], "DELTA")));
+}
+
+static void uartSwitchBaud(uint32_t baud)
+{
+	uartTxDrain();
+	if (HAL_OK != MX_USART2_SetBaud(baud))
+	{
+		_Error_Handler(__FILE__, __LINE__);
+	}
+	uartBaud = baud;
+	CQ_Flush(&qStruct);		// whatever arrived mid-switch is noise
+	uartFlowCheck();
+	RearmUART();
+}
+
+// Wait for the host to send "BAUD ACK" at the new rate.  Other lines (framing
+// garbage from the switch) are skipped.
+static bool uartWaitBaudAck(void)
+{
+	uint32_t start = osKernelSysTick();
+	uint32_t elapsed;
+
+	while (UART_BAUD_ACK_MS > (elapsed = (osKernelSysTick() - start)))
+	{
+		char line[16];
+		int i = 0;
+		uint8_t ch;
+
+		if (0 == qStruct.term_count)
+		{
+			uartWaitRx(UART_BAUD_ACK_MS - elapsed);
+			continue;
+		}
+		while (true == CQ_DequeueChar(&qStruct, &ch))
 		{
-			if (false == CQ_DequeueChar(&qStruct, &byteIn))
+			if (IS_TERMINATOR(ch))
 			{
-				huart2.Instance->TDR = 0x11; //XON
-				WriteUARTString(".");
-				osDelay(100);
-				continue;
+				break;
 			}
-			dwell = 500;
-			CAN_ProgramChar(byteIn);
-			osTimerStart(FileTransferHandle,dwell);
+			if (i < (sizeof(line) - 1))
+			{
+				line[i++] = (char)ch;
+			}
+		}
+		line[i] = '\0';
+		if (0 == strcmp(line, "BAUD ACK"))
+		{
+			return(true);
 		}
+	}
+	return(false);
+}
+
+// BAUD <rate>: answer "BAUD OK <rate>" at the old rate, switch, and wait for
+// "BAUD ACK" from the host at the new one.  No ACK in time -- back to 115200
+// (the host does the same on its side).
+void setBaud(int argc, char *argv[])
+{
+	char reply[32];
+	uint32_t baud;
 
-		CAN_ProgramClose();
-		UART_Raw = false;
-		WriteUARTString("\nLoad CLOSED\n");
+	if (true == HL_Active())
+	{
+		WriteUARTString("BAUD: text mode only\n");
+		return;
 	}
-	else
+	if (2 > argc)
 	{
-		WriteUARTString("\nAbort - no load\n");
+		sprintf(reply, "BAUD %lu\n", uartBaud);
+		WriteUARTString(reply);
+		return;
 	}
+
+	if ((false == CLI_ParseUnsigned(argv[1], 10, &baud)) ||
+		(false == MX_USART2_BaudSupported(baud, NULL)))
+	{
+		WriteUARTString("BAUD ERR\n");
+		return;
+	}
+
+	sprintf(reply, "BAUD OK %lu\n", baud);
+	WriteUARTString(reply);
+	uartSwitchBaud(baud);
+
+	if (true == uartWaitBaudAck())
+	{
+		WriteUARTString("BAUD LOCKED\n");
+		return;
+	}
+	uartSwitchBaud(USART2_DEFAULT_BAUD);
+	WriteUARTString("BAUD FALLBACK\n");
 }
 
-void resetNode(char *ptr)
+void flowControl(int argc, char *argv[])
 {
-	int channel;
-	char argBuffer[10];
+	static const char *modeNames[] = {"NONE", "XON", "RTS"};
 
-	if (false == getArgument(ptr, 1, argBuffer, 10))
+	if (2 > argc)
 	{
+		WriteUARTString("FLOW ");
+		WriteUARTString((char *)modeNames[uartFlow]);
+		WriteUARTString("\n");
 		return;
 	}
-	sscanf(argBuffer, "%d", &channel);
 
-	CAN_RestartNode(channel);
+	for (int mode = UART_FLOW_NONE; mode <= UART_FLOW_RTSCTS; mode++)
+	{
+		if (0 == strcmp(argv[1], modeNames[mode]))
+		{
+			UART_SetFlowControl((UART_FLOW_MODE)mode);
+			return;
+		}
+	}
+}
+
+static void uartRunLine(char *linePtr);
+
+static UART_MACRO *uartFindMacro(const char *namePtr)
+{
+	for (int i = 0; i < UART_MACRO_SLOTS; i++)
+	{
+		if (0 == strcmp(uartMacros[i].name, namePtr))
+		{
+			return(&uartMacros[i]);
+		}
+	}
+	return(NULL);
 }
 
-void getVersion(char *ptr)
+void defineMacro(int argc, char *argv[])
 {
-	int channel;
-	char argBuffer[10];
+	UART_MACRO *macroPtr;
 
-	if (false == getArgument(ptr, 1, argBuffer, 10))
+	if ((2 > argc) || (UART_MACRO_NAME <= strlen(argv[1])))
 	{
+		WriteUARTString("MACRO ERR\n");
 		return;
 	}
-	sscanf(argBuffer, "%d", &channel);
 
-	CAN_GetReportVersion(channel);
+	macroPtr = uartFindMacro(argv[1]);
+	if (2 == argc)
+	{
+		if (NULL != macroPtr)
+		{
+			macroPtr->name[0] = '\0';	// DEF <name> alone deletes it
+		}
+		WriteUARTString("MACRO OK\n");
+		return;
+	}
 
+	if (NULL == macroPtr)
+	{
+		macroPtr = uartFindMacro("");
+	}
+	if (NULL == macroPtr)
+	{
+		WriteUARTString("MACRO FULL\n");
+		return;
+	}
+	strcpy(macroPtr->name, argv[1]);
+	strcpy(macroPtr->body, argv[2]);
+	WriteUARTString("MACRO OK\n");
 }
-void DoUARTCommand(char *strPtr)
+
+void runMacro(int argc, char *argv[])
 {
-	char argBuffer[20];
-	COMMAND_TABLE_ENTRY *cmdTablePtr = &commandTable[0];
+	char *linePtr;
+	UART_MACRO *macroPtr = (2 > argc) ? NULL : uartFindMacro(argv[1]);
 
-	WriteUARTString(strPtr);
+	if ((NULL == macroPtr) || (0 < uartMacroDepth))
+	{
+		WriteUARTString("MACRO ERR\n");
+		return;
+	}
 
-	WriteUARTString("\r\n>");
+	// A pool block, not the stack -- the commands it runs need that room
+	linePtr = MP_Alloc(UART_LINE_LENGTH);
+	if (NULL == linePtr)
+	{
+		WriteUARTString("MACRO ERR: pool empty\n");
+		return;
+	}
+	strcpy(linePtr, macroPtr->body);	// parsing cuts the line up in place
+	uartMacroDepth++;
+	uartRunLine(linePtr);
+	uartMacroDepth--;
+	MP_Free(linePtr);
+}
+
+void listMacros(int argc, char *argv[])
+{
+	bool found = false;
+
+	for (int i = 0; i < UART_MACRO_SLOTS; i++)
+	{
+		if ('\0' == uartMacros[i].name[0])
+		{
+			continue;
+		}
+		WriteUARTString(uartMacros[i].name);
+		WriteUARTString(": ");
+		WriteUARTString(uartMacros[i].body);
+		WriteUARTString("\n");
+		found = true;
+	}
+	if (false == found)
+	{
+		WriteUARTString("NO MACROS\n");
+	}
+}
+
+void poolStatus(int argc, char *argv[])
+{
+	MP_Report();
+}
+
+// BITRATE <kbit/s> asks every node to get ready for it; BITRATE COMMIT
+// switches the whole bus (CANBitrate.h).  BITRATE AUTO is this node, or child
+// ID, and takes effect at the next power-up.
+void bitrate(int argc, char *argv[])
+{
+	uint32_t kbit;
+	uint32_t sample = BR_DEFAULT_SAMPLE;
+	uint32_t id;
+
+	if (2 > argc)
+	{
+		BR_Report();
+		return;
+	}
+	if (0 == strcmp(argv[1], "AUTO"))
+	{
+		if ((3 > argc) || ((0 != strcmp(argv[2], "ON")) && (0 != strcmp(argv[2], "OFF"))))
+		{
+			WriteUARTString("BITRATE AUTO ON|OFF [ID]\n");
+			return;
+		}
+		if ((4 <= argc) && (false == numericArgument(argc, argv, 3, 10, &id)))
+		{
+			WriteUARTString("BITRATE AUTO ON|OFF [ID]\n");
+			return;
+		}
+		if ((4 <= argc) && (CAN_MyID() != id))
+		{
+			CAN_BitrateAuto(id, 0 == strcmp(argv[2], "ON"));
+			return;
+		}
+		BR_SetAuto(0 == strcmp(argv[2], "ON"));
+		return;
+	}
+	if (false == CAN_IAmMaster())
+	{
+		WriteUARTString("BITRATE: master only\n");
+		return;
+	}
+	if (0 == strcmp(argv[1], "COMMIT"))
+	{
+		if (false == CAN_BitrateCommit())
+		{
+			WriteUARTString("BITRATE: nothing prepared\n");
+		}
+		return;
+	}
+	if ((false == numericArgument(argc, argv, 1, 10, &kbit)) ||
+		((3 <= argc) && (false == numericArgument(argc, argv, 2, 10, &sample))) || (1000 <= sample))
+	{
+		return;
+	}
+	if (false == CAN_BitratePrepare(kbit, (uint16_t)sample))
+	{
+		WriteUARTString("BITRATE: no timing\n");
+	}
+}
+
+// CANERR: this node's error state and transition log.  CANERR <ID>: a child
+// answers over CAN.  CANERR BACKOFF <min> <max> [ID]: this node, or child ID.
+void canErrors(int argc, char *argv[])
+{
+	uint32_t id;
+	uint32_t minMs;
+	uint32_t maxMs;
+
+	if (2 > argc)
+	{
+		BS_Report();
+		return;
+	}
+	if (0 == strcmp(argv[1], "BACKOFF"))
+	{
+		if ((false == numericArgument(argc, argv, 2, 10, &minMs)) || (false == numericArgument(argc, argv, 3, 10, &maxMs)) ||
+			((5 <= argc) && (false == numericArgument(argc, argv, 4, 10, &id))))
+		{
+			return;
+		}
+		if (false == BS_BackoffValid(minMs, maxMs))
+		{
+			WriteUARTString("CANERR: 1 <= min <= max <= 65535\n");
+		}
+		else if ((5 <= argc) && (CAN_MyID() != id))
+		{
+			CAN_SetBusBackoff(id, (uint16_t)minMs, (uint16_t)maxMs);
+		}
+		else
+		{
+			BS_SetBackoff(minMs, maxMs);
+		}
+		return;
+	}
+	if (false == numericArgument(argc, argv, 1, 10, &id))
+	{
+		return;
+	}
+	if (CAN_MyID() == id)
+	{
+		BS_Report();
+		return;
+	}
+	CAN_GetBusState(id);
+}
+
+// CRASH: this node's crash records, newest first.  CRASH <ID> [n]: record n
+// (default the newest) of this node, or of a child over CAN.
+void crashReport(int argc, char *argv[])
+{
+	uint32_t id;
+	uint32_t index = 0;
 
-	if (false == getArgument(strPtr, 0, argBuffer, sizeof(argBuffer) - 1))
+	if (2 > argc)
+	{
+		CR_Report();
+		return;
+	}
+	if (0 == strcmp(argv[1], "CLEAR"))
+	{
+		CR_Clear();
+		return;
+	}
+	if ((false == numericArgument(argc, argv, 1, 10, &id)) ||
+		((3 <= argc) && (false == numericArgument(argc, argv, 2, 10, &index))) || (CR_SLOTS <= index))
+	{
+		return;
+	}
+	if (CAN_MyID() == id)
 	{
+		CR_ReportRecord((uint8_t)index);
 		return;
 	}
+	CAN_GetCrashRecord(id, (uint8_t)index);
+}
 
-	while (NULL != cmdTablePtr->commandString)
+// DUMP is binary, so it needs the host link: tracedump -d sends it from there
+void traceControl(int argc, char *argv[])
+{
+	if (2 > argc)
+	{
+		TR_Report();
+	}
+	else if (0 == strcmp(argv[1], "ON"))
+	{
+		TR_SetRecording(true);
+	}
+	else if (0 == strcmp(argv[1], "OFF"))
 	{
-		if (0 == strcmp(cmdTablePtr->commandString, argBuffer))
+		TR_SetRecording(false);
+	}
+	else if (0 == strcmp(argv[1], "CLEAR"))
+	{
+		TR_Clear();
+	}
+	else if ((0 == strcmp(argv[1], "DUMP")) && (false == TR_Dump()))
+	{
+		WriteUARTString("TRACE: host link only\n");
+	}
+}
+
+// DEF takes the whole rest of the line, separators and all, as its body
+static bool uartIsDefine(const char *linePtr)
+{
+	while ((' ' == *linePtr) || ('\t' == *linePtr))
+	{
+		linePtr++;
+	}
+	return((0 == strncmp(linePtr, "DEF", 3)) &&
+			((' ' == linePtr[3]) || ('\t' == linePtr[3]) || ('\0' == linePtr[3])));
+}
+
+static void uartRunCommand(char *commandPtr, bool keepTail)
+{
+	char *argv[CLI_MAX_ARGS];
+	char nodeString[12];
+	const COMMAND_TABLE_ENTRY *entryPtr;
+	uint32_t first;
+	uint32_t last;
+	int argc;
+	int rangeArg;
+	uint8_t index;
+
+	argc = (true == keepTail) ? CLI_TokenizeHead(commandPtr, argv, 2) :
+								CLI_Tokenize(commandPtr, argv, CLI_MAX_ARGS);
+	if (0 == argc)
+	{
+		return;
+	}
+
+	// One hash, one compare -- anything that isn't a command misses here.
+	index = commandIndex[CLI_Hash(argv[0])];
+	if ((0 == index) || (0 != strcmp(commandTable[index - 1].commandString, argv[0])))
+	{
+		return;
+	}
+	entryPtr = &commandTable[index - 1];
+
+	// A "first..last" argument runs the command once per node.  Nothing here
+	// waits for the bus -- the frames queue up and go out back to back.
+	for (rangeArg = 1; (false == keepTail) && (rangeArg < argc); rangeArg++)
+	{
+		if (true == CLI_ParseRange(argv[rangeArg], entryPtr->rangeRadix, &first, &last))
 		{
-			(cmdTablePtr->functionPtr)(strPtr);
+			break;
+		}
+	}
+	if ((true == keepTail) || (rangeArg == argc))
+	{
+		(entryPtr->functionPtr)(argc, argv);
+		return;
+	}
+	if (UART_RANGE_LIMIT <= (last - first))
+	{
+		WriteUARTString("RANGE ERR\n");
+		return;
+	}
+
+	argv[rangeArg] = nodeString;
+	for (uint32_t count = last - first + 1; 0 < count; count--, first++)
+	{
+		sprintf(nodeString, (16 == entryPtr->rangeRadix) ? "%lX" : "%lu", first);
+		(entryPtr->functionPtr)(argc, argv);
+	}
+}
+
+// "cmd; cmd; ..." -- the commands run back to back on one echo and prompt
+static void uartRunLine(char *linePtr)
+{
+	while (NULL != linePtr)
+	{
+		if (true == uartIsDefine(linePtr))
+		{
+			uartRunCommand(linePtr, true);
 			return;
 		}
-		cmdTablePtr++;
+		uartRunCommand(CLI_NextCommand(&linePtr), false);
 	}
 }
 
-void MessagesUART_Init(void)
+void DoUARTCommand(char *strPtr)
 {
-	char *pBuffer;
+	WriteUARTString(strPtr);
+
+	WriteUARTString("\r\n>");
 
-	pBuffer = (char *)pvPortMalloc(MY_BUFFER_LENGTH);
-	if (NULL == pBuffer)
+	uartRunLine(strPtr);
+}
+
+// A command added to commandTable[] without regenerating commandIndex[] would
+// silently never match -- catch that on the first boot instead.
+static void verifyCommandIndex(void)
+{
+	for (int i = 0; NULL != commandTable[i].commandString; i++)
 	{
-		_Error_Handler(__FILE__, __LINE__);
+		if ((i + 1) != commandIndex[CLI_Hash(commandTable[i].commandString)])
+		{
+			_Error_Handler(__FILE__, __LINE__);
+		}
 	}
+}
+
+void MessagesUART_Init(void)
+{
+	static uint8_t rxBuffer[MY_BUFFER_LENGTH] CCM_BSS;	// CPU only -- the DMA fills uartRxDmaBuffer
 
-	CQ_Init(&qStruct, (uint8_t *)pBuffer, MY_BUFFER_LENGTH);
+	CQ_Init(&qStruct, rxBuffer, MY_BUFFER_LENGTH);
+	verifyCommandIndex();
 }
 
 void UART_Start(void)
@@ -537,15 +1333,82 @@ void UART_Start(void)
 	}
 	if (true == CAN_IAmAssignedChild())
 	{
+		WD_Unregister();
 		osThreadTerminate(osThreadGetId());
 	}
 }
 
+static int hexDigit(char ch)
+{
+	if (('0' <= ch) && ('9' >= ch))
+	{
+		return(ch - '0');
+	}
+	if (('A' <= (ch & ~0x20)) && ('F' >= (ch & ~0x20)))
+	{
+		return((ch & ~0x20) - 'A' + 10);
+	}
+	return(-1);
+}
+
+// ":<hex pairs>" is the next piece of a LOAD image, ":" alone its end.  Waits
+// for the load job to make room -- flow control holds the host off meanwhile
+// -- but lines before and after it are ordinary commands.  Dropped if no load
+// is running; a malformed or cut short line cancels the load.
+static void uartLoadLine(const char *linePtr)
+{
+	uint8_t data[UART_LINE_LENGTH / 2];
+	uint16_t length = 0;
+
+	for (linePtr++; '\0' != *linePtr; linePtr += 2)
+	{
+		int high = hexDigit(linePtr[0]);
+		int low = hexDigit(linePtr[1]);
+
+		if ((true == uartLineCut) || (0 > high) || (0 > low))
+		{
+			if (true == JOB_LoadCancel())
+			{
+				WriteUARTString("LOAD BAD LINE\n");
+			}
+			return;
+		}
+		data[length++] = (uint8_t)((high << 4) | low);
+	}
+
+	if (0 == length)
+	{
+		JOB_LoadClose();
+		return;
+	}
+	while ((true == JOB_LoadActive()) && (false == JOB_LoadFeed(data, length)))
+	{
+		uartWaitRx(1);		// pipe space frees up without a signal -- look again soon
+	}
+}
+
 void	 DoUARTProcessing(void)
 {
 	char *rxStrPtr;
 
 	UART_Start();
+	uartFlowCheck();
+
+	if (true == HL_Active())
+	{
+		uint8_t ch;
+
+		if (false == CQ_DequeueChar(&qStruct, &ch))
+		{
+			uartWaitRx(osWaitForever);
+			return;
+		}
+		do
+		{
+			HL_RxByte(ch);
+		} while ((true == HL_Active()) && (true == CQ_DequeueChar(&qStruct, &ch)));
+		return;
+	}
 
 	if (false == trafficOnUART)
 	{
@@ -562,14 +1425,14 @@ void	 DoUARTProcessing(void)
 
 	rxStrPtr = GetUARTString();
 
-	if (NULL != rxStrPtr)
+	if ((NULL != rxStrPtr) && (':' == rxStrPtr[0]))
+	{
+		uartLoadLine(rxStrPtr);
+	}
+	else if (NULL != rxStrPtr)
 	{
 		DoUARTCommand(rxStrPtr);
-		vPortFree(rxStrPtr);
-		rxStrPtr = NULL;
 	}
-
-	RearmUART();
 }
 
 void taskUARTReceive(void const * argument)
@@ -577,13 +1440,15 @@ void taskUARTReceive(void const * argument)
 	MessagesUART_Init();
 	RearmUART();
 
+	startSync = true;
+	CAN_Wake();			// the CAN task holds off until the console is up
+	WD_Register(WD_DEADLINE_LONG_MS);	// the host's flow control can hold it up
+
 	/* Infinite loop */
 	for(;;)
 	{
-	  startSync = true;
+	  // Every wait in here blocks on the receive signal -- no polling
 	  DoUARTProcessing();
-
-	  osThreadYield();
 	}
 }
 
@@ -0,0 +1,128 @@
+/*
+ * Watchdog.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ */
+
+#include "Watchdog.h"
+#include "Crash.h"
+
+#define WD_IWDG_CLOCK_HZ		40000		// LSI, typical
+#define WD_IWDG_PRESCALER		32
+#define WD_IWDG_PR_DIV32		0x03
+#define WD_IWDG_RELOAD			((WD_IWDG_TIMEOUT_MS * (WD_IWDG_CLOCK_HZ / WD_IWDG_PRESCALER)) / 1000)
+
+#define WD_KEY_RELOAD			0xAAAA
+#define WD_KEY_ACCESS			0x5555
+#define WD_KEY_START			0xCCCC
+
+typedef struct _WD_CLIENT
+{
+	osThreadId			task;
+	uint32_t			deadlineMs;
+	volatile uint32_t	lastCheckIn;
+} WD_CLIENT;
+
+static WD_CLIENT			wdClients[WD_MAX_TASKS];
+static volatile uint32_t	wdClientCount = 0;
+
+static WD_CLIENT *wdFind(osThreadId task)
+{
+	for (uint32_t i = 0; i < wdClientCount; i++)
+	{
+		if (task == wdClients[i].task)
+		{
+			return(&wdClients[i]);
+		}
+	}
+	return(NULL);
+}
+
+// Calling task, once, before its loop
+void WD_Register(uint32_t deadlineMs)
+{
+	osThreadId task = osThreadGetId();
+	WD_CLIENT *clientPtr;
+
+	taskENTER_CRITICAL();
+	clientPtr = wdFind(task);
+	if ((NULL == clientPtr) && (WD_MAX_TASKS > wdClientCount))
+	{
+		clientPtr = &wdClients[wdClientCount];
+		clientPtr->task = task;
+		clientPtr->deadlineMs = deadlineMs;
+		clientPtr->lastCheckIn = osKernelSysTick();
+		wdClientCount++;		// last -- the supervisor reads without the lock
+	}
+	taskEXIT_CRITICAL();
+}
+
+void WD_CheckIn(void)
+{
+	WD_CLIENT *clientPtr = wdFind(osThreadGetId());
+
+	if (NULL != clientPtr)
+	{
+		clientPtr->lastCheckIn = osKernelSysTick();
+	}
+}
+
+// Calling task, just before it terminates itself
+void WD_Unregister(void)
+{
+	WD_CLIENT *clientPtr;
+
+	taskENTER_CRITICAL();
+	clientPtr = wdFind(osThreadGetId());
+	if (NULL != clientPtr)
+	{
+		*clientPtr = wdClients[wdClientCount - 1];
+		wdClientCount--;
+	}
+	taskEXIT_CRITICAL();
+}
+
+// A wait timeout no longer than the check-in interval
+uint32_t WD_Wait(uint32_t waitMs)
+{
+	return((WD_CHECKIN_MS < waitMs) ? WD_CHECKIN_MS : waitMs);
+}
+
+static void wdStartIwdg(void)
+{
+	DBGMCU->APB1FZ |= DBGMCU_APB1_FZ_DBG_IWDG_STOP;		// sitting at a breakpoint is not a hang
+
+	IWDG->KR = WD_KEY_START;
+	IWDG->KR = WD_KEY_ACCESS;
+	IWDG->PR = WD_IWDG_PR_DIV32;
+	IWDG->RLR = WD_IWDG_RELOAD;
+	while (0 != (IWDG->SR & (IWDG_SR_PVU | IWDG_SR_RVU)))
+	{
+	}
+	IWDG->KR = WD_KEY_RELOAD;
+}
+
+// The default task.  Never returns.
+void WD_Supervise(void)
+{
+	osThreadSetPriority(osThreadGetId(), osPriorityRealtime);
+	wdStartIwdg();
+
+	for(;;)
+	{
+		uint32_t now = osKernelSysTick();
+
+		for (uint32_t i = 0; i < wdClientCount; i++)
+		{
+			int32_t late = (int32_t)(now - wdClients[i].lastCheckIn);
+
+			if ((int32_t)wdClients[i].deadlineMs < late)
+			{
+				CR_Watchdog(pcTaskGetName(wdClients[i].task), (uint32_t)late);
+			}
+		}
+		IWDG->KR = WD_KEY_RELOAD;
+		osDelay(WD_SUPERVISE_MS);
+	}
+}
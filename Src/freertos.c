@@ -57,6 +57,8 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */     
 #include "CAN_Exports.h"
+#include "TaskStats.h"
+#include "Watchdog.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -76,16 +78,40 @@
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN Variables */
-
+// The CAN and UART task stacks and the CAN receive ring live in CCM-RAM.  The
+// definitions below are generated, so the section is given here instead --
+// GCC carries it over from the first declaration.
+extern uint32_t UARTReceiveTaskBuffer[] CCM_BSS;
+extern uint32_t CANReceiveTaskBuffer[] CCM_BSS;
+extern uint8_t CAN_ReceiveBuffer[] CCM_BSS;
 /* USER CODE END Variables */
 osThreadId defaultTaskHandle;
+uint32_t defaultTaskBuffer[ 128 ];
+osStaticThreadDef_t defaultTaskControlBlock;
 osThreadId UARTReceiveTaskHandle;
+uint32_t UARTReceiveTaskBuffer[ 512 ];
+osStaticThreadDef_t UARTReceiveTaskControlBlock;
 osThreadId CANReceiveTaskHandle;
+uint32_t CANReceiveTaskBuffer[ 512 ];
+osStaticThreadDef_t CANReceiveTaskControlBlock;
+osThreadId FrameLogTaskHandle;
+uint32_t FrameLogTaskBuffer[ 256 ];
+osStaticThreadDef_t FrameLogTaskControlBlock;
+osThreadId JobTaskHandle;
+uint32_t JobTaskBuffer[ 512 ];
+osStaticThreadDef_t JobTaskControlBlock;
 osMessageQId CAN_ReceiveHandle;
-osTimerId FileTransferHandle;
+uint8_t CAN_ReceiveBuffer[ 16 * sizeof( COMPLETE_CAN_RX_MSG ) ];
+osStaticMessageQDef_t CAN_ReceiveControlBlock;
+osMessageQId JobQueueHandle;
+uint8_t JobQueueBuffer[ 4 * sizeof( uint32_t ) ];
+osStaticMessageQDef_t JobQueueControlBlock;
 osTimerId CAN_LoadErrorHandle;
+osStaticTimerDef_t CAN_LoadErrorControlBlock;
 osTimerId LEDFlashHandle;
+osStaticTimerDef_t LEDFlashControlBlock;
 osSemaphoreId UARTContrlHandle;
+osStaticSemaphoreDef_t UARTContrlControlBlock;
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN FunctionPrototypes */
@@ -95,12 +121,62 @@ osSemaphoreId UARTContrlHandle;
 void StartDefaultTask(void const * argument);
 extern void taskUARTReceive(void const * argument);
 extern void taskCANReceive(void const * argument);
-extern void cbFileTransfer(void const * argument);
+extern void taskFrameLog(void const * argument);
+extern void taskJob(void const * argument);
 extern void cbCANLoadError(void const * argument);
 extern void cbLEDFlash(void const * argument);
 
 void MX_FREERTOS_Init(void); /* (MISRA C 2004 rule 8.1) */
 
+/* Hook prototypes */
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
+
+/* USER CODE BEGIN 1 */
+/* Functions needed when configGENERATE_RUN_TIME_STATS is on */
+void configureTimerForRunTimeStats(void)
+{
+  TS_ClockStart();
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  return(TS_Clock());
+}
+/* USER CODE END 1 */
+
+/* GetIdleTaskMemory prototype (linked to static allocation support) */
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize );
+
+/* GetTimerTaskMemory prototype (linked to static allocation support) */
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint32_t *pulTimerTaskStackSize );
+
+/* USER CODE BEGIN GET_IDLE_TASK_MEMORY */
+static StaticTask_t xIdleTaskTCBBuffer;
+static StackType_t xIdleStack[configMINIMAL_STACK_SIZE];
+  
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize )
+{
+  *ppxIdleTaskTCBBuffer = &xIdleTaskTCBBuffer;
+  *ppxIdleTaskStackBuffer = &xIdleStack[0];
+  *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+  /* place for user code */
+}                   
+/* USER CODE END GET_IDLE_TASK_MEMORY */
+
+/* USER CODE BEGIN GET_TIMER_TASK_MEMORY */
+static StaticTask_t xTimerTaskTCBBuffer;
+static StackType_t xTimerStack[configTIMER_TASK_STACK_DEPTH];
+  
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint32_t *pulTimerTaskStackSize )  
+{
+  *ppxTimerTaskTCBBuffer = &xTimerTaskTCBBuffer;
+  *ppxTimerTaskStackBuffer = &xTimerStack[0];
+  *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+  /* place for user code */
+}                   
+/* USER CODE END GET_TIMER_TASK_MEMORY */
+
 /**
   * @brief  FreeRTOS initialization
   * @param  None
@@ -117,24 +193,22 @@ void MX_FREERTOS_Init(void) {
 
   /* Create the semaphores(s) */
   /* definition and creation of UARTContrl */
-  osSemaphoreDef(UARTContrl);
+  osSemaphoreStaticDef(UARTContrl, &UARTContrlControlBlock);
   UARTContrlHandle = osSemaphoreCreate(osSemaphore(UARTContrl), 1);
 
   /* USER CODE BEGIN RTOS_SEMAPHORES */
   /* add semaphores, ... */
+  // A statically created binary semaphore starts out taken -- UART_Write() expects it free.
+  osSemaphoreRelease(UARTContrlHandle);
   /* USER CODE END RTOS_SEMAPHORES */
 
   /* Create the timer(s) */
-  /* definition and creation of FileTransfer */
-  osTimerDef(FileTransfer, cbFileTransfer);
-  FileTransferHandle = osTimerCreate(osTimer(FileTransfer), osTimerPeriodic, NULL);
-
   /* definition and creation of CAN_LoadError */
-  osTimerDef(CAN_LoadError, cbCANLoadError);
+  osTimerStaticDef(CAN_LoadError, cbCANLoadError, &CAN_LoadErrorControlBlock);
   CAN_LoadErrorHandle = osTimerCreate(osTimer(CAN_LoadError), osTimerOnce, NULL);
 
   /* definition and creation of LEDFlash */
-  osTimerDef(LEDFlash, cbLEDFlash);
+  osTimerStaticDef(LEDFlash, cbLEDFlash, &LEDFlashControlBlock);
   LEDFlashHandle = osTimerCreate(osTimer(LEDFlash), osTimerPeriodic, NULL);
 
   /* USER CODE BEGIN RTOS_TIMERS */
@@ -143,17 +217,25 @@ void MX_FREERTOS_Init(void) {
 
   /* Create the thread(s) */
   /* definition and creation of defaultTask */
-  osThreadDef(defaultTask, StartDefaultTask, osPriorityNormal, 0, 128);
+  osThreadStaticDef(defaultTask, StartDefaultTask, osPriorityIdle, 0, 128, defaultTaskBuffer, &defaultTaskControlBlock);
   defaultTaskHandle = osThreadCreate(osThread(defaultTask), NULL);
 
   /* definition and creation of UARTReceiveTask */
-  osThreadDef(UARTReceiveTask, taskUARTReceive, osPriorityIdle, 0, 512);
+  osThreadStaticDef(UARTReceiveTask, taskUARTReceive, osPriorityNormal, 0, 512, UARTReceiveTaskBuffer, &UARTReceiveTaskControlBlock);
   UARTReceiveTaskHandle = osThreadCreate(osThread(UARTReceiveTask), NULL);
 
   /* definition and creation of CANReceiveTask */
-  osThreadDef(CANReceiveTask, taskCANReceive, osPriorityIdle, 0, 512);
+  osThreadStaticDef(CANReceiveTask, taskCANReceive, osPriorityAboveNormal, 0, 512, CANReceiveTaskBuffer, &CANReceiveTaskControlBlock);
   CANReceiveTaskHandle = osThreadCreate(osThread(CANReceiveTask), NULL);
 
+  /* definition and creation of FrameLogTask */
+  osThreadStaticDef(FrameLogTask, taskFrameLog, osPriorityBelowNormal, 0, 256, FrameLogTaskBuffer, &FrameLogTaskControlBlock);
+  FrameLogTaskHandle = osThreadCreate(osThread(FrameLogTask), NULL);
+
+  /* definition and creation of JobTask */
+  osThreadStaticDef(JobTask, taskJob, osPriorityLow, 0, 512, JobTaskBuffer, &JobTaskControlBlock);
+  JobTaskHandle = osThreadCreate(osThread(JobTask), NULL);
+
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
   /* USER CODE END RTOS_THREADS */
@@ -162,9 +244,13 @@ void MX_FREERTOS_Init(void) {
   /* definition and creation of CAN_Receive */
 /* what about the sizeof here??? cd native code */
 //  osMessageQDef(CAN_Receive, 16, uint16_t);
-  osMessageQDef(CAN_Receive, 16, COMPLETE_CAN_RX_MSG);
+  osMessageQStaticDef(CAN_Receive, 16, COMPLETE_CAN_RX_MSG, CAN_ReceiveBuffer, &CAN_ReceiveControlBlock);
   CAN_ReceiveHandle = osMessageCreate(osMessageQ(CAN_Receive), NULL);
 
+  /* definition and creation of JobQueue */
+  osMessageQStaticDef(JobQueue, 4, uint32_t, JobQueueBuffer, &JobQueueControlBlock);
+  JobQueueHandle = osMessageCreate(osMessageQ(JobQueue), NULL);
+
   /* USER CODE BEGIN RTOS_QUEUES */
   /* add queues, ... */
   /* USER CODE END RTOS_QUEUES */
@@ -181,11 +267,9 @@ void StartDefaultTask(void const * argument)
 {
 
   /* USER CODE BEGIN StartDefaultTask */
-  /* Infinite loop */
-  for(;;)
-  {
-    osDelay(1);
-  }
+  /* The work is all in the event driven tasks -- this one only watches them
+     and feeds the IWDG, waking every WD_SUPERVISE_MS (Watchdog.h). */
+  WD_Supervise();
   /* USER CODE END StartDefaultTask */
 }
 
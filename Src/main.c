@@ -51,11 +51,17 @@
 #include "stm32f3xx_hal.h"
 #include "cmsis_os.h"
 #include "can.h"
+#include "dma.h"
 #include "usart.h"
 #include "gpio.h"
 
 /* USER CODE BEGIN Includes */
 #include <stdbool.h>
+
+#include "FlashSupport.h"
+#include "BootHandoff.h"
+#include "Trace.h"
+#include "Crash.h"
 /* USER CODE END Includes */
 
 /* Private variables ---------------------------------------------------------*/
@@ -92,19 +98,14 @@ int main(void)
 	//EraseProgramBlock();
 	//EraseSystemBlock();
 
+	// A valid high flash image was already handed off by LoaderEarlyEntry()
+	// from Reset_Handler.  All that is left here is cleaning up a bad one.
 	if (true == IAmInLowFlash())
 	{
-		if (true == UpperBlockIsEmpty())
-		{
-		}
-		else if (false == ValidProgramInHighFlash())
+		if ((false == UpperBlockIsEmpty()) && (false == ValidProgramInHighFlash()))
 		{
 			EraseProgramBlock();
 		}
-		else
-		{
-			JumpToHighFlash();
-		}
 	}
 #endif
   /* USER CODE END 1 */
@@ -115,7 +116,7 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
-
+  CR_Init();		// first, so a fault in the init below cannot lose the last crash
   /* USER CODE END Init */
 
   /* Configure the system clock */
@@ -127,9 +128,11 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
   MX_CAN_Init();
   /* USER CODE BEGIN 2 */
+  TR_Init();		// before the scheduler, so its first switch is recorded
 
   /* USER CODE END 2 */
 
@@ -166,6 +169,14 @@ void SystemClock_Config(void)
   RCC_ClkInitTypeDef RCC_ClkInitStruct;
   RCC_PeriphCLKInitTypeDef PeriphClkInit;
 
+  /* USER CODE BEGIN SysClk 0 */
+  /* The loader already has SYSCLK on the PLL at 72 MHz (see BootHandoff.h).
+     HAL_RCC_OscConfig() refuses to touch a PLL that is driving SYSCLK, and
+     there is no need to wait for it to lock a second time. */
+  if (false == BOOT_HANDOFF_CLOCK_READY())
+  {
+  /* USER CODE END SysClk 0 */
+
     /**Initializes the CPU, AHB and APB busses clocks 
     */
   RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
@@ -194,6 +205,10 @@ void SystemClock_Config(void)
     _Error_Handler(__FILE__, __LINE__);
   }
 
+  /* USER CODE BEGIN SysClk 1 */
+  }
+  /* USER CODE END SysClk 1 */
+
   PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_USART2;
   PeriphClkInit.Usart2ClockSelection = RCC_USART2CLKSOURCE_PCLK1;
   if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK)
@@ -227,9 +242,7 @@ void _Error_Handler(char *file, int line)
 {
   /* USER CODE BEGIN Error_Handler_Debug */
   /* User can add his own implementation to report the HAL error return state */
-  while(1)
-  {
-  }
+  CR_Error(file, line);		// record and reset -- never returns
   /* USER CODE END Error_Handler_Debug */
 }
 
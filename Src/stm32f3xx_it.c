@@ -37,11 +37,22 @@
 #include "cmsis_os.h"
 
 /* USER CODE BEGIN 0 */
+#include "UARTHandler.h"
+#include "Trace.h"
+#include "Crash.h"
+
+// Naked so CR_FAULT_ENTRY() finds the exception frame where the core left it
+void HardFault_Handler(void) __attribute__((naked));
+void MemManage_Handler(void) __attribute__((naked));
+void BusFault_Handler(void) __attribute__((naked));
+void UsageFault_Handler(void) __attribute__((naked));
 
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
 extern CAN_HandleTypeDef hcan;
+extern DMA_HandleTypeDef hdma_usart2_rx;
+extern DMA_HandleTypeDef hdma_usart2_tx;
 extern UART_HandleTypeDef huart2;
 
 /******************************************************************************/
@@ -67,7 +78,7 @@ void NMI_Handler(void)
 void HardFault_Handler(void)
 {
   /* USER CODE BEGIN HardFault_IRQn 0 */
-
+  CR_FAULT_ENTRY(CR_REASON_HARDFAULT);
   /* USER CODE END HardFault_IRQn 0 */
   while (1)
   {
@@ -85,7 +96,7 @@ void HardFault_Handler(void)
 void MemManage_Handler(void)
 {
   /* USER CODE BEGIN MemoryManagement_IRQn 0 */
-
+  CR_FAULT_ENTRY(CR_REASON_MEMMANAGE);
   /* USER CODE END MemoryManagement_IRQn 0 */
   while (1)
   {
@@ -103,7 +114,7 @@ void MemManage_Handler(void)
 void BusFault_Handler(void)
 {
   /* USER CODE BEGIN BusFault_IRQn 0 */
-
+  CR_FAULT_ENTRY(CR_REASON_BUSFAULT);
   /* USER CODE END BusFault_IRQn 0 */
   while (1)
   {
@@ -121,7 +132,7 @@ void BusFault_Handler(void)
 void UsageFault_Handler(void)
 {
   /* USER CODE BEGIN UsageFault_IRQn 0 */
-
+  CR_FAULT_ENTRY(CR_REASON_USAGEFAULT);
   /* USER CODE END UsageFault_IRQn 0 */
   while (1)
   {
@@ -168,17 +179,63 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32f3xx.s).                    */
 /******************************************************************************/
 
+/**
+* @brief This function handles DMA1 channel6 global interrupt.
+*/
+void DMA1_Channel6_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel6_IRQn 0 */
+  TR_Event(TR_EV_ISR_ENTER, DMA1_Channel6_IRQn, 0);
+
+  /* USER CODE END DMA1_Channel6_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart2_rx);
+  /* USER CODE BEGIN DMA1_Channel6_IRQn 1 */
+  TR_Event(TR_EV_ISR_EXIT, DMA1_Channel6_IRQn, 0);
+  /* USER CODE END DMA1_Channel6_IRQn 1 */
+}
+
+/**
+* @brief This function handles DMA1 channel7 global interrupt.
+*/
+void DMA1_Channel7_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel7_IRQn 0 */
+  TR_Event(TR_EV_ISR_ENTER, DMA1_Channel7_IRQn, 0);
+
+  /* USER CODE END DMA1_Channel7_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart2_tx);
+  /* USER CODE BEGIN DMA1_Channel7_IRQn 1 */
+  TR_Event(TR_EV_ISR_EXIT, DMA1_Channel7_IRQn, 0);
+  /* USER CODE END DMA1_Channel7_IRQn 1 */
+}
+
+/**
+* @brief This function handles USB high priority or CAN_TX interrupts.
+*/
+void USB_HP_CAN_TX_IRQHandler(void)
+{
+  /* USER CODE BEGIN USB_HP_CAN_TX_IRQn 0 */
+  TR_Event(TR_EV_ISR_ENTER, USB_HP_CAN_TX_IRQn, 0);
+
+  /* USER CODE END USB_HP_CAN_TX_IRQn 0 */
+  HAL_CAN_IRQHandler(&hcan);
+  /* USER CODE BEGIN USB_HP_CAN_TX_IRQn 1 */
+  TR_Event(TR_EV_ISR_EXIT, USB_HP_CAN_TX_IRQn, 0);
+  /* USER CODE END USB_HP_CAN_TX_IRQn 1 */
+}
+
 /**
 * @brief This function handles USB low priority or CAN_RX0 interrupts.
 */
 void USB_LP_CAN_RX0_IRQHandler(void)
 {
   /* USER CODE BEGIN USB_LP_CAN_RX0_IRQn 0 */
+  TR_Event(TR_EV_ISR_ENTER, USB_LP_CAN_RX0_IRQn, 0);
 
   /* USER CODE END USB_LP_CAN_RX0_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan);
   /* USER CODE BEGIN USB_LP_CAN_RX0_IRQn 1 */
-
+  TR_Event(TR_EV_ISR_EXIT, USB_LP_CAN_RX0_IRQn, 0);
   /* USER CODE END USB_LP_CAN_RX0_IRQn 1 */
 }
 
@@ -188,11 +245,12 @@ void USB_LP_CAN_RX0_IRQHandler(void)
 void CAN_RX1_IRQHandler(void)
 {
   /* USER CODE BEGIN CAN_RX1_IRQn 0 */
+  TR_Event(TR_EV_ISR_ENTER, CAN_RX1_IRQn, 0);
 
   /* USER CODE END CAN_RX1_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan);
   /* USER CODE BEGIN CAN_RX1_IRQn 1 */
-
+  TR_Event(TR_EV_ISR_EXIT, CAN_RX1_IRQn, 0);
   /* USER CODE END CAN_RX1_IRQn 1 */
 }
 
@@ -202,11 +260,12 @@ void CAN_RX1_IRQHandler(void)
 void CAN_SCE_IRQHandler(void)
 {
   /* USER CODE BEGIN CAN_SCE_IRQn 0 */
+  TR_Event(TR_EV_ISR_ENTER, CAN_SCE_IRQn, 0);
 
   /* USER CODE END CAN_SCE_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan);
   /* USER CODE BEGIN CAN_SCE_IRQn 1 */
-
+  TR_Event(TR_EV_ISR_EXIT, CAN_SCE_IRQn, 0);
   /* USER CODE END CAN_SCE_IRQn 1 */
 }
 
@@ -216,11 +275,17 @@ void CAN_SCE_IRQHandler(void)
 void USART2_IRQHandler(void)
 {
   /* USER CODE BEGIN USART2_IRQn 0 */
-
+  TR_Event(TR_EV_ISR_ENTER, USART2_IRQn, 0);
+  if ((RESET != __HAL_UART_GET_FLAG(&huart2, UART_FLAG_IDLE)) &&
+      (RESET != __HAL_UART_GET_IT_SOURCE(&huart2, UART_IT_IDLE)))
+  {
+    __HAL_UART_CLEAR_IDLEFLAG(&huart2);
+    UART_RxIdleCallback();
+  }
   /* USER CODE END USART2_IRQn 0 */
   HAL_UART_IRQHandler(&huart2);
   /* USER CODE BEGIN USART2_IRQn 1 */
-
+  TR_Event(TR_EV_ISR_EXIT, USART2_IRQn, 0);
   /* USER CODE END USART2_IRQn 1 */
 }
 
@@ -230,11 +295,12 @@ void USART2_IRQHandler(void)
 void EXTI15_10_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI15_10_IRQn 0 */
+  TR_Event(TR_EV_ISR_ENTER, EXTI15_10_IRQn, 0);
 
   /* USER CODE END EXTI15_10_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_13);
   /* USER CODE BEGIN EXTI15_10_IRQn 1 */
-
+  TR_Event(TR_EV_ISR_EXIT, EXTI15_10_IRQn, 0);
   /* USER CODE END EXTI15_10_IRQn 1 */
 }
 
@@ -84,6 +84,7 @@
   */
 
 #include "stm32f3xx.h"
+#include "BootHandoff.h"
 
 /**
   * @}
@@ -172,6 +173,17 @@ void SystemInit(void)
     SCB->CPACR |= ((3UL << 10*2)|(3UL << 11*2));  /* set CP10 and CP11 Full Access */
   #endif
 
+#ifdef _MY_RELOCATED_RELEASE
+  /* Keep the 72 MHz clock tree the loader handed over rather than resetting
+     it and waiting for the PLL to lock all over again. */
+  if (BOOT_HANDOFF_CLOCK_READY())
+  {
+    SCB->VTOR = FLASH_BASE | VECT_TAB_OFFSET | APPLICATION_OFFSET;
+    SystemCoreClock = BOOT_HANDOFF_SYSCLK_HZ;
+    return;
+  }
+#endif
+
   /* Reset the RCC clock configuration to the default reset state ------------*/
   /* Set HSION bit */
   RCC->CR |= 0x00000001U;
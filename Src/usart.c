@@ -57,6 +57,8 @@
 /* USER CODE END 0 */
 
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USART2 init function */
 
@@ -103,6 +105,39 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
     GPIO_InitStruct.Alternate = GPIO_AF7_USART2;
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
+    /* USART2 DMA Init */
+    /* USART2_RX Init */
+    hdma_usart2_rx.Instance = DMA1_Channel6;
+    hdma_usart2_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_usart2_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart2_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart2_rx.Init.Mode = DMA_CIRCULAR;
+    hdma_usart2_rx.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_usart2_rx) != HAL_OK)
+    {
+      _Error_Handler(__FILE__, __LINE__);
+    }
+
+    __HAL_LINKDMA(uartHandle,hdmarx,hdma_usart2_rx);
+
+    /* USART2_TX Init */
+    hdma_usart2_tx.Instance = DMA1_Channel7;
+    hdma_usart2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_usart2_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart2_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart2_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart2_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart2_tx.Init.Mode = DMA_NORMAL;
+    hdma_usart2_tx.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_usart2_tx) != HAL_OK)
+    {
+      _Error_Handler(__FILE__, __LINE__);
+    }
+
+    __HAL_LINKDMA(uartHandle,hdmatx,hdma_usart2_tx);
+
     /* USART2 interrupt Init */
     HAL_NVIC_SetPriority(USART2_IRQn, 5, 0);
     HAL_NVIC_EnableIRQ(USART2_IRQn);
@@ -129,6 +164,10 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
     */
     HAL_GPIO_DeInit(GPIOA, USART_TX_Pin|USART_RX_Pin);
 
+    /* USART2 DMA DeInit */
+    HAL_DMA_DeInit(uartHandle->hdmarx);
+    HAL_DMA_DeInit(uartHandle->hdmatx);
+
     /* USART2 interrupt Deinit */
     HAL_NVIC_DisableIRQ(USART2_IRQn);
   /* USER CODE BEGIN USART2_MspDeInit 1 */
@@ -139,6 +178,100 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
 
 /* USER CODE BEGIN 1 */
 
+/* USART2 runs from PCLK1.  16x oversampling while the divider allows it,
+   8x above PCLK1/16 -- that tops out at PCLK1/8 (4.5 Mbaud at 36 MHz). */
+bool MX_USART2_BaudSupported(uint32_t baud, uint32_t *overSamplingPtr)
+{
+  uint32_t clock = HAL_RCC_GetPCLK1Freq();
+  uint32_t overSampling = UART_OVERSAMPLING_16;
+  uint32_t divider;
+  uint32_t actual;
+  uint32_t error;
+
+  if (USART2_MIN_BAUD > baud)
+  {
+    return(false);
+  }
+  if ((clock / baud) < 16)
+  {
+    overSampling = UART_OVERSAMPLING_8;
+    clock *= 2;
+    if ((clock / baud) < 16)
+    {
+      return(false);
+    }
+  }
+
+  divider = (clock + (baud / 2)) / baud;
+  actual = clock / divider;
+  error = ((actual > baud) ? (actual - baud) : (baud - actual)) * 1000 / baud;
+  if (USART2_MAX_BAUD_ERROR < error)
+  {
+    return(false);
+  }
+
+  if (NULL != overSamplingPtr)
+  {
+    *overSamplingPtr = overSampling;
+  }
+  return(true);
+}
+
+/* Stops any transfer in progress -- the caller re-arms reception. */
+HAL_StatusTypeDef MX_USART2_SetBaud(uint32_t baud)
+{
+  uint32_t overSampling;
+
+  if (false == MX_USART2_BaudSupported(baud, &overSampling))
+  {
+    return(HAL_ERROR);
+  }
+
+  HAL_UART_Abort(&huart2);
+  huart2.Init.BaudRate = baud;
+  huart2.Init.OverSampling = overSampling;
+  return(HAL_UART_Init(&huart2));
+}
+
+/* RTS/CTS: the transmitter waits on CTS (PA0) in hardware.  RTS (PA1) is a
+   plain output driven from the receive queue watermarks -- the USART's own RTS
+   only looks at RDR, and the DMA empties that after every byte. */
+HAL_StatusTypeDef MX_USART2_SetFlowControl(bool rtsCts)
+{
+  GPIO_InitTypeDef GPIO_InitStruct;
+
+  if (true == rtsCts)
+  {
+    GPIO_InitStruct.Pin = USART_CTS_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_PULLDOWN;   /* nothing wired -- clear to send */
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = GPIO_AF7_USART2;
+    HAL_GPIO_Init(USART_CTS_GPIO_Port, &GPIO_InitStruct);
+
+    HAL_GPIO_WritePin(USART_RTS_GPIO_Port, USART_RTS_Pin, GPIO_PIN_RESET);
+    GPIO_InitStruct.Pin = USART_RTS_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Alternate = 0;
+    HAL_GPIO_Init(USART_RTS_GPIO_Port, &GPIO_InitStruct);
+  }
+  else
+  {
+    HAL_GPIO_DeInit(GPIOA, USART_CTS_Pin|USART_RTS_Pin);
+  }
+
+  HAL_UART_Abort(&huart2);
+  huart2.Init.HwFlowCtl = (true == rtsCts) ? UART_HWCONTROL_CTS : UART_HWCONTROL_NONE;
+  return(HAL_UART_Init(&huart2));
+}
+
+/* RTS is active low: high asks the host to stop sending */
+void MX_USART2_SetRTS(bool stop)
+{
+  HAL_GPIO_WritePin(USART_RTS_GPIO_Port, USART_RTS_Pin, (true == stop) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
 /* USER CODE END 1 */
 
 /**
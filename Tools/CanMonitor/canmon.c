@@ -0,0 +1,508 @@
+/*
+ * canmon.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * Linux side of the master's bus monitor (see Inc/CANMonitor.h and
+ * Inc/HostLink.h).  Puts the node into HOSTLINK framed mode, turns MONITOR on
+ * and writes every captured frame to stdout as a candump log:
+ *
+ *		(1539347000.123456) can0 12345678#DEADBEEF
+ *
+ * Lost frames (node ring full or CAN FIFO overrun) are reported on stderr.
+ * With -f a previously saved raw byte stream is decoded instead.
+ *
+ *		cc -O2 -Wall -o canmon canmon.c
+ *		./canmon -d /dev/ttyACM0 -D > bus.log
+ *		canplayer -I bus.log
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Must match Inc/HostLink.h and Inc/CANMonitor.h
+#define HL_MAX_PAYLOAD			128
+#define HL_MSG_COMMAND			0x03
+#define HL_MSG_MODE				0x06
+#define HL_MSG_TEXT				0x07
+#define HL_MSG_CAN_MONITOR		0x08
+
+#define MON_FORMAT_PLAIN		0x00
+#define MON_FORMAT_DELTA		0x01
+#define MON_FLAG_DLC_MASK		0x0F
+#define MON_FLAG_EXT			0x10
+#define MON_FLAG_RTR			0x20
+#define MON_FLAG_SAME_ID		0x40
+#define MON_HEADER_LENGTH		13
+
+#define MAX_FRAME				(2 + HL_MAX_PAYLOAD + 2)
+#define MAX_ENCODED				(MAX_FRAME + 8)
+
+static volatile sig_atomic_t	stopRequested = 0;
+
+static const char		*ifName = "can0";
+static bool				haveBase = false;
+static double			hostBase;			// wall clock of device time 0
+static uint32_t			lastDeviceTime;
+static uint64_t			deviceMicros;		// unwrapped device time
+static uint32_t			lastDropped = 0;
+
+static uint16_t crc16(const uint8_t *dataPtr, size_t length)
+{
+	uint16_t crc = 0xFFFF;
+
+	while (0 != length--)
+	{
+		crc ^= (uint16_t)(*dataPtr++) << 8;
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+		}
+	}
+	return(crc);
+}
+
+static size_t cobsEncode(const uint8_t *inPtr, size_t length, uint8_t *outPtr)
+{
+	size_t codeIndex = 0;
+	size_t out = 1;
+	uint8_t code = 1;
+
+	for (size_t in = 0; in < length; in++)
+	{
+		if (0 == inPtr[in])
+		{
+			outPtr[codeIndex] = code;
+			codeIndex = out++;
+			code = 1;
+			continue;
+		}
+		outPtr[out++] = inPtr[in];
+		if (0xFF == ++code)
+		{
+			outPtr[codeIndex] = code;
+			codeIndex = out++;
+			code = 1;
+		}
+	}
+	outPtr[codeIndex] = code;
+	return(out);
+}
+
+static int cobsDecode(const uint8_t *inPtr, size_t length, uint8_t *outPtr)
+{
+	size_t in = 0;
+	int out = 0;
+
+	while (in < length)
+	{
+		uint8_t code = inPtr[in++];
+
+		if (0 == code)
+		{
+			return(-1);
+		}
+		for (uint8_t i = 1; i < code; i++)
+		{
+			if (in >= length)
+			{
+				return(-1);
+			}
+			outPtr[out++] = inPtr[in++];
+		}
+		if ((0xFF != code) && (in < length))
+		{
+			outPtr[out++] = 0;
+		}
+	}
+	return(out);
+}
+
+static void sendFrame(int fd, uint8_t type, const void *payloadPtr, size_t length)
+{
+	uint8_t frame[MAX_FRAME];
+	uint8_t encoded[MAX_ENCODED];
+	uint16_t crc;
+	size_t encodedLength;
+
+	frame[0] = type;
+	frame[1] = 0;
+	memcpy(&frame[2], payloadPtr, length);
+	crc = crc16(frame, length + 2);
+	frame[length + 2] = (uint8_t)crc;
+	frame[length + 3] = (uint8_t)(crc >> 8);
+
+	encodedLength = cobsEncode(frame, length + 4, encoded);
+	encoded[encodedLength++] = 0;
+	if (write(fd, encoded, encodedLength) != (ssize_t)encodedLength)
+	{
+		perror("canmon: write");
+	}
+}
+
+static void sendCommand(int fd, const char *commandPtr)
+{
+	sendFrame(fd, HL_MSG_COMMAND, commandPtr, strlen(commandPtr));
+}
+
+static uint32_t getLE32(const uint8_t *ptr)
+{
+	return((uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24));
+}
+
+static bool getVarint(const uint8_t **ptrPtr, const uint8_t *endPtr, uint32_t *valuePtr)
+{
+	uint32_t value = 0;
+
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		uint8_t byte;
+
+		if (*ptrPtr >= endPtr)
+		{
+			return(false);
+		}
+		byte = *(*ptrPtr)++;
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if (0 == (byte & 0x80))
+		{
+			*valuePtr = value;
+			return(true);
+		}
+	}
+	return(false);
+}
+
+static double hostNow(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return(tv.tv_sec + (tv.tv_usec / 1e6));
+}
+
+static void emitFrame(uint32_t deviceTime, uint32_t id, uint8_t flags, const uint8_t *dataPtr)
+{
+	uint8_t dlc = flags & MON_FLAG_DLC_MASK;
+	double stamp;
+
+	// Device time is 32 bits of microseconds -- unwrap it against the last one
+	if (false == haveBase)
+	{
+		deviceMicros = deviceTime;
+		hostBase = hostNow() - (deviceTime / 1e6);
+		haveBase = true;
+	}
+	else
+	{
+		deviceMicros += (uint32_t)(deviceTime - lastDeviceTime);
+	}
+	lastDeviceTime = deviceTime;
+	stamp = hostBase + (deviceMicros / 1e6);
+
+	printf("(%.6f) %s ", stamp, ifName);
+	if (0 != (flags & MON_FLAG_EXT))
+	{
+		printf("%08X#", id & 0x1FFFFFFF);
+	}
+	else
+	{
+		printf("%03X#", id & 0x7FF);
+	}
+	if (0 != (flags & MON_FLAG_RTR))
+	{
+		printf("R\n");
+		return;
+	}
+	for (uint8_t i = 0; (i < dlc) && (i < 8); i++)
+	{
+		printf("%02X", dataPtr[i]);
+	}
+	printf("\n");
+}
+
+static void decodeMonitor(const uint8_t *payloadPtr, size_t length)
+{
+	const uint8_t *ptr = payloadPtr + MON_HEADER_LENGTH;
+	const uint8_t *endPtr = payloadPtr + length;
+	uint8_t format;
+	uint32_t dropped;
+	uint32_t prevTime;
+	uint32_t prevId;
+
+	if (MON_HEADER_LENGTH > length)
+	{
+		return;
+	}
+	format = payloadPtr[0];
+	dropped = getLE32(&payloadPtr[1]);
+	prevTime = getLE32(&payloadPtr[5]);
+	prevId = getLE32(&payloadPtr[9]);
+
+	if (dropped != lastDropped)
+	{
+		fprintf(stderr, "canmon: %u frame(s) dropped by the node\n", (unsigned)(dropped - lastDropped));
+		lastDropped = dropped;
+	}
+
+	while (ptr < endPtr)
+	{
+		uint8_t flags = *ptr++;
+		uint8_t dlc = flags & MON_FLAG_DLC_MASK;
+		uint32_t time;
+		uint32_t id;
+
+		if (MON_FORMAT_PLAIN == format)
+		{
+			if ((ptr + 8) > endPtr)
+			{
+				return;
+			}
+			time = getLE32(ptr);
+			id = getLE32(ptr + 4);
+			ptr += 8;
+		}
+		else if (MON_FORMAT_DELTA == format)
+		{
+			uint32_t delta;
+
+			if (false == getVarint(&ptr, endPtr, &delta))
+			{
+				return;
+			}
+			time = prevTime + delta;
+			id = prevId;
+			if (0 == (flags & MON_FLAG_SAME_ID))
+			{
+				if (false == getVarint(&ptr, endPtr, &delta))
+				{
+					return;
+				}
+				id = prevId + (uint32_t)((int32_t)(delta >> 1) ^ -(int32_t)(delta & 1));
+			}
+		}
+		else
+		{
+			return;
+		}
+		prevTime = time;
+		prevId = id;
+
+		if (8 < dlc)
+		{
+			dlc = 8;
+		}
+		if (0 != (flags & MON_FLAG_RTR))
+		{
+			dlc = 0;
+		}
+		if ((ptr + dlc) > endPtr)
+		{
+			return;
+		}
+		emitFrame(time, id, flags, ptr);
+		ptr += dlc;
+	}
+}
+
+static void frameComplete(const uint8_t *encodedPtr, size_t length)
+{
+	uint8_t frame[MAX_ENCODED];
+	int frameLength;
+
+	if (0 == length)
+	{
+		return;
+	}
+	frameLength = cobsDecode(encodedPtr, length, frame);
+	if ((4 > frameLength) || (crc16(frame, frameLength - 2) != (frame[frameLength - 2] | (frame[frameLength - 1] << 8))))
+	{
+		fprintf(stderr, "canmon: bad frame\n");
+		return;
+	}
+
+	switch (frame[0])
+	{
+	case HL_MSG_CAN_MONITOR:
+		decodeMonitor(&frame[2], frameLength - 4);
+		fflush(stdout);
+		break;
+
+	case HL_MSG_TEXT:
+		fwrite(&frame[2], 1, frameLength - 4, stderr);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static int openPort(const char *devicePtr, speed_t speed)
+{
+	struct termios tio;
+	int fd = open(devicePtr, O_RDWR | O_NOCTTY);
+
+	if (0 > fd)
+	{
+		perror(devicePtr);
+		exit(1);
+	}
+	if (0 != tcgetattr(fd, &tio))
+	{
+		perror("canmon: tcgetattr");
+		exit(1);
+	}
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 2;
+	tcsetattr(fd, TCSANOW, &tio);
+	tcflush(fd, TCIOFLUSH);
+	return(fd);
+}
+
+static speed_t baudToSpeed(long baud)
+{
+	switch (baud)
+	{
+	case 115200:	return(B115200);
+	case 230400:	return(B230400);
+	case 460800:	return(B460800);
+	case 921600:	return(B921600);
+	default:
+		fprintf(stderr, "canmon: unsupported baud %ld\n", baud);
+		exit(1);
+	}
+}
+
+static void onSignal(int sig)
+{
+	stopRequested = 1;
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+			"usage: canmon -d <tty> [-b <baud>] [-D] [-i <ifname>]\n"
+			"       canmon -f <raw capture> [-i <ifname>]\n"
+			"  -D  ask the node for delta encoded records\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const char *devicePtr = NULL;
+	const char *filePtr = NULL;
+	long baud = 115200;
+	bool delta = false;
+	uint8_t encoded[MAX_ENCODED];
+	size_t encodedLength = 0;
+	bool overflow = false;
+	int fd;
+	int opt;
+
+	while (-1 != (opt = getopt(argc, argv, "d:b:f:i:D")))
+	{
+		switch (opt)
+		{
+		case 'd':	devicePtr = optarg;				break;
+		case 'b':	baud = strtol(optarg, NULL, 0);	break;
+		case 'f':	filePtr = optarg;				break;
+		case 'i':	ifName = optarg;				break;
+		case 'D':	delta = true;					break;
+		default:	usage();
+		}
+	}
+	if ((NULL == devicePtr) == (NULL == filePtr))
+	{
+		usage();
+	}
+
+	if (NULL != filePtr)
+	{
+		fd = open(filePtr, O_RDONLY);
+		if (0 > fd)
+		{
+			perror(filePtr);
+			return(1);
+		}
+	}
+	else
+	{
+		static const char enter[] = "\rHOSTLINK\r";
+
+		fd = openPort(devicePtr, baudToSpeed(baud));
+		if (write(fd, enter, sizeof(enter) - 1) != (ssize_t)(sizeof(enter) - 1))
+		{
+			perror("canmon: write");
+			return(1);
+		}
+		usleep(200000);
+		tcflush(fd, TCIFLUSH);		// drop the CLI echo
+		sendCommand(fd, delta ? "MONITOR ON DELTA" : "MONITOR ON");
+	}
+
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+
+	while (0 == stopRequested)
+	{
+		uint8_t buffer[512];
+		ssize_t count = read(fd, buffer, sizeof(buffer));
+
+		if (0 > count)
+		{
+			if (EINTR == errno)
+			{
+				continue;
+			}
+			perror("canmon: read");
+			break;
+		}
+		if ((0 == count) && (NULL != filePtr))
+		{
+			break;
+		}
+
+		for (ssize_t i = 0; i < count; i++)
+		{
+			if (0 == buffer[i])
+			{
+				if (false == overflow)
+				{
+					frameComplete(encoded, encodedLength);
+				}
+				encodedLength = 0;
+				overflow = false;
+				continue;
+			}
+			if (sizeof(encoded) <= encodedLength)
+			{
+				overflow = true;
+				continue;
+			}
+			encoded[encodedLength++] = buffer[i];
+		}
+	}
+
+	if (NULL != devicePtr)
+	{
+		static const uint8_t textMode = 0;
+
+		sendCommand(fd, "MONITOR OFF");
+		sendFrame(fd, HL_MSG_MODE, &textMode, 1);
+	}
+	close(fd);
+	return(0);
+}
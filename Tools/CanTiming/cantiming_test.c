@@ -0,0 +1,174 @@
+/*
+ * cantiming_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * Host check of the bit-timing solver (Src/CANTiming.c) against splits worked
+ * out by hand, then a sweep that every answer it gives is legal and on rate.
+ * Exits non-zero if any disagree.
+ *
+ *		cc -O2 -Wall -I../../Inc -o cantiming_test cantiming_test.c ../../Src/CANTiming.c
+ *		./cantiming_test
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "CANTiming.h"
+
+typedef struct _KNOWN_TIMING
+{
+	uint32_t	clockHz;
+	uint32_t	bitrate;
+	uint16_t	samplePermille;
+	CT_TIMING	reference;		// prescaler 0 = no timing exists
+	bool		unique;			// no other legal split is as good -- the solver must give this one
+} KNOWN_TIMING;
+
+// Worked by hand from the bit-time formula -- a bit is (1 + BS1 + BS2) quanta
+// of PRESCALER / clock, sampled after 1 + BS1 of them -- in the 16 and 18
+// quanta layouts bit-timing calculators offer for bxCAN, with phase segment 2
+// at ISO 11898-1's 2 quanta or more.  None of it comes from CT_Solve().  SJW
+// is left at the calculators' 1; the solver's own choice is checked for
+// legality only.
+static const KNOWN_TIMING knownTimings[] =
+{
+	// 36 MHz APB1 -- the shipping clock tree
+	{36000000,	500000,		625,	{9,		4,	3,	1},	true},		// MX_CAN_Init(), as CubeMX generated it
+	{36000000,	1000000,	875,	{2,		15,	2,	1},	false},		// 18 tq, 88.9%
+	{36000000,	500000,		875,	{4,		15,	2,	1},	false},		// 18 tq, 88.9%
+	{36000000,	250000,		875,	{9,		13,	2,	1},	true},		// 16 tq, 87.5%
+	{36000000,	125000,		875,	{18,	13,	2,	1},	true},
+	{36000000,	100000,		875,	{20,	15,	2,	1},	false},		// 18 tq, 88.9% -- 15 tq gets closer
+	{36000000,	83333,		875,	{27,	13,	2,	1},	true},
+	{36000000,	50000,		875,	{45,	13,	2,	1},	true},
+	{36000000,	20000,		875,	{100,	15,	2,	1},	false},
+	{36000000,	10000,		875,	{225,	13,	2,	1},	true},
+	{36000000,	800000,		800,	{3,		11,	3,	1},	true},		// 15 tq, 80.0%
+	// 8 MHz HSI with no PLL
+	{8000000,	500000,		875,	{1,		13,	2,	1},	true},
+	{8000000,	250000,		875,	{2,		13,	2,	1},	true},
+	{8000000,	125000,		875,	{4,		13,	2,	1},	true},
+	{8000000,	1000000,	875,	{1,		5,	2,	1},	true},		// 8 tq is all there is: 75.0%
+	// No legal split
+	{36000000,	3000000,	875,	{0,		0,	0,	0},	false},
+	{36000000,	1000,		875,	{0,		0,	0,	0},	false},
+	{8000000,	900000,		875,	{0,		0,	0,	0},	false},
+};
+
+static const uint32_t sweepClocks[] = {8000000, 16000000, 24000000, 32000000, 36000000, 48000000};
+static const uint32_t sweepRates[] = {10000, 20000, 50000, 83333, 100000, 125000, 250000, 500000, 800000, 1000000};
+static const uint16_t sweepSamples[] = {625, 750, 800, 875, 900};
+
+static uint32_t rateError(uint32_t clockHz, uint32_t bitrate, const CT_TIMING *timingPtr)
+{
+	uint32_t actual = CT_Bitrate(clockHz, timingPtr);
+
+	return((actual > bitrate) ? (actual - bitrate) : (bitrate - actual));
+}
+
+static uint16_t sampleError(uint16_t samplePermille, const CT_TIMING *timingPtr)
+{
+	uint16_t actual = CT_SamplePermille(timingPtr);
+
+	return((actual > samplePermille) ? (actual - samplePermille) : (samplePermille - actual));
+}
+
+static bool checkLegal(uint32_t clockHz, uint32_t bitrate, const CT_TIMING *timingPtr)
+{
+	uint32_t quanta = 1 + timingPtr->bs1 + timingPtr->bs2;
+	uint32_t actual = CT_Bitrate(clockHz, timingPtr);
+	uint32_t error = (actual > bitrate) ? (actual - bitrate) : (bitrate - actual);
+
+	return((1 <= timingPtr->prescaler) && (CT_PRESCALER_MAX >= timingPtr->prescaler) &&
+			(1 <= timingPtr->bs1) && (CT_BS1_MAX >= timingPtr->bs1) &&
+			(CT_BS2_MIN <= timingPtr->bs2) && (CT_BS2_MAX >= timingPtr->bs2) &&
+			(1 <= timingPtr->sjw) && (CT_SJW_MAX >= timingPtr->sjw) && (timingPtr->sjw <= timingPtr->bs2) &&
+			(CT_QUANTA_MIN <= quanta) && (CT_QUANTA_MAX >= quanta) &&
+			(((uint64_t)error * 1000000) <= ((uint64_t)CT_RATE_TOLERANCE_PPM * bitrate)));
+}
+
+int main(void)
+{
+	int failures = 0;
+	int solved = 0;
+
+	for (size_t i = 0; i < sizeof(knownTimings) / sizeof(knownTimings[0]); i++)
+	{
+		const KNOWN_TIMING *knownPtr = &knownTimings[i];
+		const CT_TIMING *referencePtr = &knownPtr->reference;
+		CT_TIMING timing = {0, 0, 0, 0};
+		bool found = CT_Solve(knownPtr->clockHz, knownPtr->bitrate, knownPtr->samplePermille, &timing);
+
+		if (found != (0 != referencePtr->prescaler))
+		{
+			printf("FAIL %lu Hz %lu bit/s: %s\n", (unsigned long)knownPtr->clockHz,
+					(unsigned long)knownPtr->bitrate, found ? "solved, expected none" : "no timing");
+			failures++;
+			continue;
+		}
+		if (false == found)
+		{
+			continue;
+		}
+		if (false == checkLegal(knownPtr->clockHz, knownPtr->bitrate, referencePtr))
+		{
+			printf("FAIL %lu Hz %lu bit/s: the reference %u/%u/%u is not legal itself\n",
+					(unsigned long)knownPtr->clockHz, (unsigned long)knownPtr->bitrate,
+					referencePtr->prescaler, referencePtr->bs1, referencePtr->bs2);
+			failures++;
+			continue;
+		}
+		if (false == checkLegal(knownPtr->clockHz, knownPtr->bitrate, &timing))
+		{
+			printf("FAIL %lu Hz %lu bit/s %u: illegal %u/%u/%u/%u\n", (unsigned long)knownPtr->clockHz,
+					(unsigned long)knownPtr->bitrate, knownPtr->samplePermille,
+					timing.prescaler, timing.bs1, timing.bs2, timing.sjw);
+			failures++;
+			continue;
+		}
+		if ((true == knownPtr->unique) ?
+			((timing.prescaler != referencePtr->prescaler) || (timing.bs1 != referencePtr->bs1) ||
+			 (timing.bs2 != referencePtr->bs2)) :
+			((rateError(knownPtr->clockHz, knownPtr->bitrate, &timing) >
+			  rateError(knownPtr->clockHz, knownPtr->bitrate, referencePtr)) ||
+			 (sampleError(knownPtr->samplePermille, &timing) > sampleError(knownPtr->samplePermille, referencePtr))))
+		{
+			printf("FAIL %lu Hz %lu bit/s %u: got %u/%u/%u, %s %u/%u/%u\n",
+					(unsigned long)knownPtr->clockHz, (unsigned long)knownPtr->bitrate, knownPtr->samplePermille,
+					timing.prescaler, timing.bs1, timing.bs2, (true == knownPtr->unique) ? "expected" : "worse than",
+					referencePtr->prescaler, referencePtr->bs1, referencePtr->bs2);
+			failures++;
+		}
+	}
+
+	for (size_t c = 0; c < sizeof(sweepClocks) / sizeof(sweepClocks[0]); c++)
+	{
+		for (size_t r = 0; r < sizeof(sweepRates) / sizeof(sweepRates[0]); r++)
+		{
+			for (size_t s = 0; s < sizeof(sweepSamples) / sizeof(sweepSamples[0]); s++)
+			{
+				CT_TIMING timing;
+
+				if (false == CT_Solve(sweepClocks[c], sweepRates[r], sweepSamples[s], &timing))
+				{
+					continue;
+				}
+				solved++;
+				if (false == checkLegal(sweepClocks[c], sweepRates[r], &timing))
+				{
+					printf("FAIL %lu Hz %lu bit/s %u: illegal %u/%u/%u/%u\n", (unsigned long)sweepClocks[c],
+							(unsigned long)sweepRates[r], sweepSamples[s],
+							timing.prescaler, timing.bs1, timing.bs2, timing.sjw);
+					failures++;
+				}
+			}
+		}
+	}
+
+	printf("%s: %u known timings, %d swept solutions, %d failure(s)\n", (0 == failures) ? "PASS" : "FAIL",
+			(unsigned)(sizeof(knownTimings) / sizeof(knownTimings[0])), solved, failures);
+	return((0 == failures) ? 0 : 1);
+}
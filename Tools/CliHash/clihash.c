@@ -0,0 +1,78 @@
+/*
+ * clihash.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * Picks CLI_HASH_SEED and prints the commandIndex[] initializer for the CLI
+ * command table in Src/UARTHandler.c.  Pass the command names in table order:
+ *
+ *		cc -O2 -Wall -o clihash clihash.c
+ *		./clihash "?" HELP MYADR GETADRS ...
+ *
+ * The hash must match CLI_Hash() in Src/CLIParse.c.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CLI_HASH_BITS		6
+#define CLI_HASH_SLOTS		(1 << CLI_HASH_BITS)
+
+static uint32_t cliHash(uint32_t seed, const char *strPtr)
+{
+	uint32_t hash = seed;
+
+	while ('\0' != *strPtr)
+	{
+		hash ^= (uint8_t)*strPtr++;
+		hash *= 16777619UL;
+	}
+	return(hash >> (32 - CLI_HASH_BITS));
+}
+
+int main(int argc, char **argv)
+{
+	int commands = argc - 1;
+
+	if ((0 == commands) || (CLI_HASH_SLOTS < commands))
+	{
+		fprintf(stderr, "usage: clihash <command> ... (at most %d)\n", CLI_HASH_SLOTS);
+		return(2);
+	}
+
+	for (uint32_t seed = 1; seed != 0; seed++)
+	{
+		int owner[CLI_HASH_SLOTS];
+		int i;
+
+		memset(owner, 0, sizeof(owner));
+		for (i = 0; i < commands; i++)
+		{
+			uint32_t slot = cliHash(seed, argv[i + 1]);
+
+			if (0 != owner[slot])
+			{
+				break;
+			}
+			owner[slot] = i + 1;
+		}
+		if (i != commands)
+		{
+			continue;
+		}
+
+		printf("#define CLI_HASH_SEED\t\t0x%08lXUL\n\n", (unsigned long)seed);
+		for (uint32_t slot = 0; slot < CLI_HASH_SLOTS; slot++)
+		{
+			if (0 != owner[slot])
+			{
+				printf("\t[%u] = %d,\t\t// %s\n", (unsigned)slot, owner[slot], argv[owner[slot]]);
+			}
+		}
+		return(0);
+	}
+	fprintf(stderr, "clihash: no perfect seed\n");
+	return(1);
+}
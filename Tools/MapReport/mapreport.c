@@ -0,0 +1,318 @@
+/*
+ * mapreport.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * Reads the GNU ld map file of a build (Debug/output.map) and reports how full
+ * each memory region is, then lists everything that landed in one region --
+ * CCMRAM unless -r says otherwise -- with the symbols in each input section:
+ *
+ *		cc -O2 -Wall -o mapreport mapreport.c
+ *		./mapreport Debug/output.map
+ *		./mapreport -r RAM Debug/output.map
+ *
+ * Sections loaded from FLASH and copied to RAM/CCMRAM at reset (.data,
+ * .ccmram) count against both regions.
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_REGIONS			8
+#define MAX_LINE			1024
+#define MAX_NAME			64
+#define MAX_SYMBOLS_TEXT	256
+
+typedef struct _REGION
+{
+	char		name[MAX_NAME];
+	uint64_t	origin;
+	uint64_t	length;
+	uint64_t	used;
+} REGION;
+
+typedef struct _INPUT
+{
+	char		section[MAX_NAME];		// input section name
+	char		output[MAX_NAME];		// output section it went into
+	char		object[MAX_NAME];		// object file, path stripped
+	uint64_t	address;
+	uint64_t	size;
+	char		symbols[MAX_SYMBOLS_TEXT];
+} INPUT;
+
+static REGION	regions[MAX_REGIONS];
+static int		regionCount = 0;
+static INPUT	*inputs = NULL;
+static int		inputCount = 0;
+static int		inputSpace = 0;
+
+static REGION *findRegion(uint64_t address)
+{
+	for (int i = 0; i < regionCount; i++)
+	{
+		if ((address >= regions[i].origin) && (address < (regions[i].origin + regions[i].length)))
+		{
+			return(&regions[i]);
+		}
+	}
+	return(NULL);
+}
+
+static bool isHex(const char *textPtr)
+{
+	return((0 == strncmp(textPtr, "0x", 2)) && isxdigit((unsigned char)textPtr[2]));
+}
+
+static void copyName(char *toPtr, const char *fromPtr)
+{
+	const char *slashPtr = strrchr(fromPtr, '/');
+
+	snprintf(toPtr, MAX_NAME, "%s", (NULL == slashPtr) ? fromPtr : (slashPtr + 1));
+}
+
+static INPUT *addInput(const char *sectionPtr, const char *outputPtr, uint64_t address, uint64_t size,
+		const char *objectPtr)
+{
+	INPUT *inputPtr;
+
+	if (inputCount == inputSpace)
+	{
+		inputSpace = (0 == inputSpace) ? 256 : (inputSpace * 2);
+		inputs = realloc(inputs, inputSpace * sizeof(INPUT));
+		if (NULL == inputs)
+		{
+			perror("mapreport");
+			exit(1);
+		}
+	}
+	inputPtr = &inputs[inputCount++];
+	snprintf(inputPtr->section, MAX_NAME, "%s", sectionPtr);
+	snprintf(inputPtr->output, MAX_NAME, "%s", outputPtr);
+	copyName(inputPtr->object, (NULL == objectPtr) ? "" : objectPtr);
+	inputPtr->address = address;
+	inputPtr->size = size;
+	inputPtr->symbols[0] = '\0';
+	return(inputPtr);
+}
+
+static void addSymbol(INPUT *inputPtr, const char *namePtr)
+{
+	size_t used = strlen(inputPtr->symbols);
+
+	if (0 != used)
+	{
+		snprintf(&inputPtr->symbols[used], MAX_SYMBOLS_TEXT - used, " %s", namePtr);
+	}
+	else
+	{
+		snprintf(inputPtr->symbols, MAX_SYMBOLS_TEXT, "%s", namePtr);
+	}
+}
+
+static int split(char *linePtr, char *tokens[], int maxTokens)
+{
+	int count = 0;
+	char *tokenPtr = strtok(linePtr, " \t\r\n");
+
+	while ((NULL != tokenPtr) && (count < maxTokens))
+	{
+		tokens[count++] = tokenPtr;
+		tokenPtr = strtok(NULL, " \t\r\n");
+	}
+	return(count);
+}
+
+static void readRegions(FILE *filePtr)
+{
+	char line[MAX_LINE];
+	bool inTable = false;
+
+	while (NULL != fgets(line, sizeof(line), filePtr))
+	{
+		char *tokens[4];
+		int count;
+
+		if (0 == strncmp(line, "Memory Configuration", 20))
+		{
+			inTable = true;
+			continue;
+		}
+		if (0 == strncmp(line, "Linker script and memory map", 28))
+		{
+			return;
+		}
+		count = split(line, tokens, 4);
+		if ((false == inTable) || (3 > count) || (false == isHex(tokens[1])) || ('*' == tokens[0][0]))
+		{
+			continue;
+		}
+		if (MAX_REGIONS > regionCount)
+		{
+			snprintf(regions[regionCount].name, MAX_NAME, "%s", tokens[0]);
+			regions[regionCount].origin = strtoull(tokens[1], NULL, 16);
+			regions[regionCount].length = strtoull(tokens[2], NULL, 16);
+			regions[regionCount].used = 0;
+			regionCount++;
+		}
+	}
+}
+
+// Long section names push the address and size onto the next line
+static int readWrapped(FILE *filePtr, char *linePtr, char *tokens[], int count, int maxTokens)
+{
+	if ((1 == count) && (NULL != fgets(linePtr, MAX_LINE, filePtr)))
+	{
+		count += split(linePtr, &tokens[1], maxTokens - 1);
+	}
+	return(count);
+}
+
+static void readMap(FILE *filePtr)
+{
+	char line[MAX_LINE];
+	char nextLine[MAX_LINE];
+	char output[MAX_NAME] = "";
+	INPUT *lastPtr = NULL;
+
+	while (NULL != fgets(line, sizeof(line), filePtr))
+	{
+		char *tokens[8];
+		int count;
+
+		if ('.' == line[0])
+		{
+			// Output section: NAME ADDRESS SIZE [load address LMA]
+			count = readWrapped(filePtr, nextLine, tokens, split(line, tokens, 8), 8);
+			snprintf(output, MAX_NAME, "%s", tokens[0]);
+			lastPtr = NULL;
+			if ((6 <= count) && (0 == strcmp(tokens[3], "load")))
+			{
+				REGION *loadPtr = findRegion(strtoull(tokens[5], NULL, 16));
+
+				if ((NULL != loadPtr) && (loadPtr != findRegion(strtoull(tokens[1], NULL, 16))))
+				{
+					loadPtr->used += strtoull(tokens[2], NULL, 16);
+				}
+			}
+			continue;
+		}
+		if ((' ' == line[0]) && (' ' != line[1]) && ('*' != line[1]))
+		{
+			// Input section: NAME ADDRESS SIZE OBJECT
+			uint64_t address;
+			uint64_t size;
+			REGION *regionPtr;
+
+			count = readWrapped(filePtr, nextLine, tokens, split(line, tokens, 8), 8);
+			lastPtr = NULL;
+			if ((3 > count) || (false == isHex(tokens[1])))
+			{
+				continue;
+			}
+			address = strtoull(tokens[1], NULL, 16);
+			size = strtoull(tokens[2], NULL, 16);
+			regionPtr = findRegion(address);
+			if ((0 == size) || (NULL == regionPtr))
+			{
+				continue;
+			}
+			regionPtr->used += size;
+			lastPtr = addInput(tokens[0], output, address, size, (4 <= count) ? tokens[3] : NULL);
+			continue;
+		}
+		if (0 == strncmp(line, " *fill*", 7))
+		{
+			// Alignment padding: *fill* ADDRESS SIZE
+			REGION *regionPtr;
+
+			count = split(line, tokens, 8);
+			if ((3 <= count) && (NULL != (regionPtr = findRegion(strtoull(tokens[1], NULL, 16)))))
+			{
+				regionPtr->used += strtoull(tokens[2], NULL, 16);
+			}
+			continue;
+		}
+
+		// Symbol: ADDRESS NAME -- anything longer is an assignment
+		count = split(line, tokens, 8);
+		if ((NULL != lastPtr) && (2 == count) && isHex(tokens[0]) && (false == isHex(tokens[1])))
+		{
+			addSymbol(lastPtr, tokens[1]);
+		}
+	}
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: mapreport [-r <region>] <output.map>\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const char *regionName = "CCMRAM";
+	uint64_t total = 0;
+	FILE *filePtr;
+	int opt;
+
+	while (-1 != (opt = getopt(argc, argv, "r:")))
+	{
+		switch (opt)
+		{
+		case 'r':	regionName = optarg;	break;
+		default:	usage();
+		}
+	}
+	if ((optind + 1) != argc)
+	{
+		usage();
+	}
+
+	filePtr = fopen(argv[optind], "r");
+	if (NULL == filePtr)
+	{
+		perror(argv[optind]);
+		return(1);
+	}
+	readRegions(filePtr);
+	readMap(filePtr);
+	fclose(filePtr);
+
+	if (0 == regionCount)
+	{
+		fprintf(stderr, "mapreport: no memory configuration in %s\n", argv[optind]);
+		return(1);
+	}
+
+	printf("%-10s %10s %10s %7s\n", "REGION", "USED", "SIZE", "USE%");
+	for (int i = 0; i < regionCount; i++)
+	{
+		printf("%-10s %10llu %10llu %6.1f%%\n", regions[i].name, (unsigned long long)regions[i].used,
+				(unsigned long long)regions[i].length, (100.0 * regions[i].used) / regions[i].length);
+	}
+
+	printf("\n%s\n%-10s %6s  %-14s %-20s %-22s %s\n", regionName,
+			"ADDRESS", "SIZE", "OUTPUT", "INPUT", "OBJECT", "SYMBOLS");
+	for (int i = 0; i < inputCount; i++)
+	{
+		REGION *regionPtr = findRegion(inputs[i].address);
+
+		if (0 != strcmp(regionPtr->name, regionName))
+		{
+			continue;
+		}
+		printf("0x%08llx %6llu  %-14s %-20s %-22s %s\n", (unsigned long long)inputs[i].address,
+				(unsigned long long)inputs[i].size, inputs[i].output, inputs[i].section, inputs[i].object,
+				inputs[i].symbols);
+		total += inputs[i].size;
+	}
+	printf("%-10s %6llu\n", "TOTAL", (unsigned long long)total);
+	return(0);
+}
@@ -0,0 +1,603 @@
+/*
+ * tracedump.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mdupont
+ *
+ * Linux side of the trace recorder (see Inc/Trace.h and Inc/HostLink.h).
+ * Puts the node into HOSTLINK framed mode, sends TRACE DUMP and writes the
+ * dump to stdout as Chrome trace event JSON, which ui.perfetto.dev and
+ * chrome://tracing both open:
+ *
+ *		pid 1	one track per task, a slice for every stretch it ran
+ *		pid 2	one track per IRQ, a slice per handler run
+ *		pid 3	tickless idle sleeps
+ *
+ * Queue sends from ISRs, task notifications and CAN/UART receive events are
+ * instant markers.  With -f a previously saved raw byte stream is decoded
+ * instead.
+ *
+ *		cc -O2 -Wall -o tracedump tracedump.c
+ *		./tracedump -d /dev/ttyACM0 > trace.json
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Must match Inc/HostLink.h and Inc/Trace.h
+#define HL_MAX_PAYLOAD			128
+#define HL_MSG_COMMAND			0x03
+#define HL_MSG_MODE				0x06
+#define HL_MSG_TEXT				0x07
+#define HL_MSG_TRACE			0x09
+
+#define TR_EV_TASK_IN			0x01
+#define TR_EV_ISR_ENTER			0x02
+#define TR_EV_ISR_EXIT			0x03
+#define TR_EV_QUEUE_SEND_ISR	0x04
+#define TR_EV_QUEUE_FULL_ISR	0x05
+#define TR_EV_NOTIFY			0x06
+#define TR_EV_NOTIFY_ISR		0x07
+#define TR_EV_SLEEP				0x08
+#define TR_EV_WAKE				0x09
+#define TR_EV_CAN_RX			0x0A
+#define TR_EV_UART_RX			0x0B
+
+#define TR_DUMP_BEGIN			0x00
+#define TR_DUMP_TASK			0x01
+#define TR_DUMP_EVENTS			0x02
+#define TR_DUMP_END				0x03
+#define TR_EVENT_LENGTH			8
+
+#define MAX_FRAME				(2 + HL_MAX_PAYLOAD + 2)
+#define MAX_ENCODED				(MAX_FRAME + 8)
+#define MAX_EVENTS				4096
+#define DUMP_TIMEOUT_READS		25			// x VTIME (0.2s) with nothing arriving
+
+#define PID_TASKS				1
+#define PID_IRQS				2
+#define PID_POWER				3
+
+typedef struct _EVENT
+{
+	uint32_t	stamp;
+	uint8_t		type;
+	uint8_t		arg;
+	uint16_t	extra;
+} EVENT;
+
+static uint32_t		clockHz = 0;
+static char			taskNames[256][17];
+static EVENT		events[MAX_EVENTS];
+static int			eventCount = 0;
+static bool			dumpDone = false;
+static bool			firstRecord = true;
+
+static uint16_t crc16(const uint8_t *dataPtr, size_t length)
+{
+	uint16_t crc = 0xFFFF;
+
+	while (0 != length--)
+	{
+		crc ^= (uint16_t)(*dataPtr++) << 8;
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+		}
+	}
+	return(crc);
+}
+
+static size_t cobsEncode(const uint8_t *inPtr, size_t length, uint8_t *outPtr)
+{
+	size_t codeIndex = 0;
+	size_t out = 1;
+	uint8_t code = 1;
+
+	for (size_t in = 0; in < length; in++)
+	{
+		if (0 == inPtr[in])
+		{
+			outPtr[codeIndex] = code;
+			codeIndex = out++;
+			code = 1;
+			continue;
+		}
+		outPtr[out++] = inPtr[in];
+		if (0xFF == ++code)
+		{
+			outPtr[codeIndex] = code;
+			codeIndex = out++;
+			code = 1;
+		}
+	}
+	outPtr[codeIndex] = code;
+	return(out);
+}
+
+static int cobsDecode(const uint8_t *inPtr, size_t length, uint8_t *outPtr)
+{
+	size_t in = 0;
+	int out = 0;
+
+	while (in < length)
+	{
+		uint8_t code = inPtr[in++];
+
+		if (0 == code)
+		{
+			return(-1);
+		}
+		for (uint8_t i = 1; i < code; i++)
+		{
+			if (in >= length)
+			{
+				return(-1);
+			}
+			outPtr[out++] = inPtr[in++];
+		}
+		if ((0xFF != code) && (in < length))
+		{
+			outPtr[out++] = 0;
+		}
+	}
+	return(out);
+}
+
+static void sendFrame(int fd, uint8_t type, const void *payloadPtr, size_t length)
+{
+	uint8_t frame[MAX_FRAME];
+	uint8_t encoded[MAX_ENCODED];
+	uint16_t crc;
+	size_t encodedLength;
+
+	frame[0] = type;
+	frame[1] = 0;
+	memcpy(&frame[2], payloadPtr, length);
+	crc = crc16(frame, length + 2);
+	frame[length + 2] = (uint8_t)crc;
+	frame[length + 3] = (uint8_t)(crc >> 8);
+
+	encodedLength = cobsEncode(frame, length + 4, encoded);
+	encoded[encodedLength++] = 0;
+	if (write(fd, encoded, encodedLength) != (ssize_t)encodedLength)
+	{
+		perror("tracedump: write");
+	}
+}
+
+static void sendCommand(int fd, const char *commandPtr)
+{
+	sendFrame(fd, HL_MSG_COMMAND, commandPtr, strlen(commandPtr));
+}
+
+static uint32_t getLE32(const uint8_t *ptr)
+{
+	return((uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24));
+}
+
+static const char *irqName(uint8_t irq)
+{
+	switch (irq)
+	{
+	case 16:	return("DMA1_CH6 (UART RX)");
+	case 17:	return("DMA1_CH7 (UART TX)");
+	case 19:	return("CAN_TX");
+	case 20:	return("CAN_RX0");
+	case 21:	return("CAN_RX1");
+	case 22:	return("CAN_SCE");
+	case 38:	return("USART2");
+	case 40:	return("EXTI15_10");
+	default:	return("IRQ");
+	}
+}
+
+static const char *taskName(uint8_t number)
+{
+	return(('\0' == taskNames[number][0]) ? "?" : taskNames[number]);
+}
+
+// One JSON object per call, comma separated
+static void record(const char *formatPtr, ...)
+{
+	va_list args;
+
+	printf("%s\n  ", (true == firstRecord) ? "" : ",");
+	firstRecord = false;
+	va_start(args, formatPtr);
+	vprintf(formatPtr, args);
+	va_end(args);
+}
+
+static void nameTrack(int pid, int tid, const char *namePtr)
+{
+	if (0 > tid)
+	{
+		record("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,\"args\":{\"name\":\"%s\"}}", pid, namePtr);
+	}
+	else
+	{
+		record("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				pid, tid, namePtr);
+	}
+}
+
+static void emitTrace(void)
+{
+	bool irqSeen[256] = {false};
+	uint64_t ticks = 0;
+	uint32_t lastStamp = 0;
+	int currentTask = -1;
+	double taskStart = 0;
+	double sleepStart = -1;
+	double now = 0;
+
+	if (0 == clockHz)
+	{
+		fprintf(stderr, "tracedump: no dump header\n");
+		return;
+	}
+
+	printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	nameTrack(PID_TASKS, -1, "Tasks");
+	nameTrack(PID_IRQS, -1, "Interrupts");
+	nameTrack(PID_POWER, -1, "Power");
+	nameTrack(PID_POWER, 0, "Tickless idle");
+	for (int i = 0; i < 256; i++)
+	{
+		if ('\0' != taskNames[i][0])
+		{
+			nameTrack(PID_TASKS, i, taskNames[i]);
+		}
+	}
+
+	for (int i = 0; i < eventCount; i++)
+	{
+		const EVENT *eventPtr = &events[i];
+
+		// TIM2 is 32 bits -- unwrap against the previous event.  It runs through
+		// tickless sleeps, so they show at their real length
+		if (0 != i)
+		{
+			ticks += (uint32_t)(eventPtr->stamp - lastStamp);
+		}
+		lastStamp = eventPtr->stamp;
+		now = (ticks * 1e6) / clockHz;
+
+		switch (eventPtr->type)
+		{
+		case TR_EV_TASK_IN:
+			if (0 <= currentTask)
+			{
+				record("{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+						taskName(currentTask), PID_TASKS, currentTask, taskStart, now - taskStart);
+			}
+			currentTask = eventPtr->arg;
+			taskStart = now;
+			break;
+
+		case TR_EV_ISR_ENTER:
+		case TR_EV_ISR_EXIT:
+			if (false == irqSeen[eventPtr->arg])
+			{
+				nameTrack(PID_IRQS, eventPtr->arg, irqName(eventPtr->arg));
+				irqSeen[eventPtr->arg] = true;
+			}
+			record("{\"ph\":\"%s\",\"name\":\"%s\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f}",
+					(TR_EV_ISR_ENTER == eventPtr->type) ? "B" : "E", irqName(eventPtr->arg),
+					PID_IRQS, eventPtr->arg, now);
+			break;
+
+		case TR_EV_QUEUE_SEND_ISR:
+		case TR_EV_QUEUE_FULL_ISR:
+			record("{\"ph\":\"i\",\"s\":\"p\",\"name\":\"%s\",\"pid\":%d,\"tid\":0,\"ts\":%.3f,"
+					"\"args\":{\"queue\":\"0x%04X\",\"waiting\":%u}}",
+					(TR_EV_QUEUE_SEND_ISR == eventPtr->type) ? "queue send" : "QUEUE FULL",
+					PID_IRQS, now, eventPtr->extra, eventPtr->arg);
+			break;
+
+		case TR_EV_NOTIFY:
+		case TR_EV_NOTIFY_ISR:
+			record("{\"ph\":\"i\",\"s\":\"t\",\"name\":\"notify %s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,"
+					"\"args\":{\"fromISR\":%s}}",
+					taskName(eventPtr->arg), PID_TASKS, (0 > currentTask) ? 0 : currentTask, now,
+					(TR_EV_NOTIFY_ISR == eventPtr->type) ? "true" : "false");
+			break;
+
+		case TR_EV_SLEEP:
+			sleepStart = now;
+			break;
+
+		case TR_EV_WAKE:
+			if (0 <= sleepStart)
+			{
+				record("{\"ph\":\"X\",\"name\":\"sleep\",\"pid\":%d,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+						PID_POWER, sleepStart, now - sleepStart);
+			}
+			sleepStart = -1;
+			break;
+
+		case TR_EV_CAN_RX:
+			record("{\"ph\":\"i\",\"s\":\"p\",\"name\":\"CAN RX\",\"pid\":%d,\"tid\":0,\"ts\":%.3f,"
+					"\"args\":{\"fifo\":%u,\"command\":\"0x%03X\"}}",
+					PID_IRQS, now, eventPtr->arg, eventPtr->extra);
+			break;
+
+		case TR_EV_UART_RX:
+			record("{\"ph\":\"i\",\"s\":\"p\",\"name\":\"UART RX\",\"pid\":%d,\"tid\":0,\"ts\":%.3f,"
+					"\"args\":{\"bytes\":%u}}", PID_IRQS, now, eventPtr->extra);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	// Whatever was running when the dump started runs to the end of the trace
+	if (0 <= currentTask)
+	{
+		record("{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				taskName(currentTask), PID_TASKS, currentTask, taskStart, now - taskStart);
+	}
+	printf("\n]}\n");
+}
+
+static void decodeTrace(const uint8_t *payloadPtr, size_t length)
+{
+	if (0 == length)
+	{
+		return;
+	}
+
+	switch (payloadPtr[0])
+	{
+	case TR_DUMP_BEGIN:
+		if (13 > length)
+		{
+			return;
+		}
+		clockHz = getLE32(&payloadPtr[1]);
+		eventCount = 0;
+		if (0 != getLE32(&payloadPtr[9]))
+		{
+			fprintf(stderr, "tracedump: %u event(s) lost on the node\n", (unsigned)getLE32(&payloadPtr[9]));
+		}
+		break;
+
+	case TR_DUMP_TASK:
+		if (2 < length)
+		{
+			size_t nameLength = length - 2;
+
+			if (sizeof(taskNames[0]) <= nameLength)
+			{
+				nameLength = sizeof(taskNames[0]) - 1;
+			}
+			memcpy(taskNames[payloadPtr[1]], &payloadPtr[2], nameLength);
+			taskNames[payloadPtr[1]][nameLength] = '\0';
+		}
+		break;
+
+	case TR_DUMP_EVENTS:
+		for (size_t offset = 1; (offset + TR_EVENT_LENGTH) <= length; offset += TR_EVENT_LENGTH)
+		{
+			const uint8_t *ptr = &payloadPtr[offset];
+
+			if (MAX_EVENTS <= eventCount)
+			{
+				break;
+			}
+			events[eventCount].stamp = getLE32(ptr);
+			events[eventCount].type = ptr[4];
+			events[eventCount].arg = ptr[5];
+			events[eventCount].extra = (uint16_t)(ptr[6] | (ptr[7] << 8));
+			eventCount++;
+		}
+		break;
+
+	case TR_DUMP_END:
+		dumpDone = true;
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void frameComplete(const uint8_t *encodedPtr, size_t length)
+{
+	uint8_t frame[MAX_ENCODED];
+	int frameLength;
+
+	if (0 == length)
+	{
+		return;
+	}
+	frameLength = cobsDecode(encodedPtr, length, frame);
+	if ((4 > frameLength) || (crc16(frame, frameLength - 2) != (frame[frameLength - 2] | (frame[frameLength - 1] << 8))))
+	{
+		fprintf(stderr, "tracedump: bad frame\n");
+		return;
+	}
+
+	switch (frame[0])
+	{
+	case HL_MSG_TRACE:
+		decodeTrace(&frame[2], frameLength - 4);
+		break;
+
+	case HL_MSG_TEXT:
+		fwrite(&frame[2], 1, frameLength - 4, stderr);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static int openPort(const char *devicePtr, speed_t speed)
+{
+	struct termios tio;
+	int fd = open(devicePtr, O_RDWR | O_NOCTTY);
+
+	if (0 > fd)
+	{
+		perror(devicePtr);
+		exit(1);
+	}
+	if (0 != tcgetattr(fd, &tio))
+	{
+		perror("tracedump: tcgetattr");
+		exit(1);
+	}
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 2;
+	tcsetattr(fd, TCSANOW, &tio);
+	tcflush(fd, TCIOFLUSH);
+	return(fd);
+}
+
+static speed_t baudToSpeed(long baud)
+{
+	switch (baud)
+	{
+	case 115200:	return(B115200);
+	case 230400:	return(B230400);
+	case 460800:	return(B460800);
+	case 921600:	return(B921600);
+	default:
+		fprintf(stderr, "tracedump: unsupported baud %ld\n", baud);
+		exit(1);
+	}
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+			"usage: tracedump -d <tty> [-b <baud>]\n"
+			"       tracedump -f <raw capture>\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const char *devicePtr = NULL;
+	const char *filePtr = NULL;
+	long baud = 115200;
+	uint8_t encoded[MAX_ENCODED];
+	size_t encodedLength = 0;
+	bool overflow = false;
+	int idleReads = 0;
+	int fd;
+	int opt;
+
+	while (-1 != (opt = getopt(argc, argv, "d:b:f:")))
+	{
+		switch (opt)
+		{
+		case 'd':	devicePtr = optarg;				break;
+		case 'b':	baud = strtol(optarg, NULL, 0);	break;
+		case 'f':	filePtr = optarg;				break;
+		default:	usage();
+		}
+	}
+	if ((NULL == devicePtr) == (NULL == filePtr))
+	{
+		usage();
+	}
+
+	if (NULL != filePtr)
+	{
+		fd = open(filePtr, O_RDONLY);
+		if (0 > fd)
+		{
+			perror(filePtr);
+			return(1);
+		}
+	}
+	else
+	{
+		static const char enter[] = "\rHOSTLINK\r";
+
+		fd = openPort(devicePtr, baudToSpeed(baud));
+		if (write(fd, enter, sizeof(enter) - 1) != (ssize_t)(sizeof(enter) - 1))
+		{
+			perror("tracedump: write");
+			return(1);
+		}
+		usleep(200000);
+		tcflush(fd, TCIFLUSH);		// drop the CLI echo
+		sendCommand(fd, "TRACE DUMP");
+	}
+
+	while (false == dumpDone)
+	{
+		uint8_t buffer[512];
+		ssize_t count = read(fd, buffer, sizeof(buffer));
+
+		if (0 > count)
+		{
+			if (EINTR == errno)
+			{
+				continue;
+			}
+			perror("tracedump: read");
+			break;
+		}
+		if (0 == count)
+		{
+			if ((NULL != filePtr) || (DUMP_TIMEOUT_READS <= ++idleReads))
+			{
+				break;
+			}
+			continue;
+		}
+		idleReads = 0;
+
+		for (ssize_t i = 0; (i < count) && (false == dumpDone); i++)
+		{
+			if (0 == buffer[i])
+			{
+				if (false == overflow)
+				{
+					frameComplete(encoded, encodedLength);
+				}
+				encodedLength = 0;
+				overflow = false;
+				continue;
+			}
+			if (sizeof(encoded) <= encodedLength)
+			{
+				overflow = true;
+				continue;
+			}
+			encoded[encodedLength++] = buffer[i];
+		}
+	}
+
+	if (NULL != devicePtr)
+	{
+		static const uint8_t textMode = 0;
+
+		sendFrame(fd, HL_MSG_MODE, &textMode, 1);
+	}
+	close(fd);
+
+	if (false == dumpDone)
+	{
+		fprintf(stderr, "tracedump: dump incomplete\n");
+	}
+	emitTrace();
+	return((true == dumpDone) ? 0 : 1);
+}
@@ -75,6 +75,10 @@ defined in linker script */
 Reset_Handler:
   ldr   sp, =_estack    /* Atollic update: set stack pointer */
 
+/* Let the loader hand a valid high flash image off straight from reset.
+   Returns if this is the relocated image or there is nothing to run. */
+  bl  LoaderEarlyEntry
+
 /* Copy the data segment initializers from flash to SRAM */
   movs	r1, #0
   b	LoopCopyDataInit
@@ -103,6 +107,34 @@ LoopFillZerobss:
 	cmp	r2, r3
 	bcc	FillZerobss
 
+/* Copy the CCM-RAM code and data from flash (CCM_FUNC in main.h) */
+  movs	r1, #0
+  b	LoopCopyCcmInit
+
+CopyCcmInit:
+	ldr	r3, =_siccmram
+	ldr	r3, [r3, r1]
+	str	r3, [r0, r1]
+	adds	r1, r1, #4
+
+LoopCopyCcmInit:
+	ldr	r0, =_sccmram
+	ldr	r3, =_eccmram
+	adds	r2, r0, r1
+	cmp	r2, r3
+	bcc	CopyCcmInit
+	ldr	r2, =_sccmbss
+	b	LoopFillZeroCcmbss
+/* Zero fill the CCM-RAM bss segment (CCM_BSS in main.h). */
+FillZeroCcmbss:
+	movs	r3, #0
+	str	r3, [r2], #4
+
+LoopFillZeroCcmbss:
+	ldr	r3, = _eccmbss
+	cmp	r2, r3
+	bcc	FillZeroCcmbss
+
 /* Call the clock system intitialization function.*/
     bl  SystemInit
 /* Call static constructors */